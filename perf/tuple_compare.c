@@ -0,0 +1,243 @@
+/*
+ * Tuple comparator microbenchmark.
+ *
+ * For each key definition shape it prints how many millions of
+ * tuple_compare() and tuple_compare_with_key() calls per second
+ * are done over a set of random tuples. Hints are not passed to
+ * the comparators, so that every call compares key fields.
+ *
+ * Usage: tuple_compare.perftest [<iterations>]
+ */
+#include "memory.h"
+#include "fiber.h"
+#include "clock.h"
+#include "tuple.h"
+#include "tuple_format.h"
+#include "key_def.h"
+#include "coll_id.h"
+#include "coll_id_def.h"
+#include "coll_id_cache.h"
+#include "msgpuck.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+	/** Number of fields in a tuple. */
+	FIELD_COUNT = 6,
+	/** Number of tuples compared with each other. */
+	TUPLE_COUNT = 1024,
+	/** Default number of comparisons per shape. */
+	ITERATIONS_DEFAULT = 10 * 1000 * 1000,
+	/** Case insensitive collation used by the shapes. */
+	COLL_ID_CI = 1,
+	/** Max size of a tuple. */
+	TUPLE_SIZE_MAX = 256,
+};
+
+struct shape_part {
+	uint32_t fieldno;
+	enum field_type type;
+	uint32_t coll_id;
+};
+
+struct shape {
+	const char *name;
+	uint32_t part_count;
+	struct shape_part parts[4];
+};
+
+static const struct shape shapes[] = {
+	{"unsigned", 1, {
+		{0, FIELD_TYPE_UNSIGNED, COLL_NONE}}},
+	{"string", 1, {
+		{0, FIELD_TYPE_STRING, COLL_NONE}}},
+	{"string(ci)", 1, {
+		{0, FIELD_TYPE_STRING, COLL_ID_CI}}},
+	{"integer", 1, {
+		{1, FIELD_TYPE_INTEGER, COLL_NONE}}},
+	{"number", 1, {
+		{2, FIELD_TYPE_NUMBER, COLL_NONE}}},
+	{"integer, integer", 2, {
+		{1, FIELD_TYPE_INTEGER, COLL_NONE},
+		{2, FIELD_TYPE_INTEGER, COLL_NONE}}},
+	{"string, integer", 2, {
+		{3, FIELD_TYPE_STRING, COLL_NONE},
+		{1, FIELD_TYPE_INTEGER, COLL_NONE}}},
+	{"string(ci), unsigned", 2, {
+		{1, FIELD_TYPE_STRING, COLL_ID_CI},
+		{2, FIELD_TYPE_UNSIGNED, COLL_NONE}}},
+	{"number, string", 2, {
+		{4, FIELD_TYPE_NUMBER, COLL_NONE},
+		{2, FIELD_TYPE_STRING, COLL_NONE}}},
+	{"integer, string, number", 3, {
+		{1, FIELD_TYPE_INTEGER, COLL_NONE},
+		{2, FIELD_TYPE_STRING, COLL_NONE},
+		{3, FIELD_TYPE_NUMBER, COLL_NONE}}},
+	{"string(ci), integer, string", 3, {
+		{5, FIELD_TYPE_STRING, COLL_ID_CI},
+		{0, FIELD_TYPE_INTEGER, COLL_NONE},
+		{3, FIELD_TYPE_STRING, COLL_NONE}}},
+	{"unsigned, unsigned, unsigned, unsigned", 4, {
+		{0, FIELD_TYPE_UNSIGNED, COLL_NONE},
+		{1, FIELD_TYPE_UNSIGNED, COLL_NONE},
+		{2, FIELD_TYPE_UNSIGNED, COLL_NONE},
+		{3, FIELD_TYPE_UNSIGNED, COLL_NONE}}},
+	{"string, integer, string, integer", 4, {
+		{2, FIELD_TYPE_STRING, COLL_NONE},
+		{0, FIELD_TYPE_INTEGER, COLL_NONE},
+		{4, FIELD_TYPE_STRING, COLL_NONE},
+		{5, FIELD_TYPE_INTEGER, COLL_NONE}}},
+	{"boolean, scalar", 2, {
+		{1, FIELD_TYPE_BOOLEAN, COLL_NONE},
+		{2, FIELD_TYPE_SCALAR, COLL_NONE}}},
+};
+
+/**
+ * Encode a random value for a field of the given type. Values
+ * are picked from a small range, so that comparisons often
+ * have to look at all key parts.
+ */
+static char *
+encode_field(char *data, enum field_type type)
+{
+	char str[16];
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+		return mp_encode_uint(data, rand() % 4);
+	case FIELD_TYPE_INTEGER:
+		return mp_encode_int(data, rand() % 4 - 2);
+	case FIELD_TYPE_NUMBER:
+		if (rand() % 2 == 0)
+			return mp_encode_double(data, (rand() % 8) / 2.0);
+		return mp_encode_uint(data, rand() % 4);
+	case FIELD_TYPE_BOOLEAN:
+		return mp_encode_bool(data, rand() % 2 == 0);
+	case FIELD_TYPE_STRING:
+	case FIELD_TYPE_SCALAR:
+		snprintf(str, sizeof(str), "%s-%d",
+			 rand() % 2 == 0 ? "key" : "KEY", rand() % 4);
+		return mp_encode_str(data, str, strlen(str));
+	default:
+		abort();
+	}
+}
+
+static struct coll_id *
+coll_id_ci_new(void)
+{
+	struct coll_id_def def;
+	memset(&def, 0, sizeof(def));
+	def.id = COLL_ID_CI;
+	def.owner_id = 1;
+	def.name = "unicode_ci";
+	def.name_len = strlen(def.name);
+	def.base.type = COLL_TYPE_ICU;
+	def.base.icu.strength = COLL_ICU_STRENGTH_PRIMARY;
+	struct coll_id *coll_id = coll_id_new(&def);
+	struct coll_id *replaced;
+	if (coll_id == NULL || coll_id_cache_replace(coll_id, &replaced) != 0)
+		abort();
+	return coll_id;
+}
+
+static void
+bench_shape(const struct shape *shape, int iterations)
+{
+	struct key_part_def parts[4];
+	for (uint32_t i = 0; i < shape->part_count; i++) {
+		parts[i] = key_part_def_default;
+		parts[i].fieldno = shape->parts[i].fieldno;
+		parts[i].type = shape->parts[i].type;
+		parts[i].coll_id = shape->parts[i].coll_id;
+	}
+	struct key_def *key_def = key_def_new(parts, shape->part_count);
+	if (key_def == NULL)
+		abort();
+	struct tuple_format *format = tuple_format_new(
+		&tuple_format_runtime->vtab, NULL, &key_def, 1,
+		NULL, 0, 0, NULL, false, false);
+	if (format == NULL)
+		abort();
+	tuple_format_ref(format);
+
+	static struct tuple *tuples[TUPLE_COUNT];
+	static const char *keys[TUPLE_COUNT];
+	for (int i = 0; i < TUPLE_COUNT; i++) {
+		char data[TUPLE_SIZE_MAX];
+		char *end = mp_encode_array(data, FIELD_COUNT);
+		for (uint32_t fieldno = 0; fieldno < FIELD_COUNT; fieldno++) {
+			enum field_type type = FIELD_TYPE_UNSIGNED;
+			for (uint32_t j = 0; j < shape->part_count; j++) {
+				if (shape->parts[j].fieldno == fieldno)
+					type = shape->parts[j].type;
+			}
+			end = encode_field(end, type);
+		}
+		tuples[i] = tuple_new(format, data, end);
+		if (tuples[i] == NULL)
+			abort();
+		tuple_ref(tuples[i]);
+		keys[i] = tuple_extract_key(tuples[i], key_def,
+					    MULTIKEY_NONE, NULL);
+		if (keys[i] == NULL)
+			abort();
+		mp_decode_array(&keys[i]);
+	}
+
+	int sink = 0;
+	double start = clock_monotonic();
+	for (int i = 0; i < iterations; i++) {
+		struct tuple *a = tuples[i % TUPLE_COUNT];
+		struct tuple *b = tuples[(i * 7 + i / TUPLE_COUNT) %
+					 TUPLE_COUNT];
+		sink += tuple_compare(a, HINT_NONE, b, HINT_NONE, key_def);
+	}
+	double cmp_time = clock_monotonic() - start;
+	start = clock_monotonic();
+	for (int i = 0; i < iterations; i++) {
+		struct tuple *a = tuples[i % TUPLE_COUNT];
+		const char *key = keys[(i * 7 + i / TUPLE_COUNT) %
+				       TUPLE_COUNT];
+		sink += tuple_compare_with_key(a, HINT_NONE, key,
+					       shape->part_count, HINT_NONE,
+					       key_def);
+	}
+	double cmp_wk_time = clock_monotonic() - start;
+	printf("%-40s %12.2f %12.2f %8d\n", shape->name,
+	       iterations / cmp_time / 1e6, iterations / cmp_wk_time / 1e6,
+	       sink);
+
+	for (int i = 0; i < TUPLE_COUNT; i++)
+		tuple_unref(tuples[i]);
+	tuple_format_unref(format);
+	key_def_delete(key_def);
+	region_truncate(&fiber()->gc, 0);
+}
+
+int
+main(int argc, char **argv)
+{
+	int iterations = argc > 1 ? atoi(argv[1]) : ITERATIONS_DEFAULT;
+	if (iterations <= 0) {
+		fprintf(stderr, "Usage: %s [<iterations>]\n", argv[0]);
+		return 1;
+	}
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	tuple_init(NULL);
+	struct coll_id *coll_id = coll_id_ci_new();
+	srand(1);
+
+	printf("%-40s %12s %12s %8s\n", "key parts", "cmp, M/s",
+	       "cmp_wk, M/s", "sink");
+	for (unsigned i = 0; i < lengthof(shapes); i++)
+		bench_shape(&shapes[i], iterations);
+
+	coll_id_cache_delete(coll_id);
+	coll_id_delete(coll_id);
+	tuple_free();
+	fiber_free();
+	memory_free();
+	return 0;
+}
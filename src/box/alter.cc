@@ -524,6 +524,16 @@ space_def_new_from_tuple(struct tuple *tuple, uint32_t errcode,
 	}
 	if (opts.is_view && opts.sql == NULL)
 		tnt_raise(ClientError, ER_VIEW_MISSING_SQL);
+	if (opts.compression == tuple_compression_MAX) {
+		tnt_raise(ClientError, errcode, tt_cstr(name, name_len),
+			  "unknown compression type");
+	}
+	if (opts.compression_level < 1 ||
+	    opts.compression_level > TUPLE_COMPRESSION_LEVEL_MAX) {
+		tnt_raise(ClientError, errcode, tt_cstr(name, name_len),
+			  tt_sprintf("compression_level must be in range "
+				     "[1, %d]", TUPLE_COMPRESSION_LEVEL_MAX));
+	}
 	struct space_def *def =
 		space_def_new_xc(id, uid, exact_field_count, name, name_len,
 				 engine_name, engine_name_len, &opts, fields,
@@ -50,6 +50,11 @@
 #include "schema.h"
 #include "txn.h"
 #include "box.h"
+#include "space.h"
+#include "index.h"
+#include "engine.h"
+#include "tuple.h"
+#include "scoped_guard.h"
 
 STRS(applier_state, applier_STATE);
 
@@ -315,6 +320,244 @@ done:
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/** Progress of fetching a shard of the master's snapshot. */
+struct applier_join_shard {
+	/** Number of rows of the shard applied so far. */
+	uint64_t row_count;
+	/** Set once all rows of the shard have been applied. */
+	bool is_done;
+};
+
+/**
+ * State shared by the fibers fetching a range of snapshot
+ * shards, see applier_fetch_shards().
+ */
+struct applier_fetch {
+	/** Applier executing JOIN. */
+	struct applier *applier;
+	/** Next shard to fetch. */
+	uint32_t next_shard;
+	/** End of the range of shards to fetch. */
+	uint32_t end_shard;
+	/** Number of fetch fibers still running. */
+	int fiber_count;
+	/** Signaled when a fetch fiber exits. */
+	struct fiber_cond cond;
+	/** The first error a fetch fiber failed with. */
+	struct diag diag;
+	/** Rows received on initial join so far, for logging. */
+	uint64_t *row_count;
+};
+
+/**
+ * Send FETCH_SNAPSHOT for the given shard over @conn and apply
+ * the rows received in response. The rows applied before are
+ * skipped by the master.
+ */
+static void
+applier_fetch_shard(struct applier_fetch *fetch, struct applier *conn,
+		    uint32_t shard_id)
+{
+	struct applier *applier = fetch->applier;
+	struct applier_join_shard *shard = &applier->join_shards[shard_id];
+	struct xrow_header row;
+	xrow_encode_fetch_snapshot_xc(&row, &applier->join_vclock, shard_id,
+				      shard->row_count);
+	coio_write_xrow(&conn->io, &row);
+	while (true) {
+		coio_read_xrow(&conn->io, &conn->ibuf, &row);
+		applier->last_row_time = ev_monotonic_now(loop());
+		if (iproto_type_is_dml(row.type)) {
+			if (apply_initial_join_row(&row) != 0)
+				diag_raise();
+			shard->row_count++;
+			if (++*fetch->row_count % 100000 == 0)
+				say_info("%.1fM rows received",
+					 *fetch->row_count / 1e6);
+		} else if (row.type == IPROTO_OK) {
+			break; /* end of shard */
+		} else if (iproto_type_is_error(row.type)) {
+			xrow_decode_error_xc(&row);  /* rethrow error */
+		} else {
+			tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+				  (uint32_t) row.type);
+		}
+	}
+	shard->is_done = true;
+}
+
+/**
+ * A fiber fetching snapshot shards over its own connection to
+ * the master until there are no shards left. Reconnects and
+ * resumes the current shard on network errors.
+ */
+static int
+applier_fetch_f(va_list ap)
+{
+	struct applier_fetch *fetch = va_arg(ap, struct applier_fetch *);
+	struct applier *applier = fetch->applier;
+	auto exit_guard = make_scoped_guard([=] {
+		if (--fetch->fiber_count == 0)
+			fiber_cond_signal(&fetch->cond);
+	});
+	struct applier *conn = NULL;
+	struct session *session = session_create_on_demand();
+	if (session == NULL || (conn = applier_new(applier->source)) == NULL) {
+		if (diag_is_empty(&fetch->diag))
+			diag_move(diag_get(), &fetch->diag);
+		return 0;
+	}
+	session_set_type(session, SESSION_TYPE_APPLIER);
+	auto conn_guard = make_scoped_guard([=] {
+		coio_close(loop(), &conn->io);
+		applier_delete(conn);
+	});
+
+	while (fetch->next_shard < fetch->end_shard &&
+	       diag_is_empty(&fetch->diag)) {
+		uint32_t shard_id = fetch->next_shard++;
+		while (!applier->join_shards[shard_id].is_done) {
+			try {
+				applier_connect(conn);
+				applier_fetch_shard(fetch, conn, shard_id);
+				break;
+			} catch (SocketError *e) {
+				applier_log_error(conn, e);
+			} catch (SystemError *e) {
+				applier_log_error(conn, e);
+			} catch (Exception *e) {
+				/* Let applier_fetch_shards() stop the rest. */
+				if (diag_is_empty(&fetch->diag))
+					diag_move(diag_get(), &fetch->diag);
+				fiber_cond_signal(&fetch->cond);
+				return 0;
+			}
+			/* See the comment to fiber_sleep() in applier_f(). */
+			coio_close(loop(), &conn->io);
+			ibuf_reinit(&conn->ibuf);
+			fiber_sleep(replication_reconnect_interval());
+			if (fiber_is_cancelled())
+				return 0;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Fetch the given range of snapshot shards over at most
+ * replication_join_connections extra connections.
+ */
+static void
+applier_fetch_shards(struct applier *applier, uint32_t begin, uint32_t end,
+		     uint64_t *row_count)
+{
+	if (begin >= end)
+		return;
+	struct applier_fetch fetch;
+	fetch.applier = applier;
+	fetch.next_shard = begin;
+	fetch.end_shard = end;
+	fetch.fiber_count = 0;
+	fetch.row_count = row_count;
+	fiber_cond_create(&fetch.cond);
+	diag_create(&fetch.diag);
+
+	/*
+	 * The option may have been reset since JOIN was sent,
+	 * still the snapshot has to be fetched.
+	 */
+	int fiber_count = MIN((uint32_t)MAX(replication_join_connections, 1),
+			      end - begin);
+	struct fiber **fibers = (struct fiber **)
+		calloc(fiber_count, sizeof(*fibers));
+	if (fibers == NULL) {
+		tnt_raise(OutOfMemory, sizeof(*fibers) * fiber_count,
+			  "malloc", "fibers");
+	}
+	auto guard = make_scoped_guard([&] {
+		/*
+		 * Stop the fibers if we are cancelled or one of
+		 * them has failed.
+		 */
+		for (int i = 0; i < fiber_count && fibers[i] != NULL; i++) {
+			fiber_cancel(fibers[i]);
+			fiber_join(fibers[i]);
+		}
+		free(fibers);
+		fiber_cond_destroy(&fetch.cond);
+		diag_destroy(&fetch.diag);
+	});
+
+	char name[FIBER_NAME_MAX];
+	for (int i = 0; i < fiber_count; i++) {
+		snprintf(name, sizeof(name), "applier_fetch/%d", i);
+		struct fiber *f = fiber_new_xc(name, applier_fetch_f);
+		fiber_set_joinable(f, true);
+		fibers[i] = f;
+		fetch.fiber_count++;
+		fiber_start(f, &fetch);
+	}
+	while (fetch.fiber_count > 0 && diag_is_empty(&fetch.diag)) {
+		fiber_cond_wait(&fetch.cond);
+		fiber_testcancel();
+	}
+	if (!diag_is_empty(&fetch.diag)) {
+		diag_move(&fetch.diag, diag_get());
+		diag_raise();
+	}
+}
+
+/**
+ * Fetch the memtx snapshot from the master over extra
+ * connections, shard 0 with system spaces first, then the
+ * rest in parallel. On success, tell the master to proceed
+ * with the rest of initial data over the JOIN connection.
+ */
+static void
+applier_fetch_snapshot(struct applier *applier, uint32_t shard_count,
+		       uint64_t *row_count)
+{
+	if (applier->join_shards != NULL) {
+		/*
+		 * JOIN has been interrupted and restarted. Resume
+		 * the fetch unless the master is going to send
+		 * a different snapshot or has already sent rows
+		 * that can't be sent again.
+		 */
+		if (applier->join_is_fetched ||
+		    applier->join_shard_count != shard_count ||
+		    vclock_compare(&applier->join_vclock,
+				   &replicaset.vclock) != 0) {
+			tnt_raise(ClientError, ER_PROTOCOL,
+				  "can't resume initial join: "
+				  "the master's snapshot has changed");
+		}
+		say_info("resuming snapshot fetch");
+	} else {
+		size_t size = sizeof(*applier->join_shards) * shard_count;
+		applier->join_shards = (struct applier_join_shard *)
+			calloc(1, size);
+		if (applier->join_shards == NULL) {
+			tnt_raise(OutOfMemory, size, "malloc",
+				  "struct applier_join_shard");
+		}
+		applier->join_shard_count = shard_count;
+		vclock_copy(&applier->join_vclock, &replicaset.vclock);
+	}
+	say_info("fetching %u snapshot shards over %d connections",
+		 (unsigned)shard_count, replication_join_connections);
+
+	applier_fetch_shards(applier, 0, 1, row_count);
+	applier_fetch_shards(applier, 1, shard_count, row_count);
+
+	/* Let the master proceed with the rest of initial data. */
+	struct xrow_header row;
+	xrow_encode_vclock_xc(&row, &replicaset.vclock);
+	coio_write_xrow(&applier->io, &row);
+	applier->join_is_fetched = true;
+	say_info("snapshot fetched");
+}
+
 /**
  * Execute and process JOIN request (bootstrap the instance).
  */
@@ -325,8 +568,10 @@ applier_join(struct applier *applier)
 	struct ev_io *coio = &applier->io;
 	struct ibuf *ibuf = &applier->ibuf;
 	struct xrow_header row;
-	xrow_encode_join_xc(&row, &INSTANCE_UUID);
+	xrow_encode_join_xc(&row, &INSTANCE_UUID,
+			    replication_join_connections);
 	coio_write_xrow(coio, &row);
+	uint32_t shard_count = 0;
 
 	/**
 	 * Tarantool < 1.7.0: if JOIN is successful, there is no "OK"
@@ -346,8 +591,13 @@ applier_join(struct applier *applier)
 		 * the master is sending to the replica.
 		 * Used to initialize the replica's initial
 		 * vclock in bootstrap_from_master()
+		 *
+		 * If the master supports fetching the snapshot
+		 * over extra connections, it also sends the
+		 * number of snapshot shards.
 		 */
-		xrow_decode_vclock_xc(&row, &replicaset.vclock);
+		xrow_decode_join_response_xc(&row, &replicaset.vclock,
+					     &shard_count);
 	}
 
 	applier_set_state(applier, APPLIER_INITIAL_JOIN);
@@ -356,6 +606,8 @@ applier_join(struct applier *applier)
 	 * Receive initial data.
 	 */
 	uint64_t row_count = 0;
+	if (shard_count > 0)
+		applier_fetch_snapshot(applier, shard_count, &row_count);
 	while (true) {
 		coio_read_xrow(coio, ibuf, &row);
 		applier->last_row_time = ev_monotonic_now(loop());
@@ -422,6 +674,8 @@ applier_join(struct applier *applier)
 	}
 	say_info("final data received");
 
+	free(applier->join_shards);
+	applier->join_shards = NULL;
 	applier_set_state(applier, APPLIER_JOINED);
 	applier_set_state(applier, APPLIER_READY);
 }
@@ -436,14 +690,253 @@ struct applier_tx_row {
 	struct xrow_header row;
 };
 
+enum {
+	/**
+	 * Size of the table used for tracking conflicts between
+	 * queued transactions. Primary keys touched by a
+	 * transaction are hashed to slots of the table, so a
+	 * hash collision results in a false dependency, which
+	 * is harmless.
+	 */
+	APPLIER_KEY_SLOTS = 4096,
+};
+
+/**
+ * A transaction received from the master and queued for
+ * applying. Each queued transaction is applied by its own
+ * fiber. Transactions are submitted to WAL strictly in the
+ * order they were received, but a transaction may be executed
+ * before its turn as soon as all transactions touching the
+ * same keys have been applied.
+ */
+struct applier_tx {
+	/** Link in applier_queue::txs. */
+	struct rlist in_queue;
+	/** Applier that received the transaction. */
+	struct applier *applier;
+	/** Memory for the rows and the dependency tracking. */
+	struct region region;
+	/** Transaction rows, linked by applier_tx_row::next. */
+	struct stailq rows;
+	/** Position of the transaction in the queue. */
+	int64_t seq;
+	/** Id of the replica the transaction originates from. */
+	uint32_t replica_id;
+	/** LSN of the last row of the transaction. */
+	int64_t lsn;
+	/** LSN of the replica preceding the transaction. */
+	int64_t prev_lsn;
+	/** Slots of the primary keys touched by the transaction. */
+	uint32_t *slots;
+	/** Number of entries in the slots array. */
+	uint32_t slot_count;
+	/** Memory for dependency records, see applier_tx_add_dep(). */
+	struct applier_tx_dep *deps;
+	/** Number of used entries in the deps array. */
+	uint32_t dep_used;
+	/** Number of queued transactions this one depends on. */
+	int dep_count;
+	/** Records of queued transactions that depend on this one. */
+	struct stailq dependents;
+	/**
+	 * Set if the transaction may have effects beyond the
+	 * primary keys it touches, e.g. if it changes the data
+	 * dictionary. Such a transaction is applied after all
+	 * transactions received before it have been written to
+	 * WAL while all transactions received after it wait for
+	 * it to be applied.
+	 */
+	bool is_barrier;
+	/** Set if the transaction may be committed asynchronously. */
+	bool is_async;
+	/** Set if the transaction has started being applied. */
+	bool is_started;
+	/**
+	 * Set if a transaction received before this one by the
+	 * same applier failed to apply, so this one must be
+	 * skipped. It will be received again after reconnect.
+	 */
+	bool is_cancelled;
+};
+
+/** A record of dependency between two queued transactions. */
+struct applier_tx_dep {
+	/** Link in applier_tx::dependents. */
+	struct stailq_entry link;
+	/** The dependent transaction. */
+	struct applier_tx *tx;
+};
+
+/**
+ * Transactions received by all appliers and not submitted to
+ * WAL yet, in the order they were received.
+ */
+static struct applier_queue {
+	/** Queued transactions, linked by applier_tx::in_queue. */
+	struct rlist txs;
+	/** Sequence number of the next queued transaction. */
+	int64_t next_seq;
+	/** Sequence number of the next transaction to submit. */
+	int64_t submit_seq;
+	/** Number of queued transactions not written to WAL yet. */
+	int size;
+	/** Max size of the queue. */
+	int concurrency;
+	/** Number of transactions submitted to WAL, not written yet. */
+	int wal_count;
+	/** The last queued barrier transaction or NULL. */
+	struct applier_tx *barrier;
+	/** The last queued transaction touching a key, by key slot. */
+	struct applier_tx *tx_by_key[APPLIER_KEY_SLOTS];
+	/**
+	 * LSN of the last queued transaction of each replica.
+	 * In a full mesh topology, the same set of changes may
+	 * arrive via two concurrently running appliers, hence
+	 * an applier doesn't queue a transaction until all
+	 * transactions of the same replica queued by other
+	 * appliers have been applied.
+	 */
+	int64_t lsn[VCLOCK_MAX];
+	/** Signaled whenever the queue state changes. */
+	struct fiber_cond cond;
+} applier_queue;
+
+void
+applier_init(void)
+{
+	memset(&applier_queue, 0, sizeof(applier_queue));
+	rlist_create(&applier_queue.txs);
+	applier_queue.concurrency = 1;
+	fiber_cond_create(&applier_queue.cond);
+}
+
+void
+applier_set_apply_concurrency(int concurrency)
+{
+	applier_queue.concurrency = concurrency;
+	fiber_cond_broadcast(&applier_queue.cond);
+}
+
+static struct applier_tx *
+applier_tx_new(struct applier *applier)
+{
+	struct applier_tx *tx = (struct applier_tx *)
+		calloc(1, sizeof(struct applier_tx));
+	if (tx == NULL)
+		tnt_raise(OutOfMemory, sizeof(struct applier_tx),
+			  "malloc", "struct applier_tx");
+	rlist_create(&tx->in_queue);
+	tx->applier = applier;
+	region_create(&tx->region, &cord()->slabc);
+	stailq_create(&tx->rows);
+	stailq_create(&tx->dependents);
+	tx->is_async = true;
+	return tx;
+}
+
+static void
+applier_tx_delete(struct applier_tx *tx)
+{
+	region_destroy(&tx->region);
+	free(tx);
+}
+
+/**
+ * Decompress a batch of rows received from the master to
+ * the applier frame buffer, see IPROTO_COMPRESSED_ROWS.
+ */
+static void
+applier_decompress_rows(struct applier *applier, struct xrow_header *row)
+{
+	const char *zdata = NULL;
+	uint32_t zsize = 0;
+	if (row->bodycnt == 1) {
+		const char *data = (const char *) row->body[0].iov_base;
+		const char *end = data + row->body[0].iov_len;
+		const char *d = data;
+		if (mp_check(&d, end) == 0 && mp_typeof(*data) == MP_MAP) {
+			d = data;
+			uint32_t map_size = mp_decode_map(&d);
+			for (uint32_t i = 0; i < map_size; i++) {
+				if (mp_typeof(*d) != MP_UINT) {
+					mp_next(&d); /* key */
+					mp_next(&d); /* value */
+					continue;
+				}
+				uint64_t key = mp_decode_uint(&d);
+				if (key == IPROTO_FRAME &&
+				    mp_typeof(*d) == MP_BIN) {
+					zdata = mp_decode_bin(&d, &zsize);
+					break;
+				}
+				mp_next(&d); /* value */
+			}
+		}
+	}
+	if (zdata == NULL) {
+		tnt_raise(ClientError, ER_INVALID_MSGPACK,
+			  "compressed rows");
+	}
+	unsigned long long size = ZSTD_getFrameContentSize(zdata, zsize);
+	if (size == ZSTD_CONTENTSIZE_UNKNOWN ||
+	    size == ZSTD_CONTENTSIZE_ERROR || size > SIZE_MAX)
+		tnt_raise(ClientError, ER_DECOMPRESSION, "invalid frame size");
+	if (applier->zdctx == NULL) {
+		applier->zdctx = ZSTD_createDCtx();
+		if (applier->zdctx == NULL)
+			tnt_raise(OutOfMemory, 0, "ZSTD_createDCtx", "zdctx");
+	}
+	struct ibuf *frame = &applier->frame;
+	ibuf_reset(frame);
+	char *buf = (char *) ibuf_reserve_xc(frame, size);
+	size_t rc = ZSTD_decompressDCtx(applier->zdctx, buf, size,
+					zdata, zsize);
+	if (ZSTD_isError(rc)) {
+		ibuf_reset(frame);
+		tnt_raise(ClientError, ER_DECOMPRESSION,
+			  ZSTD_getErrorName(rc));
+	}
+	if (rc != size) {
+		ibuf_reset(frame);
+		tnt_raise(ClientError, ER_DECOMPRESSION, "size mismatch");
+	}
+	frame->wpos += size;
+	applier->compression_raw_size += size;
+	applier->compression_zsize += zsize;
+}
+
+/**
+ * Decode the next row of the last compressed batch. The row
+ * body points to the frame buffer, which is reused for the
+ * next batch, so the caller has to copy it.
+ */
+static void
+applier_read_frame_row(struct applier *applier, struct xrow_header *row)
+{
+	struct ibuf *frame = &applier->frame;
+	const char *pos = frame->rpos;
+	if (mp_typeof(*pos) != MP_UINT ||
+	    mp_check_uint(pos, frame->wpos) > 0) {
+		ibuf_reset(frame);
+		tnt_raise(ClientError, ER_INVALID_MSGPACK, "packet length");
+	}
+	uint64_t len = mp_decode_uint(&pos);
+	if (len > (uint64_t) (frame->wpos - pos)) {
+		ibuf_reset(frame);
+		tnt_raise(ClientError, ER_INVALID_MSGPACK, "packet length");
+	}
+	frame->rpos = (char *) pos + len;
+	xrow_header_decode_xc(row, &pos, pos + len, true);
+}
+
 static struct applier_tx_row *
-applier_read_tx_row(struct applier *applier)
+applier_read_tx_row(struct applier *applier, struct region *region)
 {
 	struct ev_io *coio = &applier->io;
 	struct ibuf *ibuf = &applier->ibuf;
 
 	struct applier_tx_row *tx_row = (struct applier_tx_row *)
-		region_alloc(&fiber()->gc, sizeof(struct applier_tx_row));
+		region_alloc(region, sizeof(struct applier_tx_row));
 
 	if (tx_row == NULL)
 		tnt_raise(OutOfMemory, sizeof(struct applier_tx_row),
@@ -452,17 +945,23 @@ applier_read_tx_row(struct applier *applier)
 	struct xrow_header *row = &tx_row->row;
 
 	double timeout = replication_disconnect_timeout();
-	/*
-	 * Tarantool < 1.7.7 does not send periodic heartbeat
-	 * messages so we can't assume that if we haven't heard
-	 * from the master for quite a while the connection is
-	 * broken - the master might just be idle.
-	 */
-	if (applier->version_id < version_id(1, 7, 7))
-		coio_read_xrow(coio, ibuf, row);
-	else
-		coio_read_xrow_timeout_xc(coio, ibuf, row, timeout);
-
+	while (ibuf_used(&applier->frame) == 0) {
+		/*
+		 * Tarantool < 1.7.7 does not send periodic heartbeat
+		 * messages so we can't assume that if we haven't heard
+		 * from the master for quite a while the connection is
+		 * broken - the master might just be idle.
+		 */
+		if (applier->version_id < version_id(1, 7, 7))
+			coio_read_xrow(coio, ibuf, row);
+		else
+			coio_read_xrow_timeout_xc(coio, ibuf, row, timeout);
+		if (row->type != IPROTO_COMPRESSED_ROWS)
+			goto done;
+		applier_decompress_rows(applier, row);
+	}
+	applier_read_frame_row(applier, row);
+done:
 	applier->lag = ev_now(loop()) - row->tm;
 	applier->last_row_time = ev_monotonic_now(loop());
 	return tx_row;
@@ -470,19 +969,21 @@ applier_read_tx_row(struct applier *applier)
 
 /**
  * Read one transaction from network using applier's input buffer.
- * Transaction rows are placed onto fiber gc region.
+ * Transaction rows are placed onto the transaction region.
  * We could not use applier input buffer to store rows because
  * rpos is adjusted as xrow is decoded and the corresponding
- * network input space is reused for the next xrow.
+ * network input space is reused for the next xrow, while the
+ * transaction is applied by a separate fiber.
  */
 static void
-applier_read_tx(struct applier *applier, struct stailq *rows)
+applier_read_tx(struct applier *applier, struct applier_tx *tx)
 {
+	struct stailq *rows = &tx->rows;
 	int64_t tsn = 0;
 
-	stailq_create(rows);
 	do {
-		struct applier_tx_row *tx_row = applier_read_tx_row(applier);
+		struct applier_tx_row *tx_row =
+			applier_read_tx_row(applier, &tx->region);
 		struct xrow_header *row = &tx_row->row;
 
 		if (iproto_type_is_error(row->type))
@@ -517,15 +1018,9 @@ applier_read_tx(struct applier *applier, struct stailq *rows)
 				  "interleaving transactions");
 
 		assert(row->bodycnt <= 1);
-		if (row->bodycnt == 1 && !row->is_commit) {
-			/*
-			 * Save row body to gc region.
-			 * Not done for single-statement
-			 * transactions knowing that the input
-			 * buffer will not be used while the
-			 * transaction is applied.
-			 */
-			void *new_base = region_alloc(&fiber()->gc,
+		if (row->bodycnt == 1) {
+			/* Save row body to the transaction region. */
+			void *new_base = region_alloc(&tx->region,
 						      row->body->iov_len);
 			if (new_base == NULL)
 				tnt_raise(OutOfMemory, row->body->iov_len,
@@ -536,18 +1031,265 @@ applier_read_tx(struct applier *applier, struct stailq *rows)
 			row->body->iov_base = new_base;
 		}
 		stailq_add_tail(rows, &tx_row->next);
+		tx->replica_id = row->replica_id;
+		tx->lsn = row->lsn;
 
 	} while (!stailq_last_entry(rows, struct applier_tx_row,
 				    next)->row.is_commit);
 }
 
 /**
- * Apply all rows in the rows queue as a single transaction.
- *
- * Return 0 for success or -1 in case of an error.
+ * Find the slot of the primary key touched by a row and add
+ * it to the transaction. Return -1 if the row may have effects
+ * beyond its primary key, so the transaction must be applied
+ * as a barrier.
  */
 static int
-applier_apply_tx(struct stailq *rows)
+applier_tx_add_row(struct applier_tx *tx, struct xrow_header *row)
+{
+	struct request request;
+	if (xrow_decode_dml(row, &request, dml_request_key_map(row->type)) != 0)
+		return -1;
+	if (request.type == IPROTO_NOP)
+		return 0;
+	struct space *space = space_by_id(request.space_id);
+	if (space == NULL || space->index_count == 0 ||
+	    (space_is_system(space) &&
+	     space->def->id != BOX_SEQUENCE_DATA_ID))
+		return -1;
+	/*
+	 * Triggers and foreign keys may touch other spaces while
+	 * unique secondary keys may conflict for different
+	 * primary keys.
+	 */
+	if (!rlist_empty(&space->before_replace) ||
+	    !rlist_empty(&space->on_replace) ||
+	    space->sql_triggers != NULL ||
+	    !rlist_empty(&space->parent_fk_constraint) ||
+	    !rlist_empty(&space->child_fk_constraint))
+		return -1;
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		if (space->index[i]->def->opts.is_unique)
+			return -1;
+	}
+	struct key_def *key_def = space->index[0]->def->key_def;
+	const char *key;
+	switch (request.type) {
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPSERT:
+		if (space->format == NULL ||
+		    tuple_validate_raw(space->format, request.tuple) != 0)
+			return -1;
+		key = tuple_extract_key_raw(request.tuple, request.tuple_end,
+					    key_def, MULTIKEY_NONE, NULL);
+		if (key == NULL)
+			return -1;
+		break;
+	case IPROTO_DELETE:
+	case IPROTO_UPDATE:
+		if (request.index_id != 0)
+			return -1;
+		key = request.key;
+		break;
+	default:
+		return -1;
+	}
+	uint32_t part_count = mp_decode_array(&key);
+	if (exact_key_validate(key_def, key, part_count) != 0)
+		return -1;
+	if ((space->engine->flags & ENGINE_SUPPORTS_ASYNC_COMMIT) == 0)
+		tx->is_async = false;
+	uint32_t hash = key_hash(key, key_def) ^ space->def->id * 2654435761U;
+	tx->slots[tx->slot_count++] = hash % APPLIER_KEY_SLOTS;
+	return 0;
+}
+
+/**
+ * Collect slots of the primary keys touched by a transaction
+ * and find out whether it must be applied as a barrier.
+ */
+static void
+applier_tx_classify(struct applier_tx *tx)
+{
+	uint32_t row_count = 0;
+	struct applier_tx_row *item;
+	stailq_foreach_entry(item, &tx->rows, next)
+		row_count++;
+	size_t size = row_count * sizeof(*tx->slots);
+	tx->slots = (uint32_t *)region_alloc(&tx->region, size);
+	if (tx->slots == NULL)
+		tnt_raise(OutOfMemory, size, "region", "key slots");
+	/* A transaction depends on a barrier and a transaction per key. */
+	size = (row_count + 1) * sizeof(*tx->deps);
+	tx->deps = (struct applier_tx_dep *)region_alloc(&tx->region, size);
+	if (tx->deps == NULL)
+		tnt_raise(OutOfMemory, size, "region", "dependencies");
+	stailq_foreach_entry(item, &tx->rows, next) {
+		if (applier_tx_add_row(tx, &item->row) != 0) {
+			tx->is_barrier = true;
+			tx->slot_count = 0;
+			break;
+		}
+	}
+	/* Errors are not fatal here, they only make a barrier. */
+	diag_clear(diag_get());
+}
+
+/**
+ * Make a transaction wait for a queued transaction received
+ * before it to be applied.
+ */
+static void
+applier_tx_add_dep(struct applier_tx *tx, struct applier_tx *prev)
+{
+	if (prev == NULL || prev == tx)
+		return;
+	/* Dependencies are added in a row, skip duplicates. */
+	if (!stailq_empty(&prev->dependents) &&
+	    stailq_last_entry(&prev->dependents, struct applier_tx_dep,
+			      link)->tx == tx)
+		return;
+	assert(tx->dep_used <= tx->slot_count);
+	struct applier_tx_dep *dep = &tx->deps[tx->dep_used++];
+	dep->tx = tx;
+	stailq_add_tail(&prev->dependents, &dep->link);
+	tx->dep_count++;
+}
+
+/**
+ * Wake up transactions that depend on a transaction that has
+ * been submitted to WAL and remove it from the queue.
+ */
+static void
+applier_tx_release(struct applier_tx *tx)
+{
+	struct applier_queue *queue = &applier_queue;
+	struct applier_tx_dep *dep;
+	stailq_foreach_entry(dep, &tx->dependents, link) {
+		assert(dep->tx->dep_count > 0);
+		dep->tx->dep_count--;
+	}
+	for (uint32_t i = 0; i < tx->slot_count; i++) {
+		if (queue->tx_by_key[tx->slots[i]] == tx)
+			queue->tx_by_key[tx->slots[i]] = NULL;
+	}
+	if (queue->barrier == tx)
+		queue->barrier = NULL;
+	rlist_del_entry(tx, in_queue);
+	fiber_cond_broadcast(&queue->cond);
+}
+
+/**
+ * Account a transaction that has started being applied.
+ */
+static void
+applier_tx_start(struct applier_tx *tx)
+{
+	if (tx->is_started)
+		return;
+	tx->is_started = true;
+	assert(tx->applier->apply_queue > 0);
+	tx->applier->apply_queue--;
+	tx->applier->apply_parallelism++;
+}
+
+/**
+ * Account a transaction of an applier that has been written
+ * to WAL, failed or skipped.
+ */
+static void
+applier_complete_tx(struct applier *applier)
+{
+	struct applier_queue *queue = &applier_queue;
+	assert(applier->apply_parallelism > 0);
+	applier->apply_parallelism--;
+	assert(queue->size > 0);
+	queue->size--;
+	/* Report the new vclock to the master. */
+	if (applier->state == APPLIER_SYNC ||
+	    applier->state == APPLIER_FOLLOW)
+		fiber_cond_signal(&applier->writer_cond);
+	fiber_cond_broadcast(&queue->cond);
+}
+
+/**
+ * Handle a failure to apply a transaction received by an
+ * applier: skip all transactions queued after it by the same
+ * applier and let the reader fiber raise the error.
+ */
+static void
+applier_fail_tx(struct applier *applier, uint32_t replica_id,
+		int64_t prev_lsn, struct error *e)
+{
+	struct applier_queue *queue = &applier_queue;
+	if (diag_is_empty(&applier->diag)) {
+		diag_add_error(&applier->diag, e);
+		/*
+		 * Stop the reader right away rather than when it
+		 * receives the next transaction, which may take
+		 * long. A reader applying the transaction itself
+		 * raises the error on its own.
+		 */
+		if (applier->is_subscribed && applier->reader != fiber())
+			fiber_cancel(applier->reader);
+	}
+	queue->lsn[replica_id] = MIN(queue->lsn[replica_id], prev_lsn);
+	struct applier_tx *tx;
+	rlist_foreach_entry(tx, &queue->txs, in_queue) {
+		if (tx->applier != applier || tx->is_cancelled)
+			continue;
+		tx->is_cancelled = true;
+		queue->lsn[tx->replica_id] = MIN(queue->lsn[tx->replica_id],
+						 tx->prev_lsn);
+	}
+	applier_complete_tx(applier);
+}
+
+/**
+ * Triggers of an asynchronously committed transaction.
+ */
+struct applier_commit_triggers {
+	struct trigger on_commit;
+	struct trigger on_rollback;
+	struct applier *applier;
+	uint32_t replica_id;
+	int64_t prev_lsn;
+};
+
+static void
+applier_on_commit_f(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct applier_commit_triggers *triggers =
+		(struct applier_commit_triggers *)trigger->data;
+	assert(applier_queue.wal_count > 0);
+	applier_queue.wal_count--;
+	applier_complete_tx(triggers->applier);
+}
+
+static void
+applier_on_rollback_f(struct trigger *trigger, void *event)
+{
+	(void) event;
+	struct applier_commit_triggers *triggers =
+		(struct applier_commit_triggers *)trigger->data;
+	assert(applier_queue.wal_count > 0);
+	applier_queue.wal_count--;
+	applier_fail_tx(triggers->applier, triggers->replica_id,
+			triggers->prev_lsn,
+			BuildClientError(__FILE__, __LINE__, ER_WAL_IO));
+}
+
+/**
+ * Begin a transaction and apply all rows of a received
+ * transaction in it.
+ *
+ * Return the transaction, ready to be committed, or NULL
+ * in case of an error.
+ */
+static struct txn *
+applier_tx_execute(struct applier_tx *tx)
 {
 	/**
 	 * Explicitly begin the transaction so that we can
@@ -558,8 +1300,8 @@ applier_apply_tx(struct stailq *rows)
 	struct txn *txn = txn_begin(false);
 	struct applier_tx_row *item;
 	if (txn == NULL)
-		diag_raise();
-	stailq_foreach_entry(item, rows, next) {
+		return NULL;
+	stailq_foreach_entry(item, &tx->rows, next) {
 		struct xrow_header *row = &item->row;
 		int res = apply_row(row);
 		if (res != 0) {
@@ -599,11 +1341,230 @@ applier_apply_tx(struct stailq *rows)
 			 "Replication", "distributed transactions");
 		goto rollback;
 	}
-	return txn_commit(txn);
+	return txn;
 
 rollback:
 	txn_rollback();
-	return -1;
+	return NULL;
+}
+
+/**
+ * Commit an applied transaction without waiting for WAL.
+ * The transaction is accounted as complete by its triggers.
+ */
+static void
+applier_tx_commit_async(struct applier_tx *tx, struct txn *txn)
+{
+	struct applier_commit_triggers *triggers =
+		(struct applier_commit_triggers *)
+		region_alloc(&txn->region, sizeof(*triggers));
+	if (triggers == NULL) {
+		diag_set(OutOfMemory, sizeof(*triggers),
+			 "region", "struct applier_commit_triggers");
+		txn_rollback();
+		applier_fail_tx(tx->applier, tx->replica_id, tx->prev_lsn,
+				diag_last_error(diag_get()));
+		return;
+	}
+	triggers->applier = tx->applier;
+	triggers->replica_id = tx->replica_id;
+	triggers->prev_lsn = tx->prev_lsn;
+	trigger_create(&triggers->on_commit, applier_on_commit_f,
+		       triggers, NULL);
+	trigger_create(&triggers->on_rollback, applier_on_rollback_f,
+		       triggers, NULL);
+	txn_on_commit(txn, &triggers->on_commit);
+	txn_on_rollback(txn, &triggers->on_rollback);
+	applier_queue.wal_count++;
+	/* Errors are handled by the rollback trigger. */
+	txn_commit_async(txn);
+}
+
+/**
+ * Apply a queued transaction and submit it to WAL at its turn.
+ */
+static void
+applier_tx_apply(struct applier_tx *tx)
+{
+	struct applier_queue *queue = &applier_queue;
+	while (tx->dep_count > 0)
+		fiber_cond_wait(&queue->cond);
+
+	struct txn *txn = NULL;
+	bool is_executed_early = false;
+	if (!tx->is_async && !tx->is_barrier && !tx->is_cancelled) {
+		/*
+		 * The engine may yield while executing the
+		 * transaction, so execute it concurrently with
+		 * other transactions, as soon as all transactions
+		 * touching the same keys have been applied.
+		 * Whatever goes wrong is retried at the turn.
+		 */
+		applier_tx_start(tx);
+		txn = applier_tx_execute(tx);
+		if (txn == NULL)
+			diag_clear(diag_get());
+		is_executed_early = true;
+	}
+	while (queue->submit_seq != tx->seq ||
+	       (tx->is_barrier && queue->wal_count > 0))
+		fiber_cond_wait(&queue->cond);
+
+	applier_tx_start(tx);
+	if (tx->is_cancelled) {
+		if (txn != NULL)
+			txn_rollback();
+		applier_complete_tx(tx->applier);
+		goto done;
+	}
+	if (txn == NULL && (txn = applier_tx_execute(tx)) == NULL)
+		goto fail;
+	if (tx->is_async && !tx->is_barrier) {
+		/*
+		 * Transactions committed asynchronously don't
+		 * wait for WAL, so that their WAL writes are
+		 * batched.
+		 */
+		applier_tx_commit_async(tx, txn);
+		goto done;
+	}
+	if (txn_commit(txn) != 0) {
+		struct error *e = diag_last_error(diag_get());
+		/*
+		 * A transaction executed before its turn may
+		 * conflict with one applied in between.
+		 */
+		if (!is_executed_early ||
+		    box_error_code(e) != ER_TRANSACTION_CONFLICT)
+			goto fail;
+		diag_clear(diag_get());
+		if ((txn = applier_tx_execute(tx)) == NULL ||
+		    txn_commit(txn) != 0)
+			goto fail;
+	}
+	applier_complete_tx(tx->applier);
+	goto done;
+fail:
+	applier_fail_tx(tx->applier, tx->replica_id, tx->prev_lsn,
+			diag_last_error(diag_get()));
+done:
+	queue->submit_seq++;
+	fiber_cond_broadcast(&queue->cond);
+}
+
+static int
+applier_tx_f(va_list ap)
+{
+	struct applier_tx *tx = va_arg(ap, struct applier_tx *);
+	struct session *session = va_arg(ap, struct session *);
+	/* Apply the transaction on behalf of the applier session. */
+	fiber_set_session(fiber(), session);
+	fiber_set_user(fiber(), &session->credentials);
+	applier_tx_apply(tx);
+	applier_tx_release(tx);
+	applier_tx_delete(tx);
+	return 0;
+}
+
+/**
+ * Raise the error that happened while applying a transaction
+ * received by the applier, if any.
+ */
+static void
+applier_check_error(struct applier *applier)
+{
+	if (diag_is_empty(&applier->diag))
+		return;
+	diag_move(&applier->diag, diag_get());
+	diag_raise();
+}
+
+/**
+ * Queue a transaction received from the master for applying.
+ * Return true if the transaction has been handed over to a
+ * separate fiber, which takes care of freeing it, false if it
+ * has been applied by the caller or has already been applied
+ * and so must be skipped.
+ */
+static bool
+applier_queue_tx(struct applier *applier, struct applier_tx *tx)
+{
+	struct applier_queue *queue = &applier_queue;
+	uint32_t replica_id = tx->replica_id;
+	int64_t first_lsn = stailq_first_entry(&tx->rows,
+				struct applier_tx_row, next)->row.lsn;
+	while (true) {
+		applier_check_error(applier);
+		if (vclock_get(&replicaset.vclock, replica_id) >= first_lsn) {
+			if (applier->state == APPLIER_SYNC ||
+			    applier->state == APPLIER_FOLLOW)
+				fiber_cond_signal(&applier->writer_cond);
+			return false;
+		}
+		/*
+		 * Wait for transactions of the same replica queued
+		 * by other appliers and for room in the queue.
+		 */
+		if (queue->lsn[replica_id] < first_lsn &&
+		    queue->size < queue->concurrency)
+			break;
+		if (fiber_cond_wait(&queue->cond) != 0)
+			diag_raise();
+	}
+	applier_tx_classify(tx);
+	/*
+	 * Without concurrency, apply the transaction right in
+	 * the reader fiber and wait for WAL, as it used to be.
+	 */
+	bool is_inline = queue->concurrency == 1;
+	struct fiber *f = NULL;
+	if (is_inline)
+		tx->is_async = false;
+	else
+		f = fiber_new_xc("applier_tx", applier_tx_f);
+
+	tx->prev_lsn = MAX(vclock_get(&replicaset.vclock, replica_id),
+			   queue->lsn[replica_id]);
+	queue->lsn[replica_id] = tx->lsn;
+	tx->seq = queue->next_seq++;
+	applier_tx_add_dep(tx, queue->barrier);
+	if (tx->is_barrier)
+		queue->barrier = tx;
+	for (uint32_t i = 0; i < tx->slot_count; i++) {
+		uint32_t slot = tx->slots[i];
+		applier_tx_add_dep(tx, queue->tx_by_key[slot]);
+		queue->tx_by_key[slot] = tx;
+	}
+	rlist_add_tail_entry(&queue->txs, tx, in_queue);
+	queue->size++;
+	applier->apply_queue++;
+	if (is_inline) {
+		applier_tx_apply(tx);
+		applier_tx_release(tx);
+		applier_check_error(applier);
+		return false;
+	}
+	fiber_start(f, tx, fiber_get_session(fiber()));
+	return true;
+}
+
+/**
+ * Wait until all transactions received by the applier have
+ * been applied, because they refer to the applier.
+ */
+static void
+applier_drain(struct applier *applier)
+{
+	/* Preserve the error the applier stopped with. */
+	applier->is_subscribed = false;
+	struct diag diag;
+	diag_create(&diag);
+	diag_move(diag_get(), &diag);
+	bool cancellable = fiber_set_cancellable(false);
+	while (applier->apply_queue > 0 || applier->apply_parallelism > 0)
+		fiber_cond_wait(&applier_queue.cond);
+	fiber_set_cancellable(cancellable);
+	diag_move(&diag, diag_get());
 }
 
 /**
@@ -623,7 +1584,7 @@ applier_subscribe(struct applier *applier)
 	vclock_create(&vclock);
 	vclock_copy(&vclock, &replicaset.vclock);
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &vclock);
+				 &vclock, replication_compression);
 	coio_write_xrow(coio, &row);
 
 	/* Read SUBSCRIBE response */
@@ -709,6 +1670,11 @@ applier_subscribe(struct applier *applier)
 	}
 
 	applier->lag = TIMEOUT_INFINITY;
+	applier->compression_raw_size = 0;
+	applier->compression_zsize = 0;
+	/* Forget the error that stopped the previous subscription. */
+	diag_clear(&applier->diag);
+	applier->is_subscribed = true;
 
 	/*
 	 * Process a stream of rows from the binary log.
@@ -735,34 +1701,19 @@ applier_subscribe(struct applier *applier)
 			applier_set_state(applier, APPLIER_FOLLOW);
 		}
 
-		struct stailq rows;
-		applier_read_tx(applier, &rows);
-
-		struct xrow_header *first_row =
-			&stailq_first_entry(&rows, struct applier_tx_row,
-					    next)->row;
+		struct applier_tx *tx = applier_tx_new(applier);
+		auto tx_guard = make_scoped_guard([=] {
+			applier_tx_delete(tx);
+		});
+		applier_read_tx(applier, tx);
 		applier->last_row_time = ev_monotonic_now(loop());
-		struct replica *replica = replica_by_id(first_row->replica_id);
-		struct latch *latch = (replica ? &replica->order_latch :
-				       &replicaset.applier.order_latch);
 		/*
-		 * In a full mesh topology, the same set of changes
-		 * may arrive via two concurrently running appliers.
-		 * Hence we need a latch to strictly order all changes
-		 * that belong to the same server id.
+		 * The transaction may be applied by a separate
+		 * fiber, which then takes care of freeing it.
 		 */
-		latch_lock(latch);
-		if (vclock_get(&replicaset.vclock, first_row->replica_id) <
-		    first_row->lsn &&
-		    applier_apply_tx(&rows) != 0) {
-			latch_unlock(latch);
-			diag_raise();
-		}
-		latch_unlock(latch);
+		if (applier_queue_tx(applier, tx))
+			tx_guard.is_active = false;
 
-		if (applier->state == APPLIER_SYNC ||
-		    applier->state == APPLIER_FOLLOW)
-			fiber_cond_signal(&applier->writer_cond);
 		if (ibuf_used(ibuf) == 0)
 			ibuf_reset(ibuf);
 		fiber_gc();
@@ -772,6 +1723,7 @@ applier_subscribe(struct applier *applier)
 static inline void
 applier_disconnect(struct applier *applier, enum applier_state state)
 {
+	applier_drain(applier);
 	applier_set_state(applier, state);
 	if (applier->writer != NULL) {
 		fiber_cancel(applier->writer);
@@ -782,6 +1734,7 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 	coio_close(loop(), &applier->io);
 	/* Clear all unparsed input. */
 	ibuf_reinit(&applier->ibuf);
+	ibuf_reinit(&applier->frame);
 	fiber_gc();
 }
 
@@ -847,6 +1800,17 @@ applier_f(va_list ap)
 				return -1;
 			}
 		} catch (FiberIsCancelled *e) {
+			if (!diag_is_empty(&applier->diag)) {
+				/*
+				 * A transaction failed to apply,
+				 * see applier_fail_tx().
+				 */
+				diag_move(&applier->diag, diag_get());
+				applier_log_error(applier,
+						  diag_last_error(diag_get()));
+				applier_disconnect(applier, APPLIER_STOPPED);
+				return -1;
+			}
 			applier_disconnect(applier, APPLIER_OFF);
 			break;
 		} catch (SocketError *e) {
@@ -923,6 +1887,7 @@ applier_new(const char *uri)
 	}
 	coio_create(&applier->io, -1);
 	ibuf_create(&applier->ibuf, &cord()->slabc, 1024);
+	ibuf_create(&applier->frame, &cord()->slabc, 1024);
 
 	/* uri_parse() sets pointers to applier->source buffer */
 	snprintf(applier->source, sizeof(applier->source), "%s", uri);
@@ -935,6 +1900,7 @@ applier_new(const char *uri)
 	rlist_create(&applier->on_state);
 	fiber_cond_create(&applier->resume_cond);
 	fiber_cond_create(&applier->writer_cond);
+	diag_create(&applier->diag);
 
 	return applier;
 }
@@ -944,10 +1910,15 @@ applier_delete(struct applier *applier)
 {
 	assert(applier->reader == NULL && applier->writer == NULL);
 	ibuf_destroy(&applier->ibuf);
+	ibuf_destroy(&applier->frame);
+	if (applier->zdctx != NULL)
+		ZSTD_freeDCtx(applier->zdctx);
+	free(applier->join_shards);
 	assert(applier->io.fd == -1);
 	trigger_destroy(&applier->on_state);
 	fiber_cond_destroy(&applier->resume_cond);
 	fiber_cond_destroy(&applier->writer_cond);
+	diag_destroy(&applier->diag);
 	free(applier);
 }
 
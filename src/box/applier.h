@@ -37,6 +37,7 @@
 
 #include <small/ibuf.h>
 
+#include "diag.h"
 #include "fiber_cond.h"
 #include "trigger.h"
 #include "trivia/util.h"
@@ -44,9 +45,12 @@
 #include "uri/uri.h"
 
 #include "xrow.h"
+#include "zstd.h"
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
+struct applier_join_shard;
+
 #define applier_STATE(_)                                             \
 	_(APPLIER_OFF, 0)                                            \
 	_(APPLIER_CONNECT, 1)                                        \
@@ -114,8 +118,69 @@ struct applier {
 	bool is_paused;
 	/** Condition variable signaled to resume the applier. */
 	struct fiber_cond resume_cond;
+	/**
+	 * Number of transactions received from the master that
+	 * wait for the transactions they depend on to be applied.
+	 */
+	int apply_queue;
+	/**
+	 * Number of transactions received from the master that
+	 * are being applied, i.e. executed or written to WAL.
+	 */
+	int apply_parallelism;
+	/**
+	 * Error that happened while applying a transaction
+	 * received from the master. It is raised by the reader
+	 * fiber, see applier_subscribe().
+	 */
+	struct diag diag;
+	/**
+	 * Set while the reader fiber is receiving transactions
+	 * from the master. A failure to apply a transaction
+	 * cancels the reader only then, see applier_fail_tx().
+	 */
+	bool is_subscribed;
+	/**
+	 * Rows of the last compressed batch received from the
+	 * master, see IPROTO_COMPRESSED_ROWS.
+	 */
+	struct ibuf frame;
+	/** Context used to decompress batches of rows. */
+	ZSTD_DCtx *zdctx;
+	/** Size of the rows received in compressed batches. */
+	size_t compression_raw_size;
+	/** Size of the compressed batches received. */
+	size_t compression_zsize;
+	/**
+	 * Vclock of the snapshot fetched from the master over
+	 * extra connections on initial join.
+	 */
+	struct vclock join_vclock;
+	/** Number of shards of the snapshot. */
+	uint32_t join_shard_count;
+	/**
+	 * Progress of fetching each shard of the snapshot. Kept
+	 * across reconnects so that an interrupted fetch can be
+	 * resumed. NULL unless the snapshot is being fetched.
+	 */
+	struct applier_join_shard *join_shards;
+	/** Set once the whole snapshot has been fetched. */
+	bool join_is_fetched;
 };
 
+/**
+ * Initialize the queue of transactions received by appliers.
+ */
+void
+applier_init(void);
+
+/**
+ * Set the max number of received transactions that can be
+ * applied concurrently, see replication_apply_concurrency.
+ */
+void
+applier_set_apply_concurrency(int concurrency);
+
 /**
  * Start a client to a remote master using a background fiber.
  *
@@ -130,6 +130,7 @@ static const struct space_vtab blackhole_space_vtab = {
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ generic_space_prepare_alter,
 	/* .invalidate = */ generic_space_invalidate,
+	/* .bulk_load = */ generic_space_bulk_load,
 };
 
 static void
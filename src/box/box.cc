@@ -70,10 +70,12 @@
 #include "path_lock.h"
 #include "gc.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
 #include "systemd.h"
 #include "call.h"
 #include "func.h"
 #include "sequence.h"
+#include "read_view.h"
 
 static char status[64] = "unknown";
 
@@ -288,7 +290,7 @@ recovery_journal_write(struct journal *base,
 static inline void
 recovery_journal_create(struct recovery_journal *journal, struct vclock *v)
 {
-	journal_create(&journal->base, recovery_journal_write, NULL);
+	journal_create(&journal->base, recovery_journal_write, NULL, NULL);
 	journal->vclock = v;
 }
 
@@ -438,6 +440,53 @@ box_check_replication_sync_lag(void)
 	return lag;
 }
 
+static int
+box_check_replication_apply_concurrency(void)
+{
+	int concurrency = cfg_geti("replication_apply_concurrency");
+	if (concurrency <= 0) {
+		tnt_raise(ClientError, ER_CFG, "replication_apply_concurrency",
+			  "the value must be greater than 0");
+	}
+	return concurrency;
+}
+
+static int
+box_check_replication_compression_frame_size(void)
+{
+	int size = cfg_geti("replication_compression_frame_size");
+	if (size <= 0) {
+		tnt_raise(ClientError, ER_CFG,
+			  "replication_compression_frame_size",
+			  "the value must be greater than 0");
+	}
+	return size;
+}
+
+static int
+box_check_replication_join_connections(void)
+{
+	int count = cfg_geti("replication_join_connections");
+	if (count < 0) {
+		tnt_raise(ClientError, ER_CFG,
+			  "replication_join_connections",
+			  "the value must be greater or equal to 0");
+	}
+	return count;
+}
+
+static double
+box_check_replication_compression_frame_delay(void)
+{
+	double delay = cfg_getd("replication_compression_frame_delay");
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG,
+			  "replication_compression_frame_delay",
+			  "the value must be greater or equal to 0");
+	}
+	return delay;
+}
+
 static double
 box_check_replication_sync_timeout(void)
 {
@@ -529,6 +578,122 @@ box_check_memtx_memory(int64_t memory)
 	return memory;
 }
 
+static int
+box_check_wal_spare_files(int spare_files)
+{
+	if (spare_files < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_spare_files",
+			  "must be greater than or equal to 0");
+	}
+	return spare_files;
+}
+
+static int64_t
+box_check_wal_tail_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_tail_size",
+			  "must be greater than or equal to 0");
+	}
+	return size;
+}
+
+static double
+box_check_wal_group_commit_delay(double delay)
+{
+	if (delay < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_delay",
+			  "must be greater than or equal to 0");
+	}
+	return delay;
+}
+
+static int64_t
+box_check_wal_group_commit_size(int64_t size)
+{
+	if (size <= 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_size",
+			  "must be greater than 0");
+	}
+	return size;
+}
+
+static int
+box_check_compression_level(const char *option_name, int level)
+{
+	if (level < 0 || level > XLOG_COMPRESSION_LEVEL_MAX) {
+		tnt_raise(ClientError, ER_CFG, option_name,
+			  tt_sprintf("must be between 0 and %d",
+				     XLOG_COMPRESSION_LEVEL_MAX));
+	}
+	return level;
+}
+
+static int
+box_check_wal_compression_threads(int threads)
+{
+	if (threads < 0 || threads > XLOG_COMPRESSION_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "wal_compression_threads",
+			  tt_sprintf("must be between 0 and %d",
+				     XLOG_COMPRESSION_THREADS_MAX));
+	}
+	return threads;
+}
+
+static int
+box_check_iproto_threads(int threads)
+{
+	if (threads < 1 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  tt_sprintf("must be between 1 and %d",
+				     IPROTO_THREADS_MAX));
+	}
+	return threads;
+}
+
+static int
+box_check_read_view_threads(int threads)
+{
+	if (threads < 0 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "read_view_threads",
+			  tt_sprintf("must be between 0 and %d",
+				     IPROTO_THREADS_MAX));
+	}
+	return threads;
+}
+
+static double
+box_check_read_view_staleness(void)
+{
+	double staleness = cfg_getd("read_view_staleness");
+	if (staleness <= 0) {
+		tnt_raise(ClientError, ER_CFG, "read_view_staleness",
+			  "the value must be greater than 0");
+	}
+	return staleness;
+}
+
+static int
+box_check_sql_cache_size(void)
+{
+	int size = cfg_geti("sql_cache_size");
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "sql_cache_size",
+			  "the value must not be negative");
+	}
+	return size;
+}
+
+static int
+box_check_memtx_checkpoint_threads(int threads)
+{
+	if (threads < 1) {
+		tnt_raise(ClientError, ER_CFG, "memtx_checkpoint_threads",
+			  "must be greater than or equal to 1");
+	}
+	return threads;
+}
+
 static int64_t
 box_check_vinyl_memory(int64_t memory)
 {
@@ -593,13 +758,33 @@ box_check_config()
 	box_check_replication_connect_quorum();
 	box_check_replication_sync_lag();
 	box_check_replication_sync_timeout();
+	box_check_replication_apply_concurrency();
+	box_check_compression_level("replication_compression_level",
+				    cfg_geti("replication_compression_level"));
+	box_check_replication_compression_frame_size();
+	box_check_replication_compression_frame_delay();
+	box_check_replication_join_connections();
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_threads(cfg_geti("iproto_threads"));
+	box_check_read_view_threads(cfg_geti("read_view_threads"));
+	box_check_read_view_staleness();
+	box_check_sql_cache_size();
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
 	box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_spare_files(cfg_geti("wal_spare_files"));
+	box_check_wal_tail_size(cfg_geti64("wal_tail_size"));
+	box_check_wal_group_commit_delay(cfg_getd("wal_group_commit_delay"));
+	box_check_wal_group_commit_size(cfg_geti64("wal_group_commit_size"));
+	box_check_compression_level("wal_compression_level",
+				    cfg_geti("wal_compression_level"));
+	box_check_wal_compression_threads(cfg_geti("wal_compression_threads"));
 	box_check_memtx_memory(cfg_geti64("memtx_memory"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_memtx_checkpoint_threads(cfg_geti("memtx_checkpoint_threads"));
+	box_check_compression_level("memtx_compression_level",
+				    cfg_geti("memtx_compression_level"));
 	box_check_vinyl_options();
 }
 
@@ -722,6 +907,47 @@ box_set_replication_skip_conflict(void)
 	replication_skip_conflict = cfg_geti("replication_skip_conflict");
 }
 
+void
+box_set_replication_apply_concurrency(void)
+{
+	applier_set_apply_concurrency(box_check_replication_apply_concurrency());
+}
+
+void
+box_set_replication_compression(void)
+{
+	replication_compression = cfg_geti("replication_compression");
+}
+
+void
+box_set_replication_compression_level(void)
+{
+	replication_compression_level = box_check_compression_level(
+		"replication_compression_level",
+		cfg_geti("replication_compression_level"));
+}
+
+void
+box_set_replication_compression_frame_size(void)
+{
+	replication_compression_frame_size =
+		box_check_replication_compression_frame_size();
+}
+
+void
+box_set_replication_compression_frame_delay(void)
+{
+	replication_compression_frame_delay =
+		box_check_replication_compression_frame_delay();
+}
+
+void
+box_set_replication_join_connections(void)
+{
+	replication_join_connections =
+		box_check_replication_join_connections();
+}
+
 void
 box_listen(void)
 {
@@ -765,6 +991,28 @@ box_set_snap_io_rate_limit(void)
 			cfg_getd("snap_io_rate_limit"));
 }
 
+void
+box_set_memtx_checkpoint_threads(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_checkpoint_threads(memtx,
+		box_check_memtx_checkpoint_threads(
+			cfg_geti("memtx_checkpoint_threads")));
+}
+
+void
+box_set_memtx_compression_level(void)
+{
+	struct memtx_engine *memtx;
+	memtx = (struct memtx_engine *)engine_by_name("memtx");
+	assert(memtx != NULL);
+	memtx_engine_set_compression_level(memtx,
+		box_check_compression_level("memtx_compression_level",
+			cfg_geti("memtx_compression_level")));
+}
+
 void
 box_set_memtx_memory(void)
 {
@@ -804,6 +1052,24 @@ box_set_readahead(void)
 	iproto_readahead = readahead;
 }
 
+void
+box_set_iproto_batch(void)
+{
+	iproto_batch = cfg_getb("iproto_batch");
+}
+
+void
+box_set_read_view_staleness(void)
+{
+	read_view_staleness = box_check_read_view_staleness();
+}
+
+void
+box_set_sql_cache_size(void)
+{
+	sql_stmt_cache_set_size(box_check_sql_cache_size());
+}
+
 void
 box_set_checkpoint_count(void)
 {
@@ -826,6 +1092,39 @@ box_set_checkpoint_wal_threshold(void)
 	wal_set_checkpoint_threshold(threshold);
 }
 
+void
+box_set_wal_spare_files(void)
+{
+	int spare_files = cfg_geti("wal_spare_files");
+	wal_set_spare_files(box_check_wal_spare_files(spare_files));
+}
+
+void
+box_set_wal_tail_size(void)
+{
+	int64_t size = box_check_wal_tail_size(cfg_geti64("wal_tail_size"));
+	if (wal_set_tail_size(size) != 0)
+		diag_raise();
+}
+
+void
+box_set_wal_compression_level(void)
+{
+	int level = cfg_geti("wal_compression_level");
+	wal_set_compression_level(box_check_compression_level(
+		"wal_compression_level", level));
+}
+
+void
+box_set_wal_group_commit(void)
+{
+	double delay = box_check_wal_group_commit_delay(
+		cfg_getd("wal_group_commit_delay"));
+	int64_t size = box_check_wal_group_commit_size(
+		cfg_geti64("wal_group_commit_size"));
+	wal_set_group_commit(delay, size);
+}
+
 void
 box_set_vinyl_memory(void)
 {
@@ -869,8 +1168,13 @@ box_set_net_msg_max(void)
 {
 	int new_iproto_msg_max = cfg_geti("net_msg_max");
 	iproto_set_msg_max(new_iproto_msg_max);
+	/*
+	 * net_msg_max limits messages of each network thread,
+	 * all of which are served by the same tx fiber pool.
+	 */
 	fiber_pool_set_max_size(&tx_fiber_pool,
 				new_iproto_msg_max *
+				cfg_geti("iproto_threads") *
 				IPROTO_FIBER_POOL_SIZE_FACTOR);
 }
 
@@ -1052,8 +1356,8 @@ box_select(uint32_t space_id, uint32_t index_id,
 	if (txn_begin_ro_stmt(space, &txn) != 0)
 		return -1;
 
-	struct iterator *it = index_create_iterator(index, type,
-						    key, part_count);
+	struct iterator *it = index_create_iterator_with_offset(index, type,
+						key, part_count, offset);
 	if (it == NULL) {
 		txn_rollback_stmt();
 		return -1;
@@ -1067,10 +1371,6 @@ box_select(uint32_t space_id, uint32_t index_id,
 		rc = iterator_next(it, &tuple);
 		if (rc != 0 || tuple == NULL)
 			break;
-		if (offset > 0) {
-			offset--;
-			continue;
-		}
 		rc = port_tuple_add(port, tuple);
 		if (rc != 0)
 			break;
@@ -1087,6 +1387,74 @@ box_select(uint32_t space_id, uint32_t index_id,
 	return 0;
 }
 
+int
+box_get_many(uint32_t space_id, uint32_t index_id,
+	     const char *keys, const char *keys_end, struct port *port)
+{
+	(void)keys_end;
+
+	/* Batched lookups are accounted as SELECT. */
+	rmean_collect(rmean_box, IPROTO_SELECT, 1);
+
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (access_check_space(space, PRIV_R) != 0)
+		return -1;
+	struct index *index = index_find(space, index_id);
+	if (index == NULL)
+		return -1;
+	if (!index->def->opts.is_unique) {
+		diag_set(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		return -1;
+	}
+	if (mp_typeof(*keys) != MP_ARRAY) {
+		diag_set(ClientError, ER_ILLEGAL_PARAMS,
+			 "keys must be an array");
+		return -1;
+	}
+	uint32_t key_count = mp_decode_array(&keys);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = key_count * sizeof(const char *);
+	const char **key_list = (const char **)region_alloc(region, size);
+	if (key_list == NULL && key_count > 0) {
+		diag_set(OutOfMemory, size, "region", "keys");
+		return -1;
+	}
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (mp_typeof(*keys) != MP_ARRAY) {
+			diag_set(ClientError, ER_ILLEGAL_PARAMS,
+				 "each key must be an array");
+			goto error;
+		}
+		key_list[i] = keys;
+		const char *key = keys;
+		uint32_t part_count = mp_decode_array(&key);
+		if (exact_key_validate(index->def->key_def, key,
+				       part_count) != 0)
+			goto error;
+		mp_next(&keys);
+	}
+
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		goto error;
+	port_tuple_create(port);
+	if (index_get_many(index, key_list, key_count, port) != 0) {
+		port_destroy(port);
+		region_truncate(region, region_svp);
+		txn_rollback_stmt();
+		return -1;
+	}
+	region_truncate(region, region_svp);
+	txn_commit_ro_stmt(txn);
+	return 0;
+error:
+	region_truncate(region, region_svp);
+	return -1;
+}
+
 int
 box_insert(uint32_t space_id, const char *tuple, const char *tuple_end,
 	   box_tuple_t **result)
@@ -1203,6 +1571,46 @@ space_truncate(struct space *space)
 		diag_raise();
 }
 
+/** Return true if the replica set has members but this instance. */
+static bool
+box_has_replicas(void)
+{
+	replicaset_foreach(replica) {
+		if (!tt_uuid_is_equal(&replica->uuid, &INSTANCE_UUID))
+			return true;
+	}
+	return !rlist_empty(&replicaset.anon);
+}
+
+int
+box_space_bulk_load(uint32_t space_id, struct bulk_load_source *source)
+{
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return -1;
+	if (!space_is_temporary(space) &&
+	    space_group_id(space) != GROUP_LOCAL) {
+		if (box_check_writable() != 0)
+			return -1;
+		/*
+		 * Loaded data isn't written to WAL, so replicas
+		 * would never get it.
+		 */
+		if (box_has_replicas()) {
+			diag_set(ClientError, ER_BULK_LOAD, space_name(space),
+				 "the space is replicated");
+			return -1;
+		}
+	}
+	if (access_check_space(space, PRIV_W) != 0)
+		return -1;
+	if (in_txn() != NULL) {
+		diag_set(ClientError, ER_ACTIVE_TRANSACTION);
+		return -1;
+	}
+	return space_bulk_load(space, source);
+}
+
 int
 box_truncate(uint32_t space_id)
 {
@@ -1409,13 +1817,32 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 *  - Cluster UUID in _schema space
 	 *  - Registration of master in _cluster space
 	 *  - Registration of the new replica in _cluster space
+	 *
+	 * Parallel fetch of the memtx snapshot
+	 * ====================================
+	 *
+	 * => JOIN { INSTANCE_UUID: replica_uuid, SHARD_COUNT: connections }
+	 * <= OK { VCLOCK: start_vclock, SHARD_COUNT: shard_count }
+	 *    The replica is going to fetch the memtx snapshot over
+	 *    `connections` extra connections, one shard at a time,
+	 *    shard 0 (system spaces) first:
+	 *
+	 *    => FETCH_SNAPSHOT { VCLOCK: start_vclock, SHARD: shard,
+	 *                        OFFSET: rows already received }
+	 *    <= INSERT
+	 *       ...
+	 *    <= OK { VCLOCK: start_vclock }
+	 *
+	 * => OK - the snapshot is fetched, initial data of the other
+	 *    engines and final data follow as described above.
 	 */
 
 	assert(header->type == IPROTO_JOIN);
 
 	/* Decode JOIN request */
 	struct tt_uuid instance_uuid = uuid_nil;
-	xrow_decode_join_xc(header, &instance_uuid);
+	uint32_t connection_count = 0;
+	xrow_decode_join_xc(header, &instance_uuid, &connection_count);
 
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
@@ -1470,19 +1897,50 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 			  tt_uuid_str(&instance_uuid));
 	auto gc_guard = make_scoped_guard([&]{ gc_unref_checkpoint(&gc); });
 
+	/*
+	 * If the replica can fetch the memtx snapshot over
+	 * several connections, tell it how many shards there are.
+	 */
+	struct engine *memtx = engine_by_name("memtx");
+	uint32_t shard_count = 0;
+	if (connection_count > 0 &&
+	    memtx_engine_snapshot_shard_count((struct memtx_engine *)memtx,
+					      &start_vclock,
+					      &shard_count) != 0)
+		diag_raise();
+
 	/* Respond to JOIN request with start_vclock. */
 	struct xrow_header row;
-	xrow_encode_vclock_xc(&row, &start_vclock);
+	xrow_encode_join_response_xc(&row, &start_vclock, shard_count);
 	row.sync = header->sync;
 	coio_write_xrow(io, &row);
 
 	say_info("joining replica %s at %s",
 		 tt_uuid_str(&instance_uuid), sio_socketname(io->fd));
 
+	if (shard_count > 0) {
+		/* Wait until the replica has fetched the snapshot. */
+		struct ibuf ibuf;
+		ibuf_create(&ibuf, &cord()->slabc, 1024);
+		auto ibuf_guard = make_scoped_guard([&] {
+			ibuf_destroy(&ibuf);
+		});
+		coio_read_xrow(io, &ibuf, &row);
+		if (iproto_type_is_error(row.type)) {
+			xrow_decode_error_xc(&row);
+		} else if (row.type != IPROTO_OK) {
+			tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+				  (uint32_t) row.type);
+		}
+		say_info("replica %s has fetched %u snapshot shards",
+			 tt_uuid_str(&instance_uuid), (unsigned)shard_count);
+	}
+
 	/*
 	 * Initial stream: feed replica with dirty data from engines.
 	 */
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	relay_initial_join(io->fd, header->sync, &start_vclock,
+			   shard_count > 0 ? memtx : NULL);
 	say_info("initial data sent.");
 
 	/**
@@ -1527,6 +1985,51 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	coio_write_xrow(io, &row);
 }
 
+void
+box_process_fetch_snapshot(struct ev_io *io, struct xrow_header *header)
+{
+	assert(header->type == IPROTO_FETCH_SNAPSHOT);
+
+	struct vclock vclock;
+	uint32_t shard;
+	uint64_t offset;
+	xrow_decode_fetch_snapshot_xc(header, &vclock, &shard, &offset);
+
+	/* Check that bootstrap has been finished */
+	if (!is_box_configured)
+		tnt_raise(ClientError, ER_LOADING);
+
+	/* Check permissions */
+	access_check_universe_xc(PRIV_R);
+
+	/*
+	 * The checkpoint is referenced by the JOIN request that
+	 * has started the fetch, unless the JOIN connection has
+	 * been closed, in which case the fetch is useless.
+	 */
+	struct gc_checkpoint *checkpoint = NULL, *it;
+	gc_foreach_checkpoint_reverse(it) {
+		if (vclock_compare(&it->vclock, &vclock) == 0) {
+			checkpoint = it;
+			break;
+		}
+	}
+	if (checkpoint == NULL)
+		tnt_raise(ClientError, ER_MISSING_SNAPSHOT);
+
+	struct gc_checkpoint_ref gc;
+	gc_ref_checkpoint(checkpoint, &gc, "snapshot fetch");
+	auto gc_guard = make_scoped_guard([&]{ gc_unref_checkpoint(&gc); });
+
+	relay_fetch_snapshot(io->fd, header->sync, &vclock, shard, offset);
+
+	/* Send end of shard marker */
+	struct xrow_header row;
+	xrow_encode_vclock_xc(&row, &vclock);
+	row.sync = header->sync;
+	coio_write_xrow(io, &row);
+}
+
 void
 box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 {
@@ -1539,9 +2042,11 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	struct tt_uuid replicaset_uuid = uuid_nil, replica_uuid = uuid_nil;
 	struct vclock replica_clock;
 	uint32_t replica_version_id;
+	bool compression = false;
 	vclock_create(&replica_clock);
 	xrow_decode_subscribe_xc(header, &replicaset_uuid, &replica_uuid,
-				 &replica_clock, &replica_version_id);
+				 &replica_clock, &replica_version_id,
+				 &compression);
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -1615,7 +2120,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * indefinitely).
 	 */
 	relay_subscribe(replica, io->fd, header->sync, &replica_clock,
-			replica_version_id);
+			replica_version_id, compression);
 }
 
 void
@@ -1664,6 +2169,7 @@ box_free(void)
 		gc_free();
 		engine_shutdown();
 		wal_free();
+		xlog_compression_stop();
 	}
 }
 
@@ -2071,12 +2577,18 @@ box_cfg_xc(void)
 	schema_init();
 	replication_init();
 	port_init();
-	iproto_init();
+	int read_view_threads =
+		box_check_read_view_threads(cfg_geti("read_view_threads"));
+	iproto_init(box_check_iproto_threads(cfg_geti("iproto_threads")),
+		    read_view_threads);
 	sql_init();
 
 	int64_t wal_max_rows = box_check_wal_max_rows(cfg_geti64("rows_per_wal"));
 	int64_t wal_max_size = box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
+	if (xlog_compression_start(box_check_wal_compression_threads(
+			cfg_geti("wal_compression_threads"))) != 0)
+		diag_raise();
 	if (wal_init(wal_mode, cfg_gets("wal_dir"), wal_max_rows,
 		     wal_max_size, &INSTANCE_UUID, on_wal_garbage_collection,
 		     on_wal_checkpoint_threshold) != 0) {
@@ -2091,6 +2603,9 @@ box_cfg_xc(void)
 
 	box_set_net_msg_max();
 	box_set_readahead();
+	box_set_iproto_batch();
+	box_set_read_view_staleness();
+	box_set_sql_cache_size();
 	box_set_too_long_threshold();
 	box_set_replication_timeout();
 	box_set_replication_connect_timeout();
@@ -2098,6 +2613,12 @@ box_cfg_xc(void)
 	box_set_replication_sync_lag();
 	box_set_replication_sync_timeout();
 	box_set_replication_skip_conflict();
+	box_set_replication_apply_concurrency();
+	box_set_replication_compression();
+	box_set_replication_compression_level();
+	box_set_replication_compression_frame_size();
+	box_set_replication_compression_frame_delay();
+	box_set_replication_join_connections();
 
 	struct gc_checkpoint *checkpoint = gc_last_checkpoint();
 
@@ -2144,6 +2665,8 @@ box_cfg_xc(void)
 	replicaset_follow();
 
 	fiber_gc();
+	if (read_view_threads > 0)
+		read_view_init();
 	is_box_configured = true;
 
 	title("running");
@@ -2244,5 +2767,6 @@ box_reset_stat(void)
 	rmean_cleanup(rmean_box);
 	rmean_cleanup(rmean_error);
 	engine_reset_stat();
+	wal_reset_stat();
 	space_foreach(box_reset_space_stat, NULL);
 }
@@ -52,6 +52,7 @@ struct ev_io;
 struct auth_request;
 struct space;
 struct vclock;
+struct bulk_load_source;
 
 /**
  * Pointer to TX thread local vclock.
@@ -175,6 +176,9 @@ box_process_auth(struct auth_request *request, const char *salt);
 void
 box_process_join(struct ev_io *io, struct xrow_header *header);
 
+void
+box_process_fetch_snapshot(struct ev_io *io, struct xrow_header *header);
+
 void
 box_process_subscribe(struct ev_io *io, struct xrow_header *header);
 
@@ -194,11 +198,20 @@ void box_set_log_level(void);
 void box_set_log_format(void);
 void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
+void box_set_memtx_checkpoint_threads(void);
+void box_set_memtx_compression_level(void);
 void box_set_too_long_threshold(void);
 void box_set_readahead(void);
+void box_set_iproto_batch(void);
+void box_set_read_view_staleness(void);
+void box_set_sql_cache_size(void);
 void box_set_checkpoint_count(void);
 void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
+void box_set_wal_spare_files(void);
+void box_set_wal_tail_size(void);
+void box_set_wal_group_commit(void);
+void box_set_wal_compression_level(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
 void box_set_vinyl_memory(void);
@@ -211,6 +224,12 @@ void box_set_replication_connect_quorum(void);
 void box_set_replication_sync_lag(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
+void box_set_replication_apply_concurrency(void);
+void box_set_replication_compression(void);
+void box_set_replication_compression_level(void);
+void box_set_replication_compression_frame_size(void);
+void box_set_replication_compression_frame_delay(void);
+void box_set_replication_join_connections(void);
 void box_set_net_msg_max(void);
 
 extern "C" {
@@ -225,6 +244,16 @@ box_select(uint32_t space_id, uint32_t index_id,
 	   const char *key, const char *key_end,
 	   struct port *port);
 
+/**
+ * Look up a batch of keys in a unique index. @a keys is an
+ * array of full keys. Found tuples are added to @a port in
+ * the order of keys, keys that are not found are skipped.
+ * Private and used only by FFI and IPROTO_GET_MANY.
+ */
+API_EXPORT int
+box_get_many(uint32_t space_id, uint32_t index_id,
+	     const char *keys, const char *keys_end, struct port *port);
+
 /** \cond public */
 
 /*
@@ -436,6 +465,20 @@ box_process_rw(struct request *request, struct space *space,
 int
 boxk(int type, uint32_t space_id, const char *format, ...);
 
+/**
+ * Fill an empty space with tuples from the given source.
+ * Tuples are not written to WAL: the loaded data is made
+ * durable by a checkpoint and is not replicated, hence a
+ * space which isn't local or temporary may be loaded only
+ * if the instance has no replicas.
+ *
+ * \param space_id space identifier
+ * \param source source of tuples in the format of the space
+ * \retval 0 in success, -1 otherwise
+ */
+int
+box_space_bulk_load(uint32_t space_id, struct bulk_load_source *source);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -176,9 +176,18 @@ engine_backup(const struct vclock *vclock, engine_backup_cb cb, void *cb_arg)
 
 int
 engine_join(const struct vclock *vclock, struct xstream *stream)
+{
+	return engine_join_except(NULL, vclock, stream);
+}
+
+int
+engine_join_except(struct engine *skip, const struct vclock *vclock,
+		   struct xstream *stream)
 {
 	struct engine *engine;
 	engine_foreach(engine) {
+		if (engine == skip)
+			continue;
 		if (engine->vtab->join(engine, vclock, stream) != 0)
 			return -1;
 	}
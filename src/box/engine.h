@@ -205,6 +205,13 @@ enum {
 	 * transactions w/o throwing ER_CROSS_ENGINE_TRANSACTION.
 	 */
 	ENGINE_BYPASS_TX = 1 << 0,
+	/**
+	 * If set, transactions of this engine may be committed
+	 * without waiting for the WAL write, see txn_commit_async().
+	 * This requires engine_commit() to tolerate being called
+	 * in an order different from the WAL one.
+	 */
+	ENGINE_SUPPORTS_ASYNC_COMMIT = 1 << 1,
 };
 
 struct engine {
@@ -337,6 +344,14 @@ engine_end_recovery(void);
 int
 engine_join(const struct vclock *vclock, struct xstream *stream);
 
+/**
+ * Like engine_join(), but skip the given engine, which feeds
+ * its checkpoint to the replica some other way.
+ */
+int
+engine_join_except(struct engine *skip, const struct vclock *vclock,
+		   struct xstream *stream);
+
 int
 engine_begin_checkpoint(void);
 
@@ -475,6 +490,14 @@ engine_join_xc(const struct vclock *vclock, struct xstream *stream)
 		diag_raise();
 }
 
+static inline void
+engine_join_except_xc(struct engine *skip, const struct vclock *vclock,
+		      struct xstream *stream)
+{
+	if (engine_join_except(skip, vclock, stream) != 0)
+		diag_raise();
+}
+
 #endif /* defined(__cplusplus) */
 
 #endif /* TARANTOOL_BOX_ENGINE_H_INCLUDED */
@@ -247,6 +247,11 @@ struct errcode_record {
 	/*192 */_(ER_INDEX_DEF_UNSUPPORTED,	"%s are prohibited in an index definition") \
 	/*193 */_(ER_CK_DEF_UNSUPPORTED,	"%s are prohibited in a CHECK constraint definition") \
 	/*194 */_(ER_MULTIKEY_INDEX_MISMATCH,	"Field %s is used as multikey in one index and as single key in another") \
+	/*195 */_(ER_BULK_LOAD,			"Can't bulk load space '%s': %s") \
+	/*196 */_(ER_NO_SUCH_CURSOR,		"Cursor %llu does not exist") \
+	/*197 */_(ER_NO_SUCH_STATEMENT,		"Prepared statement %u does not exist") \
+	/*198 */_(ER_CURSOR_BUSY,		"Cursor %llu is busy fetching a page") \
+	/*199 */_(ER_CURSOR_LIMIT,		"Too many open cursors, the limit is %u") \
 
 /*
  * !IMPORTANT! Please follow instructions at start of the file
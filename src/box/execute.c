@@ -39,6 +39,7 @@
 #include "small/obuf.h"
 #include "diag.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
 #include "xrow.h"
 #include "schema.h"
 #include "port.h"
@@ -100,7 +101,7 @@ static void
 port_sql_destroy(struct port *base)
 {
 	port_tuple_vtab.destroy(base);
-	sql_finalize(((struct port_sql *)base)->stmt);
+	sql_stmt_cache_release(((struct port_sql *)base)->stmt);
 }
 
 const struct port_vtab port_sql_vtab = {
@@ -439,10 +440,8 @@ sql_execute(sql *db, struct sql_stmt *stmt, struct port *port,
 	return 0;
 }
 
-int
-sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
-			uint32_t bind_count, struct port *port,
-			struct region *region)
+struct sql_stmt *
+sql_stmt_compile(const char *sql, int len)
 {
 	struct sql_stmt *stmt;
 	struct sql *db = sql_get();
@@ -453,13 +452,54 @@ sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 				err = sqlErrStr(db->errCode);
 			diag_set(ClientError, ER_SQL_EXECUTE, err);
 		}
-		return -1;
+		return NULL;
 	}
 	assert(stmt != NULL);
+	return stmt;
+}
+
+/**
+ * Bind parameters to a statement got from the statement cache
+ * and execute it. The statement is returned to the cache when
+ * the port is destroyed.
+ */
+static int
+sql_bind_and_execute(struct sql_stmt *stmt, const struct sql_bind *bind,
+		     uint32_t bind_count, struct port *port,
+		     struct region *region)
+{
 	port_sql_create(port, stmt);
 	if (sql_bind(stmt, bind, bind_count) == 0 &&
-	    sql_execute(db, stmt, port, region) == 0)
+	    sql_execute(sql_get(), stmt, port, region) == 0)
 		return 0;
 	port_destroy(port);
 	return -1;
 }
+
+int
+sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
+			uint32_t bind_count, struct port *port,
+			struct region *region)
+{
+	struct sql_stmt *stmt = sql_stmt_cache_acquire(sql, len);
+	if (stmt == NULL)
+		return -1;
+	return sql_bind_and_execute(stmt, bind, bind_count, port, region);
+}
+
+int
+sql_stmt_prepare(const char *sql, int len, uint32_t *stmt_id)
+{
+	return sql_stmt_cache_prepare(sql, len, stmt_id);
+}
+
+int
+sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
+		     uint32_t bind_count, struct port *port,
+		     struct region *region)
+{
+	struct sql_stmt *stmt = sql_stmt_cache_acquire_by_id(stmt_id);
+	if (stmt == NULL)
+		return -1;
+	return sql_bind_and_execute(stmt, bind, bind_count, port, region);
+}
@@ -52,7 +52,8 @@ struct region;
 struct sql_bind;
 
 /**
- * Prepare and execute an SQL statement.
+ * Prepare and execute an SQL statement. The statement is taken
+ * from the statement cache if it has been compiled already.
  * @param sql SQL statement.
  * @param len Length of @a sql.
  * @param bind Array of parameters.
@@ -69,6 +70,46 @@ sql_prepare_and_execute(const char *sql, int len, const struct sql_bind *bind,
 			uint32_t bind_count, struct port *port,
 			struct region *region);
 
+/**
+ * Compile an SQL statement. The statement cache calls it on a
+ * miss.
+ *
+ * @retval NULL Compilation error, the diag is set.
+ */
+struct sql_stmt *
+sql_stmt_compile(const char *sql, int len);
+
+/**
+ * Compile an SQL statement and put it to the statement cache,
+ * or find it there, for sql_execute_prepared().
+ * @param sql SQL statement.
+ * @param len Length of @a sql.
+ * @param[out] stmt_id Id of the prepared statement.
+ *
+ * @retval  0 Success.
+ * @retval -1 Client or memory error.
+ */
+int
+sql_stmt_prepare(const char *sql, int len, uint32_t *stmt_id);
+
+/**
+ * Execute a statement prepared with sql_stmt_prepare(). A statement
+ * evicted from the cache has to be prepared again.
+ * @param stmt_id Id of the prepared statement.
+ * @param bind Array of parameters.
+ * @param bind_count Length of @a bind.
+ * @param[out] port Port to store SQL response.
+ * @param region Runtime allocator for temporary objects.
+ *
+ * @retval  0 Success.
+ * @retval -1 Client or memory error, ER_NO_SUCH_STATEMENT if
+ *         the statement is not in the cache.
+ */
+int
+sql_execute_prepared(uint32_t stmt_id, const struct sql_bind *bind,
+		     uint32_t bind_count, struct port *port,
+		     struct region *region);
+
 /**
  * Port implementation that is used to store SQL responses and
  * output them to obuf or Lua. This port implementation is
@@ -36,6 +36,7 @@
 #include "space.h"
 #include "iproto_constants.h"
 #include "txn.h"
+#include "port.h"
 #include "rmean.h"
 #include "info/info.h"
 
@@ -71,12 +72,14 @@ key_validate(const struct index_def *index_def, enum iterator_type type,
 	if (part_count == 0) {
 		/*
 		 * Zero key parts are allowed:
-		 * - for TREE index, all iterator types,
+		 * - for TREE and ART index, all iterator types,
 		 * - ITER_ALL iterator type, all index types
-		 * - ITER_GT iterator in HASH index (legacy)
+		 * - ITER_GT iterator in HASH and SWISS index (legacy)
 		 */
-		if (index_def->type == TREE || type == ITER_ALL ||
-		    (index_def->type == HASH && type == ITER_GT))
+		if (index_def->type == TREE || index_def->type == ART ||
+		    type == ITER_ALL ||
+		    ((index_def->type == HASH || index_def->type == SWISS) &&
+		     type == ITER_GT))
 			return 0;
 		/* Fall through. */
 	}
@@ -118,8 +121,9 @@ key_validate(const struct index_def *index_def, enum iterator_type type,
 			return -1;
 		}
 
-		/* Partial keys are allowed only for TREE index type. */
-		if (index_def->type != TREE && part_count < index_def->key_def->part_count) {
+		/* Partial keys are allowed only for TREE and ART index types. */
+		if (index_def->type != TREE && index_def->type != ART &&
+		    part_count < index_def->key_def->part_count) {
 			diag_set(ClientError, ER_PARTIAL_KEY,
 				 index_type_strs[index_def->type],
 				 index_def->key_def->part_count,
@@ -261,7 +265,7 @@ box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 	struct index *index;
 	if (check_index(space_id, index_id, &space, &index) != 0)
 		return -1;
-	if (index->def->type != TREE) {
+	if (index->def->type != TREE && index->def->type != ART) {
 		/* Show nice error messages in Lua. */
 		diag_set(UnsupportedIndexFeature, index->def, "min()");
 		return -1;
@@ -293,7 +297,7 @@ box_index_max(uint32_t space_id, uint32_t index_id, const char *key,
 	struct index *index;
 	if (check_index(space_id, index_id, &space, &index) != 0)
 		return -1;
-	if (index->def->type != TREE) {
+	if (index->def->type != TREE && index->def->type != ART) {
 		/* Show nice error messages in Lua. */
 		diag_set(UnsupportedIndexFeature, index->def, "max()");
 		return -1;
@@ -505,6 +509,15 @@ index_delete(struct index *index)
 
 int
 index_build(struct index *index, struct index *pk)
+{
+	if (index_build_fill(index, pk) != 0)
+		return -1;
+	index_end_build(index);
+	return 0;
+}
+
+int
+index_build_fill(struct index *index, struct index *pk)
 {
 	ssize_t n_tuples = index_size(pk);
 	if (n_tuples < 0)
@@ -538,11 +551,7 @@ index_build(struct index *index, struct index *pk)
 			break;
 	}
 	iterator_delete(it);
-	if (rc != 0)
-		return -1;
-
-	index_end_build(index);
-	return 0;
+	return rc != 0 ? -1 : 0;
 }
 
 /* }}} */
@@ -664,6 +673,22 @@ generic_index_get(struct index *index, const char *key,
 	return -1;
 }
 
+int
+generic_index_get_many(struct index *index, const char **keys,
+		       uint32_t key_count, struct port *port)
+{
+	for (uint32_t i = 0; i < key_count; i++) {
+		const char *key = keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		struct tuple *tuple;
+		if (index_get(index, key, part_count, &tuple) != 0)
+			return -1;
+		if (tuple != NULL && port_tuple_add(port, tuple) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 int
 generic_index_replace(struct index *index, struct tuple *old_tuple,
 		      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -677,6 +702,28 @@ generic_index_replace(struct index *index, struct tuple *old_tuple,
 	return -1;
 }
 
+struct iterator *
+generic_index_create_iterator_with_offset(struct index *index,
+					  enum iterator_type type,
+					  const char *key, uint32_t part_count,
+					  uint32_t offset)
+{
+	struct iterator *it = index_create_iterator(index, type,
+						    key, part_count);
+	if (it == NULL)
+		return NULL;
+	struct tuple *tuple;
+	for (; offset > 0; offset--) {
+		if (iterator_next(it, &tuple) != 0) {
+			iterator_delete(it);
+			return NULL;
+		}
+		if (tuple == NULL)
+			break;
+	}
+	return it;
+}
+
 struct snapshot_iterator *
 generic_index_create_snapshot_iterator(struct index *index)
 {
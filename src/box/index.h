@@ -45,6 +45,7 @@ struct index;
 struct index_def;
 struct key_def;
 struct info_handler;
+struct port;
 
 /** \cond public */
 
@@ -411,6 +412,14 @@ struct index_vtab {
 			 const char *key, uint32_t part_count);
 	int (*get)(struct index *index, const char *key,
 		   uint32_t part_count, struct tuple **result);
+	/**
+	 * Look up a batch of full keys of a unique index.
+	 * Every key is a MessagePack array. Found tuples are
+	 * appended to the port in the order of keys, keys
+	 * that are not found are skipped.
+	 */
+	int (*get_many)(struct index *index, const char **keys,
+			uint32_t key_count, struct port *port);
 	int (*replace)(struct index *index, struct tuple *old_tuple,
 		       struct tuple *new_tuple, enum dup_replace_mode mode,
 		       struct tuple **result);
@@ -418,6 +427,13 @@ struct index_vtab {
 	struct iterator *(*create_iterator)(struct index *index,
 			enum iterator_type type,
 			const char *key, uint32_t part_count);
+	/**
+	 * Create an index iterator that skips the first @offset
+	 * tuples of the result set.
+	 */
+	struct iterator *(*create_iterator_with_offset)(struct index *index,
+			enum iterator_type type, const char *key,
+			uint32_t part_count, uint32_t offset);
 	/**
 	 * Create an ALL iterator with personal read view so further
 	 * index modifications will not affect the iteration results.
@@ -506,6 +522,14 @@ index_delete(struct index *index);
 int
 index_build(struct index *index, struct index *pk);
 
+/**
+ * Begin building this index and feed it the contents of
+ * another index. The build must then be completed with
+ * index_end_build(). index_build() is a shortcut for both.
+ */
+int
+index_build_fill(struct index *index, struct index *pk);
+
 static inline void
 index_commit_create(struct index *index, int64_t signature)
 {
@@ -595,6 +619,13 @@ index_get(struct index *index, const char *key,
 	return index->vtab->get(index, key, part_count, result);
 }
 
+static inline int
+index_get_many(struct index *index, const char **keys,
+	       uint32_t key_count, struct port *port)
+{
+	return index->vtab->get_many(index, keys, key_count, port);
+}
+
 static inline int
 index_replace(struct index *index, struct tuple *old_tuple,
 	      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -610,6 +641,15 @@ index_create_iterator(struct index *index, enum iterator_type type,
 	return index->vtab->create_iterator(index, type, key, part_count);
 }
 
+static inline struct iterator *
+index_create_iterator_with_offset(struct index *index, enum iterator_type type,
+				  const char *key, uint32_t part_count,
+				  uint32_t offset)
+{
+	return index->vtab->create_iterator_with_offset(index, type, key,
+							part_count, offset);
+}
+
 static inline struct snapshot_iterator *
 index_create_snapshot_iterator(struct index *index)
 {
@@ -677,8 +717,13 @@ int generic_index_random(struct index *, uint32_t, struct tuple **);
 ssize_t generic_index_count(struct index *, enum iterator_type,
 			    const char *, uint32_t);
 int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
+int generic_index_get_many(struct index *, const char **, uint32_t,
+			   struct port *);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode, struct tuple **);
+struct iterator *
+generic_index_create_iterator_with_offset(struct index *, enum iterator_type,
+					  const char *, uint32_t, uint32_t);
 struct snapshot_iterator *generic_index_create_snapshot_iterator(struct index *);
 void generic_index_stat(struct index *, struct info_handler *);
 void generic_index_compact(struct index *);
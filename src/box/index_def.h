@@ -44,6 +44,8 @@ enum index_type {
 	TREE,     /* TREE Index */
 	BITSET,   /* BITSET Index */
 	RTREE,    /* R-Tree Index */
+	SWISS,    /* SIMD probed HASH Index */
+	ART,      /* Adaptive Radix Tree Index */
 	index_type_MAX,
 };
 
@@ -61,12 +61,22 @@
 #include "iproto_constants.h"
 #include "rmean.h"
 #include "execute.h"
+#include "read_view.h"
+#include "session_cursor.h"
+#include "space.h"
+#include "txn.h" /* rmean_box */
 #include "errinj.h"
 #include "tt_static.h"
 
 enum {
 	IPROTO_SALT_SIZE = 32,
 	IPROTO_PACKET_SIZE_MAX = 2UL * 1024 * 1024 * 1024,
+	/**
+	 * A cursor page is cut short when the connection output
+	 * buffer gets bigger than this, so that a client can't
+	 * make it grow without limit by asking for a big page.
+	 */
+	IPROTO_CURSOR_OBUF_MAX = 1024 * 1024,
 };
 
 /**
@@ -129,6 +139,13 @@ unsigned iproto_readahead = 16320;
 /* The maximal number of iproto messages in fly. */
 static int iproto_msg_max = IPROTO_MSG_MAX_MIN;
 
+/**
+ * Deliver requests parsed from one input buffer to tx in one
+ * message, see iproto_enqueue_batch(). Assigned in tx thread
+ * and used in iproto threads without locks, like readahead.
+ */
+bool iproto_batch = false;
+
 /**
  * How big is a buffer which needs to be shrunk before
  * it is put back into buffer cache.
@@ -180,6 +197,8 @@ struct iproto_msg
 		struct auth_request auth;
 		/* SQL request, if this is the EXECUTE request. */
 		struct sql_request sql;
+		/** CURSOR_FETCH or CURSOR_CLOSE request. */
+		struct cursor_request cursor;
 		/** In case of iproto parse error, saved diagnostics. */
 		struct diag diag;
 	};
@@ -215,62 +234,62 @@ struct iproto_msg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/** Link in iproto_batch::msgs. */
+	struct stailq_entry in_batch;
+	/** SELECT served from a read view, see rv_process_select(). */
+	struct {
+		/**
+		 * Pipe to the reader thread the request is sent
+		 * to or NULL if the request goes directly to tx.
+		 */
+		struct cpipe *pipe;
+		/** Encoded tuples, allocated with malloc(). */
+		char *data;
+		size_t size;
+		/** Number of tuples or -1 if tx must execute it. */
+		int count;
+		/** Schema version of the read view. */
+		uint32_t schema_version;
+	} read_view;
 };
 
-static struct mempool iproto_msg_pool;
+/**
+ * Requests of one connection parsed from one input buffer
+ * and delivered to tx as a single message. tx executes them
+ * one by one in the same fiber and sends all the replies back
+ * at once, which saves a fiber switch and a cbus round trip
+ * per request. Only reads (SELECT and GET_MANY) are batched.
+ * A DML request yields on its WAL write, so a batch of writes
+ * executed one by one would wait for a WAL round trip per
+ * request instead of sharing a group commit, as writes sent
+ * in separate messages do. A vinyl read may still yield, and
+ * then it delays the requests following it in the batch.
+ */
+struct iproto_batch {
+	struct cmsg base;
+	/** The connection the requests came from. */
+	struct iproto_connection *connection;
+	/** Requests of the batch, linked by iproto_msg::in_batch. */
+	struct stailq msgs;
+};
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con);
 
-/**
- * Resume stopped connections, if any.
- */
 static void
-iproto_resume();
+iproto_msg_delete(struct iproto_msg *msg);
 
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input);
 
-static inline void
-iproto_msg_delete(struct iproto_msg *msg)
-{
-	mempool_free(&iproto_msg_pool, msg);
-	iproto_resume();
-}
-
-/**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
- * Is also used as a queue for just established connections and to
- * execute disconnect triggers. A few notes about these triggers:
- * - they need to be run in a fiber
- * - unlike an ordinary request failure, on_connect trigger
- *   failure must lead to connection close.
- * - on_connect trigger must be processed before any other
- *   request on this connection.
- */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
-
-/**
- * Network thread.
- */
-static struct cord net_cord;
-
-/**
- * Slab cache used for allocating memory for output network buffers
- * in the tx thread.
- */
-static struct slab_cache net_slabc;
-
-struct rmean *rmean_net;
-
 enum rmean_net_name {
 	IPROTO_SENT,
 	IPROTO_RECEIVED,
 	IPROTO_CONNECTIONS,
 	IPROTO_REQUESTS,
+	/** Requests delivered to tx in one message. */
+	IPROTO_BATCHES,
 	IPROTO_LAST,
 };
 
@@ -279,19 +298,117 @@ const char *rmean_net_strings[IPROTO_LAST] = {
 	"RECEIVED",
 	"CONNECTIONS",
 	"REQUESTS",
+	"BATCHES",
 };
 
+/**
+ * A network thread. Connections accepted by a thread are
+ * served by it until closed: it reads and parses their requests,
+ * sends them to tx and writes responses back to the sockets.
+ */
+struct iproto_thread {
+	/** Index of the thread in iproto_threads. */
+	int id;
+	/** The thread itself. */
+	struct cord net_cord;
+	/**
+	 * A single queue for all requests in all connections of
+	 * the thread. All requests from all connections are
+	 * processed concurrently. Is also used as a queue for
+	 * just established connections and to execute disconnect
+	 * triggers. A few notes about these triggers:
+	 * - they need to be run in a fiber
+	 * - unlike an ordinary request failure, on_connect trigger
+	 *   failure must lead to connection close.
+	 * - on_connect trigger must be processed before any other
+	 *   request on this connection.
+	 */
+	struct cpipe tx_pipe;
+	/** A pipe from tx to the thread. */
+	struct cpipe net_pipe;
+	/** Messages sent by the thread to tx. */
+	struct mempool iproto_msg_pool;
+	/** Batches of messages, see struct iproto_batch. */
+	struct mempool iproto_batch_pool;
+	/** Connections served by the thread. */
+	struct mempool iproto_connection_pool;
+	/** Connections with input stopped by net_msg_max. */
+	struct rlist stopped_connections;
+	/** Network statistics of the thread. */
+	struct rmean *rmean;
+	/**
+	 * Listener. Thread 0 binds the socket, other threads
+	 * accept connections on it, see evio_service_attach().
+	 */
+	struct evio_service binary;
+	/*
+	 * Routes of messages sent by the thread, the replies
+	 * come back to it over its own net_pipe.
+	 */
+	struct cmsg_hop destroy_route[2];
+	struct cmsg_hop push_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop call_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop sql_route[2];
+	struct cmsg_hop cursor_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+	struct cmsg_hop join_route[2];
+	struct cmsg_hop subscribe_route[2];
+	struct cmsg_hop error_route[2];
+	struct cmsg_hop connect_route[2];
+	struct cmsg_hop batch_route[2];
+	/** Pipes to reader threads, see struct iproto_reader. */
+	struct cpipe *reader_pipes;
+	/** Routes of SELECTs served by reader threads. */
+	struct cmsg_hop (*reader_routes)[3];
+	/** Reader thread to send the next SELECT to. */
+	int next_reader;
+};
+
+/** Network threads, see iproto_init(). */
+static struct iproto_thread *iproto_threads;
+static int iproto_threads_count;
+
+/**
+ * A reader thread. It executes primary key SELECTs over
+ * spaces which have a read view (see read_view.h) and
+ * passes the result to tx, which checks access and writes
+ * it to the connection output buffer. This way tx doesn't
+ * spend time looking up and encoding tuples.
+ */
+struct iproto_reader {
+	/** Index of the thread in iproto_readers. */
+	int id;
+	/** The thread itself. */
+	struct cord cord;
+	/** A pipe from the reader to tx. */
+	struct cpipe tx_pipe;
+};
+
+/** Reader threads, see iproto_init(). */
+static struct iproto_reader *iproto_readers;
+static int iproto_readers_count;
+
+/**
+ * Resume stopped connections of the thread, if any.
+ */
+static void
+iproto_resume(struct iproto_thread *iproto_thread);
+
+/**
+ * Slab cache used for allocating memory for output network buffers
+ * in the tx thread.
+ */
+static struct slab_cache net_slabc;
+
 static void
 tx_process_destroy(struct cmsg *m);
 
 static void
 net_finish_destroy(struct cmsg *m);
 
-static const struct cmsg_hop destroy_route[] = {
-	{ tx_process_destroy, &net_pipe },
-	{ net_finish_destroy, NULL },
-};
-
 /** Fire on_disconnect triggers in the tx thread. */
 static void
 tx_process_disconnect(struct cmsg *m);
@@ -317,11 +434,6 @@ iproto_process_push(struct cmsg *m);
 static void
 tx_end_push(struct cmsg *m);
 
-static const struct cmsg_hop push_route[] = {
-	{ iproto_process_push, &tx_pipe },
-	{ tx_end_push, NULL }
-};
-
 
 /* }}} */
 
@@ -482,29 +594,30 @@ struct iproto_connection
 	} tx;
 	/** Authentication salt. */
 	char salt[IPROTO_SALT_SIZE];
+	/** The thread serving the connection. */
+	struct iproto_thread *iproto_thread;
 };
 
-static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
-
 /**
  * Return true if we have not enough spare messages
- * in the message pool.
+ * in the message pool of the thread.
  */
 static inline bool
-iproto_check_msg_max()
+iproto_check_msg_max(struct iproto_thread *iproto_thread)
 {
-	size_t request_count = mempool_count(&iproto_msg_pool);
+	size_t request_count =
+		mempool_count(&iproto_thread->iproto_msg_pool);
 	return request_count > (size_t) iproto_msg_max;
 }
 
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
 {
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc(&iproto_msg_pool);
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	struct iproto_msg *msg = (struct iproto_msg *)
+		mempool_alloc(&iproto_thread->iproto_msg_pool);
 	ERROR_INJECT(ERRINJ_TESTING, {
-		mempool_free(&iproto_msg_pool, msg);
+		mempool_free(&iproto_thread->iproto_msg_pool, msg);
 		msg = NULL;
 	});
 	if (msg == NULL) {
@@ -514,10 +627,18 @@ iproto_msg_new(struct iproto_connection *con)
 		return NULL;
 	}
 	msg->connection = con;
-	rmean_collect(rmean_net, IPROTO_REQUESTS, 1);
+	rmean_collect(iproto_thread->rmean, IPROTO_REQUESTS, 1);
 	return msg;
 }
 
+static void
+iproto_msg_delete(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	iproto_resume(iproto_thread);
+}
+
 /**
  * A connection is idle when the client is gone
  * and there are no outstanding msgs in the msg queue.
@@ -569,7 +690,8 @@ iproto_connection_stop_msg_max_limit(struct iproto_connection *con)
 	 * Important to add to tail and fetch from head to ensure
 	 * strict lifo order (fairness) for stopped connections.
 	 */
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&con->iproto_thread->stopped_connections,
+		       &con->in_stop_list);
 }
 
 /**
@@ -596,7 +718,8 @@ iproto_connection_close(struct iproto_connection *con)
 		 * is done only once.
 		 */
 		con->p_ibuf->wpos -= con->parse_size;
-		cpipe_push(&tx_pipe, &con->disconnect_msg);
+		cpipe_push(&con->iproto_thread->tx_pipe,
+			   &con->disconnect_msg);
 	}
 	/*
 	 * If the connection has no outstanding requests in the
@@ -613,7 +736,7 @@ iproto_connection_close(struct iproto_connection *con)
 	if (iproto_connection_is_idle(con)) {
 		assert(! con->is_destroy_sent);
 		con->is_destroy_sent = true;
-		cpipe_push(&tx_pipe, &con->destroy_msg);
+		cpipe_push(&con->iproto_thread->tx_pipe, &con->destroy_msg);
 	}
 	rlist_del(&con->in_stop_list);
 }
@@ -722,6 +845,48 @@ iproto_connection_input_buffer(struct iproto_connection *con)
 	return new_ibuf;
 }
 
+/**
+ * Return true if the request may be delivered to tx as a part
+ * of a batch, see struct iproto_batch.
+ */
+static inline bool
+iproto_msg_is_batchable(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	return msg->base.route == iproto_thread->select_route;
+}
+
+/**
+ * Push the requests collected for a batch to tx. A single
+ * request, or all of them if there is no memory for a batch,
+ * are pushed as ordinary messages.
+ */
+static void
+iproto_push_batch(struct iproto_connection *con, struct stailq *msgs)
+{
+	if (stailq_empty(msgs))
+		return;
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	struct iproto_batch *batch = NULL;
+	if (stailq_first(msgs) != stailq_last(msgs)) {
+		batch = (struct iproto_batch *)
+			mempool_alloc(&iproto_thread->iproto_batch_pool);
+	}
+	if (batch != NULL) {
+		cmsg_init(&batch->base, iproto_thread->batch_route);
+		batch->connection = con;
+		stailq_create(&batch->msgs);
+		stailq_concat(&batch->msgs, msgs);
+		cpipe_push_input(&iproto_thread->tx_pipe, &batch->base);
+		rmean_collect(iproto_thread->rmean, IPROTO_BATCHES, 1);
+		return;
+	}
+	struct iproto_msg *msg;
+	stailq_foreach_entry(msg, msgs, in_batch)
+		cpipe_push_input(&iproto_thread->tx_pipe, &msg->base);
+	stailq_create(msgs);
+}
+
 /**
  * Enqueue all requests which were read up. If a request limit is
  * reached - stop the connection input even if not the whole batch
@@ -737,13 +902,21 @@ static inline int
 iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	assert(rlist_empty(&con->in_stop_list));
+	struct cpipe *tx_pipe = &con->iproto_thread->tx_pipe;
 	int n_requests = 0;
 	bool stop_input = false;
 	const char *errmsg;
+	/*
+	 * Requests to be delivered in one message, kept in
+	 * the parse order with respect to other requests.
+	 */
+	struct stailq batch;
+	stailq_create(&batch);
 	while (con->parse_size != 0 && !stop_input) {
-		if (iproto_check_msg_max()) {
+		if (iproto_check_msg_max(con->iproto_thread)) {
 			iproto_connection_stop_msg_max_limit(con);
-			cpipe_flush_input(&tx_pipe);
+			iproto_push_batch(con, &batch);
+			cpipe_flush_input(tx_pipe);
 			return 0;
 		}
 		const char *reqstart = in->wpos - con->parse_size;
@@ -752,7 +925,8 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		if (mp_typeof(*pos) != MP_UINT) {
 			errmsg = "packet length";
 err_msgpack:
-			cpipe_flush_input(&tx_pipe);
+			iproto_push_batch(con, &batch);
+			cpipe_flush_input(tx_pipe);
 			diag_set(ClientError, ER_INVALID_MSGPACK,
 				 errmsg);
 			return -1;
@@ -776,6 +950,8 @@ err_msgpack:
 			 * until some of requests are finished.
 			 */
 			iproto_connection_stop_msg_max_limit(con);
+			iproto_push_batch(con, &batch);
+			cpipe_flush_input(tx_pipe);
 			return 0;
 		}
 		msg->p_ibuf = con->p_ibuf;
@@ -788,13 +964,22 @@ err_msgpack:
 		 * This can't throw, but should not be
 		 * done in case of exception.
 		 */
-		cpipe_push_input(&tx_pipe, &msg->base);
+		if (msg->read_view.pipe != NULL) {
+			iproto_push_batch(con, &batch);
+			cpipe_push(msg->read_view.pipe, &msg->base);
+		} else if (iproto_batch && iproto_msg_is_batchable(msg)) {
+			stailq_add_tail_entry(&batch, msg, in_batch);
+		} else {
+			iproto_push_batch(con, &batch);
+			cpipe_push_input(tx_pipe, &msg->base);
+		}
 		n_requests++;
 		/* Request is parsed */
 		assert(reqend > reqstart);
 		assert(con->parse_size >= (size_t) (reqend - reqstart));
 		con->parse_size -= reqend - reqstart;
 	}
+	iproto_push_batch(con, &batch);
 	if (stop_input) {
 		/**
 		 * Don't mess with the file descriptor
@@ -826,7 +1011,7 @@ err_msgpack:
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(tx_pipe);
 	return 0;
 }
 
@@ -838,7 +1023,7 @@ err_msgpack:
 static void
 iproto_connection_resume(struct iproto_connection *con)
 {
-	assert(! iproto_check_msg_max());
+	assert(! iproto_check_msg_max(con->iproto_thread));
 	rlist_del(&con->in_stop_list);
 	/*
 	 * Enqueue_batch() stops the connection again, if the
@@ -862,15 +1047,17 @@ iproto_connection_resume(struct iproto_connection *con)
  * necessary to use up the limit.
  */
 static void
-iproto_resume()
+iproto_resume(struct iproto_thread *iproto_thread)
 {
-	while (!iproto_check_msg_max() && !rlist_empty(&stopped_connections)) {
+	struct rlist *stopped = &iproto_thread->stopped_connections;
+	while (!iproto_check_msg_max(iproto_thread) &&
+	       !rlist_empty(stopped)) {
 		/*
 		 * Shift from list head to ensure strict FIFO
 		 * (fairness) for resumed connections.
 		 */
 		struct iproto_connection *con =
-			rlist_first_entry(&stopped_connections,
+			rlist_first_entry(stopped,
 					  struct iproto_connection,
 					  in_stop_list);
 		iproto_connection_resume(con);
@@ -892,7 +1079,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * otherwise we might deplete the fiber pool in tx
 	 * thread and deadlock.
 	 */
-	if (iproto_check_msg_max()) {
+	if (iproto_check_msg_max(con->iproto_thread)) {
 		iproto_connection_stop_msg_max_limit(con);
 		return;
 	}
@@ -917,7 +1104,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -976,7 +1163,7 @@ iproto_flush(struct iproto_connection *con)
 
 	if (nwr > 0) {
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_SENT, nwr);
+		rmean_collect(con->iproto_thread->rmean, IPROTO_SENT, nwr);
 		if (begin->used + nwr == end->used) {
 			*begin = *end;
 			return 0;
@@ -1021,15 +1208,16 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 }
 
 static struct iproto_connection *
-iproto_connection_new(int fd)
+iproto_connection_new(struct iproto_thread *iproto_thread, int fd)
 {
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc(&iproto_connection_pool);
+		mempool_alloc(&iproto_thread->iproto_connection_pool);
 	if (con == NULL) {
 		diag_set(OutOfMemory, sizeof(*con), "mempool_alloc", "con");
 		return NULL;
 	}
 	con->input.data = con->output.data = con;
+	con->iproto_thread = iproto_thread;
 	con->loop = loop();
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
 	ev_io_init(&con->output, iproto_connection_on_output, fd, EV_WRITE);
@@ -1046,12 +1234,12 @@ iproto_connection_new(int fd)
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
 	/* It may be very awkward to allocate at close. */
-	cmsg_init(&con->destroy_msg, destroy_route);
+	cmsg_init(&con->destroy_msg, iproto_thread->destroy_route);
 	cmsg_init(&con->disconnect_msg, disconnect_route);
 	con->is_destroy_sent = false;
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = false;
-	rmean_collect(rmean_net, IPROTO_CONNECTIONS, 1);
+	rmean_collect(iproto_thread->rmean, IPROTO_CONNECTIONS, 1);
 	return con;
 }
 
@@ -1073,7 +1261,7 @@ iproto_connection_delete(struct iproto_connection *con)
 	       con->obuf[0].iov[0].iov_base == NULL);
 	assert(con->obuf[1].pos == 0 &&
 	       con->obuf[1].iov[0].iov_base == NULL);
-	mempool_free(&iproto_connection_pool, con);
+	mempool_free(&con->iproto_thread->iproto_connection_pool, con);
 }
 
 /* }}} iproto_connection */
@@ -1095,6 +1283,9 @@ tx_process_select(struct cmsg *msg);
 static void
 tx_process_sql(struct cmsg *msg);
 
+static void
+tx_process_cursor(struct cmsg *msg);
+
 static void
 tx_reply_error(struct iproto_msg *msg);
 
@@ -1116,67 +1307,119 @@ net_end_join(struct cmsg *msg);
 static void
 net_end_subscribe(struct cmsg *msg);
 
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+tx_process_connect(struct cmsg *msg);
 
-static const struct cmsg_hop call_route[] = {
-	{ tx_process_call, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+net_send_greeting(struct cmsg *msg);
 
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+tx_process_batch(struct cmsg *msg);
 
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+net_send_batch(struct cmsg *msg);
 
-static const struct cmsg_hop sql_route[] = {
-	{ tx_process_sql, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+rv_process_select(struct cmsg *msg);
 
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	call_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	call_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	call_route,                             /* IPROTO_CALL */
-	sql_route,                              /* IPROTO_EXECUTE */
-	NULL,                                   /* IPROTO_NOP */
-};
+static void
+tx_process_read_view_select(struct cmsg *msg);
 
-static const struct cmsg_hop join_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join, NULL },
-};
+static inline void
+iproto_route_init(struct cmsg_hop *route, cmsg_f tx_f, cmsg_f net_f,
+		  struct iproto_thread *iproto_thread)
+{
+	route[0].f = tx_f;
+	route[0].pipe = &iproto_thread->net_pipe;
+	route[1].f = net_f;
+	route[1].pipe = NULL;
+}
 
-static const struct cmsg_hop subscribe_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_subscribe, NULL },
-};
+/** Initialize routes of messages sent by the thread. */
+static void
+iproto_thread_init_routes(struct iproto_thread *iproto_thread)
+{
+	iproto_route_init(iproto_thread->destroy_route, tx_process_destroy,
+			  net_finish_destroy, iproto_thread);
+	iproto_thread->push_route[0].f = iproto_process_push;
+	iproto_thread->push_route[0].pipe = &iproto_thread->tx_pipe;
+	iproto_thread->push_route[1].f = tx_end_push;
+	iproto_thread->push_route[1].pipe = NULL;
+	iproto_route_init(iproto_thread->misc_route, tx_process_misc,
+			  net_send_msg, iproto_thread);
+	iproto_route_init(iproto_thread->call_route, tx_process_call,
+			  net_send_msg, iproto_thread);
+	iproto_route_init(iproto_thread->select_route, tx_process_select,
+			  net_send_msg, iproto_thread);
+	iproto_route_init(iproto_thread->process1_route, tx_process1,
+			  net_send_msg, iproto_thread);
+	iproto_route_init(iproto_thread->sql_route, tx_process_sql,
+			  net_send_msg, iproto_thread);
+	iproto_route_init(iproto_thread->cursor_route, tx_process_cursor,
+			  net_send_msg, iproto_thread);
+	iproto_route_init(iproto_thread->join_route,
+			  tx_process_join_subscribe, net_end_join,
+			  iproto_thread);
+	iproto_route_init(iproto_thread->subscribe_route,
+			  tx_process_join_subscribe, net_end_subscribe,
+			  iproto_thread);
+	iproto_route_init(iproto_thread->error_route, tx_reply_iproto_error,
+			  net_send_error, iproto_thread);
+	iproto_route_init(iproto_thread->connect_route, tx_process_connect,
+			  net_send_greeting, iproto_thread);
+	iproto_route_init(iproto_thread->batch_route, tx_process_batch,
+			  net_send_batch, iproto_thread);
+
+	const struct cmsg_hop **dml_route = iproto_thread->dml_route;
+	memset(dml_route, 0, sizeof(iproto_thread->dml_route));
+	dml_route[IPROTO_SELECT] = iproto_thread->select_route;
+	dml_route[IPROTO_INSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_REPLACE] = iproto_thread->process1_route;
+	dml_route[IPROTO_UPDATE] = iproto_thread->process1_route;
+	dml_route[IPROTO_DELETE] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL_16] = iproto_thread->call_route;
+	dml_route[IPROTO_AUTH] = iproto_thread->misc_route;
+	dml_route[IPROTO_EVAL] = iproto_thread->call_route;
+	dml_route[IPROTO_UPSERT] = iproto_thread->process1_route;
+	dml_route[IPROTO_CALL] = iproto_thread->call_route;
+	dml_route[IPROTO_EXECUTE] = iproto_thread->sql_route;
+	dml_route[IPROTO_GET_MANY] = iproto_thread->select_route;
+
+	for (int i = 0; i < iproto_readers_count; i++) {
+		struct cmsg_hop *route = iproto_thread->reader_routes[i];
+		route[0].f = rv_process_select;
+		route[0].pipe = &iproto_readers[i].tx_pipe;
+		route[1].f = tx_process_read_view_select;
+		route[1].pipe = &iproto_thread->net_pipe;
+		route[2].f = net_send_msg;
+		route[2].pipe = NULL;
+	}
+}
 
-static const struct cmsg_hop error_route[] = {
-	{ tx_reply_iproto_error, &net_pipe },
-	{ net_send_error, NULL },
-};
+/**
+ * Send the SELECT to a reader thread if it may be served
+ * from a read view.
+ */
+static inline void
+iproto_msg_route_to_reader(struct iproto_msg *msg)
+{
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	if (iproto_readers_count == 0 || msg->dml.index_id != 0 ||
+	    !read_view_has_space(msg->dml.space_id))
+		return;
+	int i = iproto_thread->next_reader;
+	iproto_thread->next_reader = (i + 1) % iproto_readers_count;
+	cmsg_init(&msg->base, iproto_thread->reader_routes[i]);
+	msg->read_view.pipe = &iproto_thread->reader_pipes[i];
+}
 
 static void
 iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 		  bool *stop_input)
 {
 	uint8_t type;
+	struct iproto_thread *iproto_thread = msg->connection->iproto_thread;
+	msg->read_view.pipe = NULL;
 
 	if (xrow_header_decode(&msg->header, pos, reqend, true))
 		goto error;
@@ -1196,43 +1439,60 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 	case IPROTO_UPDATE:
 	case IPROTO_DELETE:
 	case IPROTO_UPSERT:
+	case IPROTO_GET_MANY:
 		if (xrow_decode_dml(&msg->header, &msg->dml,
 				    dml_request_key_map(type)))
 			goto error;
-		assert(type < sizeof(dml_route)/sizeof(*dml_route));
-		cmsg_init(&msg->base, dml_route[type]);
+		assert(type < lengthof(iproto_thread->dml_route));
+		cmsg_init(&msg->base, iproto_thread->dml_route[type]);
+		if (type == IPROTO_SELECT)
+			iproto_msg_route_to_reader(msg);
 		break;
 	case IPROTO_CALL_16:
 	case IPROTO_CALL:
 	case IPROTO_EVAL:
 		if (xrow_decode_call(&msg->header, &msg->call))
 			goto error;
-		cmsg_init(&msg->base, call_route);
+		cmsg_init(&msg->base, iproto_thread->call_route);
 		break;
 	case IPROTO_EXECUTE:
+	case IPROTO_PREPARE:
 		if (xrow_decode_sql(&msg->header, &msg->sql) != 0)
 			goto error;
-		cmsg_init(&msg->base, sql_route);
+		cmsg_init(&msg->base, iproto_thread->sql_route);
+		break;
+	case IPROTO_CURSOR_OPEN:
+		if (xrow_decode_dml(&msg->header, &msg->dml,
+				    dml_request_key_map(type)))
+			goto error;
+		cmsg_init(&msg->base, iproto_thread->cursor_route);
+		break;
+	case IPROTO_CURSOR_FETCH:
+	case IPROTO_CURSOR_CLOSE:
+		if (xrow_decode_cursor(&msg->header, &msg->cursor) != 0)
+			goto error;
+		cmsg_init(&msg->base, iproto_thread->cursor_route);
 		break;
 	case IPROTO_PING:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_JOIN:
-		cmsg_init(&msg->base, join_route);
+	case IPROTO_FETCH_SNAPSHOT:
+		cmsg_init(&msg->base, iproto_thread->join_route);
 		*stop_input = true;
 		break;
 	case IPROTO_SUBSCRIBE:
-		cmsg_init(&msg->base, subscribe_route);
+		cmsg_init(&msg->base, iproto_thread->subscribe_route);
 		*stop_input = true;
 		break;
 	case IPROTO_VOTE_DEPRECATED:
 	case IPROTO_VOTE:
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	case IPROTO_AUTH:
 		if (xrow_decode_auth(&msg->header, &msg->auth))
 			goto error;
-		cmsg_init(&msg->base, misc_route);
+		cmsg_init(&msg->base, iproto_thread->misc_route);
 		break;
 	default:
 		diag_set(ClientError, ER_UNKNOWN_REQUEST_TYPE,
@@ -1245,7 +1505,7 @@ error:
 	diag_log();
 	diag_create(&msg->diag);
 	diag_move(&fiber()->diag, &msg->diag);
-	cmsg_init(&msg->base, error_route);
+	cmsg_init(&msg->base, iproto_thread->error_route);
 }
 
 static void
@@ -1348,7 +1608,8 @@ tx_discard_input(struct iproto_msg *msg)
 		{ net_discard_input, NULL },
 	};
 	cmsg_init(&msg->discard_input, discard_input_route);
-	cpipe_push(&net_pipe, &msg->discard_input);
+	cpipe_push(&msg->connection->iproto_thread->net_pipe,
+		   &msg->discard_input);
 }
 
 /**
@@ -1476,9 +1737,14 @@ tx_process_select(struct cmsg *m)
 		goto error;
 
 	tx_inject_delay();
-	rc = box_select(req->space_id, req->index_id,
-			req->iterator, req->offset, req->limit,
-			req->key, req->key_end, &port);
+	if (msg->header.type == IPROTO_GET_MANY) {
+		rc = box_get_many(req->space_id, req->index_id,
+				  req->key, req->key_end, &port);
+	} else {
+		rc = box_select(req->space_id, req->index_id,
+				req->iterator, req->offset, req->limit,
+				req->key, req->key_end, &port);
+	}
 	if (rc < 0)
 		goto error;
 
@@ -1505,6 +1771,178 @@ error:
 	tx_reply_error(msg);
 }
 
+/**
+ * Write the next page of a cursor to the output buffer. The
+ * page is cut short if the output buffer is full, but has at
+ * least one tuple, so that the cursor keeps moving.
+ */
+static int
+tx_fetch_cursor(struct iproto_msg *msg, struct obuf *out)
+{
+	struct session_cursor *cursor =
+		session_cursor_find(msg->connection->session,
+				    msg->cursor.cursor_id);
+	if (cursor == NULL)
+		return -1;
+	struct obuf_svp svp;
+	if (iproto_prepare_select(out, &svp) != 0)
+		return -1;
+	/* Reading the page may yield, see session_cursor::is_busy. */
+	cursor->is_busy = true;
+	uint32_t count = 0;
+	while (count < msg->cursor.limit) {
+		if (count > 0 && obuf_size(out) >= IPROTO_CURSOR_OBUF_MAX)
+			break;
+		struct tuple *tuple;
+		if (session_cursor_next(cursor, &tuple) != 0)
+			goto error;
+		if (tuple == NULL)
+			break;
+		if (tuple_to_obuf(tuple, out) != 0)
+			goto error;
+		count++;
+	}
+	cursor->is_busy = false;
+	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
+			    count);
+	return 0;
+error:
+	cursor->is_busy = false;
+	obuf_rollback_to_svp(out, &svp);
+	return -1;
+}
+
+static void
+tx_process_cursor(struct cmsg *m)
+{
+	struct iproto_msg *msg = tx_accept_msg(m);
+	struct obuf *out = msg->connection->tx.p_obuf;
+	struct session *session = msg->connection->session;
+	struct session_cursor *cursor;
+	struct request *req = &msg->dml;
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+
+	switch (msg->header.type) {
+	case IPROTO_CURSOR_OPEN:
+		cursor = session_cursor_new(session, req->space_id,
+					    req->index_id, req->iterator,
+					    req->key, req->key_end);
+		if (cursor == NULL)
+			goto error;
+		if (iproto_reply_cursor(out, cursor->id, msg->header.sync,
+					::schema_version) != 0) {
+			session_cursor_delete(cursor);
+			goto error;
+		}
+		break;
+	case IPROTO_CURSOR_FETCH:
+		if (tx_fetch_cursor(msg, out) != 0)
+			goto error;
+		break;
+	case IPROTO_CURSOR_CLOSE:
+		cursor = session_cursor_find(session, msg->cursor.cursor_id);
+		if (cursor == NULL)
+			goto error;
+		session_cursor_delete(cursor);
+		if (iproto_reply_ok(out, msg->header.sync,
+				    ::schema_version) != 0)
+			goto error;
+		break;
+	default:
+		unreachable();
+	}
+	iproto_wpos_create(&msg->wpos, out);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
+/**
+ * Execute a SELECT in a reader thread. The result is only
+ * encoded here, tx checks access and sends it.
+ */
+static void
+rv_process_select(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct request *req = &msg->dml;
+	msg->read_view.count = -1;
+	struct read_view *rv = read_view_acquire(req->space_id);
+	if (rv == NULL)
+		return;
+	msg->read_view.schema_version = read_view_schema_version(rv);
+	msg->read_view.count = read_view_select(rv, req->space_id,
+						req->iterator, req->offset,
+						req->limit, req->key,
+						req->key_end,
+						&msg->read_view.data,
+						&msg->read_view.size);
+	read_view_release(rv);
+	/* Errors are reported by tx, which repeats the request. */
+	diag_clear(diag_get());
+}
+
+static void
+tx_process_read_view_select(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct obuf *out;
+	struct obuf_svp svp;
+	struct space *space;
+	if (msg->read_view.count < 0 ||
+	    msg->read_view.schema_version != ::schema_version) {
+		/* The read view can't serve the request. */
+		if (msg->read_view.count >= 0)
+			free(msg->read_view.data);
+		tx_process_select(m);
+		return;
+	}
+	tx_accept_msg(m);
+	if (tx_check_schema(msg->header.schema_version))
+		goto error;
+	rmean_collect(rmean_box, IPROTO_SELECT, 1);
+	space = space_cache_find(msg->dml.space_id);
+	if (space == NULL)
+		goto error;
+	if (access_check_space(space, PRIV_R) != 0)
+		goto error;
+	out = msg->connection->tx.p_obuf;
+	if (iproto_prepare_select(out, &svp) != 0)
+		goto error;
+	if (msg->read_view.size > 0 &&
+	    obuf_dup(out, msg->read_view.data,
+		     msg->read_view.size) != msg->read_view.size) {
+		obuf_rollback_to_svp(out, &svp);
+		diag_set(OutOfMemory, msg->read_view.size, "obuf_dup",
+			 "msg->read_view.data");
+		goto error;
+	}
+	iproto_reply_select(out, &svp, msg->header.sync, ::schema_version,
+			    msg->read_view.count);
+	iproto_wpos_create(&msg->wpos, out);
+	free(msg->read_view.data);
+	return;
+error:
+	free(msg->read_view.data);
+	tx_reply_error(msg);
+}
+
+/**
+ * Execute requests of a batch in a row in the same fiber.
+ * Every request writes its reply to the connection output
+ * buffer and the write position of the last one is sent
+ * back to iproto.
+ */
+static void
+tx_process_batch(struct cmsg *m)
+{
+	struct iproto_batch *batch = (struct iproto_batch *) m;
+	struct iproto_msg *msg;
+	stailq_foreach_entry(msg, &batch->msgs, in_batch)
+		msg->base.route[0].f(&msg->base);
+}
+
 static void
 tx_process_call_on_yield(struct trigger *trigger, void *event)
 {
@@ -1637,6 +2075,24 @@ error:
 	tx_reply_error(msg);
 }
 
+/** Compile an SQL statement and reply with its id. */
+static void
+tx_process_prepare(struct iproto_msg *msg)
+{
+	uint32_t len, stmt_id;
+	const char *sql = msg->sql.sql_text;
+	sql = mp_decode_str(&sql, &len);
+	if (sql_stmt_prepare(sql, len, &stmt_id) != 0)
+		goto error;
+	if (iproto_reply_prepare(msg->connection->tx.p_obuf, stmt_id,
+				 msg->header.sync, ::schema_version) != 0)
+		goto error;
+	iproto_wpos_create(&msg->wpos, msg->connection->tx.p_obuf);
+	return;
+error:
+	tx_reply_error(msg);
+}
+
 static void
 tx_process_sql(struct cmsg *m)
 {
@@ -1652,6 +2108,10 @@ tx_process_sql(struct cmsg *m)
 
 	if (tx_check_schema(msg->header.schema_version))
 		goto error;
+	if (msg->header.type == IPROTO_PREPARE) {
+		tx_process_prepare(msg);
+		return;
+	}
 	assert(msg->header.type == IPROTO_EXECUTE);
 	tx_inject_delay();
 	if (msg->sql.bind != NULL) {
@@ -1659,11 +2119,17 @@ tx_process_sql(struct cmsg *m)
 		if (bind_count < 0)
 			goto error;
 	}
-	sql = msg->sql.sql_text;
-	sql = mp_decode_str(&sql, &len);
-	if (sql_prepare_and_execute(sql, len, bind, bind_count, &port,
-				    &fiber()->gc) != 0)
-		goto error;
+	if (msg->sql.sql_text == NULL) {
+		if (sql_execute_prepared(msg->sql.stmt_id, bind, bind_count,
+					 &port, &fiber()->gc) != 0)
+			goto error;
+	} else {
+		sql = msg->sql.sql_text;
+		sql = mp_decode_str(&sql, &len);
+		if (sql_prepare_and_execute(sql, len, bind, bind_count, &port,
+					    &fiber()->gc) != 0)
+			goto error;
+	}
 	/*
 	 * Take an obuf only after execute(). Else the buffer can
 	 * become out of date during yield.
@@ -1703,6 +2169,9 @@ tx_process_join_subscribe(struct cmsg *m)
 			 */
 			box_process_join(&con->input, &msg->header);
 			break;
+		case IPROTO_FETCH_SNAPSHOT:
+			box_process_fetch_snapshot(&con->input, &msg->header);
+			break;
 		case IPROTO_SUBSCRIBE:
 			/*
 			 * Subscribe never returns - unless there
@@ -1723,12 +2192,14 @@ tx_process_join_subscribe(struct cmsg *m)
 	}
 }
 
-static void
-net_send_msg(struct cmsg *m)
+/**
+ * Discard the request input and advance the connection
+ * write position to the end of the reply.
+ */
+static inline void
+net_end_msg(struct iproto_msg *msg)
 {
-	struct iproto_msg *msg = (struct iproto_msg *) m;
 	struct iproto_connection *con = msg->connection;
-
 	if (msg->len != 0) {
 		/* Discard request (see iproto_enqueue_batch()). */
 		msg->p_ibuf->rpos += msg->len;
@@ -1738,16 +2209,49 @@ net_send_msg(struct cmsg *m)
 		con->long_poll_count--;
 	}
 	con->wend = msg->wpos;
+}
 
+/** Flush the connection output or close it if it is done. */
+static inline void
+net_flush_output(struct iproto_connection *con)
+{
 	if (evio_has_fd(&con->output)) {
 		if (! ev_is_active(&con->output))
 			ev_feed_event(con->loop, &con->output, EV_WRITE);
 	} else if (iproto_connection_is_idle(con)) {
 		iproto_connection_close(con);
 	}
+}
+
+static void
+net_send_msg(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	net_end_msg(msg);
+	net_flush_output(msg->connection);
 	iproto_msg_delete(msg);
 }
 
+/**
+ * Complete all requests of a batch: the replies are written
+ * by tx one after another, so the output is flushed once.
+ */
+static void
+net_send_batch(struct cmsg *m)
+{
+	struct iproto_batch *batch = (struct iproto_batch *) m;
+	struct iproto_connection *con = batch->connection;
+	struct iproto_thread *iproto_thread = con->iproto_thread;
+	struct iproto_msg *msg, *next;
+	stailq_foreach_entry(msg, &batch->msgs, in_batch)
+		net_end_msg(msg);
+	net_flush_output(con);
+	stailq_foreach_entry_safe(msg, next, &batch->msgs, in_batch)
+		mempool_free(&iproto_thread->iproto_msg_pool, msg);
+	mempool_free(&iproto_thread->iproto_batch_pool, batch);
+	iproto_resume(iproto_thread);
+}
+
 /**
  * Complete sending an iproto error: 
  * recycle the error object and flush output.
@@ -1844,7 +2348,8 @@ net_send_greeting(struct cmsg *m)
 
 		if (nwr > 0) {
 			/* Count statistics. */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->iproto_thread->rmean, IPROTO_SENT,
+				      nwr);
 		} else if (nwr < 0 && ! sio_wouldblock(errno)) {
 			diag_log();
 		}
@@ -1865,24 +2370,22 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
-
 /** }}} */
 
 /**
  * Create a connection and start input.
  */
 static int
-iproto_on_accept(struct evio_service * /* service */, int fd,
+iproto_on_accept(struct evio_service *service, int fd,
 		 struct sockaddr *addr, socklen_t addrlen)
 {
 	(void) addr;
 	(void) addrlen;
+	struct iproto_thread *iproto_thread =
+		(struct iproto_thread *) service->on_accept_param;
 	struct iproto_msg *msg;
-	struct iproto_connection *con = iproto_connection_new(fd);
+	struct iproto_connection *con =
+		iproto_connection_new(iproto_thread, fd);
 	if (con == NULL)
 		return -1;
 	/*
@@ -1892,62 +2395,94 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	 */
 	msg = iproto_msg_new(con);
 	if (msg == NULL) {
-		mempool_free(&iproto_connection_pool, con);
+		mempool_free(&iproto_thread->iproto_connection_pool, con);
 		return -1;
 	}
-	cmsg_init(&msg->base, connect_route);
+	cmsg_init(&msg->base, iproto_thread->connect_route);
 	msg->p_ibuf = con->p_ibuf;
 	msg->wpos = con->wpos;
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, &msg->base);
+	cpipe_push(&iproto_thread->tx_pipe, &msg->base);
 	return 0;
 }
 
-static struct evio_service binary; /* iproto binary listener */
-
 /**
  * The network io thread main function:
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
-		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
-		       sizeof(struct iproto_connection));
+	struct iproto_thread *iproto_thread =
+		va_arg(ap, struct iproto_thread *);
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
+	mempool_create(&iproto_thread->iproto_msg_pool, &cord()->slabc,
+		       sizeof(struct iproto_msg));
+	mempool_create(&iproto_thread->iproto_connection_pool,
+		       &cord()->slabc, sizeof(struct iproto_connection));
+	mempool_create(&iproto_thread->iproto_batch_pool, &cord()->slabc,
+		       sizeof(struct iproto_batch));
+	rlist_create(&iproto_thread->stopped_connections);
 
+	evio_service_init(loop(), &iproto_thread->binary, "binary",
+			  iproto_on_accept, iproto_thread);
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	iproto_thread->rmean = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (iproto_thread->rmean == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
 	struct cbus_endpoint endpoint;
-	/* Create "net" endpoint. */
-	cbus_endpoint_create(&endpoint, "net", fiber_schedule_cb, fiber());
+	/* Create "net<id>" endpoint. */
+	cbus_endpoint_create(&endpoint,
+			     tt_sprintf("net%d", iproto_thread->id),
+			     fiber_schedule_cb, fiber());
 	/* Create a pipe to "tx" thread. */
-	cpipe_create(&tx_pipe, "tx");
-	cpipe_set_max_input(&tx_pipe, iproto_msg_max / 2);
+	cpipe_create(&iproto_thread->tx_pipe, "tx");
+	cpipe_set_max_input(&iproto_thread->tx_pipe, iproto_msg_max / 2);
+	/* Create pipes to reader threads. */
+	for (int i = 0; i < iproto_readers_count; i++) {
+		cpipe_create(&iproto_thread->reader_pipes[i],
+			     tt_sprintf("reader%d", i));
+	}
 	/* Process incomming messages. */
 	cbus_loop(&endpoint);
 
-	cpipe_destroy(&tx_pipe);
+	for (int i = 0; i < iproto_readers_count; i++)
+		cpipe_destroy(&iproto_thread->reader_pipes[i]);
+	cpipe_destroy(&iproto_thread->tx_pipe);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
-	if (evio_service_is_active(&binary))
-		evio_service_stop(&binary);
+	if (iproto_thread->id != 0)
+		evio_service_detach(&iproto_thread->binary);
+	else if (evio_service_is_active(&iproto_thread->binary))
+		evio_service_stop(&iproto_thread->binary);
 
-	rmean_delete(rmean_net);
+	rmean_delete(iproto_thread->rmean);
+	return 0;
+}
+
+/** The reader thread main function. */
+static int
+reader_cord_f(va_list ap)
+{
+	struct iproto_reader *reader = va_arg(ap, struct iproto_reader *);
+	struct cbus_endpoint endpoint;
+	/* Create "reader<id>" endpoint. */
+	cbus_endpoint_create(&endpoint, tt_sprintf("reader%d", reader->id),
+			     fiber_schedule_cb, fiber());
+	/* Create a pipe to "tx" thread. */
+	cpipe_create(&reader->tx_pipe, "tx");
+	cpipe_set_max_input(&reader->tx_pipe, iproto_msg_max / 2);
+	/* Process incomming messages. */
+	cbus_loop(&endpoint);
+	cpipe_destroy(&reader->tx_pipe);
 	return 0;
 }
 
@@ -1989,11 +2524,12 @@ static void
 tx_begin_push(struct iproto_connection *con)
 {
 	assert(! con->tx.is_push_sent);
-	cmsg_init(&con->kharon.base, push_route);
+	cmsg_init(&con->kharon.base, con->iproto_thread->push_route);
 	iproto_wpos_create(&con->kharon.wpos, con->tx.p_obuf);
 	con->tx.is_push_pending = false;
 	con->tx.is_push_sent = true;
-	cpipe_push(&net_pipe, (struct cmsg *) &con->kharon);
+	cpipe_push(&con->iproto_thread->net_pipe,
+		   (struct cmsg *) &con->kharon);
 }
 
 static void
@@ -2041,18 +2577,63 @@ iproto_session_push(struct session *session, uint64_t sync, struct port *port)
 
 /** }}} */
 
-/** Initialize the iproto subsystem and start network io thread */
+/** Initialize the iproto subsystem and start network io threads */
 void
-iproto_init()
+iproto_init(int threads_count, int readers_count)
 {
+	assert(threads_count > 0 && threads_count <= IPROTO_THREADS_MAX);
+	assert(readers_count >= 0 && readers_count <= IPROTO_THREADS_MAX);
 	slab_cache_create(&net_slabc, &runtime);
 
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
+	if (readers_count > 0) {
+		iproto_readers = (struct iproto_reader *)
+			calloc(readers_count, sizeof(*iproto_readers));
+		if (iproto_readers == NULL) {
+			tnt_raise(OutOfMemory,
+				  readers_count * sizeof(*iproto_readers),
+				  "calloc", "struct iproto_reader");
+		}
+	}
+	iproto_readers_count = readers_count;
+	for (int i = 0; i < readers_count; i++) {
+		struct iproto_reader *reader = &iproto_readers[i];
+		reader->id = i;
+		if (cord_costart(&reader->cord, tt_sprintf("reader%d", i),
+				 reader_cord_f, reader))
+			panic("failed to initialize reader thread");
+	}
 
-	/* Create a pipe to "net" thread. */
-	cpipe_create(&net_pipe, "net");
-	cpipe_set_max_input(&net_pipe, iproto_msg_max / 2);
+	iproto_threads = (struct iproto_thread *)
+		calloc(threads_count, sizeof(*iproto_threads));
+	if (iproto_threads == NULL) {
+		tnt_raise(OutOfMemory, threads_count * sizeof(*iproto_threads),
+			  "calloc", "struct iproto_thread");
+	}
+	iproto_threads_count = threads_count;
+	for (int i = 0; i < threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_thread->id = i;
+		if (readers_count > 0) {
+			iproto_thread->reader_pipes = (struct cpipe *)
+				calloc(readers_count,
+				       sizeof(*iproto_thread->reader_pipes));
+			iproto_thread->reader_routes = (struct cmsg_hop (*)[3])
+				calloc(readers_count,
+				       sizeof(*iproto_thread->reader_routes));
+			if (iproto_thread->reader_pipes == NULL ||
+			    iproto_thread->reader_routes == NULL)
+				panic("failed to allocate reader pipes");
+		}
+		iproto_thread_init_routes(iproto_thread);
+		if (cord_costart(&iproto_thread->net_cord,
+				 tt_sprintf("iproto%d", i), net_cord_f,
+				 iproto_thread))
+			panic("failed to initialize iproto thread");
+		/* Create a pipe to "net" thread. */
+		cpipe_create(&iproto_thread->net_pipe, tt_sprintf("net%d", i));
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    iproto_msg_max / 2);
+	}
 	struct session_vtab iproto_session_vtab = {
 		/* .push = */ iproto_session_push,
 		/* .fd = */ iproto_session_fd,
@@ -2064,7 +2645,11 @@ iproto_init()
 /** Available iproto configuration changes. */
 enum iproto_cfg_op {
 	IPROTO_CFG_MSG_MAX,
-	IPROTO_CFG_LISTEN
+	IPROTO_CFG_LISTEN,
+	/** Start accepting connections on thread 0 socket. */
+	IPROTO_CFG_ATTACH,
+	/** Stop accepting connections on thread 0 socket. */
+	IPROTO_CFG_DETACH,
 };
 
 /**
@@ -2077,6 +2662,8 @@ struct iproto_cfg_msg: public cbus_call_msg
 {
 	/** Operation to execute in iproto thread. */
 	enum iproto_cfg_op op;
+	/** The thread the message is sent to. */
+	struct iproto_thread *iproto_thread;
 	union {
 		/** New URI to bind to. */
 		const char *uri;
@@ -2097,25 +2684,30 @@ static int
 iproto_do_cfg_f(struct cbus_call_msg *m)
 {
 	struct iproto_cfg_msg *cfg_msg = (struct iproto_cfg_msg *) m;
-	int old;
+	struct iproto_thread *iproto_thread = cfg_msg->iproto_thread;
+	struct evio_service *binary = &iproto_thread->binary;
 	try {
 		switch (cfg_msg->op) {
 		case IPROTO_CFG_MSG_MAX:
-			cpipe_set_max_input(&tx_pipe,
+			cpipe_set_max_input(&iproto_thread->tx_pipe,
 					    cfg_msg->iproto_msg_max / 2);
-			old = iproto_msg_max;
 			iproto_msg_max = cfg_msg->iproto_msg_max;
-			if (old < iproto_msg_max)
-				iproto_resume();
+			iproto_resume(iproto_thread);
 			break;
 		case IPROTO_CFG_LISTEN:
-			if (evio_service_is_active(&binary))
-				evio_service_stop(&binary);
+			if (evio_service_is_active(binary))
+				evio_service_stop(binary);
 			if (cfg_msg->uri != NULL &&
-			    (evio_service_bind(&binary, cfg_msg->uri) != 0 ||
-			     evio_service_listen(&binary) != 0))
+			    (evio_service_bind(binary, cfg_msg->uri) != 0 ||
+			     evio_service_listen(binary) != 0))
 				diag_raise();
 			break;
+		case IPROTO_CFG_ATTACH:
+			evio_service_attach(binary, &iproto_threads[0].binary);
+			break;
+		case IPROTO_CFG_DETACH:
+			evio_service_detach(binary);
+			break;
 		default:
 			unreachable();
 		}
@@ -2126,10 +2718,11 @@ iproto_do_cfg_f(struct cbus_call_msg *m)
 }
 
 static inline void
-iproto_do_cfg(struct iproto_cfg_msg *msg)
+iproto_do_cfg(struct iproto_thread *iproto_thread, struct iproto_cfg_msg *msg)
 {
-	if (cbus_call(&net_pipe, &tx_pipe, msg, iproto_do_cfg_f,
-		      NULL, TIMEOUT_INFINITY) != 0)
+	msg->iproto_thread = iproto_thread;
+	if (cbus_call(&iproto_thread->net_pipe, &iproto_thread->tx_pipe, msg,
+		      iproto_do_cfg_f, NULL, TIMEOUT_INFINITY) != 0)
 		diag_raise();
 }
 
@@ -2137,33 +2730,76 @@ void
 iproto_listen(const char *uri)
 {
 	struct iproto_cfg_msg cfg_msg;
+	/*
+	 * Only thread 0 binds the socket. The other threads
+	 * stop accepting on the old socket before it is closed
+	 * and start accepting on the new one once it listens.
+	 */
+	for (int i = 1; i < iproto_threads_count; i++) {
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_DETACH);
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+	}
 	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_LISTEN);
 	cfg_msg.uri = uri;
-	iproto_do_cfg(&cfg_msg);
+	iproto_do_cfg(&iproto_threads[0], &cfg_msg);
+	if (uri == NULL)
+		return;
+	for (int i = 1; i < iproto_threads_count; i++) {
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_ATTACH);
+		iproto_do_cfg(&iproto_threads[i], &cfg_msg);
+	}
 }
 
 size_t
 iproto_mem_used(void)
 {
-	return slab_cache_used(&net_cord.slabc) + slab_cache_used(&net_slabc);
+	size_t mem = slab_cache_used(&net_slabc);
+	for (int i = 0; i < iproto_threads_count; i++)
+		mem += slab_cache_used(&iproto_threads[i].net_cord.slabc);
+	return mem;
 }
 
 size_t
 iproto_connection_count(void)
 {
-	return mempool_count(&iproto_connection_pool);
+	size_t count = 0;
+	for (int i = 0; i < iproto_threads_count; i++)
+		count += mempool_count(&iproto_threads[i].iproto_connection_pool);
+	return count;
 }
 
 size_t
 iproto_request_count(void)
 {
-	return mempool_count(&iproto_msg_pool);
+	size_t count = 0;
+	for (int i = 0; i < iproto_threads_count; i++)
+		count += mempool_count(&iproto_threads[i].iproto_msg_pool);
+	return count;
 }
 
 void
 iproto_reset_stat(void)
 {
-	rmean_cleanup(rmean_net);
+	for (int i = 0; i < iproto_threads_count; i++)
+		rmean_cleanup(iproto_threads[i].rmean);
+}
+
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx)
+{
+	for (size_t name = 0; name < IPROTO_LAST; name++) {
+		int64_t mean = 0;
+		int64_t total = 0;
+		for (int i = 0; i < iproto_threads_count; i++) {
+			struct rmean *rmean = iproto_threads[i].rmean;
+			mean += rmean_mean(rmean, name);
+			total += rmean_total(rmean, name);
+		}
+		int rc = cb(rmean_net_strings[name], mean, total, cb_ctx);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
 }
 
 void
@@ -2175,22 +2811,33 @@ iproto_set_msg_max(int new_iproto_msg_max)
 				     IPROTO_MSG_MAX_MIN));
 	}
 	struct iproto_cfg_msg cfg_msg;
-	iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
-	cfg_msg.iproto_msg_max = new_iproto_msg_max;
-	iproto_do_cfg(&cfg_msg);
-	cpipe_set_max_input(&net_pipe, new_iproto_msg_max / 2);
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_thread *iproto_thread = &iproto_threads[i];
+		iproto_cfg_msg_create(&cfg_msg, IPROTO_CFG_MSG_MAX);
+		cfg_msg.iproto_msg_max = new_iproto_msg_max;
+		iproto_do_cfg(iproto_thread, &cfg_msg);
+		cpipe_set_max_input(&iproto_thread->net_pipe,
+				    new_iproto_msg_max / 2);
+	}
 }
 
 void
 iproto_free()
 {
-	tt_pthread_cancel(net_cord.id);
-	tt_pthread_join(net_cord.id, NULL);
+	for (int i = 0; i < iproto_threads_count; i++) {
+		tt_pthread_cancel(iproto_threads[i].net_cord.id);
+		tt_pthread_join(iproto_threads[i].net_cord.id, NULL);
+	}
+	for (int i = 0; i < iproto_readers_count; i++) {
+		tt_pthread_cancel(iproto_readers[i].cord.id);
+		tt_pthread_join(iproto_readers[i].cord.id, NULL);
+	}
 	/*
 	* Close socket descriptor to prevent hot standby instance
 	* failing to bind in case it tries to bind before socket
 	* is closed by OS.
 	*/
-	if (evio_service_is_active(&binary))
-		close(binary.ev.fd);
+	struct evio_service *binary = &iproto_threads[0].binary;
+	if (evio_service_is_active(binary))
+		close(binary->ev.fd);
 }
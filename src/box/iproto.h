@@ -32,6 +32,9 @@
  */
 
 #include <stddef.h>
+#include <stdbool.h>
+
+#include "rmean.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -52,9 +55,12 @@ enum {
 	 * processing stops until some new fibers are freed up.
 	 */
 	IPROTO_FIBER_POOL_SIZE_FACTOR = 5,
+	/** The maximal value for iproto_threads. */
+	IPROTO_THREADS_MAX = 1000,
 };
 
 extern unsigned iproto_readahead;
+extern bool iproto_batch;
 
 /**
  * Return size of memory used for storing network buffers.
@@ -80,11 +86,22 @@ iproto_request_count(void);
 void
 iproto_reset_stat(void);
 
+/**
+ * Invoke the callback for each network statistics item
+ * summed over all network threads.
+ */
+int
+iproto_rmean_foreach(rmean_cb cb, void *cb_ctx);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 
+/**
+ * Start the given number of network threads and reader
+ * threads serving SELECTs from read views.
+ */
 void
-iproto_init();
+iproto_init(int threads_count, int readers_count);
 
 void
 iproto_listen(const char *uri);
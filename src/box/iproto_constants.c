@@ -63,9 +63,11 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 		/* 0x15 */	MP_UINT, /* IPROTO_INDEX_BASE */
 	/* }}} */
 
+		/* 0x16 */	MP_UINT, /* IPROTO_CURSOR_ID */
+		/* 0x17 */	MP_UINT, /* IPROTO_STMT_ID */
+	/* }}} */
+
 	/* {{{ unused */
-		/* 0x16 */	MP_UINT,
-		/* 0x17 */	MP_UINT,
 		/* 0x18 */	MP_UINT,
 		/* 0x19 */	MP_UINT,
 		/* 0x1a */	MP_UINT,
@@ -89,6 +91,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 	/* 0x29 */	MP_MAP, /* IPROTO_BALLOT */
 	/* 0x2a */	MP_MAP, /* IPROTO_TUPLE_META */
 	/* 0x2b */	MP_MAP, /* IPROTO_OPTIONS */
+	/* 0x2c */	MP_BOOL, /* IPROTO_COMPRESSION */
+	/* 0x2d */	MP_BIN, /* IPROTO_FRAME */
+	/* 0x2e */	MP_UINT, /* IPROTO_SHARD */
+	/* 0x2f */	MP_UINT, /* IPROTO_SHARD_COUNT */
 	/* }}} */
 };
 
@@ -107,6 +113,11 @@ const char *iproto_type_strs[] =
 	"CALL",
 	"EXECUTE",
 	NULL, /* NOP */
+	NULL, /* GET_MANY */
+	NULL, /* CURSOR_OPEN */
+	NULL, /* CURSOR_FETCH */
+	NULL, /* CURSOR_CLOSE */
+	NULL, /* PREPARE */
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
@@ -124,6 +135,11 @@ const uint64_t iproto_body_key_map[IPROTO_TYPE_STAT_MAX] = {
 	0,                                                     /* CALL */
 	0,                                                     /* EXECUTE */
 	0,                                                     /* NOP */
+	bit(SPACE_ID) | bit(KEY),                              /* GET_MANY */
+	bit(SPACE_ID),                                         /* CURSOR_OPEN */
+	bit(CURSOR_ID),                                        /* CURSOR_FETCH */
+	bit(CURSOR_ID),                                        /* CURSOR_CLOSE */
+	0,                                                     /* PREPARE */
 };
 #undef bit
 
@@ -150,8 +166,8 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"offset",           /* 0x13 */
 	"iterator",         /* 0x14 */
 	"index base",       /* 0x15 */
-	NULL,               /* 0x16 */
-	NULL,               /* 0x17 */
+	"cursor id",        /* 0x16 */
+	"stmt id",          /* 0x17 */
 	NULL,               /* 0x18 */
 	NULL,               /* 0x19 */
 	NULL,               /* 0x1a */
@@ -172,10 +188,10 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"ballot",           /* 0x29 */
 	"tuple meta",       /* 0x2a */
 	"options",          /* 0x2b */
-	NULL,               /* 0x2c */
-	NULL,               /* 0x2d */
-	NULL,               /* 0x2e */
-	NULL,               /* 0x2f */
+	"compression",      /* 0x2c */
+	"frame",            /* 0x2d */
+	"shard",            /* 0x2e */
+	"shard count",      /* 0x2f */
 	"data",             /* 0x30 */
 	"error",            /* 0x31 */
 	"metadata",         /* 0x32 */
@@ -74,6 +74,10 @@ enum iproto_key {
 	IPROTO_OFFSET = 0x13,
 	IPROTO_ITERATOR = 0x14,
 	IPROTO_INDEX_BASE = 0x15,
+	/** Cursor id, see IPROTO_CURSOR_OPEN. */
+	IPROTO_CURSOR_ID = 0x16,
+	/** Prepared SQL statement id, see IPROTO_PREPARE. */
+	IPROTO_STMT_ID = 0x17,
 
 	/* Leave a gap between integer values and other keys */
 	IPROTO_KEY = 0x20,
@@ -98,6 +102,22 @@ enum iproto_key {
 	IPROTO_BALLOT = 0x29,
 	IPROTO_TUPLE_META = 0x2a,
 	IPROTO_OPTIONS = 0x2b,
+	/**
+	 * Set in SUBSCRIBE by a replica that wants to receive
+	 * the rows compressed, see IPROTO_COMPRESSED_ROWS.
+	 */
+	IPROTO_COMPRESSION = 0x2c,
+	/** A zstd frame in IPROTO_COMPRESSED_ROWS. */
+	IPROTO_FRAME = 0x2d,
+	/** Snapshot shard number, see IPROTO_FETCH_SNAPSHOT. */
+	IPROTO_SHARD = 0x2e,
+	/**
+	 * Set in JOIN by a replica that fetches the snapshot with
+	 * IPROTO_FETCH_SNAPSHOT to the number of connections it
+	 * uses. The master replies with the number of shards of
+	 * the snapshot.
+	 */
+	IPROTO_SHARD_COUNT = 0x2f,
 
 	/* Leave a gap between request keys and response keys */
 	IPROTO_DATA = 0x30,
@@ -202,6 +222,29 @@ enum iproto_type {
 	IPROTO_EXECUTE = 11,
 	/** No operation. Treated as DML, used to bump LSN. */
 	IPROTO_NOP = 12,
+	/** Look up a batch of keys in a unique index. */
+	IPROTO_GET_MANY = 13,
+	/**
+	 * Open a cursor over an index: { SPACE_ID, INDEX_ID,
+	 * ITERATOR, KEY }. The reply is { CURSOR_ID: id }. The
+	 * cursor belongs to the session and is closed with it.
+	 */
+	IPROTO_CURSOR_OPEN = 14,
+	/**
+	 * Fetch the next page of a cursor: { CURSOR_ID, LIMIT }.
+	 * The reply is the same as to SELECT. A page may have less
+	 * than LIMIT tuples, an empty page means the cursor is
+	 * exhausted.
+	 */
+	IPROTO_CURSOR_FETCH = 15,
+	/** Close a cursor: { CURSOR_ID }. */
+	IPROTO_CURSOR_CLOSE = 16,
+	/**
+	 * Prepare an SQL statement: { SQL_TEXT }. The reply is
+	 * { STMT_ID: id }. EXECUTE with STMT_ID instead of
+	 * SQL_TEXT runs the statement without compiling it.
+	 */
+	IPROTO_PREPARE = 17,
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
@@ -215,6 +258,19 @@ enum iproto_type {
 	IPROTO_VOTE_DEPRECATED = 67,
 	/** Vote request command for master election */
 	IPROTO_VOTE = 68,
+	/**
+	 * A batch of replication rows compressed as a single zstd
+	 * frame: { IPROTO_FRAME: zstd(row, row, ...) }, where each
+	 * row is encoded the same way as it is sent over the wire.
+	 */
+	IPROTO_COMPRESSED_ROWS = 69,
+	/**
+	 * Fetch a shard of a snapshot on initial join:
+	 * { VCLOCK: checkpoint vclock, SHARD: shard, OFFSET: rows }.
+	 * The master skips OFFSET rows of the shard, sends the rest
+	 * and then replies with OK.
+	 */
+	IPROTO_FETCH_SNAPSHOT = 70,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -248,6 +304,25 @@ iproto_type_name(uint32_t type)
 	 */
 	if (type == IPROTO_NOP)
 		return "NOP";
+	/* Sic: GET_MANY is accounted as SELECT in box.stat(). */
+	if (type == IPROTO_GET_MANY)
+		return "GET_MANY";
+	/*
+	 * Sic: cursors are accounted as SELECT on open, PREPARE
+	 * is not shown in box.stat().
+	 */
+	switch (type) {
+	case IPROTO_CURSOR_OPEN:
+		return "CURSOR_OPEN";
+	case IPROTO_CURSOR_FETCH:
+		return "CURSOR_FETCH";
+	case IPROTO_CURSOR_CLOSE:
+		return "CURSOR_CLOSE";
+	case IPROTO_PREPARE:
+		return "PREPARE";
+	default:
+		break;
+	}
 
 	if (type < IPROTO_TYPE_STAT_MAX)
 		return iproto_type_strs[type];
@@ -293,7 +368,8 @@ static inline uint64_t
 dml_request_key_map(uint32_t type)
 {
 	/** Advanced requests don't have a defined key map. */
-	assert(iproto_type_is_dml(type));
+	assert(iproto_type_is_dml(type) || type == IPROTO_GET_MANY ||
+	       type == IPROTO_CURSOR_OPEN);
 	extern const uint64_t iproto_body_key_map[];
 	return iproto_body_key_map[type];
 }
@@ -306,7 +382,8 @@ dml_request_key_map(uint32_t type)
 static inline bool
 iproto_type_is_select(uint32_t type)
 {
-	return type <= IPROTO_SELECT || type == IPROTO_CALL || type == IPROTO_EVAL;
+	return type <= IPROTO_SELECT || type == IPROTO_CALL ||
+	       type == IPROTO_EVAL || type == IPROTO_GET_MANY;
 }
 
 /** A common request with a mandatory and simple body (key, tuple, ops)  */
@@ -48,6 +48,7 @@ dummy_journal_write(struct journal *journal, struct journal_entry *entry)
 static struct journal dummy_journal = {
 	dummy_journal_write,
 	NULL,
+	NULL,
 };
 
 struct journal *current_journal = &dummy_journal;
@@ -70,6 +71,17 @@ journal_entry_new(size_t n_rows, struct region *region)
 	entry->n_rows = n_rows;
 	entry->res = -1;
 	entry->fiber = fiber();
+	entry->on_done = NULL;
+	entry->on_done_arg = NULL;
 	return entry;
 }
 
+void
+journal_entry_complete(struct journal_entry *entry)
+{
+	if (entry->on_done != NULL)
+		entry->on_done(entry, entry->on_done_arg);
+	else
+		fiber_wakeup(entry->fiber);
+}
+
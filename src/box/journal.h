@@ -30,6 +30,7 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <assert.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "salad/stailq.h"
@@ -58,6 +59,15 @@ struct journal_entry {
 	 * The fiber issuing the request.
 	 */
 	struct fiber *fiber;
+	/**
+	 * Function called in tx when the request has been written
+	 * or failed to be written. If not set, the issuing fiber
+	 * is woken up instead. Used for asynchronous writes, see
+	 * journal_async_write().
+	 */
+	void (*on_done)(struct journal_entry *entry, void *arg);
+	/** Argument passed to on_done. */
+	void *on_done_arg;
 	/**
 	 * Approximate size of this request when encoded.
 	 */
@@ -82,6 +92,14 @@ struct region;
 struct journal_entry *
 journal_entry_new(size_t n_rows, struct region *region);
 
+/**
+ * Notify the issuer that the entry has been written, in which
+ * case entry->res is set to the entry signature, or failed to
+ * be written, in which case entry->res is -1.
+ */
+void
+journal_entry_complete(struct journal_entry *entry);
+
 /**
  * An API for an abstract journal for all transactions of this
  * instance, as well as for multiple instances in case of
@@ -90,6 +108,13 @@ journal_entry_new(size_t n_rows, struct region *region);
 struct journal {
 	int64_t (*write)(struct journal *journal,
 			 struct journal_entry *req);
+	/**
+	 * Queue a request for writing without waiting for it
+	 * to complete. NULL if the journal can only write
+	 * synchronously.
+	 */
+	int (*async_write)(struct journal *journal,
+			   struct journal_entry *req);
 	void (*destroy)(struct journal *journal);
 };
 
@@ -111,6 +136,30 @@ journal_write(struct journal_entry *entry)
 	return current_journal->write(current_journal, entry);
 }
 
+/**
+ * Queue a single entry for writing and return without waiting
+ * for the write to complete. entry->on_done is invoked when the
+ * write is done. The entries are written in the order they were
+ * queued in, including the ones written with journal_write().
+ *
+ * If the journal doesn't support asynchronous writes, the entry
+ * is written synchronously and on_done is invoked before return.
+ *
+ * @retval  0 the entry was queued
+ * @retval -1 the entry was rejected, on_done won't be invoked
+ */
+static inline int
+journal_async_write(struct journal_entry *entry)
+{
+	assert(entry->on_done != NULL);
+	if (current_journal->async_write == NULL) {
+		entry->res = journal_write(entry);
+		journal_entry_complete(entry);
+		return 0;
+	}
+	return current_journal->async_write(current_journal, entry);
+}
+
 /**
  * Change the current implementation of the journaling API.
  * Happens during life cycle of an instance:
@@ -143,9 +192,11 @@ journal_set(struct journal *new_journal)
 static inline void
 journal_create(struct journal *journal,
 	       int64_t (*write)(struct journal *, struct journal_entry *),
+	       int (*async_write)(struct journal *, struct journal_entry *),
 	       void (*destroy)(struct journal *))
 {
 	journal->write = write;
+	journal->async_write = async_write;
 	journal->destroy = destroy;
 }
 
@@ -120,6 +120,36 @@ lbox_cfg_set_readahead(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_iproto_batch(struct lua_State *L)
+{
+	(void) L;
+	box_set_iproto_batch();
+	return 0;
+}
+
+static int
+lbox_cfg_set_read_view_staleness(struct lua_State *L)
+{
+	try {
+		box_set_read_view_staleness();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_sql_cache_size(struct lua_State *L)
+{
+	try {
+		box_set_sql_cache_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_io_collect_interval(struct lua_State *L)
 {
@@ -153,6 +183,28 @@ lbox_cfg_set_snap_io_rate_limit(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_memtx_checkpoint_threads(struct lua_State *L)
+{
+	try {
+		box_set_memtx_checkpoint_threads();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_memtx_compression_level(struct lua_State *L)
+{
+	try {
+		box_set_memtx_compression_level();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_checkpoint_count(struct lua_State *L)
 {
@@ -186,6 +238,50 @@ lbox_cfg_set_checkpoint_wal_threshold(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_wal_spare_files(struct lua_State *L)
+{
+	try {
+		box_set_wal_spare_files();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_tail_size(struct lua_State *L)
+{
+	try {
+		box_set_wal_tail_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_group_commit(struct lua_State *L)
+{
+	try {
+		box_set_wal_group_commit();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_wal_compression_level(struct lua_State *L)
+{
+	try {
+		box_set_wal_compression_level();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_read_only(struct lua_State *L)
 {
@@ -346,6 +442,72 @@ lbox_cfg_set_replication_skip_conflict(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_replication_apply_concurrency(struct lua_State *L)
+{
+	try {
+		box_set_replication_apply_concurrency();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_compression(struct lua_State *L)
+{
+	try {
+		box_set_replication_compression();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_compression_level(struct lua_State *L)
+{
+	try {
+		box_set_replication_compression_level();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_compression_frame_size(struct lua_State *L)
+{
+	try {
+		box_set_replication_compression_frame_size();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_compression_frame_delay(struct lua_State *L)
+{
+	try {
+		box_set_replication_compression_frame_delay();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_join_connections(struct lua_State *L)
+{
+	try {
+		box_set_replication_join_connections();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 void
 box_lua_cfg_init(struct lua_State *L)
 {
@@ -358,12 +520,21 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_log_level", lbox_cfg_set_log_level},
 		{"cfg_set_log_format", lbox_cfg_set_log_format},
 		{"cfg_set_readahead", lbox_cfg_set_readahead},
+		{"cfg_set_iproto_batch", lbox_cfg_set_iproto_batch},
+		{"cfg_set_read_view_staleness", lbox_cfg_set_read_view_staleness},
+		{"cfg_set_sql_cache_size", lbox_cfg_set_sql_cache_size},
 		{"cfg_set_io_collect_interval", lbox_cfg_set_io_collect_interval},
 		{"cfg_set_too_long_threshold", lbox_cfg_set_too_long_threshold},
 		{"cfg_set_snap_io_rate_limit", lbox_cfg_set_snap_io_rate_limit},
+		{"cfg_set_memtx_checkpoint_threads", lbox_cfg_set_memtx_checkpoint_threads},
+		{"cfg_set_memtx_compression_level", lbox_cfg_set_memtx_compression_level},
 		{"cfg_set_checkpoint_count", lbox_cfg_set_checkpoint_count},
 		{"cfg_set_checkpoint_interval", lbox_cfg_set_checkpoint_interval},
 		{"cfg_set_checkpoint_wal_threshold", lbox_cfg_set_checkpoint_wal_threshold},
+		{"cfg_set_wal_spare_files", lbox_cfg_set_wal_spare_files},
+		{"cfg_set_wal_tail_size", lbox_cfg_set_wal_tail_size},
+		{"cfg_set_wal_group_commit", lbox_cfg_set_wal_group_commit},
+		{"cfg_set_wal_compression_level", lbox_cfg_set_wal_compression_level},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
@@ -377,6 +548,12 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_replication_sync_lag", lbox_cfg_set_replication_sync_lag},
 		{"cfg_set_replication_sync_timeout", lbox_cfg_set_replication_sync_timeout},
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
+		{"cfg_set_replication_apply_concurrency", lbox_cfg_set_replication_apply_concurrency},
+		{"cfg_set_replication_compression", lbox_cfg_set_replication_compression},
+		{"cfg_set_replication_compression_level", lbox_cfg_set_replication_compression_level},
+		{"cfg_set_replication_compression_frame_size", lbox_cfg_set_replication_compression_frame_size},
+		{"cfg_set_replication_compression_frame_delay", lbox_cfg_set_replication_compression_frame_delay},
+		{"cfg_set_replication_join_connections", lbox_cfg_set_replication_join_connections},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
 		{NULL, NULL}
 	};
@@ -65,6 +65,27 @@ lbox_pushvclock(struct lua_State *L, const struct vclock *vclock)
 	luaL_setmaphint(L, -1); /* compact flow */
 }
 
+/**
+ * Push compression ratio and the number of bytes saved by
+ * compression of a replication stream unless the stream is
+ * not compressed.
+ */
+static void
+lbox_pushcompression(lua_State *L, size_t raw_size, size_t zsize)
+{
+	if (zsize == 0)
+		return;
+	lua_pushstring(L, "compression");
+	lua_createtable(L, 0, 2);
+	lua_pushstring(L, "ratio");
+	lua_pushnumber(L, (double) raw_size / zsize);
+	lua_settable(L, -3);
+	lua_pushstring(L, "saved");
+	lua_pushnumber(L, (double) raw_size - zsize);
+	lua_settable(L, -3);
+	lua_settable(L, -3);
+}
+
 static void
 lbox_pushapplier(lua_State *L, struct applier *applier)
 {
@@ -102,6 +123,17 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 		lua_pushlstring(L, name, total);
 		lua_settable(L, -3);
 
+		lua_pushstring(L, "apply_queue");
+		lua_pushinteger(L, applier->apply_queue);
+		lua_settable(L, -3);
+
+		lua_pushstring(L, "apply_parallelism");
+		lua_pushinteger(L, applier->apply_parallelism);
+		lua_settable(L, -3);
+
+		lbox_pushcompression(L, applier->compression_raw_size,
+				     applier->compression_zsize);
+
 		struct error *e = diag_last_error(&applier->reader->diag);
 		if (e != NULL) {
 			lua_pushstring(L, "message");
@@ -128,6 +160,9 @@ lbox_pushrelay(lua_State *L, struct relay *relay)
 		lua_pushnumber(L, ev_monotonic_now(loop()) -
 			       relay_last_row_time(relay));
 		lua_settable(L, -3);
+		size_t raw_size, zsize;
+		relay_compression_stat(relay, &raw_size, &zsize);
+		lbox_pushcompression(L, raw_size, zsize);
 		break;
 	case RELAY_STOPPED:
 	{
@@ -89,12 +89,37 @@ static const char *lua_sources[] = {
 	NULL
 };
 
+/**
+ * box.commit([{wait = 'complete' | 'none'}])
+ *
+ * With wait = 'none', return without waiting for the
+ * transaction to be written to WAL, see txn_commit_async().
+ */
 static int
 lbox_commit(lua_State *L)
 {
-	if (box_txn_commit() != 0)
+	bool is_async = false;
+	if (!lua_isnoneornil(L, 1)) {
+		if (!lua_istable(L, 1))
+			goto usage;
+		lua_getfield(L, 1, "wait");
+		if (!lua_isnil(L, -1)) {
+			if (lua_type(L, -1) != LUA_TSTRING)
+				goto usage;
+			const char *wait = lua_tostring(L, -1);
+			if (strcmp(wait, "none") == 0)
+				is_async = true;
+			else if (strcmp(wait, "complete") != 0)
+				goto usage;
+		}
+		lua_pop(L, 1);
+	}
+	if ((is_async ? box_txn_commit_async() : box_txn_commit()) != 0)
 		return luaT_error(L);
 	return 0;
+usage:
+	return luaL_error(L, "Usage: box.commit([{wait = 'complete' | "
+			  "'none'}])");
 }
 
 static int
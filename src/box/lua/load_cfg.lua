@@ -27,6 +27,8 @@ local default_cfg = {
     memtx_memory        = 256 * 1024 *1024,
     memtx_min_tuple_size = 16,
     memtx_max_tuple_size = 1024 * 1024,
+    memtx_checkpoint_threads = 1,
+    memtx_compression_level = 3,
     slab_alloc_factor   = 1.05,
     work_dir            = nil,
     memtx_dir           = ".",
@@ -56,6 +58,12 @@ local default_cfg = {
     rows_per_wal        = 500000,
     wal_max_size        = 256 * 1024 * 1024,
     wal_dir_rescan_delay= 2,
+    wal_spare_files     = 0,
+    wal_tail_size       = 16 * 1024 * 1024,
+    wal_group_commit_delay = 0,
+    wal_group_commit_size = 1024 * 1024,
+    wal_compression_level = 3,
+    wal_compression_threads = 0,
     force_recovery      = false,
     replication         = nil,
     instance_uuid       = nil,
@@ -77,10 +85,21 @@ local default_cfg = {
     replication_connect_timeout = 30,
     replication_connect_quorum = nil, -- connect all
     replication_skip_conflict = false,
+    replication_apply_concurrency = 1,
+    replication_compression = false,
+    replication_compression_level = 3,
+    replication_compression_frame_size = 64 * 1024,
+    replication_compression_frame_delay = 0.01,
+    replication_join_connections = 0,
     feedback_enabled      = true,
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
     net_msg_max           = 768,
+    iproto_threads        = 1,
+    iproto_batch          = false,
+    read_view_threads     = 0,
+    read_view_staleness   = 1,
+    sql_cache_size        = 64,
 }
 
 -- types of available options
@@ -90,6 +109,8 @@ local template_cfg = {
     memtx_memory        = 'number',
     memtx_min_tuple_size  = 'number',
     memtx_max_tuple_size  = 'number',
+    memtx_checkpoint_threads = 'number',
+    memtx_compression_level = 'number',
     slab_alloc_factor   = 'number',
     work_dir            = 'string',
     memtx_dir            = 'string',
@@ -119,6 +140,12 @@ local template_cfg = {
     rows_per_wal        = 'number',
     wal_max_size        = 'number',
     wal_dir_rescan_delay= 'number',
+    wal_spare_files     = 'number',
+    wal_tail_size       = 'number',
+    wal_group_commit_delay = 'number',
+    wal_group_commit_size = 'number',
+    wal_compression_level = 'number',
+    wal_compression_threads = 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
     instance_uuid       = 'string',
@@ -140,10 +167,21 @@ local template_cfg = {
     replication_connect_timeout = 'number',
     replication_connect_quorum = 'number',
     replication_skip_conflict = 'boolean',
+    replication_apply_concurrency = 'number',
+    replication_compression = 'boolean',
+    replication_compression_level = 'number',
+    replication_compression_frame_size = 'number',
+    replication_compression_frame_delay = 'number',
+    replication_join_connections = 'number',
     feedback_enabled      = 'boolean',
     feedback_host         = 'string',
     feedback_interval     = 'number',
     net_msg_max           = 'number',
+    iproto_threads        = 'number',
+    iproto_batch          = 'boolean',
+    read_view_threads     = 'number',
+    read_view_staleness   = 'number',
+    sql_cache_size        = 'number',
 }
 
 local function normalize_uri(port)
@@ -219,11 +257,16 @@ local dynamic_cfg = {
     log_format              = private.cfg_set_log_format,
     io_collect_interval     = private.cfg_set_io_collect_interval,
     readahead               = private.cfg_set_readahead,
+    iproto_batch            = private.cfg_set_iproto_batch,
+    read_view_staleness     = private.cfg_set_read_view_staleness,
+    sql_cache_size          = private.cfg_set_sql_cache_size,
     too_long_threshold      = private.cfg_set_too_long_threshold,
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
     read_only               = private.cfg_set_read_only,
     memtx_memory            = private.cfg_set_memtx_memory,
     memtx_max_tuple_size    = private.cfg_set_memtx_max_tuple_size,
+    memtx_checkpoint_threads = private.cfg_set_memtx_checkpoint_threads,
+    memtx_compression_level = private.cfg_set_memtx_compression_level,
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
@@ -231,6 +274,11 @@ local dynamic_cfg = {
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.cfg_set_checkpoint_interval,
     checkpoint_wal_threshold = private.cfg_set_checkpoint_wal_threshold,
+    wal_spare_files         = private.cfg_set_wal_spare_files,
+    wal_tail_size           = private.cfg_set_wal_tail_size,
+    wal_group_commit_delay  = private.cfg_set_wal_group_commit,
+    wal_group_commit_size   = private.cfg_set_wal_group_commit,
+    wal_compression_level   = private.cfg_set_wal_compression_level,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
     feedback_enabled        = private.feedback_daemon.set_feedback_params,
     feedback_host           = private.feedback_daemon.set_feedback_params,
@@ -247,6 +295,12 @@ local dynamic_cfg = {
     replication_sync_lag    = private.cfg_set_replication_sync_lag,
     replication_sync_timeout = private.cfg_set_replication_sync_timeout,
     replication_skip_conflict = private.cfg_set_replication_skip_conflict,
+    replication_apply_concurrency = private.cfg_set_replication_apply_concurrency,
+    replication_compression = private.cfg_set_replication_compression,
+    replication_compression_level = private.cfg_set_replication_compression_level,
+    replication_compression_frame_size = private.cfg_set_replication_compression_frame_size,
+    replication_compression_frame_delay = private.cfg_set_replication_compression_frame_delay,
+    replication_join_connections = private.cfg_set_replication_join_connections,
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
@@ -268,6 +322,12 @@ local dynamic_cfg_skip_at_load = {
     replication_sync_lag    = true,
     replication_sync_timeout = true,
     replication_skip_conflict = true,
+    replication_apply_concurrency = true,
+    replication_compression = true,
+    replication_compression_level = true,
+    replication_compression_frame_size = true,
+    replication_compression_frame_delay = true,
+    replication_join_connections = true,
     wal_dir_rescan_delay    = true,
     custom_proc_title       = true,
     force_recovery          = true,
@@ -275,6 +335,9 @@ local dynamic_cfg_skip_at_load = {
     replicaset_uuid         = true,
     net_msg_max             = true,
     readahead               = true,
+    iproto_batch            = true,
+    read_view_staleness     = true,
+    sql_cache_size          = true,
 }
 
 local function convert_gb(size)
@@ -116,11 +116,38 @@ lbox_select(lua_State *L)
 
 /* }}} */
 
+/** {{{ Lua/C implementation of index:get_many(): used only by Vinyl **/
+
+static int
+lbox_get_many(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    !lua_istable(L, 3))
+		return luaL_error(L, "Usage index:get_many(keys)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+
+	size_t keys_len;
+	const char *keys = lbox_encode_tuple_on_gc(L, 3, &keys_len);
+
+	struct port port;
+	if (box_get_many(space_id, index_id, keys, keys + keys_len,
+			 &port) != 0)
+		return luaT_error(L);
+	port_dump_lua(&port, L);
+	port_destroy(&port);
+	return 1; /* lua table with tuples */
+}
+
+/* }}} */
+
 void
 box_lua_misc_init(struct lua_State *L)
 {
 	static const struct luaL_Reg boxlib_internal[] = {
 		{"select", lbox_select},
+		{"get_many", lbox_get_many},
 		{NULL, NULL}
 	};
 
@@ -338,6 +338,132 @@ netbox_encode_delete(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_get_many(lua_State *L)
+{
+	if (lua_gettop(L) < 5 || lua_type(L, 5) != LUA_TTABLE) {
+		return luaL_error(L, "Usage: netbox.encode_get_many(ibuf, "
+				     "sync, space_id, index_id, keys)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_GET_MANY);
+
+	mpstream_encode_map(&stream, 3);
+
+	/* encode space_id */
+	uint32_t space_id = lua_tonumber(L, 3);
+	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
+	mpstream_encode_uint(&stream, space_id);
+
+	/* encode index_id */
+	uint32_t index_id = lua_tonumber(L, 4);
+	mpstream_encode_uint(&stream, IPROTO_INDEX_ID);
+	mpstream_encode_uint(&stream, index_id);
+
+	/* encode keys */
+	mpstream_encode_uint(&stream, IPROTO_KEY);
+	uint32_t key_count = lua_objlen(L, 5);
+	mpstream_encode_array(&stream, key_count);
+	for (uint32_t i = 1; i <= key_count; i++) {
+		lua_rawgeti(L, 5, i);
+		luamp_convert_key(L, cfg, &stream, lua_gettop(L));
+		lua_pop(L, 1);
+	}
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_open(lua_State *L)
+{
+	if (lua_gettop(L) < 6) {
+		return luaL_error(L, "Usage: netbox.encode_cursor_open(ibuf, "
+				     "sync, space_id, index_id, iterator, "
+				     "key)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_OPEN);
+
+	mpstream_encode_map(&stream, 4);
+
+	uint32_t space_id = lua_tonumber(L, 3);
+	uint32_t index_id = lua_tonumber(L, 4);
+	int iterator = lua_tointeger(L, 5);
+
+	/* encode space_id */
+	mpstream_encode_uint(&stream, IPROTO_SPACE_ID);
+	mpstream_encode_uint(&stream, space_id);
+
+	/* encode index_id */
+	mpstream_encode_uint(&stream, IPROTO_INDEX_ID);
+	mpstream_encode_uint(&stream, index_id);
+
+	/* encode iterator */
+	mpstream_encode_uint(&stream, IPROTO_ITERATOR);
+	mpstream_encode_uint(&stream, iterator);
+
+	/* encode key */
+	mpstream_encode_uint(&stream, IPROTO_KEY);
+	luamp_convert_key(L, cfg, &stream, 6);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_fetch(lua_State *L)
+{
+	if (lua_gettop(L) < 4) {
+		return luaL_error(L, "Usage: netbox.encode_cursor_fetch(ibuf, "
+				     "sync, cursor_id, limit)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_FETCH);
+
+	mpstream_encode_map(&stream, 2);
+
+	uint64_t cursor_id = lua_tonumber(L, 3);
+	uint32_t limit = lua_tonumber(L, 4);
+
+	/* encode cursor_id */
+	mpstream_encode_uint(&stream, IPROTO_CURSOR_ID);
+	mpstream_encode_uint(&stream, cursor_id);
+
+	/* encode limit */
+	mpstream_encode_uint(&stream, IPROTO_LIMIT);
+	mpstream_encode_uint(&stream, limit);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
+static int
+netbox_encode_cursor_close(lua_State *L)
+{
+	if (lua_gettop(L) < 3) {
+		return luaL_error(L, "Usage: netbox.encode_cursor_close(ibuf, "
+				     "sync, cursor_id)");
+	}
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_CURSOR_CLOSE);
+
+	mpstream_encode_map(&stream, 1);
+
+	uint64_t cursor_id = lua_tonumber(L, 3);
+
+	/* encode cursor_id */
+	mpstream_encode_uint(&stream, IPROTO_CURSOR_ID);
+	mpstream_encode_uint(&stream, cursor_id);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 static int
 netbox_encode_update(lua_State *L)
 {
@@ -569,10 +695,17 @@ netbox_encode_execute(lua_State *L)
 
 	mpstream_encode_map(&stream, 3);
 
-	size_t len;
-	const char *query = lua_tolstring(L, 3, &len);
-	mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
-	mpstream_encode_strn(&stream, query, len);
+	if (lua_type(L, 3) == LUA_TNUMBER) {
+		/* Execute a prepared statement by id. */
+		uint32_t stmt_id = lua_tonumber(L, 3);
+		mpstream_encode_uint(&stream, IPROTO_STMT_ID);
+		mpstream_encode_uint(&stream, stmt_id);
+	} else {
+		size_t len;
+		const char *query = lua_tolstring(L, 3, &len);
+		mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
+		mpstream_encode_strn(&stream, query, len);
+	}
 
 	mpstream_encode_uint(&stream, IPROTO_SQL_BIND);
 	luamp_encode_tuple(L, cfg, &stream, 4);
@@ -584,6 +717,26 @@ netbox_encode_execute(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_prepare(lua_State *L)
+{
+	if (lua_gettop(L) < 3)
+		return luaL_error(L, "Usage: netbox.encode_prepare(ibuf, "\
+				  "sync, query)");
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_PREPARE);
+
+	mpstream_encode_map(&stream, 1);
+
+	size_t len;
+	const char *query = lua_tolstring(L, 3, &len);
+	mpstream_encode_uint(&stream, IPROTO_SQL_TEXT);
+	mpstream_encode_strn(&stream, query, len);
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 /**
  * Decode IPROTO_DATA into tuples array.
  * @param L Lua stack to push result on.
@@ -758,9 +911,14 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_insert",  netbox_encode_insert },
 		{ "encode_replace", netbox_encode_replace },
 		{ "encode_delete",  netbox_encode_delete },
+		{ "encode_get_many", netbox_encode_get_many },
+		{ "encode_cursor_open", netbox_encode_cursor_open },
+		{ "encode_cursor_fetch", netbox_encode_cursor_fetch },
+		{ "encode_cursor_close", netbox_encode_cursor_close },
 		{ "encode_update",  netbox_encode_update },
 		{ "encode_upsert",  netbox_encode_upsert },
 		{ "encode_execute", netbox_encode_execute},
+		{ "encode_prepare", netbox_encode_prepare},
 		{ "encode_auth",    netbox_encode_auth },
 		{ "decode_greeting",netbox_decode_greeting },
 		{ "communicate",    netbox_communicate },
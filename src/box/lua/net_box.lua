@@ -41,6 +41,8 @@ local IPROTO_METADATA_KEY = 0x32
 local IPROTO_SQL_INFO_KEY = 0x42
 local SQL_INFO_ROW_COUNT_KEY = 0
 local IPROTO_FIELD_NAME_KEY = 0
+local IPROTO_CURSOR_ID_KEY = 0x16
+local IPROTO_STMT_ID_KEY   = 0x17
 local IPROTO_DATA_KEY      = 0x30
 local IPROTO_ERROR_KEY     = 0x31
 local IPROTO_GREETING_SIZE = 128
@@ -78,6 +80,14 @@ local function decode_count(raw_data)
     local response, raw_end = decode(raw_data)
     return response[IPROTO_DATA_KEY][1], raw_end
 end
+local function decode_cursor(raw_data)
+    local response, raw_end = decode(raw_data)
+    return response[IPROTO_CURSOR_ID_KEY], raw_end
+end
+local function decode_prepare(raw_data)
+    local response, raw_end = decode(raw_data)
+    return response[IPROTO_STMT_ID_KEY], raw_end
+end
 local function decode_push(raw_data)
     local response, raw_end = decode(raw_data)
     return response[IPROTO_DATA_KEY][1], raw_end
@@ -95,7 +105,12 @@ local method_encoder = {
     upsert  = internal.encode_upsert,
     select  = internal.encode_select,
     execute = internal.encode_execute,
+    prepare = internal.encode_prepare,
     get     = internal.encode_select,
+    get_many = internal.encode_get_many,
+    cursor_open = internal.encode_cursor_open,
+    cursor_fetch = internal.encode_cursor_fetch,
+    cursor_close = internal.encode_cursor_close,
     min     = internal.encode_select,
     max     = internal.encode_select,
     count   = internal.encode_call,
@@ -119,7 +134,12 @@ local method_decoder = {
     upsert  = decode_nil,
     select  = internal.decode_select,
     execute = internal.decode_execute,
+    prepare = decode_prepare,
     get     = decode_get,
+    get_many = internal.decode_select,
+    cursor_open = decode_cursor,
+    cursor_fetch = internal.decode_select,
+    cursor_close = decode_nil,
     min     = decode_get,
     max     = decode_get,
     count   = decode_count,
@@ -1166,6 +1186,14 @@ function remote_methods:execute(query, parameters, sql_opts, netbox_opts)
                          sql_opts or {})
 end
 
+-- Compile an SQL statement on the server and return its id.
+-- The id may be passed to execute() instead of the statement
+-- text to run the statement without compiling it again.
+function remote_methods:prepare(query, netbox_opts)
+    check_remote_arg(self, "prepare")
+    return self:_request('prepare', netbox_opts, query)
+end
+
 function remote_methods:wait_state(state, timeout)
     check_remote_arg(self, 'wait_state')
     if timeout == nil then
@@ -1319,6 +1347,59 @@ local function nothing_or_data(value)
     end
 end
 
+--
+-- A server-side cursor, see index:cursor(). Tuples are fetched
+-- page by page, so that a big result set is never kept in
+-- memory at once, neither on the server nor on the client.
+--
+local cursor_methods = {}
+
+-- Fetch the next page of at most @a limit tuples. An empty
+-- page means the cursor is exhausted, it is closed then.
+function cursor_methods:fetch(limit)
+    if self.is_closed then
+        return {}
+    end
+    local tuples = self.remote:_request('cursor_fetch', self.opts, self.id,
+                                        limit or self.batch_size)
+    if #tuples == 0 then
+        self:close()
+    end
+    return tuples
+end
+
+function cursor_methods:close()
+    if self.is_closed then
+        return
+    end
+    self.is_closed = true
+    self.remote:_request('cursor_close', self.opts, self.id)
+end
+
+-- Iterate over the tuples of the cursor:
+-- for _, tuple in cursor:pairs() do ... end
+function cursor_methods:pairs()
+    local page, pos, count = {}, 0, 0
+    return function()
+        pos = pos + 1
+        if pos > #page then
+            page, pos = self:fetch(), 1
+            if #page == 0 then
+                return nil
+            end
+        end
+        count = count + 1
+        return count, page[pos]
+    end
+end
+
+local cursor_mt = {
+    __index = cursor_methods,
+    __serialize = function(self)
+        return {id = self.id, is_closed = self.is_closed}
+    end,
+}
+
 space_metatable = function(remote)
     local methods = {}
 
@@ -1358,6 +1439,16 @@ space_metatable = function(remote)
         return check_primary_index(self):get(key, opts)
     end
 
+    function methods:get_many(keys, opts)
+        check_space_arg(self, 'get_many')
+        return check_primary_index(self):get_many(keys, opts)
+    end
+
+    function methods:cursor(key, opts)
+        check_space_arg(self, 'cursor')
+        return check_primary_index(self):cursor(key, opts)
+    end
+
     function methods:format(format)
         if format == nil then
             return self._format
@@ -1392,6 +1483,34 @@ index_metatable = function(remote)
                                self.id, box.index.EQ, 0, 2, key))
     end
 
+    function methods:get_many(keys, opts)
+        check_index_arg(self, 'get_many')
+        if type(keys) ~= 'table' then
+            error("Usage: index:get_many({key1, key2, ...})")
+        end
+        return (remote:_request('get_many', opts, self.space.id, self.id,
+                                keys))
+    end
+
+    function methods:cursor(key, opts)
+        check_index_arg(self, 'cursor')
+        if opts and (opts.buffer or opts.is_async) then
+            error("index:cursor() doesn't support `buffer` and "..
+                  "`is_async` arguments")
+        end
+        local key_is_nil = (key == nil or
+                            (type(key) == 'table' and #key == 0))
+        local iterator = check_iterator_type(opts, key_is_nil)
+        local batch_size = tonumber(opts and opts.batch_size) or 1000
+        local request_opts = opts and opts.timeout and
+                             {timeout = opts.timeout} or nil
+        local id = remote:_request('cursor_open', request_opts,
+                                   self.space.id, self.id, iterator, key)
+        return setmetatable({remote = remote, id = id, opts = request_opts,
+                             batch_size = batch_size, is_closed = false},
+                            cursor_mt)
+    end
+
     function methods:min(key, opts)
         check_index_arg(self, 'min')
         if opts and opts.buffer then
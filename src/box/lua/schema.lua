@@ -100,6 +100,9 @@ ffi.cdef[[
                int iterator, uint32_t offset, uint32_t limit,
                const char *key, const char *key_end,
                struct port *port);
+    int
+    box_get_many(uint32_t space_id, uint32_t index_id,
+                 const char *keys, const char *keys_end, struct port *port);
 
     void password_prepare(const char *password, int len,
                           char *out, int out_len);
@@ -431,6 +434,10 @@ box.schema.space.create = function(name, options)
         format = 'table',
         is_local = 'boolean',
         temporary = 'boolean',
+        compression = 'string',
+        compression_threshold = 'number',
+        compression_level = 'number',
+        read_view = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -475,6 +482,10 @@ box.schema.space.create = function(name, options)
     local space_options = setmap({
         group_id = options.is_local and 1 or nil,
         temporary = options.temporary and true or nil,
+        compression = options.compression,
+        compression_threshold = options.compression_threshold,
+        compression_level = options.compression_level,
+        read_view = options.read_view and true or nil,
     })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -1348,6 +1359,17 @@ base_index_mt.count_luac = function(index, key, opts)
     return internal.count(index.space_id, index.id, itype, key);
 end
 
+-- number of tuples strictly less than the key, i.e. the position
+-- the key has or would have in the index
+base_index_mt.rank = function(index, key)
+    check_index_arg(index, 'rank')
+    key = keify(key)
+    if #key == 0 then
+        box.error(box.error.ILLEGAL_PARAMS, "Usage: index:rank(key)")
+    end
+    return index:count(key, {iterator = 'LT'})
+end
+
 base_index_mt.get_ffi = function(index, key)
     check_index_arg(index, 'get')
     local key, key_end = tuple_encode(key)
@@ -1411,6 +1433,42 @@ base_index_mt.select_luac = function(index, key, opts)
         offset, limit, key)
 end
 
+local function keify_many(keys)
+    if type(keys) ~= 'table' then
+        box.error(box.error.PROC_LUA, "Usage: index:get_many({key1, ...})")
+    end
+    local list = {}
+    for i, key in ipairs(keys) do
+        list[i] = keify(key)
+    end
+    return list
+end
+
+base_index_mt.get_many_ffi = function(index, keys)
+    check_index_arg(index, 'get_many')
+    local keys, keys_end = tuple_encode(keify_many(keys))
+    local port = ffi.cast('struct port *', port_tuple)
+
+    if builtin.box_get_many(index.space_id, index.id,
+        keys, keys_end, port) ~= 0 then
+        return box.error()
+    end
+
+    local ret = {}
+    local entry = port_tuple.first
+    for i=1,tonumber(port_tuple.size),1 do
+        ret[i] = tuple_bless(entry.tuple)
+        entry = entry.next
+    end
+    builtin.port_destroy(port);
+    return ret
+end
+
+base_index_mt.get_many_luac = function(index, keys)
+    check_index_arg(index, 'get_many')
+    return internal.get_many(index.space_id, index.id, keify_many(keys))
+end
+
 base_index_mt.update = function(index, key, ops)
     check_index_arg(index, 'update')
     return internal.update(index.space_id, index.id, keify(key), ops);
@@ -1444,7 +1502,8 @@ base_index_mt.alter = function(index, options)
     return box.schema.index.alter(index.space_id, index.id, options)
 end
 
-local read_ops = {'select', 'get', 'min', 'max', 'count', 'random', 'pairs'}
+local read_ops = {'select', 'get', 'get_many', 'min', 'max', 'count', 'random',
+                  'pairs'}
 for _, op in ipairs(read_ops) do
     vinyl_index_mt[op] = base_index_mt[op..'_luac']
     memtx_index_mt[op] = base_index_mt[op..'_ffi']
@@ -1485,6 +1544,10 @@ space_mt.get = function(space, key)
     check_space_arg(space, 'get')
     return check_primary_index(space):get(key)
 end
+space_mt.get_many = function(space, keys)
+    check_space_arg(space, 'get_many')
+    return check_primary_index(space):get_many(keys)
+end
 space_mt.select = function(space, key, opts)
     check_space_arg(space, 'select')
     return check_primary_index(space):select(key, opts)
@@ -1573,6 +1636,28 @@ space_mt.run_triggers = function(space, yesno)
     builtin.space_run_triggers(s, yesno)
 end
 space_mt.frommap = box.internal.space.frommap
+-- Fill an empty space with tuples from a table, an iterator
+-- (a function or a luafun object) or a file of MsgPack arrays.
+space_mt.bulk_load = function(space, source, param, state)
+    check_space_arg(space, 'bulk_load')
+    check_space_exists(space)
+    if type(source) == 'string' then
+        return box.internal.space.bulk_load_file(space.id, source)
+    end
+    local gen = source
+    if type(source) == 'table' then
+        if type(source.gen) == 'function' then
+            gen, param, state = source.gen, source.param, source.state
+        else
+            gen, param, state = ipairs(source)
+        end
+    end
+    if type(gen) ~= 'function' then
+        box.error(box.error.ILLEGAL_PARAMS, "Usage: space:bulk_load(" ..
+                  "table | iterator | path)")
+    end
+    return box.internal.space.bulk_load(space.id, gen, param, state)
+end
 space_mt.__index = space_mt
 
 box.schema.index_mt = base_index_mt
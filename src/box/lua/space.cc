@@ -51,6 +51,10 @@ extern "C" {
 #include "box/coll_id_cache.h"
 #include "box/replication.h" /* GROUP_LOCAL */
 #include "box/iproto_constants.h" /* iproto_type_name */
+#include "box/box.h" /* box_space_bulk_load */
+#include "coio_file.h"
+#include "small/ibuf.h"
+#include <fcntl.h>
 
 /**
  * Trigger function for all spaces
@@ -266,7 +270,8 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			assert(! lua_isnil(L, -1));
 		}
 
-		if (index_def->type == HASH || index_def->type == TREE) {
+		if (index_def->type == HASH || index_def->type == TREE ||
+		    index_def->type == SWISS || index_def->type == ART) {
 			lua_pushboolean(L, index_opts->is_unique);
 			lua_setfield(L, -2, "unique");
 		} else if (index_def->type == RTREE) {
@@ -494,6 +499,175 @@ usage_error:
 	return luaL_error(L, "Usage: space:frommap(map, opts)");
 }
 
+/** Bulk load source calling a Lua iterator. */
+struct lbox_bulk_load_source {
+	struct bulk_load_source base;
+	struct lua_State *L;
+	struct tuple_format *format;
+};
+
+/**
+ * Create a tuple of the given format from a Lua value. Called
+ * in protected mode, because tuple encoding may throw.
+ */
+static int
+lbox_bulk_load_tuple_new(struct lua_State *L)
+{
+	struct tuple_format *format =
+		(struct tuple_format *)lua_touserdata(L, 1);
+	struct tuple *tuple = luaT_tuple_new(L, 2, format);
+	if (tuple == NULL)
+		return luaT_error(L);
+	lua_pushlightuserdata(L, tuple);
+	return 1;
+}
+
+/**
+ * Get the next tuple from gen(param, state), which are
+ * at the stack indexes 2, 3, 4.
+ */
+static int
+lbox_bulk_load_source_next(struct bulk_load_source *base,
+			   struct tuple **tuple)
+{
+	struct lbox_bulk_load_source *source =
+		(struct lbox_bulk_load_source *)base;
+	struct lua_State *L = source->L;
+	lua_pushvalue(L, 2);
+	lua_pushvalue(L, 3);
+	lua_pushvalue(L, 4);
+	if (luaT_call(L, 2, 2) != 0)
+		return -1;
+	if (lua_isnil(L, -2)) {
+		lua_pop(L, 2);
+		*tuple = NULL;
+		return 0;
+	}
+	lua_pushcfunction(L, lbox_bulk_load_tuple_new);
+	lua_pushlightuserdata(L, source->format);
+	lua_pushvalue(L, -3);
+	if (luaT_call(L, 2, 1) != 0)
+		return -1;
+	*tuple = (struct tuple *)lua_touserdata(L, -1);
+	lua_pop(L, 2);
+	/* Store the new state. */
+	lua_replace(L, 4);
+	return 0;
+}
+
+/**
+ * Fill an empty space with tuples returned by a Lua iterator.
+ * Lua usage: bulk_load(space_id, gen, param, state)
+ */
+static int
+lbox_space_bulk_load(struct lua_State *L)
+{
+	if (lua_gettop(L) != 4 || !lua_isnumber(L, 1) ||
+	    !lua_isfunction(L, 2))
+		return luaL_error(L, "Usage: bulk_load(space_id, gen, "
+				  "param, state)");
+	uint32_t space_id = lua_tointeger(L, 1);
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return luaT_error(L);
+	struct lbox_bulk_load_source source;
+	source.base.next = lbox_bulk_load_source_next;
+	source.L = L;
+	source.format = space->format;
+	if (box_space_bulk_load(space_id, &source.base) != 0)
+		return luaT_error(L);
+	return 0;
+}
+
+enum {
+	/** Size of a chunk read by a file bulk load source. */
+	BULK_LOAD_FILE_CHUNK_SIZE = 1024 * 1024,
+};
+
+/** Bulk load source reading a file of MessagePack arrays. */
+struct lbox_bulk_load_file {
+	struct bulk_load_source base;
+	struct tuple_format *format;
+	int fd;
+	bool eof;
+	struct ibuf buf;
+};
+
+static int
+lbox_bulk_load_file_next(struct bulk_load_source *base, struct tuple **tuple)
+{
+	struct lbox_bulk_load_file *source =
+		(struct lbox_bulk_load_file *)base;
+	struct ibuf *buf = &source->buf;
+	while (true) {
+		const char *end = buf->rpos;
+		if (ibuf_used(buf) > 0 && mp_check(&end, buf->wpos) == 0) {
+			if (mp_typeof(*buf->rpos) != MP_ARRAY) {
+				diag_set(ClientError, ER_TUPLE_NOT_ARRAY);
+				return -1;
+			}
+			*tuple = tuple_new(source->format, buf->rpos, end);
+			buf->rpos = (char *)end;
+			return *tuple == NULL ? -1 : 0;
+		}
+		if (source->eof) {
+			if (ibuf_used(buf) == 0) {
+				*tuple = NULL;
+				return 0;
+			}
+			diag_set(ClientError, ER_INVALID_MSGPACK,
+				 "truncated or corrupted bulk load file");
+			return -1;
+		}
+		if (ibuf_reserve(buf, BULK_LOAD_FILE_CHUNK_SIZE) == NULL) {
+			diag_set(OutOfMemory, BULK_LOAD_FILE_CHUNK_SIZE,
+				 "ibuf", "bulk load file");
+			return -1;
+		}
+		ssize_t n = coio_read(source->fd, buf->wpos, ibuf_unused(buf));
+		if (n < 0) {
+			diag_set(SystemError, "failed to read bulk load file");
+			return -1;
+		}
+		source->eof = n == 0;
+		buf->wpos += n;
+	}
+}
+
+/**
+ * Fill an empty space with tuples stored in a file as
+ * a sequence of MessagePack arrays.
+ * Lua usage: bulk_load_file(space_id, path)
+ */
+static int
+lbox_space_bulk_load_file(struct lua_State *L)
+{
+	if (lua_gettop(L) != 2 || !lua_isnumber(L, 1) ||
+	    lua_type(L, 2) != LUA_TSTRING)
+		return luaL_error(L, "Usage: bulk_load_file(space_id, path)");
+	uint32_t space_id = lua_tointeger(L, 1);
+	const char *path = lua_tostring(L, 2);
+	struct space *space = space_cache_find(space_id);
+	if (space == NULL)
+		return luaT_error(L);
+	struct lbox_bulk_load_file source;
+	source.base.next = lbox_bulk_load_file_next;
+	source.format = space->format;
+	source.eof = false;
+	source.fd = coio_file_open(path, O_RDONLY, 0);
+	if (source.fd < 0) {
+		diag_set(SystemError, "failed to open file '%s'", path);
+		return luaT_error(L);
+	}
+	ibuf_create(&source.buf, &cord()->slabc, BULK_LOAD_FILE_CHUNK_SIZE);
+	int rc = box_space_bulk_load(space_id, &source.base);
+	ibuf_destroy(&source.buf);
+	coio_file_close(source.fd);
+	if (rc != 0)
+		return luaT_error(L);
+	return 0;
+}
+
 void
 box_lua_space_init(struct lua_State *L)
 {
@@ -585,6 +759,8 @@ box_lua_space_init(struct lua_State *L)
 
 	static const struct luaL_Reg space_internal_lib[] = {
 		{"frommap", lbox_space_frommap},
+		{"bulk_load", lbox_space_bulk_load},
+		{"bulk_load_file", lbox_space_bulk_load_file},
 		{NULL, NULL}
 	};
 	luaL_register(L, "box.internal.space", space_internal_lib);
@@ -42,6 +42,7 @@
 #include "box/iproto.h"
 #include "box/engine.h"
 #include "box/vinyl.h"
+#include "box/wal.h"
 #include "box/sql.h"
 #include "info/info.h"
 #include "lua/info.h"
@@ -49,8 +50,6 @@
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
 extern struct rmean *rmean_tx_wal_bus;
 
 static void
@@ -128,6 +127,15 @@ lbox_stat_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_stat_wal(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	wal_stat(&h);
+	return 1;
+}
+
 static int
 lbox_stat_reset(struct lua_State *L)
 {
@@ -149,7 +157,7 @@ static int
 lbox_stat_net_index(struct lua_State *L)
 {
 	const char *key = luaL_checkstring(L, -1);
-	if (rmean_foreach(rmean_net, seek_stat_item, L) == 0)
+	if (iproto_rmean_foreach(seek_stat_item, L) == 0)
 		return 0;
 
 	if (strcmp(key, "CONNECTIONS") == 0) {
@@ -184,7 +192,7 @@ static int
 lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
+	iproto_rmean_foreach(set_stat_item, L);
 
 	lua_pushstring(L, "CONNECTIONS");
 	lua_rawget(L, -2);
@@ -230,6 +238,7 @@ box_lua_stat_init(struct lua_State *L)
 {
 	static const struct luaL_Reg statlib [] = {
 		{"vinyl", lbox_stat_vinyl},
+		{"wal", lbox_stat_wal},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
 		{NULL, NULL}
@@ -0,0 +1,1845 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_art.h"
+#include "say.h"
+#include "fiber.h"
+#include "index.h"
+#include "tuple.h"
+#include "port.h"
+#include "memtx_engine.h"
+#include "space.h"
+#include "schema.h" /* space_cache_find() */
+#include "errinj.h"
+#include "bit/bit.h"
+
+#include <small/mempool.h>
+#include <small/region.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif /* defined(__SSE2__) */
+
+/*
+ * ART index is an adaptive radix tree (Leis et al., "The Adaptive
+ * Radix Tree: ARTful Indexing for Main-Memory Databases") built
+ * over a memcomparable encoding of tuple keys, i.e. an encoding
+ * such that memcmp() of two encoded keys orders them the same way
+ * tuple_compare() orders the keys themselves. An inner node has
+ * from 4 to 256 children, depending on how many distinct bytes
+ * follow its path, and stores a compressed path, i.e. bytes all
+ * keys of the node have in common. Each leaf stores a tuple and
+ * the full encoded key of the tuple, so a lookup costs O(key
+ * length) and never dereferences tuples.
+ *
+ * The encoding of every supported field type is prefix-free, so
+ * an encoded key is never a prefix of another encoded key, and
+ * leaves may only be found in place of child pointers. The
+ * encoding of the first N parts of a key is a prefix of the
+ * encoding of the whole key, which makes any partial key lookup a
+ * prefix scan of the tree.
+ *
+ * Nodes and leaves are allocated from memtx index extents, which
+ * are split into objects of a few size classes.
+ *
+ * A snapshot freezes the tree: every object carries the version
+ * of the tree it was created in, and taking a snapshot bumps the
+ * version. While a snapshot is open, objects of older versions
+ * are never modified in place. Instead, a modified node is copied
+ * along with the path leading to it, and unlinked objects are
+ * kept until the last snapshot is closed, so that a snapshot can
+ * walk its root in another thread.
+ */
+enum {
+	ART_NODE4 = 0,
+	ART_NODE16 = 1,
+	ART_NODE48 = 2,
+	ART_NODE256 = 3,
+};
+
+enum {
+	/** Number of compressed path bytes stored in a node. */
+	ART_PREFIX_MAX = 8,
+	/** Number of allocation size classes. */
+	ART_SIZE_CLASS_COUNT = 40,
+	/** Size of the biggest object that can be allocated. */
+	ART_OBJ_SIZE_MAX = 8192,
+};
+
+/** Header of an inner node. */
+struct art_node {
+	uint8_t type;
+	uint8_t unused;
+	/** Number of children. */
+	uint16_t child_count;
+	/** Version of the tree the node was created in. */
+	uint32_t version;
+	/** Length of the compressed path. */
+	uint32_t prefix_len;
+	/**
+	 * First bytes of the compressed path. The rest of the
+	 * path, if any, is taken from any leaf of the node.
+	 */
+	uint8_t prefix[ART_PREFIX_MAX];
+};
+
+struct art_node4 {
+	struct art_node base;
+	/** Sorted key bytes of children. */
+	uint8_t key[4];
+	struct art_node *child[4];
+};
+
+struct art_node16 {
+	struct art_node base;
+	/** Sorted key bytes of children. */
+	uint8_t key[16];
+	struct art_node *child[16];
+};
+
+struct art_node48 {
+	struct art_node base;
+	/** 1-based positions of children in the array below. */
+	uint8_t index[256];
+	struct art_node *child[48];
+};
+
+struct art_node256 {
+	struct art_node base;
+	struct art_node *child[256];
+};
+
+/**
+ * A leaf. Pointers to leaves are stored in place of pointers
+ * to nodes, with the least significant bit set.
+ */
+struct art_leaf {
+	struct tuple *tuple;
+	/** Encoded key of the tuple. */
+	uint32_t key_len;
+	/** Version of the tree the leaf was created in. */
+	uint32_t version;
+	uint8_t key[0];
+};
+
+static inline bool
+art_is_leaf(const struct art_node *node)
+{
+	return ((uintptr_t)node & 1) != 0;
+}
+
+static inline struct art_leaf *
+art_leaf(struct art_node *node)
+{
+	assert(art_is_leaf(node));
+	return (struct art_leaf *)((uintptr_t)node & ~(uintptr_t)1);
+}
+
+static inline struct art_node *
+art_leaf_ref(struct art_leaf *leaf)
+{
+	return (struct art_node *)((uintptr_t)leaf | 1);
+}
+
+static inline size_t
+art_leaf_size(uint32_t key_len)
+{
+	return offsetof(struct art_leaf, key) + key_len;
+}
+
+static const size_t art_node_size[] = {
+	sizeof(struct art_node4),
+	sizeof(struct art_node16),
+	sizeof(struct art_node48),
+	sizeof(struct art_node256),
+};
+
+static const uint32_t art_node_capacity[] = { 4, 16, 48, 256 };
+
+/* {{{ Allocator ***************************************************/
+
+/** A chunk of the list of objects unlinked from a frozen tree. */
+struct art_garbage {
+	struct art_garbage *next;
+	/** Number of used entries. */
+	uint32_t count;
+	struct {
+		void *ptr;
+		uint32_t size;
+	} obj[255];
+};
+
+struct art_tree {
+	struct art_node *root;
+	/** Number of leaves. */
+	uint32_t count;
+	/** Version of objects created now. */
+	uint32_t version;
+	/** Number of open snapshots. */
+	uint32_t snapshot_count;
+	/**
+	 * Number of references: one is held by the index the
+	 * tree belongs to, one by each snapshot.
+	 */
+	uint32_t refs;
+	/**
+	 * Objects unlinked from the tree while it was frozen,
+	 * freed when the last snapshot is closed.
+	 */
+	struct art_garbage *garbage;
+	struct memtx_engine *memtx;
+	/** Extents allocated by the tree, linked via first word. */
+	void *extents;
+	/** Number of allocated extents. */
+	uint32_t extent_count;
+	/** Unused part of the last allocated extent. */
+	char *pos;
+	char *end;
+	/** Lists of free objects, one per size class. */
+	void *free_list[ART_SIZE_CLASS_COUNT];
+};
+
+/**
+ * Size class of an object. Sizes up to 128 bytes are rounded
+ * up to 8 bytes, bigger ones to a quarter of a power of 2.
+ */
+static inline uint32_t
+art_size_class(size_t size)
+{
+	assert(size > 0 && size <= ART_OBJ_SIZE_MAX);
+	if (size <= 128)
+		return (size - 1) / 8;
+	uint32_t p = 31 - bit_clz_u32(size - 1);
+	return 16 + (p - 7) * 4 + ((size - 1) >> (p - 2)) - 4;
+}
+
+static inline size_t
+art_class_size(uint32_t cls)
+{
+	if (cls < 16)
+		return (cls + 1) * 8;
+	uint32_t p = 7 + (cls - 16) / 4;
+	return ((cls - 16) % 4 + 5) << (p - 2);
+}
+
+static_assert(ART_SIZE_CLASS_COUNT == 16 + 6 * 4 &&
+	      ART_OBJ_SIZE_MAX <= MEMTX_EXTENT_SIZE / 2,
+	      "size classes must cover objects up to ART_OBJ_SIZE_MAX");
+
+static void *
+art_alloc(struct art_tree *tree, size_t size)
+{
+	uint32_t cls = art_size_class(size);
+	void *ptr = tree->free_list[cls];
+	if (ptr != NULL) {
+		tree->free_list[cls] = *(void **)ptr;
+		return ptr;
+	}
+	size = art_class_size(cls);
+	if ((size_t)(tree->end - tree->pos) < size) {
+		/* Put the rest of the extent to free lists. */
+		while (tree->end - tree->pos >= 8) {
+			size_t rest = tree->end - tree->pos;
+			uint32_t c = art_size_class(MIN(rest,
+					(size_t)ART_OBJ_SIZE_MAX));
+			if (art_class_size(c) > rest)
+				c--;
+			*(void **)tree->pos = tree->free_list[c];
+			tree->free_list[c] = tree->pos;
+			tree->pos += art_class_size(c);
+		}
+		char *extent = memtx_index_extent_alloc(tree->memtx);
+		if (extent == NULL)
+			return NULL;
+		*(void **)extent = tree->extents;
+		tree->extents = extent;
+		tree->extent_count++;
+		tree->pos = extent + sizeof(void *);
+		tree->end = extent + MEMTX_EXTENT_SIZE;
+	}
+	ptr = tree->pos;
+	tree->pos += size;
+	return ptr;
+}
+
+static inline void
+art_free(struct art_tree *tree, void *ptr, size_t size)
+{
+	uint32_t cls = art_size_class(size);
+	*(void **)ptr = tree->free_list[cls];
+	tree->free_list[cls] = ptr;
+}
+
+/**
+ * Check if an object created in the given version of the tree
+ * may be reachable from a snapshot and so must not be modified.
+ */
+static inline bool
+art_is_frozen(struct art_tree *tree, uint32_t version)
+{
+	return tree->snapshot_count > 0 && version != tree->version;
+}
+
+/**
+ * Free an object unlinked from the tree. If the object may be
+ * reachable from a snapshot, it's put to the garbage list.
+ */
+static void
+art_release(struct art_tree *tree, void *ptr, size_t size, uint32_t version)
+{
+	if (!art_is_frozen(tree, version)) {
+		art_free(tree, ptr, size);
+		return;
+	}
+	struct art_garbage *garbage = tree->garbage;
+	if (garbage == NULL || garbage->count == lengthof(garbage->obj)) {
+		garbage = art_alloc(tree, sizeof(*garbage));
+		if (garbage == NULL) {
+			/*
+			 * Leave the object in the extent, it will
+			 * be freed with the tree.
+			 */
+			diag_clear(diag_get());
+			return;
+		}
+		garbage->next = tree->garbage;
+		garbage->count = 0;
+		tree->garbage = garbage;
+	}
+	garbage->obj[garbage->count].ptr = ptr;
+	garbage->obj[garbage->count].size = size;
+	garbage->count++;
+}
+
+static void
+art_collect_garbage(struct art_tree *tree)
+{
+	assert(tree->snapshot_count == 0);
+	while (tree->garbage != NULL) {
+		struct art_garbage *garbage = tree->garbage;
+		tree->garbage = garbage->next;
+		for (uint32_t i = 0; i < garbage->count; i++)
+			art_free(tree, garbage->obj[i].ptr,
+				 garbage->obj[i].size);
+		art_free(tree, garbage, sizeof(*garbage));
+	}
+}
+
+static struct art_tree *
+art_tree_new(struct memtx_engine *memtx)
+{
+	struct art_tree *tree = calloc(1, sizeof(*tree));
+	if (tree == NULL) {
+		diag_set(OutOfMemory, sizeof(*tree), "malloc", "art tree");
+		return NULL;
+	}
+	tree->memtx = memtx;
+	tree->refs = 1;
+	return tree;
+}
+
+static void
+art_tree_unref(struct art_tree *tree)
+{
+	assert(tree->refs > 0);
+	if (--tree->refs > 0)
+		return;
+	void *extent = tree->extents;
+	while (extent != NULL) {
+		void *next = *(void **)extent;
+		memtx_index_extent_free(tree->memtx, extent);
+		extent = next;
+	}
+	free(tree);
+}
+
+static struct art_node *
+art_node_new(struct art_tree *tree, uint8_t type)
+{
+	struct art_node *node = art_alloc(tree, art_node_size[type]);
+	if (node == NULL)
+		return NULL;
+	memset(node, 0, art_node_size[type]);
+	node->type = type;
+	node->version = tree->version;
+	return node;
+}
+
+static inline void
+art_node_delete(struct art_tree *tree, struct art_node *node)
+{
+	art_release(tree, node, art_node_size[node->type], node->version);
+}
+
+static struct art_leaf *
+art_leaf_new(struct art_tree *tree, const uint8_t *key, uint32_t key_len,
+	     struct tuple *tuple)
+{
+	struct art_leaf *leaf = art_alloc(tree, art_leaf_size(key_len));
+	if (leaf == NULL)
+		return NULL;
+	leaf->tuple = tuple;
+	leaf->key_len = key_len;
+	leaf->version = tree->version;
+	memcpy(leaf->key, key, key_len);
+	return leaf;
+}
+
+static inline void
+art_leaf_delete(struct art_tree *tree, struct art_leaf *leaf)
+{
+	art_release(tree, leaf, art_leaf_size(leaf->key_len), leaf->version);
+}
+
+/* }}} */
+
+/* {{{ Nodes *******************************************************/
+
+/** Return a pointer to the child of a node or NULL. */
+static inline struct art_node **
+art_node_find_child(struct art_node *node, uint8_t byte)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		for (uint32_t i = 0; i < node->child_count; i++) {
+			if (n->key[i] == byte)
+				return &n->child[i];
+		}
+		return NULL;
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+#if defined(__SSE2__)
+		__m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(byte),
+				_mm_loadu_si128((const __m128i *)n->key));
+		uint32_t mask = _mm_movemask_epi8(cmp) &
+				((1U << node->child_count) - 1);
+		return mask != 0 ? &n->child[bit_ctz_u32(mask)] : NULL;
+#else
+		for (uint32_t i = 0; i < node->child_count; i++) {
+			if (n->key[i] == byte)
+				return &n->child[i];
+		}
+		return NULL;
+#endif
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		uint8_t pos = n->index[byte];
+		return pos != 0 ? &n->child[pos - 1] : NULL;
+	}
+	case ART_NODE256: {
+		struct art_node256 *n = (struct art_node256 *)node;
+		return n->child[byte] != NULL ? &n->child[byte] : NULL;
+	}
+	default:
+		unreachable();
+	}
+	return NULL;
+}
+
+/**
+ * Return the child of a node with the smallest key byte
+ * greater than @a byte or NULL. Pass -1 to get the first child.
+ */
+static struct art_node *
+art_node_child_after(struct art_node *node, int byte)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		for (uint32_t i = 0; i < node->child_count; i++) {
+			if (n->key[i] > byte)
+				return n->child[i];
+		}
+		return NULL;
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+		for (uint32_t i = 0; i < node->child_count; i++) {
+			if (n->key[i] > byte)
+				return n->child[i];
+		}
+		return NULL;
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		for (int b = byte + 1; b < 256; b++) {
+			if (n->index[b] != 0)
+				return n->child[n->index[b] - 1];
+		}
+		return NULL;
+	}
+	case ART_NODE256: {
+		struct art_node256 *n = (struct art_node256 *)node;
+		for (int b = byte + 1; b < 256; b++) {
+			if (n->child[b] != NULL)
+				return n->child[b];
+		}
+		return NULL;
+	}
+	default:
+		unreachable();
+	}
+	return NULL;
+}
+
+/**
+ * Return the child of a node with the greatest key byte
+ * less than @a byte or NULL. Pass 256 to get the last child.
+ */
+static struct art_node *
+art_node_child_before(struct art_node *node, int byte)
+{
+	switch (node->type) {
+	case ART_NODE4: {
+		struct art_node4 *n = (struct art_node4 *)node;
+		for (uint32_t i = node->child_count; i > 0; i--) {
+			if (n->key[i - 1] < byte)
+				return n->child[i - 1];
+		}
+		return NULL;
+	}
+	case ART_NODE16: {
+		struct art_node16 *n = (struct art_node16 *)node;
+		for (uint32_t i = node->child_count; i > 0; i--) {
+			if (n->key[i - 1] < byte)
+				return n->child[i - 1];
+		}
+		return NULL;
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		for (int b = byte - 1; b >= 0; b--) {
+			if (n->index[b] != 0)
+				return n->child[n->index[b] - 1];
+		}
+		return NULL;
+	}
+	case ART_NODE256: {
+		struct art_node256 *n = (struct art_node256 *)node;
+		for (int b = byte - 1; b >= 0; b--) {
+			if (n->child[b] != NULL)
+				return n->child[b];
+		}
+		return NULL;
+	}
+	default:
+		unreachable();
+	}
+	return NULL;
+}
+
+/** Return the i-th child of a node in key order. */
+static struct art_node *
+art_node_child_at(struct art_node *node, uint32_t i)
+{
+	assert(i < node->child_count);
+	switch (node->type) {
+	case ART_NODE4:
+		return ((struct art_node4 *)node)->child[i];
+	case ART_NODE16:
+		return ((struct art_node16 *)node)->child[i];
+	default:
+		for (int b = 0; b < 256; b++) {
+			struct art_node **ref = art_node_find_child(node, b);
+			if (ref != NULL && i-- == 0)
+				return *ref;
+		}
+		unreachable();
+		return NULL;
+	}
+}
+
+/** Add a child to a node that has room for it. */
+static void
+art_node_add_child(struct art_node *node, uint8_t byte,
+		   struct art_node *child)
+{
+	assert(node->child_count < art_node_capacity[node->type]);
+	assert(art_node_find_child(node, byte) == NULL);
+	switch (node->type) {
+	case ART_NODE4:
+	case ART_NODE16: {
+		uint8_t *key;
+		struct art_node **children;
+		if (node->type == ART_NODE4) {
+			key = ((struct art_node4 *)node)->key;
+			children = ((struct art_node4 *)node)->child;
+		} else {
+			key = ((struct art_node16 *)node)->key;
+			children = ((struct art_node16 *)node)->child;
+		}
+		uint32_t i = 0;
+		while (i < node->child_count && key[i] < byte)
+			i++;
+		uint32_t tail = node->child_count - i;
+		memmove(key + i + 1, key + i, tail);
+		memmove(children + i + 1, children + i,
+			tail * sizeof(children[0]));
+		key[i] = byte;
+		children[i] = child;
+		break;
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		uint32_t pos = 0;
+		while (n->child[pos] != NULL)
+			pos++;
+		n->child[pos] = child;
+		n->index[byte] = pos + 1;
+		break;
+	}
+	case ART_NODE256:
+		((struct art_node256 *)node)->child[byte] = child;
+		break;
+	default:
+		unreachable();
+	}
+	node->child_count++;
+}
+
+/** Remove a child from a node. */
+static void
+art_node_remove_child(struct art_node *node, uint8_t byte)
+{
+	switch (node->type) {
+	case ART_NODE4:
+	case ART_NODE16: {
+		uint8_t *key;
+		struct art_node **children;
+		if (node->type == ART_NODE4) {
+			key = ((struct art_node4 *)node)->key;
+			children = ((struct art_node4 *)node)->child;
+		} else {
+			key = ((struct art_node16 *)node)->key;
+			children = ((struct art_node16 *)node)->child;
+		}
+		uint32_t i = 0;
+		while (key[i] != byte)
+			i++;
+		uint32_t tail = node->child_count - i - 1;
+		memmove(key + i, key + i + 1, tail);
+		memmove(children + i, children + i + 1,
+			tail * sizeof(children[0]));
+		break;
+	}
+	case ART_NODE48: {
+		struct art_node48 *n = (struct art_node48 *)node;
+		assert(n->index[byte] != 0);
+		n->child[n->index[byte] - 1] = NULL;
+		n->index[byte] = 0;
+		break;
+	}
+	case ART_NODE256:
+		((struct art_node256 *)node)->child[byte] = NULL;
+		break;
+	default:
+		unreachable();
+	}
+	node->child_count--;
+}
+
+/**
+ * Create a node of the given type with the same compressed
+ * path and children as @a node. Used to grow and shrink nodes.
+ */
+static struct art_node *
+art_node_copy(struct art_tree *tree, struct art_node *node, uint8_t type)
+{
+	assert(node->child_count <= art_node_capacity[type]);
+	struct art_node *copy = art_node_new(tree, type);
+	if (copy == NULL)
+		return NULL;
+	copy->prefix_len = node->prefix_len;
+	memcpy(copy->prefix, node->prefix, ART_PREFIX_MAX);
+	for (int b = 0; b < 256; b++) {
+		struct art_node **child = art_node_find_child(node, b);
+		if (child != NULL)
+			art_node_add_child(copy, b, *child);
+	}
+	return copy;
+}
+
+/**
+ * Make the node referenced by @a ref modifiable: if the node may
+ * be reachable from a snapshot, replace it with a copy. The node
+ * holding the reference must be modifiable. Returns NULL on memory
+ * allocation error.
+ */
+static struct art_node *
+art_node_unfreeze(struct art_tree *tree, struct art_node **ref)
+{
+	struct art_node *node = *ref;
+	assert(!art_is_leaf(node));
+	if (!art_is_frozen(tree, node->version))
+		return node;
+	struct art_node *copy = art_alloc(tree, art_node_size[node->type]);
+	if (copy == NULL)
+		return NULL;
+	memcpy(copy, node, art_node_size[node->type]);
+	copy->version = tree->version;
+	art_node_delete(tree, node);
+	*ref = copy;
+	return copy;
+}
+
+static inline void
+art_node_set_prefix(struct art_node *node, const uint8_t *prefix,
+		    uint32_t len)
+{
+	node->prefix_len = len;
+	memcpy(node->prefix, prefix, MIN(len, (uint32_t)ART_PREFIX_MAX));
+}
+
+static struct art_leaf *
+art_minimum(struct art_node *node)
+{
+	while (!art_is_leaf(node))
+		node = art_node_child_after(node, -1);
+	return art_leaf(node);
+}
+
+static struct art_leaf *
+art_maximum(struct art_node *node)
+{
+	while (!art_is_leaf(node))
+		node = art_node_child_before(node, 256);
+	return art_leaf(node);
+}
+
+/**
+ * Return the compressed path of a node found at the given
+ * depth. If the path doesn't fit in the node, it is read from
+ * the key of the leftmost leaf of the node.
+ */
+static inline const uint8_t *
+art_node_prefix(struct art_node *node, uint32_t depth)
+{
+	if (node->prefix_len <= ART_PREFIX_MAX)
+		return node->prefix;
+	return art_minimum(node)->key + depth;
+}
+
+/* }}} */
+
+/* {{{ Tree ********************************************************/
+
+/**
+ * Compare an encoded key with a search key. A key starting
+ * with the search key is considered equal to it.
+ */
+static inline int
+art_key_cmp(const uint8_t *key, uint32_t key_len,
+	    const uint8_t *search, uint32_t search_len)
+{
+	int rc = memcmp(key, search, MIN(key_len, search_len));
+	if (rc != 0)
+		return rc;
+	return key_len < search_len ? -1 : 0;
+}
+
+static inline bool
+art_leaf_matches(struct art_leaf *leaf, const uint8_t *key, uint32_t len)
+{
+	return leaf->key_len == len && memcmp(leaf->key, key, len) == 0;
+}
+
+/** Find the leaf with the given key. */
+static struct art_leaf *
+art_lookup(struct art_tree *tree, const uint8_t *key, uint32_t len)
+{
+	struct art_node *node = tree->root;
+	uint32_t depth = 0;
+	while (node != NULL && !art_is_leaf(node)) {
+		/*
+		 * Skip the compressed path, it's checked against
+		 * the leaf key in the end.
+		 */
+		depth += node->prefix_len;
+		if (depth >= len)
+			return NULL;
+		struct art_node **child = art_node_find_child(node, key[depth]);
+		node = child != NULL ? *child : NULL;
+		depth++;
+	}
+	if (node == NULL || !art_leaf_matches(art_leaf(node), key, len))
+		return NULL;
+	return art_leaf(node);
+}
+
+/**
+ * Position search. Returns the first leaf whose key compares
+ * greater than or equal to (greater than if @a strict is set)
+ * the search key or, if @a reverse is set, the last leaf whose
+ * key compares less than or equal to (less than) the search key.
+ * Keys are compared with art_key_cmp(). The tree is given by its
+ * root, which may be the root of a snapshot.
+ */
+static struct art_leaf *
+art_seek(struct art_node *root, const uint8_t *key, uint32_t len,
+	 bool reverse, bool strict)
+{
+	struct art_node *node = root;
+	/*
+	 * Closest subtree following (preceding) the path to
+	 * the search key. The result is looked up there if the
+	 * subtree at the end of the path doesn't contain it.
+	 */
+	struct art_node *next = NULL;
+	uint32_t depth = 0;
+	/* How all keys of the current subtree compare with the key. */
+	int cmp;
+	while (true) {
+		if (node == NULL)
+			goto fallback;
+		if (art_is_leaf(node)) {
+			struct art_leaf *leaf = art_leaf(node);
+			cmp = art_key_cmp(leaf->key, leaf->key_len, key, len);
+			break;
+		}
+		const uint8_t *prefix = art_node_prefix(node, depth);
+		uint32_t i = 0;
+		while (i < node->prefix_len && depth + i < len &&
+		       prefix[i] == key[depth + i])
+			i++;
+		if (depth + i >= len) {
+			cmp = 0;
+			break;
+		}
+		if (i < node->prefix_len) {
+			cmp = prefix[i] < key[depth + i] ? -1 : 1;
+			break;
+		}
+		depth += node->prefix_len;
+		uint8_t byte = key[depth];
+		struct art_node *sibling = reverse ?
+			art_node_child_before(node, byte) :
+			art_node_child_after(node, byte);
+		if (sibling != NULL)
+			next = sibling;
+		struct art_node **child = art_node_find_child(node, byte);
+		node = child != NULL ? *child : NULL;
+		depth++;
+	}
+	if (!reverse && (cmp > 0 || (cmp == 0 && !strict)))
+		return art_minimum(node);
+	if (reverse && (cmp < 0 || (cmp == 0 && !strict)))
+		return art_maximum(node);
+fallback:
+	if (next == NULL)
+		return NULL;
+	return reverse ? art_maximum(next) : art_minimum(next);
+}
+
+/** Return the leaf following the given one in key order. */
+static inline struct art_leaf *
+art_next(struct art_node *root, struct art_leaf *leaf)
+{
+	return art_seek(root, leaf->key, leaf->key_len, false, true);
+}
+
+/**
+ * Insert a leaf. The tree must not contain a leaf with the
+ * same key. Returns -1 on memory allocation error, in which
+ * case the content of the tree is unchanged.
+ */
+static int
+art_insert(struct art_tree *tree, struct art_leaf *leaf)
+{
+	const uint8_t *key = leaf->key;
+	struct art_node **ref = &tree->root;
+	uint32_t depth = 0;
+	while (true) {
+		struct art_node *node = *ref;
+		if (node == NULL) {
+			*ref = art_leaf_ref(leaf);
+			break;
+		}
+		if (art_is_leaf(node)) {
+			/*
+			 * Replace the leaf with a node holding both
+			 * leaves. Encoded keys are prefix-free, so
+			 * they must differ before either of them ends.
+			 */
+			struct art_leaf *other = art_leaf(node);
+			uint32_t len = MIN(leaf->key_len, other->key_len);
+			uint32_t i = depth;
+			while (i < len && key[i] == other->key[i])
+				i++;
+			assert(i < len);
+			struct art_node *parent = art_node_new(tree, ART_NODE4);
+			if (parent == NULL)
+				return -1;
+			art_node_set_prefix(parent, key + depth, i - depth);
+			art_node_add_child(parent, key[i], art_leaf_ref(leaf));
+			art_node_add_child(parent, other->key[i], node);
+			*ref = parent;
+			break;
+		}
+		const uint8_t *prefix = art_node_prefix(node, depth);
+		uint32_t i = 0;
+		while (i < node->prefix_len && prefix[i] == key[depth + i])
+			i++;
+		assert(depth + i < leaf->key_len);
+		if (i < node->prefix_len) {
+			/*
+			 * The key diverges from the compressed path.
+			 * Split the path at the mismatch.
+			 */
+			node = art_node_unfreeze(tree, ref);
+			if (node == NULL)
+				return -1;
+			prefix = art_node_prefix(node, depth);
+			struct art_node *parent = art_node_new(tree, ART_NODE4);
+			if (parent == NULL)
+				return -1;
+			art_node_set_prefix(parent, key + depth, i);
+			uint8_t byte = prefix[i];
+			node->prefix_len -= i + 1;
+			uint32_t len = MIN(node->prefix_len,
+					   (uint32_t)ART_PREFIX_MAX);
+			memmove(node->prefix, prefix + i + 1, len);
+			art_node_add_child(parent, byte, node);
+			art_node_add_child(parent, key[depth + i],
+					   art_leaf_ref(leaf));
+			*ref = parent;
+			break;
+		}
+		depth += node->prefix_len;
+		struct art_node **child = art_node_find_child(node, key[depth]);
+		if (child == NULL &&
+		    node->child_count == art_node_capacity[node->type]) {
+			struct art_node *bigger = art_node_copy(tree, node,
+								node->type + 1);
+			if (bigger == NULL)
+				return -1;
+			art_node_delete(tree, node);
+			*ref = bigger;
+			art_node_add_child(bigger, key[depth],
+					   art_leaf_ref(leaf));
+			break;
+		}
+		/*
+		 * The node is going to be modified, either here or
+		 * down the path, so it must not be shared with
+		 * a snapshot.
+		 */
+		node = art_node_unfreeze(tree, ref);
+		if (node == NULL)
+			return -1;
+		if (child == NULL) {
+			art_node_add_child(node, key[depth],
+					   art_leaf_ref(leaf));
+			break;
+		}
+		ref = art_node_find_child(node, key[depth]);
+		depth++;
+	}
+	tree->count++;
+	return 0;
+}
+
+/**
+ * Remove a child from a node referenced by @a ref, shrinking
+ * the node if it gets sparse. Never fails: if there's no memory
+ * for a smaller node, the node is left as is. The node must
+ * have been made modifiable with art_unfreeze_path().
+ */
+static void
+art_remove_child(struct art_tree *tree, struct art_node **ref,
+		 uint8_t byte)
+{
+	struct art_node *node = *ref;
+	assert(!art_is_frozen(tree, node->version));
+	art_node_remove_child(node, byte);
+	if (node->child_count == 1) {
+		/*
+		 * Merge the node with its only child. Normally it's
+		 * NODE4, but a bigger node may get here if it failed
+		 * to shrink.
+		 */
+		int b = 0;
+		struct art_node **only = NULL;
+		while (only == NULL)
+			only = art_node_find_child(node, b++);
+		struct art_node *child = *only;
+		if (!art_is_leaf(child)) {
+			assert(!art_is_frozen(tree, child->version));
+			uint8_t prefix[ART_PREFIX_MAX];
+			uint32_t len = MIN(node->prefix_len,
+					   (uint32_t)ART_PREFIX_MAX);
+			memcpy(prefix, node->prefix, len);
+			if (len < ART_PREFIX_MAX)
+				prefix[len++] = b - 1;
+			if (len < ART_PREFIX_MAX) {
+				memcpy(prefix + len, child->prefix,
+				       MIN(child->prefix_len,
+					   (uint32_t)ART_PREFIX_MAX - len));
+			}
+			child->prefix_len += node->prefix_len + 1;
+			memcpy(child->prefix, prefix, ART_PREFIX_MAX);
+		}
+		*ref = child;
+		art_node_delete(tree, node);
+		return;
+	}
+	/* Shrink thresholds leave a gap to avoid thrashing. */
+	static const uint32_t shrink_count[] = { 0, 3, 12, 37 };
+	if (node->type == ART_NODE4 ||
+	    node->child_count > shrink_count[node->type])
+		return;
+	struct art_node *smaller = art_node_copy(tree, node, node->type - 1);
+	if (smaller == NULL) {
+		diag_clear(diag_get());
+		return;
+	}
+	art_node_delete(tree, node);
+	*ref = smaller;
+}
+
+/**
+ * Prepare removal of the leaf with the given key: make all nodes
+ * on the path to the leaf modifiable and, if the parent of the
+ * leaf is going to be merged with its other child, that child
+ * too. Sets @a leaf_ref to the reference to the leaf or NULL if
+ * there's no such leaf. Returns -1 on memory allocation error,
+ * in which case the content of the tree is unchanged.
+ *
+ * Insertion only replaces nodes with modifiable ones, so the
+ * leaf may be removed without allocating memory even if another
+ * leaf is inserted in between.
+ */
+static int
+art_unfreeze_path(struct art_tree *tree, const uint8_t *key, uint32_t len,
+		  struct art_node ***leaf_ref)
+{
+	struct art_node **ref = &tree->root;
+	uint32_t depth = 0;
+	*leaf_ref = NULL;
+	while (*ref != NULL && !art_is_leaf(*ref)) {
+		struct art_node *node = art_node_unfreeze(tree, ref);
+		if (node == NULL)
+			return -1;
+		depth += node->prefix_len;
+		if (depth >= len)
+			return 0;
+		struct art_node **child = art_node_find_child(node, key[depth]);
+		if (child == NULL)
+			return 0;
+		if (!art_is_leaf(*child)) {
+			ref = child;
+			depth++;
+			continue;
+		}
+		if (!art_leaf_matches(art_leaf(*child), key, len))
+			return 0;
+		if (node->child_count == 2 && tree->snapshot_count > 0) {
+			/* See the merge in art_remove_child(). */
+			for (int b = 0; b < 256; b++) {
+				struct art_node **other =
+					art_node_find_child(node, b);
+				if (other == NULL || other == child ||
+				    art_is_leaf(*other))
+					continue;
+				if (art_node_unfreeze(tree, other) == NULL)
+					return -1;
+			}
+		}
+		*leaf_ref = child;
+		return 0;
+	}
+	if (*ref != NULL && art_leaf_matches(art_leaf(*ref), key, len))
+		*leaf_ref = ref;
+	return 0;
+}
+
+/**
+ * Remove and return the leaf with the given key. The path to
+ * the leaf must have been made modifiable with art_unfreeze_path().
+ */
+static struct art_leaf *
+art_delete(struct art_tree *tree, const uint8_t *key, uint32_t len)
+{
+	struct art_node **ref = &tree->root;
+	struct art_leaf *leaf;
+	if (*ref == NULL)
+		return NULL;
+	if (art_is_leaf(*ref)) {
+		leaf = art_leaf(*ref);
+		if (!art_leaf_matches(leaf, key, len))
+			return NULL;
+		*ref = NULL;
+		goto out;
+	}
+	uint32_t depth = 0;
+	while (true) {
+		struct art_node *node = *ref;
+		depth += node->prefix_len;
+		if (depth >= len)
+			return NULL;
+		struct art_node **child = art_node_find_child(node, key[depth]);
+		if (child == NULL)
+			return NULL;
+		if (art_is_leaf(*child)) {
+			leaf = art_leaf(*child);
+			if (!art_leaf_matches(leaf, key, len))
+				return NULL;
+			art_remove_child(tree, ref, key[depth]);
+			break;
+		}
+		ref = child;
+		depth++;
+	}
+out:
+	assert(tree->count > 0);
+	tree->count--;
+	return leaf;
+}
+
+/**
+ * Replace the tuple stored in a leaf. A leaf shared with a
+ * snapshot is replaced with a copy. Returns -1 on memory
+ * allocation error.
+ */
+static int
+art_replace(struct art_tree *tree, struct art_leaf *leaf, struct tuple *tuple)
+{
+	if (!art_is_frozen(tree, leaf->version)) {
+		leaf->tuple = tuple;
+		return 0;
+	}
+	struct art_node **ref;
+	if (art_unfreeze_path(tree, leaf->key, leaf->key_len, &ref) != 0)
+		return -1;
+	assert(ref != NULL && art_leaf(*ref) == leaf);
+	struct art_leaf *copy = art_leaf_new(tree, leaf->key, leaf->key_len,
+					     tuple);
+	if (copy == NULL)
+		return -1;
+	*ref = art_leaf_ref(copy);
+	art_leaf_delete(tree, leaf);
+	return 0;
+}
+
+/* }}} */
+
+/* {{{ Key encoding ************************************************/
+
+/** Max size of the encoding of a key part. */
+static inline uint32_t
+art_part_size_max(const char *field)
+{
+	switch (mp_typeof(*field)) {
+	case MP_STR:
+		return 2 * mp_decode_strl(&field) + 2;
+	case MP_BOOL:
+		return 1;
+	default:
+		return 9;
+	}
+}
+
+/**
+ * Encode a key part. Integers are stored as a sign byte
+ * followed by 8 big-endian bytes. In a string zero bytes are
+ * escaped as 0x00 0xff and the string is terminated with 0x00
+ * 0x00, so that a string is ordered before its extensions.
+ */
+static uint8_t *
+art_encode_part(uint8_t *out, const char *field)
+{
+	uint64_t value;
+	switch (mp_typeof(*field)) {
+	case MP_UINT:
+		value = mp_decode_uint(&field);
+		*out++ = 1;
+		break;
+	case MP_INT: {
+		int64_t v = mp_decode_int(&field);
+		value = (uint64_t)v;
+		*out++ = v < 0 ? 0 : 1;
+		break;
+	}
+	case MP_BOOL:
+		*out++ = mp_decode_bool(&field) ? 1 : 0;
+		return out;
+	case MP_STR: {
+		uint32_t len;
+		const char *str = mp_decode_str(&field, &len);
+		for (uint32_t i = 0; i < len; i++) {
+			*out++ = str[i];
+			if (str[i] == 0)
+				*out++ = 0xff;
+		}
+		*out++ = 0;
+		*out++ = 0;
+		return out;
+	}
+	default:
+		unreachable();
+		return out;
+	}
+	for (int shift = 56; shift >= 0; shift -= 8)
+		*out++ = (uint8_t)(value >> shift);
+	return out;
+}
+
+/**
+ * Encode a key given in MsgPack into a buffer allocated on
+ * the region. Returns NULL on memory allocation error.
+ */
+static uint8_t *
+art_encode_key(const char *key, uint32_t part_count, uint32_t *len)
+{
+	uint32_t size = 0;
+	const char *field = key;
+	for (uint32_t i = 0; i < part_count; i++) {
+		size += art_part_size_max(field);
+		mp_next(&field);
+	}
+	uint8_t *buf = region_alloc(&fiber()->gc, MAX(size, 1U));
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "key");
+		return NULL;
+	}
+	uint8_t *end = buf;
+	for (uint32_t i = 0; i < part_count; i++) {
+		end = art_encode_part(end, key);
+		mp_next(&key);
+	}
+	*len = end - buf;
+	return buf;
+}
+
+/**
+ * Encode the key of a tuple into a buffer allocated on the
+ * region. Returns NULL on memory allocation error.
+ */
+static uint8_t *
+art_encode_tuple(struct tuple *tuple, struct key_def *key_def,
+		 uint32_t *len)
+{
+	uint32_t size = 0;
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		const char *field = tuple_field_by_part(tuple,
+							&key_def->parts[i],
+							MULTIKEY_NONE);
+		assert(field != NULL);
+		size += art_part_size_max(field);
+	}
+	uint8_t *buf = region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "key");
+		return NULL;
+	}
+	uint8_t *end = buf;
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		const char *field = tuple_field_by_part(tuple,
+							&key_def->parts[i],
+							MULTIKEY_NONE);
+		end = art_encode_part(end, field);
+	}
+	*len = end - buf;
+	return buf;
+}
+
+/* }}} */
+
+struct memtx_art_index {
+	struct index base;
+	/** The tree, shared with snapshot iterators. */
+	struct art_tree *tree;
+	struct memtx_gc_task gc_task;
+	/** Leaf of the next tuple to free on drop. */
+	struct art_leaf *gc_leaf;
+};
+
+/**
+ * Key definition used for encoding tuple keys. Tuple keys of
+ * a non-unique index are extended with primary key parts.
+ */
+static inline struct key_def *
+memtx_art_index_key_def(struct memtx_art_index *index)
+{
+	struct index_def *def = index->base.def;
+	return def->opts.is_unique ? def->key_def : def->cmp_def;
+}
+
+/* {{{ MemtxArt Iterators *******************************************/
+
+struct art_iterator {
+	struct iterator base; /* Must be the first member. */
+	struct art_tree *tree;
+	enum iterator_type type;
+	/** Encoded search key. */
+	uint8_t *key;
+	uint32_t key_len;
+	/**
+	 * Encoded key of the last returned tuple. The next tuple
+	 * is looked up by this key, so that the iterator stays
+	 * valid no matter how the tree is modified between calls.
+	 */
+	uint8_t *last;
+	uint32_t last_len;
+	uint32_t last_size;
+	/** Memory pool the iterator was allocated from. */
+	struct mempool *pool;
+};
+
+static_assert(sizeof(struct art_iterator) <= MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct art_iterator) must be less than or equal "
+	      "to MEMTX_ITERATOR_SIZE");
+
+static void
+art_iterator_free(struct iterator *iterator)
+{
+	assert(iterator->free == art_iterator_free);
+	struct art_iterator *it = (struct art_iterator *) iterator;
+	free(it->key);
+	free(it->last);
+	mempool_free(it->pool, it);
+}
+
+static int
+art_iterator_dummie(MAYBE_UNUSED struct iterator *it, struct tuple **ret)
+{
+	*ret = NULL;
+	return 0;
+}
+
+static int
+art_iterator_next(struct iterator *ptr, struct tuple **ret)
+{
+	assert(ptr->free == art_iterator_free);
+	struct art_iterator *it = (struct art_iterator *) ptr;
+	bool reverse = iterator_type_is_reverse(it->type);
+	struct art_leaf *leaf;
+	if (it->last_size == 0) {
+		bool strict = it->type == ITER_GT || it->type == ITER_LT;
+		leaf = art_seek(it->tree->root, it->key, it->key_len,
+				reverse, strict);
+	} else {
+		leaf = art_seek(it->tree->root, it->last, it->last_len,
+				reverse, true);
+	}
+	if (leaf != NULL && (it->type == ITER_EQ || it->type == ITER_REQ) &&
+	    art_key_cmp(leaf->key, leaf->key_len, it->key, it->key_len) != 0)
+		leaf = NULL;
+	if (leaf == NULL) {
+		ptr->next = art_iterator_dummie;
+		*ret = NULL;
+		return 0;
+	}
+	if (leaf->key_len > it->last_size) {
+		uint32_t size = MAX(leaf->key_len, it->last_size * 2);
+		uint8_t *last = realloc(it->last, size);
+		if (last == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "key");
+			return -1;
+		}
+		it->last = last;
+		it->last_size = size;
+	}
+	memcpy(it->last, leaf->key, leaf->key_len);
+	it->last_len = leaf->key_len;
+	*ret = leaf->tuple;
+	return 0;
+}
+
+/* }}} */
+
+/* {{{ MemtxArt ****************************************************/
+
+static void
+memtx_art_index_free(struct memtx_art_index *index)
+{
+	art_tree_unref(index->tree);
+	free(index);
+}
+
+static void
+memtx_art_index_gc_run(struct memtx_gc_task *task, bool *done)
+{
+	/*
+	 * Yield every 1K tuples to keep latency < 0.1 ms.
+	 * Yield more often in debug mode.
+	 */
+#ifdef NDEBUG
+	enum { YIELD_LOOPS = 1000 };
+#else
+	enum { YIELD_LOOPS = 10 };
+#endif
+
+	struct memtx_art_index *index = container_of(task,
+			struct memtx_art_index, gc_task);
+
+	unsigned int loops = 0;
+	while (index->gc_leaf != NULL) {
+		struct art_leaf *leaf = index->gc_leaf;
+		index->gc_leaf = art_next(index->tree->root, leaf);
+		tuple_unref(leaf->tuple);
+		if (++loops >= YIELD_LOOPS) {
+			*done = false;
+			return;
+		}
+	}
+	*done = true;
+}
+
+static void
+memtx_art_index_gc_free(struct memtx_gc_task *task)
+{
+	struct memtx_art_index *index = container_of(task,
+			struct memtx_art_index, gc_task);
+	memtx_art_index_free(index);
+}
+
+static const struct memtx_gc_task_vtab memtx_art_index_gc_vtab = {
+	.run = memtx_art_index_gc_run,
+	.free = memtx_art_index_gc_free,
+};
+
+static void
+memtx_art_index_destroy(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	if (base->def->iid == 0 && index->tree->root != NULL) {
+		/*
+		 * Primary index. We need to free all tuples stored
+		 * in the index, which may take a while. Schedule a
+		 * background task in order not to block tx thread.
+		 */
+		index->gc_task.vtab = &memtx_art_index_gc_vtab;
+		index->gc_leaf = art_minimum(index->tree->root);
+		memtx_engine_schedule_gc(memtx, &index->gc_task);
+	} else {
+		/*
+		 * Secondary index. Destruction is fast, no need to
+		 * hand over to background fiber.
+		 */
+		memtx_art_index_free(index);
+	}
+}
+
+static bool
+memtx_art_index_depends_on_pk(struct index *base)
+{
+	/* See memtx_art_index_key_def(). */
+	return !base->def->opts.is_unique;
+}
+
+static ssize_t
+memtx_art_index_size(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	return index->tree->count;
+}
+
+static ssize_t
+memtx_art_index_bsize(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	return (ssize_t)index->tree->extent_count * MEMTX_EXTENT_SIZE;
+}
+
+static int
+memtx_art_index_random(struct index *base, uint32_t rnd,
+		       struct tuple **result)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct art_node *node = index->tree->root;
+	*result = NULL;
+	if (node == NULL)
+		return 0;
+	while (!art_is_leaf(node)) {
+		node = art_node_child_at(node, rnd % node->child_count);
+		rnd = rnd * 1103515245 + 12345;
+	}
+	*result = art_leaf(node)->tuple;
+	return 0;
+}
+
+static ssize_t
+memtx_art_index_count(struct index *base, enum iterator_type type,
+		      const char *key, uint32_t part_count)
+{
+	if (type == ITER_ALL)
+		return memtx_art_index_size(base); /* optimization */
+	return generic_index_count(base, type, key, part_count);
+}
+
+static int
+memtx_art_index_get(struct index *base, const char *key,
+		    uint32_t part_count, struct tuple **result)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	assert(base->def->opts.is_unique &&
+	       part_count == base->def->key_def->part_count);
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t len;
+	uint8_t *encoded = art_encode_key(key, part_count, &len);
+	if (encoded == NULL)
+		return -1;
+	struct art_leaf *leaf = art_lookup(index->tree, encoded, len);
+	*result = leaf != NULL ? leaf->tuple : NULL;
+	region_truncate(region, region_svp);
+	return 0;
+}
+
+static int
+memtx_art_index_get_many(struct index *base, const char **keys,
+			 uint32_t key_count, struct port *port)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	assert(base->def->opts.is_unique);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	int rc = 0;
+	for (uint32_t i = 0; i < key_count && rc == 0; i++) {
+		const char *key = keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		assert(part_count == base->def->key_def->part_count);
+		uint32_t len;
+		uint8_t *encoded = art_encode_key(key, part_count, &len);
+		if (encoded == NULL) {
+			rc = -1;
+			break;
+		}
+		struct art_leaf *leaf = art_lookup(index->tree, encoded, len);
+		if (leaf != NULL)
+			rc = port_tuple_add(port, leaf->tuple);
+		region_truncate(region, region_svp);
+	}
+	region_truncate(region, region_svp);
+	return rc;
+}
+
+static int
+memtx_art_index_replace(struct index *base, struct tuple *old_tuple,
+			struct tuple *new_tuple, enum dup_replace_mode mode,
+			struct tuple **result)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct key_def *key_def = memtx_art_index_key_def(index);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint8_t *new_key = NULL, *old_key = NULL;
+	uint32_t new_len = 0, old_len = 0;
+	/* Encode keys before modifying the tree. */
+	if (new_tuple != NULL &&
+	    (new_key = art_encode_tuple(new_tuple, key_def, &new_len)) == NULL)
+		goto fail;
+	if (old_tuple != NULL &&
+	    (old_key = art_encode_tuple(old_tuple, key_def, &old_len)) == NULL)
+		goto fail;
+
+	struct art_tree *tree = index->tree;
+	struct art_node **ref;
+	/*
+	 * Copy nodes shared with snapshots before inserting the
+	 * new tuple so that removal of the old one can't fail.
+	 */
+	if (old_tuple != NULL &&
+	    art_unfreeze_path(tree, old_key, old_len, &ref) != 0)
+		goto fail;
+
+	if (new_tuple) {
+		struct art_leaf *dup_leaf = art_lookup(tree, new_key, new_len);
+		struct tuple *dup_tuple = dup_leaf != NULL ?
+					  dup_leaf->tuple : NULL;
+		uint32_t errcode = replace_check_dup(old_tuple,
+						     dup_tuple, mode);
+		if (errcode) {
+			struct space *sp = space_cache_find(base->def->space_id);
+			if (sp != NULL)
+				diag_set(ClientError, errcode, base->def->name,
+					 space_name(sp));
+			goto fail;
+		}
+		if (dup_leaf != NULL) {
+			/* Equal keys have equal encodings. */
+			if (art_replace(tree, dup_leaf, new_tuple) != 0)
+				goto fail;
+			region_truncate(region, region_svp);
+			*result = dup_tuple;
+			return 0;
+		}
+		if (art_leaf_size(new_len) > ART_OBJ_SIZE_MAX) {
+			diag_set(ClientError, ER_UNSUPPORTED, "ART index",
+				 tt_sprintf("keys longer than %u bytes",
+					    (unsigned)(ART_OBJ_SIZE_MAX -
+						       art_leaf_size(0))));
+			goto fail;
+		}
+		int rc = 0;
+		ERROR_INJECT(ERRINJ_INDEX_ALLOC, {
+			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+				 "memtx_index_extent_alloc", "art node");
+			rc = -1;
+		});
+		if (rc != 0)
+			goto fail;
+		struct art_leaf *leaf = art_leaf_new(tree, new_key,
+						     new_len, new_tuple);
+		if (leaf == NULL)
+			goto fail;
+		if (art_insert(tree, leaf) != 0) {
+			art_leaf_delete(tree, leaf);
+			goto fail;
+		}
+	}
+
+	if (old_tuple) {
+		struct art_leaf *leaf = art_delete(tree, old_key, old_len);
+		assert(leaf != NULL && leaf->tuple == old_tuple);
+		if (leaf != NULL)
+			art_leaf_delete(tree, leaf);
+	}
+	region_truncate(region, region_svp);
+	*result = old_tuple;
+	return 0;
+fail:
+	region_truncate(region, region_svp);
+	return -1;
+}
+
+static struct iterator *
+memtx_art_index_create_iterator(struct index *base, enum iterator_type type,
+				const char *key, uint32_t part_count)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+
+	assert(part_count == 0 || key != NULL);
+	if (type > ITER_GT) {
+		diag_set(UnsupportedIndexFeature, base->def,
+			 "requested iterator type");
+		return NULL;
+	}
+	if (part_count == 0) {
+		/*
+		 * If no key is specified, downgrade equality
+		 * iterators to a full range.
+		 */
+		type = iterator_type_is_reverse(type) ? ITER_LE : ITER_GE;
+	} else if (type == ITER_ALL) {
+		type = ITER_GE;
+	}
+
+	struct art_iterator *it = mempool_alloc(&memtx->iterator_pool);
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(struct art_iterator),
+			 "memtx_art_index", "iterator");
+		return NULL;
+	}
+	iterator_create(&it->base, base);
+	it->pool = &memtx->iterator_pool;
+	it->base.next = art_iterator_next;
+	it->base.free = art_iterator_free;
+	it->tree = index->tree;
+	it->type = type;
+	it->key = NULL;
+	it->key_len = 0;
+	it->last = NULL;
+	it->last_len = 0;
+	it->last_size = 0;
+	if (part_count > 0) {
+		struct region *region = &fiber()->gc;
+		size_t region_svp = region_used(region);
+		uint8_t *encoded = art_encode_key(key, part_count,
+						  &it->key_len);
+		if (encoded != NULL) {
+			it->key = malloc(it->key_len);
+			if (it->key == NULL) {
+				diag_set(OutOfMemory, it->key_len,
+					 "malloc", "key");
+			} else {
+				memcpy(it->key, encoded, it->key_len);
+			}
+		}
+		region_truncate(region, region_svp);
+		if (it->key == NULL) {
+			mempool_free(&memtx->iterator_pool, it);
+			return NULL;
+		}
+	}
+	return (struct iterator *)it;
+}
+
+struct art_snapshot_iterator {
+	struct snapshot_iterator base;
+	/** The frozen tree. */
+	struct art_tree *tree;
+	/** Root of the tree at the time the snapshot was taken. */
+	struct art_node *root;
+	/** Leaf of the last returned tuple. */
+	struct art_leaf *last;
+	/** Buffer for data of compressed tuples. */
+	char *buf;
+	size_t buf_size;
+};
+
+/**
+ * Unfreeze the tree and free snapshot iterator.
+ * Virtual method of snapshot iterator.
+ * @sa index_vtab::create_snapshot_iterator.
+ */
+static void
+art_snapshot_iterator_free(struct snapshot_iterator *iterator)
+{
+	assert(iterator->free == art_snapshot_iterator_free);
+	struct art_snapshot_iterator *it =
+		(struct art_snapshot_iterator *) iterator;
+	struct art_tree *tree = it->tree;
+	assert(tree->snapshot_count > 0);
+	if (--tree->snapshot_count == 0)
+		art_collect_garbage(tree);
+	art_tree_unref(tree);
+	free(it->buf);
+	free(iterator);
+}
+
+/**
+ * Get next tuple from snapshot iterator.
+ * Virtual method of snapshot iterator.
+ * @sa index_vtab::create_snapshot_iterator.
+ */
+static const char *
+art_snapshot_iterator_next(struct snapshot_iterator *iterator,
+			   uint32_t *size)
+{
+	assert(iterator->free == art_snapshot_iterator_free);
+	struct art_snapshot_iterator *it =
+		(struct art_snapshot_iterator *) iterator;
+	if (it->root == NULL)
+		return NULL;
+	it->last = it->last == NULL ? art_minimum(it->root) :
+		   art_next(it->root, it->last);
+	if (it->last == NULL) {
+		it->root = NULL;
+		return NULL;
+	}
+	return tuple_data_range_to(it->last->tuple, &it->buf,
+				   &it->buf_size, size);
+}
+
+/**
+ * Create an ALL iterator with personal read view so further
+ * index modifications will not affect the iteration results.
+ * The tree is frozen until the iterator is freed: objects
+ * reachable from its current root are copied rather than
+ * modified in place. Must be destroyed by iterator->free after
+ * usage.
+ */
+static struct snapshot_iterator *
+memtx_art_index_create_snapshot_iterator(struct index *base)
+{
+	struct memtx_art_index *index = (struct memtx_art_index *)base;
+	struct art_tree *tree = index->tree;
+	struct art_snapshot_iterator *it = (struct art_snapshot_iterator *)
+		calloc(1, sizeof(*it));
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(struct art_snapshot_iterator),
+			 "memtx_art_index", "iterator");
+		return NULL;
+	}
+	it->base.next = art_snapshot_iterator_next;
+	it->base.free = art_snapshot_iterator_free;
+	it->tree = tree;
+	it->root = tree->root;
+	tree->refs++;
+	tree->snapshot_count++;
+	tree->version++;
+	return (struct snapshot_iterator *) it;
+}
+
+static const struct index_vtab memtx_art_index_vtab = {
+	/* .destroy = */ memtx_art_index_destroy,
+	/* .commit_create = */ generic_index_commit_create,
+	/* .abort_create = */ generic_index_abort_create,
+	/* .commit_modify = */ generic_index_commit_modify,
+	/* .commit_drop = */ generic_index_commit_drop,
+	/* .update_def = */ generic_index_update_def,
+	/* .depends_on_pk = */ memtx_art_index_depends_on_pk,
+	/* .def_change_requires_rebuild = */
+		memtx_index_def_change_requires_rebuild,
+	/* .size = */ memtx_art_index_size,
+	/* .bsize = */ memtx_art_index_bsize,
+	/* .min = */ generic_index_min,
+	/* .max = */ generic_index_max,
+	/* .random = */ memtx_art_index_random,
+	/* .count = */ memtx_art_index_count,
+	/* .get = */ memtx_art_index_get,
+	/* .get_many = */ memtx_art_index_get_many,
+	/* .replace = */ memtx_art_index_replace,
+	/* .create_iterator = */ memtx_art_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
+	/* .create_snapshot_iterator = */
+		memtx_art_index_create_snapshot_iterator,
+	/* .stat = */ generic_index_stat,
+	/* .compact = */ generic_index_compact,
+	/* .reset_stat = */ generic_index_reset_stat,
+	/* .begin_build = */ generic_index_begin_build,
+	/* .reserve = */ generic_index_reserve,
+	/* .build_next = */ generic_index_build_next,
+	/* .end_build = */ generic_index_end_build,
+};
+
+struct index *
+memtx_art_index_new(struct memtx_engine *memtx, struct index_def *def)
+{
+	struct memtx_art_index *index =
+		(struct memtx_art_index *)calloc(1, sizeof(*index));
+	if (index == NULL) {
+		diag_set(OutOfMemory, sizeof(*index),
+			 "malloc", "struct memtx_art_index");
+		return NULL;
+	}
+	index->tree = art_tree_new(memtx);
+	if (index->tree == NULL) {
+		free(index);
+		return NULL;
+	}
+	if (index_create(&index->base, (struct engine *)memtx,
+			 &memtx_art_index_vtab, def) != 0) {
+		art_tree_unref(index->tree);
+		free(index);
+		return NULL;
+	}
+	return &index->base;
+}
+
+/* }}} */
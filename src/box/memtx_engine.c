@@ -36,8 +36,12 @@
 #include <small/mempool.h>
 
 #include "fiber.h"
+#include "fiber_cond.h"
 #include "errinj.h"
 #include "coio_file.h"
+#include "coio_task.h"
+#include "cbus.h"
+#include "salad/stailq.h"
 #include "tuple.h"
 #include "txn.h"
 #include "memtx_tree.h"
@@ -113,7 +117,8 @@ memtx_init_txn(struct txn *txn)
 struct PACKED memtx_tuple {
 	/*
 	 * sic: the header of the tuple is used
-	 * to store a free list pointer in smfree_delayed.
+	 * to store a free list pointer in smfree_delayed
+	 * and in memtx_read_view::garbage.
 	 * Please don't change it without understanding
 	 * how smfree_delayed and snapshotting COW works.
 	 */
@@ -122,6 +127,22 @@ struct PACKED memtx_tuple {
 	struct tuple base;
 };
 
+struct memtx_read_view {
+	/** Link in memtx_engine::read_views. */
+	struct stailq_entry link;
+	/** Tuples with a lower version are seen by the view. */
+	uint32_t version;
+	/** Set when the view is closed. */
+	bool is_closed;
+	/**
+	 * Tuples deleted while this view was the newest one,
+	 * linked through memtx_tuple headers. Older views may
+	 * see them too, so they are freed when all views up
+	 * to this one are closed.
+	 */
+	struct memtx_tuple *garbage;
+};
+
 enum {
 	OBJSIZE_MIN = 16,
 	SLAB_SIZE = 16 * 1024 * 1024,
@@ -141,43 +162,190 @@ memtx_end_build_primary_key(struct space *space, void *param)
 	return 0;
 }
 
+/**
+ * Secondary index builds are batched so that the sorting
+ * of different indexes, of one space or of different spaces,
+ * can be done in parallel. To keep memory usage sane, a batch
+ * is flushed as soon as it accumulates this many tuples
+ * (a space is never split between batches though).
+ */
+enum { MEMTX_BUILD_BATCH_TUPLES = 64 * 1024 * 1024 };
+
+/** Secondary keys filled but not built yet. */
+struct memtx_build_batch {
+	struct memtx_engine *memtx;
+	/** Indexes to complete with index_end_build(). */
+	struct index **indexes;
+	uint32_t index_count;
+	uint32_t index_capacity;
+	/** Spaces owning @indexes, in order. */
+	struct space **spaces;
+	uint32_t space_count;
+	uint32_t space_capacity;
+	/** Sum of sizes of @spaces times their index count. */
+	size_t tuple_count;
+};
+
+static ssize_t
+memtx_sort_build_array_f(va_list ap)
+{
+	struct index *index = va_arg(ap, struct index *);
+	memtx_tree_index_sort_build_array(index);
+	return 0;
+}
+
+static int
+memtx_sort_build_array_fiber_f(va_list ap)
+{
+	struct index *index = va_arg(ap, struct index *);
+	/*
+	 * If the call fails, the array will be sorted by
+	 * index_end_build() in tx.
+	 */
+	if (coio_call(memtx_sort_build_array_f, index) != 0)
+		diag_clear(diag_get());
+	return 0;
+}
+
+void
+memtx_sort_build_arrays(struct index **indexes, uint32_t index_count)
+{
+	struct fiber **fibers = NULL;
+	if (index_count > 1)
+		fibers = calloc(index_count, sizeof(*fibers));
+	for (uint32_t i = 0; fibers != NULL && i < index_count; i++) {
+		struct index *index = indexes[i];
+		if (index->def->type != TREE)
+			continue;
+		fibers[i] = fiber_new("memtx.build",
+				      memtx_sort_build_array_fiber_f);
+		if (fibers[i] == NULL) {
+			diag_clear(diag_get());
+			continue;
+		}
+		fiber_set_joinable(fibers[i], true);
+		fiber_start(fibers[i], index);
+	}
+	for (uint32_t i = 0; fibers != NULL && i < index_count; i++) {
+		if (fibers[i] != NULL)
+			fiber_join(fibers[i]);
+	}
+	free(fibers);
+}
+
+/**
+ * Complete building of batched secondary keys. Build arrays
+ * of tree indexes are sorted in coio threads, all at once,
+ * then trees are constructed in tx.
+ */
+static void
+memtx_build_batch_flush(struct memtx_build_batch *batch)
+{
+	memtx_sort_build_arrays(batch->indexes, batch->index_count);
+	for (uint32_t i = 0; i < batch->index_count; i++)
+		index_end_build(batch->indexes[i]);
+	for (uint32_t i = 0; i < batch->space_count; i++) {
+		struct space *space = batch->spaces[i];
+		struct memtx_space *memtx_space = (struct memtx_space *)space;
+		if (index_size(space->index[0]) > 0)
+			say_info("Space '%s': done", space_name(space));
+		memtx_space->replace = memtx_space_replace_all_keys;
+	}
+	batch->index_count = 0;
+	batch->space_count = 0;
+	batch->tuple_count = 0;
+}
+
+/**
+ * Append an element to an array of pointers growing it
+ * as needed.
+ */
+static int
+memtx_build_batch_append(void ***array, uint32_t *count,
+			 uint32_t *capacity, void *elem)
+{
+	if (*count == *capacity) {
+		uint32_t new_capacity = MAX(*capacity * 2, 16);
+		size_t size = sizeof(**array) * new_capacity;
+		void **new_array = realloc(*array, size);
+		if (new_array == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "memtx build batch");
+			return -1;
+		}
+		*array = new_array;
+		*capacity = new_capacity;
+	}
+	(*array)[(*count)++] = elem;
+	return 0;
+}
+
 /**
  * Secondary indexes are built in bulk after all data is
- * recovered. This function enables secondary keys on a space.
+ * recovered. This function fills secondary keys of a space
+ * and adds them to a batch, which enables them once built.
  * Data dictionary spaces are an exception, they are fully
  * built right from the start.
  */
 static int
 memtx_build_secondary_keys(struct space *space, void *param)
 {
+	struct memtx_build_batch *batch = (struct memtx_build_batch *)param;
 	struct memtx_space *memtx_space = (struct memtx_space *)space;
-	if (space->engine != param || space_index(space, 0) == NULL ||
+	if (space->engine != (struct engine *)batch->memtx ||
+	    space_index(space, 0) == NULL ||
 	    memtx_space->replace == memtx_space_replace_all_keys)
 		return 0;
 
-	if (space->index_id_max > 0) {
-		struct index *pk = space->index[0];
-		ssize_t n_tuples = index_size(pk);
-		assert(n_tuples >= 0);
+	struct index *pk = space->index[0];
+	ssize_t n_tuples = index_size(pk);
+	assert(n_tuples >= 0);
+	size_t tuple_count = n_tuples * (space->index_count - 1);
+	if (batch->space_count > 0 &&
+	    batch->tuple_count + tuple_count > MEMTX_BUILD_BATCH_TUPLES)
+		memtx_build_batch_flush(batch);
+
+	if (memtx_build_batch_append((void ***)&batch->spaces,
+				     &batch->space_count,
+				     &batch->space_capacity, space) != 0)
+		return -1;
+	batch->tuple_count += tuple_count;
 
+	if (space->index_id_max > 0) {
 		if (n_tuples > 0) {
 			say_info("Building secondary indexes in space '%s'...",
 				 space_name(space));
 		}
 
 		for (uint32_t j = 1; j < space->index_count; j++) {
-			if (index_build(space->index[j], pk) < 0)
+			struct index *index = space->index[j];
+			if (memtx_build_batch_append((void ***)&batch->indexes,
+						     &batch->index_count,
+						     &batch->index_capacity,
+						     index) != 0)
+				return -1;
+			if (index_build_fill(index, pk) < 0)
 				return -1;
-		}
-
-		if (n_tuples > 0) {
-			say_info("Space '%s': done", space_name(space));
 		}
 	}
-	memtx_space->replace = memtx_space_replace_all_keys;
 	return 0;
 }
 
+/** Build secondary keys of all memtx spaces. */
+static int
+memtx_build_all_secondary_keys(struct memtx_engine *memtx)
+{
+	struct memtx_build_batch batch;
+	memset(&batch, 0, sizeof(batch));
+	batch.memtx = memtx;
+	int rc = space_foreach(memtx_build_secondary_keys, &batch);
+	if (rc == 0)
+		memtx_build_batch_flush(&batch);
+	free(batch.indexes);
+	free(batch.spaces);
+	return rc;
+}
+
 static void
 memtx_engine_shutdown(struct engine *engine)
 {
@@ -189,6 +357,8 @@ memtx_engine_shutdown(struct engine *engine)
 		mempool_destroy(&memtx->rtree_iterator_pool);
 	mempool_destroy(&memtx->index_extent_pool);
 	slab_cache_destroy(&memtx->index_slab_cache);
+	if (memtx->zctx != NULL)
+		ZSTD_freeCCtx(memtx->zctx);
 	small_alloc_destroy(&memtx->alloc);
 	slab_cache_destroy(&memtx->slab_cache);
 	tuple_arena_destroy(&memtx->arena);
@@ -200,53 +370,420 @@ static int
 memtx_engine_recover_snapshot_row(struct memtx_engine *memtx,
 				  struct xrow_header *row);
 
-int
-memtx_engine_recover_snapshot(struct memtx_engine *memtx,
-			      const struct vclock *vclock)
-{
-	/* Process existing snapshot */
-	say_info("recovery start");
-	int64_t signature = vclock_sum(vclock);
-	const char *filename = xdir_format_filename(&memtx->snap_dir,
-						    signature, NONE);
+/**
+ * Snapshot files are read by dedicated threads, one per file,
+ * which decompress and decode xlog transactions into batches
+ * of rows while tx inserts rows of previously read batches.
+ */
+enum {
+	/** Approximate size of a batch of snapshot rows. */
+	MEMTX_RECOVERY_BATCH_SIZE = 1024 * 1024,
+	/** Number of batches a reader thread may fill ahead. */
+	MEMTX_RECOVERY_BATCH_COUNT = 2,
+};
+
+struct memtx_recovery_reader;
+
+/** A batch of rows decoded by a snapshot reader thread. */
+struct memtx_recovery_batch {
+	/** Cbus message used to request the batch. */
+	struct cbus_call_msg base;
+	/** The reader the batch belongs to. */
+	struct memtx_recovery_reader *reader;
+	/** Decoded rows, bodies point to @data. */
+	struct xrow_header *rows;
+	uint32_t row_count;
+	uint32_t row_capacity;
+	/** Row bodies. */
+	char *data;
+	size_t data_size;
+	size_t data_capacity;
+	/** Set if this is the last batch of the file. */
+	bool is_last;
+	/** Link in memtx_recovery::ready or reader free list. */
+	struct stailq_entry in_queue;
+};
 
-	say_info("recovering from `%s'", filename);
+/** State shared by readers of snapshot files. */
+struct memtx_recovery {
+	/** Batches read, but not applied yet. */
+	struct stailq ready;
+	/** Signaled when a batch is read or returned. */
+	struct fiber_cond cond;
+	/** Set to make readers stop reading ahead. */
+	bool is_stopped;
+	bool force_recovery;
+};
+
+/** A thread reading a snapshot file. */
+struct memtx_recovery_reader {
+	struct memtx_recovery *recovery;
+	/** The thread that decodes the file. */
+	struct cord cord;
+	/** Pipe from tx to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	/** Tx fiber requesting batches from the thread. */
+	struct fiber *fetcher;
+	/** Set when the fetcher is done with the file. */
+	bool is_done;
+	/** Error that stopped the fetcher, if any. */
+	struct diag diag;
+	/** File cursor, only accessed by the reader thread. */
 	struct xlog_cursor cursor;
-	if (xlog_cursor_open(&cursor, filename) < 0)
-		return -1;
+	bool cursor_is_open;
+	/** Set if the file ends with an EOF marker. */
+	bool is_eof;
+	/** Number of shards, read from the file header. */
+	uint32_t shard_count;
+	char filename[PATH_MAX];
+	/** Batches available for reading. */
+	struct stailq free;
+	struct memtx_recovery_batch batches[MEMTX_RECOVERY_BATCH_COUNT];
+};
 
-	int rc;
+/** Append a row to a batch, copying its body. */
+static int
+memtx_recovery_batch_add(struct memtx_recovery_batch *batch,
+			 struct xrow_header *row)
+{
+	assert(row->bodycnt <= 1);
+	size_t len = row->bodycnt > 0 ? row->body[0].iov_len : 0;
+	if (batch->row_count == batch->row_capacity) {
+		uint32_t capacity = MAX(batch->row_capacity * 2, 1024);
+		size_t size = capacity * sizeof(*batch->rows);
+		struct xrow_header *rows = realloc(batch->rows, size);
+		if (rows == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "rows");
+			return -1;
+		}
+		batch->rows = rows;
+		batch->row_capacity = capacity;
+	}
+	if (batch->data_size + len > batch->data_capacity) {
+		size_t capacity = MAX(batch->data_capacity * 2,
+				      batch->data_size + len);
+		capacity = MAX(capacity, MEMTX_RECOVERY_BATCH_SIZE);
+		char *data = realloc(batch->data, capacity);
+		if (data == NULL) {
+			diag_set(OutOfMemory, capacity, "realloc", "data");
+			return -1;
+		}
+		batch->data = data;
+		batch->data_capacity = capacity;
+	}
+	struct xrow_header *copy = &batch->rows[batch->row_count++];
+	*copy = *row;
+	if (len > 0) {
+		memcpy(batch->data + batch->data_size,
+		       row->body[0].iov_base, len);
+		/* Bodies are relocated once the batch is complete. */
+		copy->body[0].iov_base = (void *)(uintptr_t)batch->data_size;
+		batch->data_size += len;
+	}
+	return 0;
+}
+
+/** Fill a batch with rows. Called in the reader thread. */
+static int
+memtx_recovery_read_batch(struct cbus_call_msg *base)
+{
+	struct memtx_recovery_batch *batch =
+		(struct memtx_recovery_batch *)base;
+	struct memtx_recovery_reader *reader = batch->reader;
+	batch->row_count = 0;
+	batch->data_size = 0;
+	batch->is_last = false;
+	if (!reader->cursor_is_open) {
+		if (xlog_cursor_open(&reader->cursor, reader->filename) < 0)
+			return -1;
+		reader->cursor_is_open = true;
+		reader->shard_count = MAX(reader->cursor.meta.shard_count, 1);
+	}
+	int rc = 0;
 	struct xrow_header row;
-	uint64_t row_count = 0;
-	while ((rc = xlog_cursor_next(&cursor, &row,
-				      memtx->force_recovery)) == 0) {
-		row.lsn = signature;
-		rc = memtx_engine_recover_snapshot_row(memtx, &row);
-		if (rc < 0) {
-			if (!memtx->force_recovery)
+	while (batch->data_size < MEMTX_RECOVERY_BATCH_SIZE &&
+	       (rc = xlog_cursor_next(&reader->cursor, &row,
+				reader->recovery->force_recovery)) == 0) {
+		if (memtx_recovery_batch_add(batch, &row) != 0)
+			return -1;
+	}
+	if (batch->data_size < MEMTX_RECOVERY_BATCH_SIZE) {
+		if (rc < 0)
+			return -1;
+		reader->is_eof = xlog_cursor_is_eof(&reader->cursor);
+		xlog_cursor_close(&reader->cursor, false);
+		reader->cursor_is_open = false;
+		batch->is_last = true;
+	}
+	for (uint32_t i = 0; i < batch->row_count; i++) {
+		struct xrow_header *r = &batch->rows[i];
+		if (r->bodycnt > 0)
+			r->body[0].iov_base = batch->data +
+				(uintptr_t)r->body[0].iov_base;
+	}
+	return 0;
+}
+
+/** Reader thread function. */
+static int
+memtx_recovery_reader_f(va_list ap)
+{
+	struct memtx_recovery_reader *reader =
+		va_arg(ap, struct memtx_recovery_reader *);
+	struct cbus_endpoint endpoint;
+
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	cbus_endpoint_create(&endpoint, cord_name(cord()),
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&reader->tx_pipe);
+	if (reader->cursor_is_open)
+		xlog_cursor_close(&reader->cursor, false);
+	return 0;
+}
+
+/**
+ * Tx fiber requesting batches from a reader thread as long as
+ * there are free batches, so that the thread reads ahead.
+ */
+static int
+memtx_recovery_fetch_f(va_list ap)
+{
+	struct memtx_recovery_reader *reader =
+		va_arg(ap, struct memtx_recovery_reader *);
+	struct memtx_recovery *recovery = reader->recovery;
+	while (!recovery->is_stopped) {
+		if (stailq_empty(&reader->free)) {
+			fiber_cond_wait(&recovery->cond);
+			continue;
+		}
+		struct memtx_recovery_batch *batch =
+			stailq_shift_entry(&reader->free,
+					   struct memtx_recovery_batch,
+					   in_queue);
+		if (cbus_call(&reader->reader_pipe, &reader->tx_pipe,
+			      &batch->base, memtx_recovery_read_batch,
+			      NULL, TIMEOUT_INFINITY) != 0) {
+			diag_move(diag_get(), &reader->diag);
+			break;
+		}
+		stailq_add_tail_entry(&recovery->ready, batch, in_queue);
+		fiber_cond_broadcast(&recovery->cond);
+		if (batch->is_last)
+			break;
+	}
+	reader->is_done = true;
+	fiber_cond_broadcast(&recovery->cond);
+	return 0;
+}
+
+static int
+memtx_recovery_reader_start(struct memtx_recovery_reader *reader,
+			    struct memtx_recovery *recovery,
+			    const char *filename, uint32_t id)
+{
+	memset(reader, 0, sizeof(*reader));
+	reader->recovery = recovery;
+	diag_create(&reader->diag);
+	snprintf(reader->filename, sizeof(reader->filename), "%s", filename);
+	stailq_create(&reader->free);
+	for (int i = 0; i < MEMTX_RECOVERY_BATCH_COUNT; i++) {
+		struct memtx_recovery_batch *batch = &reader->batches[i];
+		batch->reader = reader;
+		stailq_add_tail_entry(&reader->free, batch, in_queue);
+	}
+	char name[FIBER_NAME_MAX];
+	snprintf(name, sizeof(name), "snapshot.reader.%u", id);
+	if (cord_costart(&reader->cord, name, memtx_recovery_reader_f,
+			 reader) != 0)
+		return -1;
+	cpipe_create(&reader->reader_pipe, name);
+	reader->fetcher = fiber_new(name, memtx_recovery_fetch_f);
+	if (reader->fetcher == NULL) {
+		cbus_stop_loop(&reader->reader_pipe);
+		cpipe_destroy(&reader->reader_pipe);
+		cord_cojoin(&reader->cord);
+		return -1;
+	}
+	fiber_set_joinable(reader->fetcher, true);
+	fiber_start(reader->fetcher, reader);
+	return 0;
+}
+
+/**
+ * Wait for the fetcher of a reader to complete, then stop
+ * the reader thread and free the batches.
+ */
+static void
+memtx_recovery_reader_stop(struct memtx_recovery_reader *reader)
+{
+	fiber_join(reader->fetcher);
+	cbus_stop_loop(&reader->reader_pipe);
+	cpipe_destroy(&reader->reader_pipe);
+	if (cord_cojoin(&reader->cord) != 0)
+		diag_log();
+	for (int i = 0; i < MEMTX_RECOVERY_BATCH_COUNT; i++) {
+		free(reader->batches[i].rows);
+		free(reader->batches[i].data);
+	}
+	diag_destroy(&reader->diag);
+}
+
+/**
+ * Apply rows read by the given readers in the order batches
+ * become ready, until all files are read.
+ */
+static int
+memtx_recovery_apply(struct memtx_engine *memtx,
+		     struct memtx_recovery *recovery,
+		     struct memtx_recovery_reader *readers,
+		     uint32_t reader_count, int64_t signature,
+		     uint64_t *row_count)
+{
+	while (true) {
+		if (stailq_empty(&recovery->ready)) {
+			uint32_t i;
+			for (i = 0; i < reader_count; i++) {
+				if (!readers[i].is_done)
+					break;
+			}
+			if (i == reader_count)
 				break;
-			say_error("can't apply row: ");
-			diag_log();
+			fiber_cond_wait(&recovery->cond);
+			continue;
 		}
-		++row_count;
-		if (row_count % 100000 == 0) {
-			say_info("%.1fM rows processed",
-				 row_count / 1000000.);
-			fiber_yield_timeout(0);
+		struct memtx_recovery_batch *batch =
+			stailq_shift_entry(&recovery->ready,
+					   struct memtx_recovery_batch,
+					   in_queue);
+		for (uint32_t i = 0; i < batch->row_count; i++) {
+			struct xrow_header *row = &batch->rows[i];
+			row->lsn = signature;
+			if (memtx_engine_recover_snapshot_row(memtx,
+							      row) != 0) {
+				if (!memtx->force_recovery)
+					return -1;
+				say_error("can't apply row: ");
+				diag_log();
+			}
+			++*row_count;
+			if (*row_count % 100000 == 0) {
+				say_info("%.1fM rows processed",
+					 *row_count / 1000000.);
+				fiber_yield_timeout(0);
+			}
 		}
+		stailq_add_tail_entry(&batch->reader->free, batch, in_queue);
+		fiber_cond_broadcast(&recovery->cond);
 	}
-	xlog_cursor_close(&cursor, false);
-	if (rc < 0)
+	for (uint32_t i = 0; i < reader_count; i++) {
+		struct memtx_recovery_reader *reader = &readers[i];
+		if (!diag_is_empty(&reader->diag)) {
+			diag_move(&reader->diag, diag_get());
+			return -1;
+		}
+		/**
+		 * We should never try to read snapshots with no EOF
+		 * marker - such snapshots are very likely corrupted and
+		 * should not be trusted.
+		 */
+		if (!reader->is_eof)
+			panic("snapshot `%s' has no EOF marker",
+			      reader->filename);
+	}
+	return 0;
+}
+
+/**
+ * Recover snapshot files [@first, @last), one reader thread
+ * per file. Shard 0 is the main snapshot file.
+ */
+static int
+memtx_engine_recover_snapshot_files(struct memtx_engine *memtx,
+				    int64_t signature, uint32_t first,
+				    uint32_t last, uint64_t *row_count,
+				    uint32_t *shard_count)
+{
+	struct memtx_recovery recovery;
+	stailq_create(&recovery.ready);
+	fiber_cond_create(&recovery.cond);
+	recovery.is_stopped = false;
+	recovery.force_recovery = memtx->force_recovery;
+
+	uint32_t count = last - first;
+	size_t size = count * sizeof(struct memtx_recovery_reader);
+	struct memtx_recovery_reader *readers = malloc(size);
+	if (readers == NULL) {
+		diag_set(OutOfMemory, size, "malloc",
+			 "struct memtx_recovery_reader");
 		return -1;
+	}
+	int rc = 0;
+	uint32_t started;
+	for (started = 0; started < count; started++) {
+		const char *filename =
+			xdir_format_shard_filename(&memtx->snap_dir, signature,
+						   first + started, NONE);
+		say_info("recovering from `%s'", filename);
+		if (memtx_recovery_reader_start(&readers[started], &recovery,
+						filename, first + started) != 0) {
+			rc = -1;
+			break;
+		}
+	}
+	if (rc == 0) {
+		rc = memtx_recovery_apply(memtx, &recovery, readers, count,
+					  signature, row_count);
+	}
+	recovery.is_stopped = true;
+	fiber_cond_broadcast(&recovery.cond);
+	for (uint32_t i = 0; i < started; i++) {
+		struct memtx_recovery_reader *reader = &readers[i];
+		memtx_recovery_reader_stop(reader);
+		if (rc != 0)
+			continue;
+		if (first == 0 && i == 0)
+			*shard_count = reader->shard_count;
+		if (reader->shard_count != *shard_count) {
+			diag_set(XlogError, "snapshot shard `%s' belongs to "
+				 "a snapshot of %u shards, expected %u",
+				 reader->filename,
+				 (unsigned)reader->shard_count,
+				 (unsigned)*shard_count);
+			rc = -1;
+		}
+	}
+	free(readers);
+	fiber_cond_destroy(&recovery.cond);
+	return rc;
+}
 
-	/**
-	 * We should never try to read snapshots with no EOF
-	 * marker - such snapshots are very likely corrupted and
-	 * should not be trusted.
+int
+memtx_engine_recover_snapshot(struct memtx_engine *memtx,
+			      const struct vclock *vclock)
+{
+	/* Process existing snapshot */
+	say_info("recovery start");
+	int64_t signature = vclock_sum(vclock);
+	uint64_t row_count = 0;
+	uint32_t shard_count;
+	/*
+	 * The main file holds the system spaces and goes first,
+	 * so the schema is in place by the time user data stored
+	 * in other shards is loaded. The shards are then read
+	 * in parallel.
 	 */
-	if (!xlog_cursor_is_eof(&cursor))
-		panic("snapshot `%s' has no EOF marker", filename);
-
+	if (memtx_engine_recover_snapshot_files(memtx, signature, 0, 1,
+						&row_count, &shard_count) != 0)
+		return -1;
+	if (shard_count > 1 &&
+	    memtx_engine_recover_snapshot_files(memtx, signature, 1,
+						shard_count, &row_count,
+						&shard_count) != 0)
+		return -1;
 	return 0;
 }
 
@@ -333,7 +870,7 @@ memtx_engine_begin_final_recovery(struct engine *engine)
 		 * unique keys.
 		 */
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_build_all_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	return 0;
@@ -352,7 +889,7 @@ memtx_engine_end_recovery(struct engine *engine)
 	if (memtx->state != MEMTX_OK) {
 		assert(memtx->state == MEMTX_FINAL_RECOVERY);
 		memtx->state = MEMTX_OK;
-		if (space_foreach(memtx_build_secondary_keys, memtx) != 0)
+		if (memtx_build_all_secondary_keys(memtx) != 0)
 			return -1;
 	}
 	xdir_collect_inprogress(&memtx->snap_dir);
@@ -500,13 +1037,6 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 	if (errinj != NULL && errinj->dparam > 0)
 		usleep(errinj->dparam * 1000000);
 
-	static ev_tstamp last = 0;
-	if (last == 0) {
-		ev_now_update(loop());
-		last = ev_now(loop());
-	}
-
-	row->tm = last;
 	row->replica_id = 0;
 	/**
 	 * Rows in snapshot are numbered from 1 to %rows.
@@ -531,7 +1061,7 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row)
 
 static int
 checkpoint_write_tuple(struct xlog *l, struct space *space,
-		       const char *data, uint32_t size)
+		       const char *data, uint32_t size, double tm)
 {
 	struct request_replace_body body;
 	body.m_body = 0x82; /* map of two elements. */
@@ -544,6 +1074,7 @@ checkpoint_write_tuple(struct xlog *l, struct space *space,
 	memset(&row, 0, sizeof(struct xrow_header));
 	row.type = IPROTO_INSERT;
 	row.group_id = space_group_id(space);
+	row.tm = tm;
 
 	row.bodycnt = 2;
 	row.body[0].iov_base = &body;
@@ -556,19 +1087,48 @@ checkpoint_write_tuple(struct xlog *l, struct space *space,
 struct checkpoint_entry {
 	struct space *space;
 	struct snapshot_iterator *iterator;
+	/** Space size estimate, used to balance shards. */
+	size_t bsize;
 	struct rlist link;
 };
 
+/**
+ * A part of a checkpoint written by its own thread to its
+ * own file. Shard 0 is the snapshot file proper and always
+ * holds system spaces so that the schema is recovered before
+ * any user data stored in other shards.
+ */
+struct checkpoint_shard {
+	/** The checkpoint this shard belongs to. */
+	struct checkpoint *ckpt;
+	/** Shard number, @sa xdir_format_shard_filename(). */
+	uint32_t id;
+	/** Spaces to write to this shard. */
+	struct rlist entries;
+	/** Sum of sizes of spaces assigned to this shard. */
+	size_t bsize;
+	/** The thread writing this shard. */
+	struct cord cord;
+	/** True while the shard thread is running. */
+	bool is_running;
+};
+
 struct checkpoint {
 	/**
 	 * List of MemTX spaces to snapshot, with consistent
-	 * read view iterators.
+	 * read view iterators. Entries are distributed among
+	 * shards by checkpoint_assign_shards().
 	 */
 	struct rlist entries;
-	struct cord cord;
+	/** Shards of the checkpoint, at least one. */
+	struct checkpoint_shard *shards;
+	/** Number of shards, 1 for a plain snapshot file. */
+	uint32_t shard_count;
 	bool waiting_for_snap_thread;
 	/** The vclock of the snapshot file. */
 	struct vclock vclock;
+	/** Timestamp of snapshot rows. */
+	double tm;
 	struct xdir dir;
 	/**
 	 * Do nothing, just touch the snapshot file - the
@@ -578,7 +1138,8 @@ struct checkpoint {
 };
 
 static struct checkpoint *
-checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
+checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit,
+	       int compression_level)
 {
 	struct checkpoint *ckpt = malloc(sizeof(*ckpt));
 	if (ckpt == NULL) {
@@ -587,25 +1148,39 @@ checkpoint_new(const char *snap_dirname, uint64_t snap_io_rate_limit)
 		return NULL;
 	}
 	rlist_create(&ckpt->entries);
+	ckpt->shards = NULL;
+	ckpt->shard_count = 0;
 	ckpt->waiting_for_snap_thread = false;
 	struct xlog_opts opts = xlog_opts_default;
 	opts.rate_limit = snap_io_rate_limit;
+	opts.compression_level = compression_level;
 	opts.sync_interval = SNAP_SYNC_INTERVAL;
 	opts.free_cache = true;
 	xdir_create(&ckpt->dir, snap_dirname, SNAP, &INSTANCE_UUID, &opts);
 	vclock_create(&ckpt->vclock);
+	ev_now_update(loop());
+	ckpt->tm = ev_now(loop());
 	ckpt->touch = false;
 	return ckpt;
 }
 
 static void
-checkpoint_delete(struct checkpoint *ckpt)
+checkpoint_free_entries(struct rlist *entries)
 {
 	struct checkpoint_entry *entry, *tmp;
-	rlist_foreach_entry_safe(entry, &ckpt->entries, link, tmp) {
+	rlist_foreach_entry_safe(entry, entries, link, tmp) {
 		entry->iterator->free(entry->iterator);
 		free(entry);
 	}
+}
+
+static void
+checkpoint_delete(struct checkpoint *ckpt)
+{
+	checkpoint_free_entries(&ckpt->entries);
+	for (uint32_t i = 0; i < ckpt->shard_count; i++)
+		checkpoint_free_entries(&ckpt->shards[i].entries);
+	free(ckpt->shards);
 	xdir_destroy(&ckpt->dir);
 	free(ckpt);
 }
@@ -614,13 +1189,18 @@ static void
 checkpoint_cancel(struct checkpoint *ckpt)
 {
 	/*
-	 * Cancel the checkpoint thread if it's running and wait
-	 * for it to terminate so as to eliminate the possibility
-	 * of use-after-free.
+	 * Cancel the checkpoint threads if they're running and
+	 * wait for them to terminate so as to eliminate the
+	 * possibility of use-after-free.
 	 */
 	if (ckpt->waiting_for_snap_thread) {
-		tt_pthread_cancel(ckpt->cord.id);
-		tt_pthread_join(ckpt->cord.id, NULL);
+		for (uint32_t i = 0; i < ckpt->shard_count; i++) {
+			struct checkpoint_shard *shard = &ckpt->shards[i];
+			if (!shard->is_running)
+				continue;
+			tt_pthread_cancel(shard->cord.id);
+			tt_pthread_join(shard->cord.id, NULL);
+		}
 	}
 	checkpoint_delete(ckpt);
 }
@@ -645,6 +1225,7 @@ checkpoint_add_space(struct space *sp, void *data)
 	rlist_add_tail_entry(&ckpt->entries, entry, link);
 
 	entry->space = sp;
+	entry->bsize = space_bsize(sp);
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL)
 		return -1;
@@ -652,12 +1233,95 @@ checkpoint_add_space(struct space *sp, void *data)
 	return 0;
 };
 
+static int
+checkpoint_entry_cmp_bsize(const void *a, const void *b)
+{
+	const struct checkpoint_entry *e1 =
+		*(const struct checkpoint_entry **)a;
+	const struct checkpoint_entry *e2 =
+		*(const struct checkpoint_entry **)b;
+	/* Biggest first. */
+	return e1->bsize < e2->bsize ? 1 : e1->bsize > e2->bsize ? -1 : 0;
+}
+
+/**
+ * Distribute checkpoint entries among at most @max_shards
+ * shards. System spaces always go to shard 0, in the order
+ * they were added. User spaces are spread greedily, biggest
+ * first, each to the least loaded shard.
+ */
+static int
+checkpoint_assign_shards(struct checkpoint *ckpt, uint32_t max_shards)
+{
+	assert(ckpt->shards == NULL);
+	uint32_t user_count = 0;
+	struct checkpoint_entry *entry, *tmp;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (space_id(entry->space) > BOX_SYSTEM_ID_MAX)
+			user_count++;
+	}
+	assert(max_shards > 0);
+	uint32_t shard_count = MIN(max_shards, user_count + 1);
+
+	size_t size = sizeof(*ckpt->shards) * shard_count;
+	ckpt->shards = calloc(1, size);
+	if (ckpt->shards == NULL) {
+		diag_set(OutOfMemory, size, "calloc",
+			 "struct checkpoint_shard");
+		return -1;
+	}
+	ckpt->shard_count = shard_count;
+	for (uint32_t i = 0; i < shard_count; i++) {
+		struct checkpoint_shard *shard = &ckpt->shards[i];
+		shard->ckpt = ckpt;
+		shard->id = i;
+		rlist_create(&shard->entries);
+	}
+	if (shard_count == 1) {
+		rlist_splice_tail(&ckpt->shards[0].entries, &ckpt->entries);
+		return 0;
+	}
+
+	size = sizeof(entry) * user_count;
+	struct checkpoint_entry **user = malloc(size);
+	if (user == NULL) {
+		diag_set(OutOfMemory, size, "malloc", "checkpoint entries");
+		return -1;
+	}
+	uint32_t i = 0;
+	rlist_foreach_entry_safe(entry, &ckpt->entries, link, tmp) {
+		rlist_del_entry(entry, link);
+		if (space_id(entry->space) > BOX_SYSTEM_ID_MAX) {
+			user[i++] = entry;
+		} else {
+			rlist_add_tail_entry(&ckpt->shards[0].entries,
+					     entry, link);
+			ckpt->shards[0].bsize += entry->bsize;
+		}
+	}
+	assert(i == user_count);
+	qsort(user, user_count, sizeof(*user), checkpoint_entry_cmp_bsize);
+	for (i = 0; i < user_count; i++) {
+		struct checkpoint_shard *min = &ckpt->shards[0];
+		for (uint32_t j = 1; j < shard_count; j++) {
+			if (ckpt->shards[j].bsize < min->bsize)
+				min = &ckpt->shards[j];
+		}
+		rlist_add_tail_entry(&min->entries, user[i], link);
+		min->bsize += user[i]->bsize;
+	}
+	free(user);
+	return 0;
+}
+
 static int
 checkpoint_f(va_list ap)
 {
-	struct checkpoint *ckpt = va_arg(ap, struct checkpoint *);
+	struct checkpoint_shard *shard = va_arg(ap, struct checkpoint_shard *);
+	struct checkpoint *ckpt = shard->ckpt;
 
 	if (ckpt->touch) {
+		assert(shard->id == 0);
 		if (xdir_touch_xlog(&ckpt->dir, &ckpt->vclock) == 0)
 			return 0;
 		/*
@@ -668,19 +1332,26 @@ checkpoint_f(va_list ap)
 	}
 
 	struct xlog snap;
-	if (xdir_create_xlog(&ckpt->dir, &snap, &ckpt->vclock) != 0)
+	int rc;
+	if (ckpt->shard_count == 1) {
+		rc = xdir_create_xlog(&ckpt->dir, &snap, &ckpt->vclock);
+	} else {
+		rc = xdir_create_xlog_shard(&ckpt->dir, &snap, &ckpt->vclock,
+					    shard->id, ckpt->shard_count);
+	}
+	if (rc != 0)
 		return -1;
 
 	say_info("saving snapshot `%s'", snap.filename);
 	struct checkpoint_entry *entry;
-	rlist_foreach_entry(entry, &ckpt->entries, link) {
+	rlist_foreach_entry(entry, &shard->entries, link) {
 		uint32_t size;
 		const char *data;
 		struct snapshot_iterator *it = entry->iterator;
 		for (data = it->next(it, &size); data != NULL;
 		     data = it->next(it, &size)) {
 			if (checkpoint_write_tuple(&snap, entry->space,
-					data, size) != 0) {
+					data, size, ckpt->tm) != 0) {
 				xlog_close(&snap, false);
 				return -1;
 			}
@@ -695,6 +1366,44 @@ checkpoint_f(va_list ap)
 	return 0;
 }
 
+/**
+ * Start threads writing shards [@first, @last) and wait for
+ * all of them to complete.
+ */
+static int
+checkpoint_run_shards(struct checkpoint *ckpt, uint32_t first, uint32_t last)
+{
+	int rc = 0;
+	uint32_t i;
+	ckpt->waiting_for_snap_thread = true;
+	for (i = first; i < last; i++) {
+		struct checkpoint_shard *shard = &ckpt->shards[i];
+		char name[FIBER_NAME_MAX];
+		if (i == 0)
+			snprintf(name, sizeof(name), "snapshot");
+		else
+			snprintf(name, sizeof(name), "snapshot.%u", i);
+		if (cord_costart(&shard->cord, name, checkpoint_f,
+				 shard) != 0) {
+			rc = -1;
+			break;
+		}
+		shard->is_running = true;
+	}
+	last = i;
+	for (i = first; i < last; i++) {
+		struct checkpoint_shard *shard = &ckpt->shards[i];
+		/* wait for memtx-part snapshot completion */
+		if (cord_cojoin(&shard->cord) != 0) {
+			diag_log();
+			rc = -1;
+		}
+		shard->is_running = false;
+	}
+	ckpt->waiting_for_snap_thread = false;
+	return rc;
+}
+
 static int
 memtx_engine_begin_checkpoint(struct engine *engine)
 {
@@ -702,19 +1411,23 @@ memtx_engine_begin_checkpoint(struct engine *engine)
 
 	assert(memtx->checkpoint == NULL);
 	memtx->checkpoint = checkpoint_new(memtx->snap_dir.dirname,
-					   memtx->snap_io_rate_limit);
+					   memtx->snap_io_rate_limit,
+					   memtx->compression_level);
 	if (memtx->checkpoint == NULL)
 		return -1;
 
-	if (space_foreach(checkpoint_add_space, memtx->checkpoint) != 0) {
+	if (space_foreach(checkpoint_add_space, memtx->checkpoint) != 0 ||
+	    checkpoint_assign_shards(memtx->checkpoint,
+				     memtx->checkpoint_threads) != 0) {
 		checkpoint_delete(memtx->checkpoint);
 		memtx->checkpoint = NULL;
 		return -1;
 	}
+	/* Shards share the disk bandwidth. */
+	memtx->checkpoint->dir.opts.rate_limit /=
+		memtx->checkpoint->shard_count;
 
-	/* increment snapshot version; set tuple deletion to delayed mode */
-	memtx->snapshot_version++;
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, true);
+	memtx_engine_enter_delayed_free_mode(memtx);
 	return 0;
 }
 
@@ -723,31 +1436,29 @@ memtx_engine_wait_checkpoint(struct engine *engine,
 			     const struct vclock *vclock)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	struct checkpoint *ckpt = memtx->checkpoint;
 
-	assert(memtx->checkpoint != NULL);
+	assert(ckpt != NULL);
 	/*
 	 * If a snapshot already exists, do not create a new one.
 	 */
 	struct vclock last;
 	if (xdir_last_vclock(&memtx->snap_dir, &last) >= 0 &&
 	    vclock_compare(&last, vclock) == 0) {
-		memtx->checkpoint->touch = true;
+		ckpt->touch = true;
 	}
-	vclock_copy(&memtx->checkpoint->vclock, vclock);
+	vclock_copy(&ckpt->vclock, vclock);
 
-	if (cord_costart(&memtx->checkpoint->cord, "snapshot",
-			 checkpoint_f, memtx->checkpoint)) {
-		return -1;
+	uint32_t first = 0;
+	if (ckpt->touch) {
+		if (checkpoint_run_shards(ckpt, 0, 1) != 0)
+			return -1;
+		if (ckpt->touch)
+			return 0;
+		/* Touch failed, shard 0 has been written anew. */
+		first = 1;
 	}
-	memtx->checkpoint->waiting_for_snap_thread = true;
-
-	/* wait for memtx-part snapshot completion */
-	int result = cord_cojoin(&memtx->checkpoint->cord);
-	if (result != 0)
-		diag_log();
-
-	memtx->checkpoint->waiting_for_snap_thread = false;
-	return result;
+	return checkpoint_run_shards(ckpt, first, ckpt->shard_count);
 }
 
 static void
@@ -762,16 +1473,11 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 	/* waitCheckpoint() must have been done. */
 	assert(!memtx->checkpoint->waiting_for_snap_thread);
 
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+	memtx_engine_leave_delayed_free_mode(memtx);
 
 	if (!memtx->checkpoint->touch) {
 		int64_t lsn = vclock_sum(&memtx->checkpoint->vclock);
 		struct xdir *dir = &memtx->checkpoint->dir;
-		/* rename snapshot on completion */
-		char to[PATH_MAX];
-		snprintf(to, sizeof(to), "%s",
-			 xdir_format_filename(dir, lsn, NONE));
-		const char *from = xdir_format_filename(dir, lsn, INPROGRESS);
 #ifndef NDEBUG
 		struct errinj *delay = errinj(ERRINJ_SNAP_COMMIT_DELAY,
 					       ERRINJ_BOOL);
@@ -780,9 +1486,24 @@ memtx_engine_commit_checkpoint(struct engine *engine,
 				fiber_sleep(0.001);
 		}
 #endif
-		int rc = coio_rename(from, to);
-		if (rc != 0)
-			panic("can't rename .snap.inprogress");
+		/*
+		 * Rename snapshot on completion. The main file
+		 * goes last so that it only appears when all
+		 * its shards are in place.
+		 */
+		uint32_t i = memtx->checkpoint->shard_count;
+		while (i-- > 0) {
+			char to[PATH_MAX];
+			snprintf(to, sizeof(to), "%s",
+				 xdir_format_shard_filename(dir, lsn, i,
+							    NONE));
+			const char *from =
+				xdir_format_shard_filename(dir, lsn, i,
+							   INPROGRESS);
+			int rc = coio_rename(from, to);
+			if (rc != 0)
+				panic("can't rename .snap.inprogress");
+		}
 	}
 
 	struct vclock last;
@@ -800,27 +1521,36 @@ static void
 memtx_engine_abort_checkpoint(struct engine *engine)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	struct checkpoint *ckpt = memtx->checkpoint;
 
 	/**
 	 * An error in the other engine's first phase.
 	 */
-	if (memtx->checkpoint->waiting_for_snap_thread) {
+	if (ckpt->waiting_for_snap_thread) {
 		/* wait for memtx-part snapshot completion */
-		if (cord_cojoin(&memtx->checkpoint->cord) != 0)
-			diag_log();
-		memtx->checkpoint->waiting_for_snap_thread = false;
+		for (uint32_t i = 0; i < ckpt->shard_count; i++) {
+			struct checkpoint_shard *shard = &ckpt->shards[i];
+			if (!shard->is_running)
+				continue;
+			if (cord_cojoin(&shard->cord) != 0)
+				diag_log();
+			shard->is_running = false;
+		}
+		ckpt->waiting_for_snap_thread = false;
 	}
 
-	small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+	memtx_engine_leave_delayed_free_mode(memtx);
 
-	/** Remove garbage .inprogress file. */
-	const char *filename =
-		xdir_format_filename(&memtx->checkpoint->dir,
-				     vclock_sum(&memtx->checkpoint->vclock),
-				     INPROGRESS);
-	(void) coio_unlink(filename);
+	/** Remove garbage .inprogress files. */
+	for (uint32_t i = 0; i < ckpt->shard_count; i++) {
+		const char *filename =
+			xdir_format_shard_filename(&ckpt->dir,
+						   vclock_sum(&ckpt->vclock),
+						   i, INPROGRESS);
+		(void) coio_unlink(filename);
+	}
 
-	checkpoint_delete(memtx->checkpoint);
+	checkpoint_delete(ckpt);
 	memtx->checkpoint = NULL;
 }
 
@@ -837,42 +1567,70 @@ memtx_engine_backup(struct engine *engine, const struct vclock *vclock,
 		    engine_backup_cb cb, void *cb_arg)
 {
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	int64_t signature = vclock_sum(vclock);
 	const char *filename = xdir_format_filename(&memtx->snap_dir,
-						    vclock_sum(vclock), NONE);
-	return cb(filename, cb_arg);
+						    signature, NONE);
+	uint32_t shard_count;
+	if (xdir_read_shard_count(filename, &shard_count) != 0)
+		return -1;
+	if (cb(filename, cb_arg) != 0)
+		return -1;
+	/*
+	 * Shards of a sharded snapshot, if any. A backup
+	 * missing any of them couldn't be restored.
+	 */
+	for (uint32_t i = 1; i < shard_count; i++) {
+		filename = xdir_format_shard_filename(&memtx->snap_dir,
+						      signature, i, NONE);
+		if (access(filename, F_OK) != 0) {
+			diag_set(SystemError, "snapshot shard '%s' is missing",
+				 filename);
+			return -1;
+		}
+		if (cb(filename, cb_arg) != 0)
+			return -1;
+	}
+	return 0;
 }
 
 /** Used to pass arguments to memtx_initial_join_f */
 struct memtx_join_arg {
 	const char *snap_dirname;
 	int64_t checkpoint_lsn;
+	/** Shard to feed or MEMTX_JOIN_ALL_SHARDS. */
+	uint32_t shard;
+	/**
+	 * Stream to feed rows to. If NULL, only the number of
+	 * shards is read from the snapshot.
+	 */
 	struct xstream *stream;
+	/** Number of shards of the snapshot (out). */
+	uint32_t shard_count;
 };
 
+enum { MEMTX_JOIN_ALL_SHARDS = UINT32_MAX };
+
 /**
- * Invoked from a thread to feed snapshot rows.
+ * Feed rows of a shard of a snapshot to a stream. Shard 0
+ * is the snapshot file itself. If @shard_count is not NULL,
+ * it is set to the number of shards of the snapshot.
  */
 static int
-memtx_initial_join_f(va_list ap)
+memtx_initial_join_shard(struct xdir *dir, int64_t checkpoint_lsn,
+			 uint32_t shard, struct xstream *stream,
+			 uint32_t *shard_count)
 {
-	struct memtx_join_arg *arg = va_arg(ap, struct memtx_join_arg *);
-	const char *snap_dirname = arg->snap_dirname;
-	int64_t checkpoint_lsn = arg->checkpoint_lsn;
-	struct xstream *stream = arg->stream;
-
-	struct xdir dir;
-	/*
-	 * snap_dirname and INSTANCE_UUID don't change after start,
-	 * safe to use in another thread.
-	 */
-	xdir_create(&dir, snap_dirname, SNAP, &INSTANCE_UUID,
-		    &xlog_opts_default);
 	struct xlog_cursor cursor;
-	int rc = xdir_open_cursor(&dir, checkpoint_lsn, &cursor);
-	xdir_destroy(&dir);
-	if (rc < 0)
+	if (xdir_open_shard_cursor(dir, checkpoint_lsn, shard, &cursor) < 0)
 		return -1;
+	if (shard_count != NULL)
+		*shard_count = MAX(cursor.meta.shard_count, 1);
+	if (stream == NULL) {
+		xlog_cursor_close(&cursor, false);
+		return 0;
+	}
 
+	int rc;
 	struct xrow_header row;
 	while ((rc = xlog_cursor_next(&cursor, &row, true)) == 0) {
 		rc = xstream_write(stream, &row);
@@ -894,25 +1652,98 @@ memtx_initial_join_f(va_list ap)
 	return 0;
 }
 
+/**
+ * Invoked from a thread to feed snapshot rows.
+ */
 static int
-memtx_engine_join(struct engine *engine, const struct vclock *vclock,
-		  struct xstream *stream)
+memtx_initial_join_f(va_list ap)
 {
-	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	struct memtx_join_arg *arg = va_arg(ap, struct memtx_join_arg *);
+	const char *snap_dirname = arg->snap_dirname;
+	int64_t checkpoint_lsn = arg->checkpoint_lsn;
+	struct xstream *stream = arg->stream;
+	uint32_t shard = arg->shard;
+
+	struct xdir dir;
+	/*
+	 * snap_dirname and INSTANCE_UUID don't change after start,
+	 * safe to use in another thread.
+	 */
+	xdir_create(&dir, snap_dirname, SNAP, &INSTANCE_UUID,
+		    &xlog_opts_default);
+	int rc = 0;
+	if (shard != MEMTX_JOIN_ALL_SHARDS) {
+		rc = memtx_initial_join_shard(&dir, checkpoint_lsn, shard,
+					      stream, &arg->shard_count);
+		xdir_destroy(&dir);
+		return rc;
+	}
+	uint32_t shard_count = 1;
+	for (uint32_t i = 0; i < shard_count && rc == 0; i++) {
+		rc = memtx_initial_join_shard(&dir, checkpoint_lsn, i, stream,
+					      i == 0 ? &shard_count : NULL);
+	}
+	arg->shard_count = shard_count;
+	xdir_destroy(&dir);
+	return rc;
+}
 
+/**
+ * Run memtx_initial_join_f() in a thread so as not to block
+ * tx on disk reads.
+ */
+static int
+memtx_engine_run_join(struct memtx_engine *memtx,
+		      const struct vclock *vclock, uint32_t shard,
+		      struct xstream *stream, uint32_t *shard_count)
+{
 	/*
 	 * cord_costart() passes only void * pointer as an argument.
 	 */
 	struct memtx_join_arg arg = {
 		/* .snap_dirname   = */ memtx->snap_dir.dirname,
 		/* .checkpoint_lsn = */ vclock_sum(vclock),
-		/* .stream         = */ stream
+		/* .shard          = */ shard,
+		/* .stream         = */ stream,
+		/* .shard_count    = */ 0,
 	};
 
-	/* Send snapshot using a thread */
 	struct cord cord;
-	cord_costart(&cord, "initial_join", memtx_initial_join_f, &arg);
-	return cord_cojoin(&cord);
+	if (cord_costart(&cord, "initial_join", memtx_initial_join_f,
+			 &arg) != 0)
+		return -1;
+	if (cord_cojoin(&cord) != 0)
+		return -1;
+	if (shard_count != NULL)
+		*shard_count = arg.shard_count;
+	return 0;
+}
+
+static int
+memtx_engine_join(struct engine *engine, const struct vclock *vclock,
+		  struct xstream *stream)
+{
+	struct memtx_engine *memtx = (struct memtx_engine *)engine;
+	/* Send snapshot using a thread */
+	return memtx_engine_run_join(memtx, vclock, MEMTX_JOIN_ALL_SHARDS,
+				     stream, NULL);
+}
+
+int
+memtx_engine_snapshot_shard_count(struct memtx_engine *memtx,
+				  const struct vclock *vclock,
+				  uint32_t *shard_count)
+{
+	return memtx_engine_run_join(memtx, vclock, 0, NULL, shard_count);
+}
+
+int
+memtx_engine_join_shard(struct memtx_engine *memtx,
+			const struct vclock *vclock, uint32_t shard,
+			struct xstream *stream)
+{
+	assert(stream != NULL);
+	return memtx_engine_run_join(memtx, vclock, shard, stream, NULL);
 }
 
 static int
@@ -974,6 +1805,20 @@ memtx_engine_run_gc(struct memtx_engine *memtx, bool *stop)
 
 	struct memtx_gc_task *task = stailq_first_entry(&memtx->gc_queue,
 					struct memtx_gc_task, link);
+	if (!stailq_empty(&memtx->read_views)) {
+		struct memtx_read_view *rv = stailq_first_entry(
+				&memtx->read_views, struct memtx_read_view,
+				link);
+		if (rv->version <= task->version) {
+			/*
+			 * The memory may be read by the view. The task
+			 * will be resumed when the view is closed, see
+			 * memtx_engine_close_read_view().
+			 */
+			*stop = true;
+			return;
+		}
+	}
 	bool task_done;
 	task->vtab->run(task, &task_done);
 	if (task_done) {
@@ -1055,6 +1900,7 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	}
 
 	stailq_create(&memtx->gc_queue);
+	stailq_create(&memtx->read_views);
 	memtx->gc_fiber = fiber_new("memtx.gc", memtx_engine_gc_f);
 	if (memtx->gc_fiber == NULL)
 		goto fail;
@@ -1082,10 +1928,13 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 
 	memtx->state = MEMTX_INITIALIZED;
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
+	memtx->checkpoint_threads = 1;
+	memtx->compression_level = XLOG_COMPRESSION_LEVEL_DEFAULT;
 	memtx->force_recovery = force_recovery;
 
 	memtx->base.vtab = &memtx_engine_vtab;
 	memtx->base.name = "memtx";
+	memtx->base.flags = ENGINE_SUPPORTS_ASYNC_COMMIT;
 
 	fiber_start(memtx->gc_fiber, memtx);
 	return memtx;
@@ -1099,6 +1948,7 @@ void
 memtx_engine_schedule_gc(struct memtx_engine *memtx,
 			 struct memtx_gc_task *task)
 {
+	task->version = memtx->snapshot_version;
 	stailq_add_tail_entry(&memtx->gc_queue, task, link);
 	fiber_wakeup(memtx->gc_fiber);
 }
@@ -1109,6 +1959,37 @@ memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit)
 	memtx->snap_io_rate_limit = limit * 1024 * 1024;
 }
 
+void
+memtx_engine_enter_delayed_free_mode(struct memtx_engine *memtx)
+{
+	/* Tuples older than the read view must be freed in delayed mode. */
+	memtx->snapshot_version++;
+	if (memtx->delayed_free_mode++ == 0)
+		small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, true);
+}
+
+void
+memtx_engine_leave_delayed_free_mode(struct memtx_engine *memtx)
+{
+	assert(memtx->delayed_free_mode > 0);
+	if (--memtx->delayed_free_mode == 0)
+		small_alloc_setopt(&memtx->alloc, SMALL_DELAYED_FREE_MODE, false);
+}
+
+void
+memtx_engine_set_checkpoint_threads(struct memtx_engine *memtx,
+				    uint32_t threads)
+{
+	assert(threads > 0);
+	memtx->checkpoint_threads = threads;
+}
+
+void
+memtx_engine_set_compression_level(struct memtx_engine *memtx, int level)
+{
+	memtx->compression_level = level;
+}
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size)
 {
@@ -1127,6 +2008,53 @@ memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size)
 	memtx->max_tuple_size = max_size;
 }
 
+/**
+ * Compress MessagePack of a tuple following the fields
+ * indexed by the format. The compressed data is allocated
+ * on the region. If compression doesn't make the tuple
+ * shorter, @a zdata is set to NULL.
+ */
+static int
+memtx_tuple_compress(struct memtx_engine *memtx, struct tuple_format *format,
+		     const char *data, const char *end, size_t *prefix_size,
+		     char **zdata, size_t *zsize)
+{
+	assert(format->compression == TUPLE_COMPRESSION_ZSTD);
+	*zdata = NULL;
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	if (field_count <= format->index_field_count)
+		return 0;
+	for (uint32_t i = 0; i < format->index_field_count; i++)
+		mp_next(&pos);
+	size_t size = end - pos;
+	if (memtx->zctx == NULL) {
+		memtx->zctx = ZSTD_createCCtx();
+		if (memtx->zctx == NULL) {
+			diag_set(OutOfMemory, 0, "ZSTD_createCCtx", "zctx");
+			return -1;
+		}
+	}
+	size_t zmax_size = ZSTD_compressBound(size);
+	char *buf = region_alloc(&fiber()->gc, zmax_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, zmax_size, "region_alloc", "buf");
+		return -1;
+	}
+	size_t rc = ZSTD_compressCCtx(memtx->zctx, buf, zmax_size,
+				      pos, size, format->compression_level);
+	if (ZSTD_isError(rc)) {
+		diag_set(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+		return -1;
+	}
+	if (rc + sizeof(struct tuple_compressed) >= size)
+		return 0;
+	*prefix_size = pos - data;
+	*zdata = buf;
+	*zsize = rc;
+	return 0;
+}
+
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 {
@@ -1141,7 +2069,22 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	uint32_t field_map_size = field_map_build_size(&builder);
 
 	size_t tuple_len = end - data;
-	size_t total = sizeof(struct memtx_tuple) + field_map_size + tuple_len;
+	size_t prefix_size = tuple_len;
+	char *zdata = NULL;
+	size_t zsize = 0;
+	if (unlikely(format->compression != TUPLE_COMPRESSION_NONE &&
+		     tuple_len >= format->compression_threshold) &&
+	    memtx_tuple_compress(memtx, format, data, end, &prefix_size,
+				 &zdata, &zsize) != 0)
+		goto end;
+	size_t header_size = 0;
+	size_t data_size = tuple_len;
+	if (zdata != NULL) {
+		header_size = sizeof(struct tuple_compressed);
+		data_size = prefix_size + zsize;
+	}
+	size_t total = sizeof(struct memtx_tuple) + header_size +
+		       field_map_size + data_size;
 
 	ERROR_INJECT(ERRINJ_TUPLE_ALLOC, {
 		diag_set(OutOfMemory, total, "slab allocator", "memtx_tuple");
@@ -1176,10 +2119,20 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	 * tuple base, not from memtx_tuple, because the struct
 	 * tuple is not the first field of the memtx_tuple.
 	 */
-	tuple->data_offset = sizeof(struct tuple) + field_map_size;
+	tuple->data_offset = sizeof(struct tuple) + header_size +
+			     field_map_size;
 	char *raw = (char *) tuple + tuple->data_offset;
 	field_map_build(&builder, raw - field_map_size);
-	memcpy(raw, data, tuple_len);
+	tuple->is_compressed = zdata != NULL;
+	if (tuple->is_compressed) {
+		struct tuple_compressed *compressed = tuple_compressed(tuple);
+		compressed->prefix_size = prefix_size;
+		compressed->zsize = zsize;
+		memcpy(raw, data, prefix_size);
+		memcpy(raw + prefix_size, zdata, zsize);
+	} else {
+		memcpy(raw, data, tuple_len);
+	}
 	say_debug("%s(%zu) = %p", __func__, tuple_len, memtx_tuple);
 end:
 	region_truncate(region, region_svp);
@@ -1196,6 +2149,19 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	struct memtx_tuple *memtx_tuple =
 		container_of(tuple, struct memtx_tuple, base);
 	size_t total = tuple_size(tuple) + offsetof(struct memtx_tuple, base);
+	if (tuple->is_compressed)
+		tuple_decompress_forget(tuple);
+	if (!stailq_empty(&memtx->read_views)) {
+		struct memtx_read_view *rv = stailq_last_entry(
+				&memtx->read_views, struct memtx_read_view,
+				link);
+		if (memtx_tuple->version < rv->version) {
+			/* The tuple may be seen by a read view. */
+			*(struct memtx_tuple **)memtx_tuple = rv->garbage;
+			rv->garbage = memtx_tuple;
+			return;
+		}
+	}
 	if (memtx->alloc.free_mode != SMALL_DELAYED_FREE ||
 	    memtx_tuple->version == memtx->snapshot_version ||
 	    format->is_temporary)
@@ -1204,6 +2170,67 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 		smfree_delayed(&memtx->alloc, memtx_tuple, total);
 }
 
+struct memtx_read_view *
+memtx_engine_open_read_view(struct memtx_engine *memtx)
+{
+	struct memtx_read_view *rv = malloc(sizeof(*rv));
+	if (rv == NULL) {
+		diag_set(OutOfMemory, sizeof(*rv), "malloc",
+			 "struct memtx_read_view");
+		return NULL;
+	}
+	/* Tuples created from now on aren't seen by the view. */
+	rv->version = ++memtx->snapshot_version;
+	rv->is_closed = false;
+	rv->garbage = NULL;
+	stailq_add_tail_entry(&memtx->read_views, rv, link);
+	return rv;
+}
+
+/** Free tuples deleted while a read view was the newest one. */
+static void
+memtx_read_view_free_garbage(struct memtx_engine *memtx,
+			     struct memtx_read_view *rv)
+{
+	struct memtx_tuple *memtx_tuple = rv->garbage;
+	while (memtx_tuple != NULL) {
+		struct memtx_tuple *next = *(struct memtx_tuple **)memtx_tuple;
+		size_t total = tuple_size(&memtx_tuple->base) +
+			       offsetof(struct memtx_tuple, base);
+		/*
+		 * The version is overwritten by the list link,
+		 * so assume a checkpoint in progress may see
+		 * the tuple.
+		 */
+		if (memtx->alloc.free_mode != SMALL_DELAYED_FREE)
+			smfree(&memtx->alloc, memtx_tuple, total);
+		else
+			smfree_delayed(&memtx->alloc, memtx_tuple, total);
+		memtx_tuple = next;
+	}
+	rv->garbage = NULL;
+}
+
+void
+memtx_engine_close_read_view(struct memtx_engine *memtx,
+			     struct memtx_read_view *rv)
+{
+	assert(!rv->is_closed);
+	rv->is_closed = true;
+	while (!stailq_empty(&memtx->read_views)) {
+		rv = stailq_first_entry(&memtx->read_views,
+					struct memtx_read_view, link);
+		if (!rv->is_closed)
+			break;
+		stailq_shift(&memtx->read_views);
+		memtx_read_view_free_garbage(memtx, rv);
+		free(rv);
+	}
+	/* Resume tasks postponed by memtx_engine_run_gc(). */
+	if (!stailq_empty(&memtx->gc_queue))
+		fiber_wakeup(memtx->gc_fiber);
+}
+
 struct tuple_format_vtab memtx_tuple_format_vtab = {
 	memtx_tuple_delete,
 	memtx_tuple_new,
@@ -105,6 +105,13 @@ struct memtx_engine {
 	struct xdir snap_dir;
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t snap_io_rate_limit;
+	/**
+	 * Max number of threads writing a checkpoint, each to
+	 * its own shard of the snapshot.
+	 */
+	uint32_t checkpoint_threads;
+	/** zstd compression level of snapshots, 0 if disabled. */
+	int compression_level;
 	/** Skip invalid snapshot records if this flag is set. */
 	bool force_recovery;
 	/** Common quota for tuples and indexes. */
@@ -135,8 +142,23 @@ struct memtx_engine {
 	void *reserved_extents;
 	/** Maximal allowed tuple size, box.cfg.memtx_max_tuple_size. */
 	size_t max_tuple_size;
+	/**
+	 * Context used to compress tuples of spaces with
+	 * compression enabled, created on demand.
+	 */
+	ZSTD_CCtx *zctx;
 	/** Incremented with each next snapshot. */
 	uint32_t snapshot_version;
+	/**
+	 * Number of checkpoints in progress which need tuples
+	 * to be freed in delayed mode.
+	 */
+	uint32_t delayed_free_mode;
+	/**
+	 * Open read views, oldest first, linked by
+	 * memtx_read_view::link.
+	 */
+	struct stailq read_views;
 	/** Memory pool for rtree index iterator. */
 	struct mempool rtree_iterator_pool;
 	/**
@@ -177,6 +199,13 @@ struct memtx_gc_task {
 	struct stailq_entry link;
 	/** Virtual function table. */
 	const struct memtx_gc_task_vtab *vtab;
+	/**
+	 * memtx_engine::snapshot_version when the task was
+	 * scheduled. Read views opened before may still use
+	 * the memory the task frees, so it is postponed until
+	 * they are closed.
+	 */
+	uint32_t version;
 };
 
 /**
@@ -198,12 +227,83 @@ memtx_engine_recover_snapshot(struct memtx_engine *memtx,
 void
 memtx_engine_set_snap_io_rate_limit(struct memtx_engine *memtx, double limit);
 
+/**
+ * Switch tuple deletion to delayed mode, so that tuples seen
+ * by snapshot iterators created after this call stay in place
+ * until memtx_engine_leave_delayed_free_mode() is called.
+ */
+void
+memtx_engine_enter_delayed_free_mode(struct memtx_engine *memtx);
+
+/**
+ * Undo memtx_engine_enter_delayed_free_mode(). Tuples are freed
+ * at once again when the last checkpoint leaves the mode.
+ */
+void
+memtx_engine_leave_delayed_free_mode(struct memtx_engine *memtx);
+
+struct memtx_read_view;
+
+/**
+ * Open a read view. Indexes frozen after this call and before
+ * the next yield may be read from any thread until the view is
+ * closed: tuples they refer to and memory of dropped indexes are
+ * not freed until then. Unlike delayed free mode, a read view
+ * keeps only the tuples deleted while it is open, and frees them
+ * once it is closed, so it may be kept open for long.
+ */
+struct memtx_read_view *
+memtx_engine_open_read_view(struct memtx_engine *memtx);
+
+/**
+ * Close a read view opened with memtx_engine_open_read_view().
+ * The indexes frozen in it must not be read any more.
+ */
+void
+memtx_engine_close_read_view(struct memtx_engine *memtx,
+			     struct memtx_read_view *rv);
+
+void
+memtx_engine_set_checkpoint_threads(struct memtx_engine *memtx,
+				    uint32_t threads);
+
+void
+memtx_engine_set_compression_level(struct memtx_engine *memtx, int level);
+
 int
 memtx_engine_set_memory(struct memtx_engine *memtx, size_t size);
 
 void
 memtx_engine_set_max_tuple_size(struct memtx_engine *memtx, size_t max_size);
 
+/**
+ * Get the number of shards of the snapshot taken at @vclock.
+ * The shards can be fed to replicas independently of each
+ * other with memtx_engine_join_shard(). Yields.
+ */
+int
+memtx_engine_snapshot_shard_count(struct memtx_engine *memtx,
+				  const struct vclock *vclock,
+				  uint32_t *shard_count);
+
+/**
+ * Feed rows of a shard of the snapshot taken at @vclock to
+ * a stream, like engine_join() does for the whole snapshot.
+ * Yields.
+ */
+int
+memtx_engine_join_shard(struct memtx_engine *memtx,
+			const struct vclock *vclock, uint32_t shard,
+			struct xstream *stream);
+
+/**
+ * Sort build arrays of the given tree indexes, filled with
+ * build_next(), in coio threads, all at once. Indexes of other
+ * types are skipped. Yields.
+ */
+void
+memtx_sort_build_arrays(struct index **indexes, uint32_t index_count);
+
 /** Allocate a memtx tuple. @sa tuple_new(). */
 struct tuple *
 memtx_tuple_new(struct tuple_format *format, const char *data, const char *end);
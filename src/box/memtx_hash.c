@@ -33,6 +33,7 @@
 #include "fiber.h"
 #include "index.h"
 #include "tuple.h"
+#include "port.h"
 #include "memtx_engine.h"
 #include "space.h"
 #include "schema.h" /* space_cache_find() */
@@ -286,6 +287,41 @@ memtx_hash_index_get(struct index *base, const char *key,
 	return 0;
 }
 
+static int
+memtx_hash_index_get_many(struct index *base, const char **keys,
+			  uint32_t key_count, struct port *port)
+{
+	/* Number of lookups whose bucket loads overlap. */
+	enum { MEMTX_HASH_BATCH = 16 };
+	struct memtx_hash_index *index = (struct memtx_hash_index *)base;
+	struct key_def *key_def = base->def->key_def;
+	assert(base->def->opts.is_unique);
+	const char *key[MEMTX_HASH_BATCH];
+	uint32_t hash[MEMTX_HASH_BATCH];
+	for (uint32_t start = 0; start < key_count; start += MEMTX_HASH_BATCH) {
+		uint32_t n = MIN(key_count - start, (uint32_t)MEMTX_HASH_BATCH);
+		for (uint32_t i = 0; i < n; i++) {
+			key[i] = keys[start + i];
+			uint32_t part_count = mp_decode_array(&key[i]);
+			assert(part_count == key_def->part_count);
+			(void)part_count;
+			hash[i] = key_hash(key[i], key_def);
+			light_index_prefetch(&index->hash_table, hash[i]);
+		}
+		for (uint32_t i = 0; i < n; i++) {
+			uint32_t k = light_index_find_key(&index->hash_table,
+							  hash[i], key[i]);
+			if (k == light_index_end)
+				continue;
+			struct tuple *tuple = light_index_get(&index->hash_table,
+							      k);
+			if (port_tuple_add(port, tuple) != 0)
+				return -1;
+		}
+	}
+	return 0;
+}
+
 static int
 memtx_hash_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -401,6 +437,9 @@ struct hash_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct light_index_core *hash_table;
 	struct light_index_iterator iterator;
+	/** Buffer for data of compressed tuples. */
+	char *buf;
+	size_t buf_size;
 };
 
 /**
@@ -415,6 +454,7 @@ hash_snapshot_iterator_free(struct snapshot_iterator *iterator)
 	struct hash_snapshot_iterator *it =
 		(struct hash_snapshot_iterator *) iterator;
 	light_index_iterator_destroy(it->hash_table, &it->iterator);
+	free(it->buf);
 	free(iterator);
 }
 
@@ -433,7 +473,7 @@ hash_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
 							       &it->iterator);
 	if (res == NULL)
 		return NULL;
-	return tuple_data_range(*res, size);
+	return tuple_data_range_to(*res, &it->buf, &it->buf_size, size);
 }
 
 /**
@@ -478,8 +518,11 @@ static const struct index_vtab memtx_hash_index_vtab = {
 	/* .random = */ memtx_hash_index_random,
 	/* .count = */ memtx_hash_index_count,
 	/* .get = */ memtx_hash_index_get,
+	/* .get_many = */ memtx_hash_index_get_many,
 	/* .replace = */ memtx_hash_index_replace,
 	/* .create_iterator = */ memtx_hash_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		memtx_hash_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
@@ -325,8 +325,11 @@ static const struct index_vtab memtx_rtree_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ memtx_rtree_index_count,
 	/* .get = */ memtx_rtree_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ memtx_rtree_index_replace,
 	/* .create_iterator = */ memtx_rtree_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
@@ -36,12 +36,15 @@
 #include "tuple_update.h"
 #include "xrow.h"
 #include "memtx_hash.h"
+#include "memtx_swiss.h"
+#include "memtx_art.h"
 #include "memtx_tree.h"
 #include "memtx_rtree.h"
 #include "memtx_bitset.h"
 #include "memtx_engine.h"
 #include "column_mask.h"
 #include "sequence.h"
+#include "gc.h"
 
 static void
 memtx_space_destroy(struct space *space)
@@ -130,6 +133,27 @@ memtx_space_replace_build_next(struct space *space, struct tuple *old_tuple,
 	return 0;
 }
 
+/**
+ * A version of replace() used while a space is being bulk
+ * loaded and until the loaded data is checkpointed: rows
+ * written to WAL must not refer to data which may not be
+ * recovered.
+ */
+static int
+memtx_space_replace_bulk_load(struct space *space, struct tuple *old_tuple,
+			      struct tuple *new_tuple,
+			      enum dup_replace_mode mode,
+			      struct tuple **result)
+{
+	(void)old_tuple;
+	(void)new_tuple;
+	(void)mode;
+	(void)result;
+	diag_set(ClientError, ER_BULK_LOAD, space_name(space),
+		 "bulk load is in progress");
+	return -1;
+}
+
 /**
  * A short-cut version of replace() used when loading
  * data from XLOG files.
@@ -614,6 +638,47 @@ memtx_space_ephemeral_rowid_next(struct space *space, uint64_t *rowid)
 
 /* {{{ DDL */
 
+/**
+ * ART index stores keys in an encoding that preserves the order
+ * of unsigned, integer, boolean and binary collated string values.
+ * Primary key parts are a part of the key of a non-unique index,
+ * so they are checked too.
+ */
+static int
+memtx_space_check_art_index_def(struct space *space,
+				struct index_def *index_def)
+{
+	if (key_def_is_multikey(index_def->key_def)) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "ART index cannot be multikey");
+		return -1;
+	}
+	struct key_def *cmp_def = index_def->opts.is_unique ?
+				  index_def->key_def : index_def->cmp_def;
+	for (uint32_t i = 0; i < cmp_def->part_count; i++) {
+		struct key_part *part = &cmp_def->parts[i];
+		if (part->type != FIELD_TYPE_UNSIGNED &&
+		    part->type != FIELD_TYPE_INTEGER &&
+		    part->type != FIELD_TYPE_BOOLEAN &&
+		    part->type != FIELD_TYPE_STRING) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 tt_sprintf("ART index does not support "
+					    "field type '%s'",
+					    field_type_strs[part->type]));
+			return -1;
+		}
+		if (part->coll != NULL) {
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "ART index does not support collations");
+			return -1;
+		}
+	}
+	return 0;
+}
+
 static int
 memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 {
@@ -632,22 +697,29 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 	}
 	switch (index_def->type) {
 	case HASH:
+	case SWISS:
 		if (! index_def->opts.is_unique) {
 			diag_set(ClientError, ER_MODIFY_INDEX,
 				 index_def->name, space_name(space),
-				 "HASH index must be unique");
+				 tt_sprintf("%s index must be unique",
+					    index_type_strs[index_def->type]));
 			return -1;
 		}
 		if (key_def_is_multikey(index_def->key_def)) {
 			diag_set(ClientError, ER_MODIFY_INDEX,
 				 index_def->name, space_name(space),
-				 "HASH index cannot be multikey");
+				 tt_sprintf("%s index cannot be multikey",
+					    index_type_strs[index_def->type]));
 			return -1;
 		}
 		break;
 	case TREE:
 		/* TREE index has no limitations. */
 		break;
+	case ART:
+		if (memtx_space_check_art_index_def(space, index_def) != 0)
+			return -1;
+		break;
 	case RTREE:
 		if (index_def->key_def->part_count != 1) {
 			diag_set(ClientError, ER_MODIFY_INDEX,
@@ -708,7 +780,7 @@ memtx_space_check_index_def(struct space *space, struct index_def *index_def)
 			 index_def->name, space_name(space));
 		return -1;
 	}
-	/* Only HASH and TREE indexes checks parts there */
+	/* Only HASH, SWISS, ART and TREE indexes checks parts there */
 	/* Check that there are no ANY, ARRAY, MAP parts */
 	for (uint32_t i = 0; i < index_def->key_def->part_count; i++) {
 		struct key_part *part = &index_def->key_def->parts[i];
@@ -770,6 +842,10 @@ memtx_space_create_index(struct space *space, struct index_def *index_def)
 	switch (index_def->type) {
 	case HASH:
 		return memtx_hash_index_new(memtx, index_def);
+	case SWISS:
+		return memtx_swiss_index_new(memtx, index_def);
+	case ART:
+		return memtx_art_index_new(memtx, index_def);
 	case TREE:
 		return memtx_tree_index_new(memtx, index_def);
 	case RTREE:
@@ -951,6 +1027,12 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 		return -1;
 	}
 
+	if (old_memtx_space->replace == memtx_space_replace_bulk_load) {
+		diag_set(ClientError, ER_ALTER_SPACE, old_space->def->name,
+			 "bulk load is in progress");
+		return -1;
+	}
+
 	new_memtx_space->replace = old_memtx_space->replace;
 	new_memtx_space->bsize = old_memtx_space->bsize;
 	return 0;
@@ -958,6 +1040,145 @@ memtx_space_prepare_alter(struct space *old_space, struct space *new_space)
 
 /* }}} DDL */
 
+/* {{{ Bulk load */
+
+/**
+ * Make a checkpoint containing bulk loaded data, waiting for
+ * a checkpoint that is already in progress, since it may
+ * have been started before the data was loaded.
+ */
+static int
+memtx_space_bulk_load_checkpoint(void)
+{
+	while (gc_checkpoint() != 0) {
+		struct error *e = diag_last_error(diag_get());
+		if (box_error_code(e) != ER_CHECKPOINT_IN_PROGRESS)
+			return -1;
+		fiber_sleep(0.1);
+	}
+	return 0;
+}
+
+/**
+ * Delete bulk loaded tuples which couldn't be checkpointed.
+ * Deletes are not written to WAL, as inserts weren't.
+ */
+static int
+memtx_space_bulk_load_truncate(struct space *space)
+{
+	struct index *pk = space->index[0];
+	while (true) {
+		struct tuple *tuple;
+		if (index_min(pk, NULL, 0, &tuple) != 0)
+			return -1;
+		if (tuple == NULL)
+			return 0;
+		struct tuple *old_tuple;
+		if (memtx_space_replace_all_keys(space, tuple, NULL,
+						 DUP_REPLACE, &old_tuple) != 0)
+			return -1;
+		assert(old_tuple == tuple);
+		tuple_unref(old_tuple);
+	}
+}
+
+/**
+ * Bulk load is the snapshot recovery path applied to a live
+ * space: tuples are appended to build arrays of all indexes,
+ * which are then sorted in parallel and turned into trees at
+ * once. Nothing is written to WAL, instead the space rejects
+ * writes until the loaded data is checkpointed. If the
+ * checkpoint fails, the loaded data is deleted.
+ */
+static int
+memtx_space_bulk_load(struct space *space, struct bulk_load_source *source)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	if (memtx_space->replace != memtx_space_replace_all_keys) {
+		if (memtx_space->replace == memtx_space_replace_no_keys) {
+			diag_set(ClientError, ER_BULK_LOAD, space_name(space),
+				 "the space has no primary key");
+		} else {
+			diag_set(ClientError, ER_BULK_LOAD, space_name(space),
+				 "the space is not ready");
+		}
+		return -1;
+	}
+	if (index_size(space->index[0]) != 0) {
+		diag_set(ClientError, ER_BULK_LOAD, space_name(space),
+			 "the space is not empty");
+		return -1;
+	}
+	for (uint32_t i = 0; i < space->index_count; i++) {
+		if (space->index[i]->def->type != TREE) {
+			diag_set(ClientError, ER_BULK_LOAD, space_name(space),
+				 "only TREE indexes are supported");
+			return -1;
+		}
+	}
+	memtx_space->replace = memtx_space_replace_bulk_load;
+	for (uint32_t i = 0; i < space->index_count; i++)
+		index_begin_build(space->index[i]);
+
+	int rc;
+	struct tuple *tuple;
+	while ((rc = source->next(source, &tuple)) == 0 && tuple != NULL) {
+		assert(tuple_format(tuple) == space->format);
+		/* Referenced by the primary index build array. */
+		tuple_ref(tuple);
+		rc = index_build_next(space->index[0], tuple);
+		if (rc != 0) {
+			tuple_unref(tuple);
+			break;
+		}
+		memtx_space_update_bsize(space, NULL, tuple);
+		for (uint32_t i = 1; rc == 0 && i < space->index_count; i++)
+			rc = index_build_next(space->index[i], tuple);
+		if (rc != 0)
+			break;
+	}
+	if (rc == 0) {
+		memtx_sort_build_arrays(space->index, space->index_count);
+		for (uint32_t i = 0; rc == 0 && i < space->index_count; i++)
+			rc = memtx_tree_index_check_build_array(space->index[i]);
+	}
+	if (rc != 0) {
+		for (uint32_t i = 0; i < space->index_count; i++)
+			memtx_tree_index_abort_build(space->index[i]);
+		memtx_space->bsize = 0;
+		memtx_space->replace = memtx_space_replace_all_keys;
+		return -1;
+	}
+	for (uint32_t i = 0; i < space->index_count; i++)
+		index_end_build(space->index[i]);
+	if (index_size(space->index[0]) > 0 && !space_is_temporary(space) &&
+	    memtx_space_bulk_load_checkpoint() != 0) {
+		/*
+		 * Rows written to WAL must not refer to data
+		 * which won't be recovered. Keep rejecting writes
+		 * if the data can't be deleted either, the space
+		 * can only be dropped then.
+		 */
+		struct error *e = diag_last_error(diag_get());
+		error_ref(e);
+		if (memtx_space_bulk_load_truncate(space) == 0) {
+			memtx_space->replace = memtx_space_replace_all_keys;
+		} else {
+			diag_log();
+			say_error("failed to delete data bulk loaded to "
+				  "space '%s'", space_name(space));
+		}
+		/* Report the checkpoint error. */
+		diag_add_error(diag_get(), e);
+		error_unref(e);
+		return -1;
+	}
+	memtx_space->replace = memtx_space_replace_all_keys;
+	return 0;
+}
+
+/* }}} Bulk load */
+
 static const struct space_vtab memtx_space_vtab = {
 	/* .destroy = */ memtx_space_destroy,
 	/* .bsize = */ memtx_space_bsize,
@@ -980,6 +1201,7 @@ static const struct space_vtab memtx_space_vtab = {
 	/* .swap_index = */ generic_space_swap_index,
 	/* .prepare_alter = */ memtx_space_prepare_alter,
 	/* .invalidate = */ generic_space_invalidate,
+	/* .bulk_load = */ memtx_space_bulk_load,
 };
 
 struct space *
@@ -1009,6 +1231,12 @@ memtx_space_new(struct memtx_engine *memtx,
 		free(memtx_space);
 		return NULL;
 	}
+	if (!def->opts.is_ephemeral) {
+		format->compression = def->opts.compression;
+		format->compression_threshold =
+			def->opts.compression_threshold;
+		format->compression_level = def->opts.compression_level;
+	}
 	tuple_format_ref(format);
 
 	if (space_create((struct space *)memtx_space, (struct engine *)memtx,
@@ -0,0 +1,1201 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_swiss.h"
+#include "say.h"
+#include "fiber.h"
+#include "index.h"
+#include "tuple.h"
+#include "port.h"
+#include "memtx_engine.h"
+#include "space.h"
+#include "schema.h" /* space_cache_find() */
+#include "errinj.h"
+#include "bit/bit.h"
+
+#include <small/mempool.h>
+#include <small/matras.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif /* defined(__SSE2__) */
+
+/*
+ * SWISS index is an open addressing hash table in the spirit
+ * of Swiss tables. Slots are split into groups of 16. Each slot
+ * has a control byte, which is either EMPTY, DELETED or, for an
+ * occupied slot, stores 7 bits of the tuple hash. Control bytes
+ * of a group are probed at once with SSE2, and only slots whose
+ * control byte matches the looked up hash are examined further.
+ * A slot stores a tuple pointer along with the full 32-bit hash
+ * of the tuple key, so tuples are only dereferenced when both
+ * hashes match, i.e. almost only for the tuple being looked up.
+ * Control bytes and slots of a group are stored in matras
+ * blocks, which allows taking consistent read views of the table
+ * for checkpointing. When the table gets 3/4 full, a bigger one
+ * is allocated and tuples are moved to it a few groups per
+ * insertion, while lookups probe both tables, so no insertion
+ * stalls for a rehash of the whole table. Moving tuples doesn't
+ * require touching them as their hashes are cached in slots.
+ */
+enum {
+	/** Number of slots in a group. */
+	SWISS_GROUP_SIZE = 16,
+	/** Control byte of a slot that has never been occupied. */
+	SWISS_CTRL_EMPTY = -128,
+	/** Control byte of a slot whose tuple was deleted. */
+	SWISS_CTRL_DELETED = -2,
+	/** Position returned when a tuple isn't found. */
+	SWISS_END = UINT32_MAX,
+	/**
+	 * Number of groups allocated or moved to a new table
+	 * per insertion while the table grows.
+	 */
+	SWISS_GROW_STEP = 8,
+};
+
+/** Control bytes of a group of slots. */
+struct swiss_ctrl {
+	int8_t byte[SWISS_GROUP_SIZE];
+};
+
+/** A slot of the table. */
+struct swiss_slot {
+	struct tuple *tuple;
+	/** Hash of the tuple key. */
+	uint32_t hash;
+	uint32_t unused;
+};
+
+/** Slots of a group. */
+struct swiss_group {
+	struct swiss_slot slot[SWISS_GROUP_SIZE];
+};
+
+static_assert(sizeof(struct swiss_ctrl) == 16 &&
+	      sizeof(struct swiss_group) == 256,
+	      "matras block size must be a power of 2");
+
+struct swiss_table {
+	/** Control bytes, a block per group. */
+	struct matras ctrl;
+	/** Slots, a block per group. */
+	struct matras groups;
+	/** Number of groups, a power of 2. */
+	uint32_t group_count;
+	/**
+	 * Number of groups allocated so far. A table is only
+	 * used once all its groups have been allocated.
+	 */
+	uint32_t alloc_count;
+	/** Number of tuples stored in the table. */
+	uint32_t count;
+	/** Number of slots marked DELETED. */
+	uint32_t deleted;
+	/**
+	 * Number of references: one is held by the index the
+	 * table belongs to, one by each snapshot iterator.
+	 */
+	uint32_t refs;
+};
+
+/** Control byte stored for a tuple with the given hash. */
+static inline int8_t
+swiss_hash_ctrl(uint32_t hash)
+{
+	return hash & 0x7f;
+}
+
+/** Group a probe sequence for the given hash starts at. */
+static inline uint32_t
+swiss_hash_group(struct swiss_table *table, uint32_t hash)
+{
+	return (hash >> 7) & (table->group_count - 1);
+}
+
+/** Max number of slots that may be taken, full or deleted. */
+static inline uint32_t
+swiss_table_capacity(uint32_t group_count)
+{
+	return group_count * SWISS_GROUP_SIZE / 8 * 7;
+}
+
+/** Number of taken slots at which the table starts growing. */
+static inline uint32_t
+swiss_table_grow_threshold(uint32_t group_count)
+{
+	return group_count * SWISS_GROUP_SIZE / 4 * 3;
+}
+
+/** Bit mask of slots whose control byte equals @a ctrl. */
+static inline uint32_t
+swiss_ctrl_match(const struct swiss_ctrl *group, int8_t ctrl)
+{
+#if defined(__SSE2__)
+	__m128i bytes = _mm_loadu_si128((const __m128i *)group->byte);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(ctrl)));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++) {
+		if (group->byte[i] == ctrl)
+			mask |= 1U << i;
+	}
+	return mask;
+#endif
+}
+
+/** Bit mask of slots that are either EMPTY or DELETED. */
+static inline uint32_t
+swiss_ctrl_match_free(const struct swiss_ctrl *group)
+{
+#if defined(__SSE2__)
+	__m128i bytes = _mm_loadu_si128((const __m128i *)group->byte);
+	return _mm_movemask_epi8(bytes);
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++) {
+		if (group->byte[i] < 0)
+			mask |= 1U << i;
+	}
+	return mask;
+#endif
+}
+
+/** Pop the lowest slot number from a bit mask. */
+static inline int
+swiss_mask_next(uint32_t *mask)
+{
+	int i = bit_ctz_u32(*mask);
+	*mask &= *mask - 1;
+	return i;
+}
+
+/**
+ * Create a table of @a group_count groups. No group is allocated,
+ * see swiss_table_alloc().
+ */
+static struct swiss_table *
+swiss_table_new(struct memtx_engine *memtx, uint32_t group_count)
+{
+	assert(group_count > 0 && (group_count & (group_count - 1)) == 0);
+	struct swiss_table *table = calloc(1, sizeof(*table));
+	if (table == NULL) {
+		diag_set(OutOfMemory, sizeof(*table), "malloc",
+			 "struct swiss_table");
+		return NULL;
+	}
+	matras_create(&table->ctrl, MEMTX_EXTENT_SIZE,
+		      sizeof(struct swiss_ctrl), memtx_index_extent_alloc,
+		      memtx_index_extent_free, memtx);
+	matras_create(&table->groups, MEMTX_EXTENT_SIZE,
+		      sizeof(struct swiss_group), memtx_index_extent_alloc,
+		      memtx_index_extent_free, memtx);
+	table->refs = 1;
+	table->group_count = group_count;
+	return table;
+}
+
+/** Allocate up to @a count more groups of a table. */
+static int
+swiss_table_alloc(struct swiss_table *table, uint32_t count)
+{
+	uint32_t end = MIN(table->alloc_count + count, table->group_count);
+	for (; table->alloc_count < end; table->alloc_count++) {
+		matras_id_t id;
+		struct swiss_ctrl *ctrl = matras_alloc(&table->ctrl, &id);
+		if (ctrl == NULL)
+			goto fail;
+		if (matras_alloc(&table->groups, &id) == NULL) {
+			matras_dealloc(&table->ctrl);
+			goto fail;
+		}
+		memset(ctrl, SWISS_CTRL_EMPTY, sizeof(*ctrl));
+	}
+	return 0;
+fail:
+	diag_set(OutOfMemory, MEMTX_EXTENT_SIZE, "memtx_index_extent_alloc",
+		 "swiss table");
+	return -1;
+}
+
+static void
+swiss_table_unref(struct swiss_table *table)
+{
+	assert(table->refs > 0);
+	if (--table->refs > 0)
+		return;
+	matras_destroy(&table->ctrl);
+	matras_destroy(&table->groups);
+	free(table);
+}
+
+static inline struct swiss_ctrl *
+swiss_table_ctrl(struct swiss_table *table, uint32_t group)
+{
+	return matras_get(&table->ctrl, group);
+}
+
+static inline struct swiss_group *
+swiss_table_group(struct swiss_table *table, uint32_t group)
+{
+	return matras_get(&table->groups, group);
+}
+
+/** Number of slots of a table. */
+static inline uint32_t
+swiss_table_size(struct swiss_table *table)
+{
+	return table->group_count * SWISS_GROUP_SIZE;
+}
+
+/** Tuple stored at the given position, NULL if the slot is free. */
+static inline struct tuple *
+swiss_table_get(struct swiss_table *table, uint32_t pos)
+{
+	uint32_t group = pos / SWISS_GROUP_SIZE;
+	uint32_t i = pos % SWISS_GROUP_SIZE;
+	if (swiss_table_ctrl(table, group)->byte[i] < 0)
+		return NULL;
+	return swiss_table_group(table, group)->slot[i].tuple;
+}
+
+/** Find a tuple matching a key. Return its position or SWISS_END. */
+static uint32_t
+swiss_table_find_key(struct swiss_table *table, uint32_t hash,
+		     const char *key, struct key_def *key_def)
+{
+	int8_t h2 = swiss_hash_ctrl(hash);
+	uint32_t group = swiss_hash_group(table, hash);
+	for (uint32_t step = 1; ; step++) {
+		struct swiss_ctrl *ctrl = swiss_table_ctrl(table, group);
+		uint32_t mask = swiss_ctrl_match(ctrl, h2);
+		if (mask != 0) {
+			struct swiss_group *g = swiss_table_group(table, group);
+			do {
+				int i = swiss_mask_next(&mask);
+				struct swiss_slot *slot = &g->slot[i];
+				if (slot->hash == hash &&
+				    tuple_compare_with_key(slot->tuple,
+						HINT_NONE, key,
+						key_def->part_count,
+						HINT_NONE, key_def) == 0)
+					return group * SWISS_GROUP_SIZE + i;
+			} while (mask != 0);
+		}
+		if (swiss_ctrl_match(ctrl, SWISS_CTRL_EMPTY) != 0)
+			return SWISS_END;
+		group = (group + step) & (table->group_count - 1);
+	}
+}
+
+/** Prefetch the first group probed by a lookup of the given hash. */
+static inline void
+swiss_table_prefetch(struct swiss_table *table, uint32_t hash)
+{
+	uint32_t group = swiss_hash_group(table, hash);
+	__builtin_prefetch(swiss_table_ctrl(table, group));
+	__builtin_prefetch(swiss_table_group(table, group));
+}
+
+/**
+ * Find a tuple equal to the given one, or the very same tuple
+ * if @a key_def is NULL. Return its position or SWISS_END.
+ */
+static uint32_t
+swiss_table_find_tuple(struct swiss_table *table, uint32_t hash,
+		       struct tuple *tuple, struct key_def *key_def)
+{
+	int8_t h2 = swiss_hash_ctrl(hash);
+	uint32_t group = swiss_hash_group(table, hash);
+	for (uint32_t step = 1; ; step++) {
+		struct swiss_ctrl *ctrl = swiss_table_ctrl(table, group);
+		uint32_t mask = swiss_ctrl_match(ctrl, h2);
+		if (mask != 0) {
+			struct swiss_group *g = swiss_table_group(table, group);
+			do {
+				int i = swiss_mask_next(&mask);
+				struct swiss_slot *slot = &g->slot[i];
+				if (slot->tuple == tuple ||
+				    (key_def != NULL && slot->hash == hash &&
+				     tuple_compare(slot->tuple, HINT_NONE,
+						   tuple, HINT_NONE,
+						   key_def) == 0))
+					return group * SWISS_GROUP_SIZE + i;
+			} while (mask != 0);
+		}
+		if (swiss_ctrl_match(ctrl, SWISS_CTRL_EMPTY) != 0)
+			return SWISS_END;
+		group = (group + step) & (table->group_count - 1);
+	}
+}
+
+/**
+ * Insert a tuple that is known to be absent from the table.
+ * The table must have room for it.
+ */
+static int
+swiss_table_insert(struct swiss_table *table, uint32_t hash,
+		   struct tuple *tuple)
+{
+	assert(table->count + table->deleted <
+	       swiss_table_capacity(table->group_count));
+	uint32_t group = swiss_hash_group(table, hash);
+	uint32_t mask;
+	for (uint32_t step = 1; ; step++) {
+		mask = swiss_ctrl_match_free(swiss_table_ctrl(table, group));
+		if (mask != 0)
+			break;
+		group = (group + step) & (table->group_count - 1);
+	}
+	int i = bit_ctz_u32(mask);
+	struct swiss_ctrl *ctrl = matras_touch(&table->ctrl, group);
+	struct swiss_group *g = matras_touch(&table->groups, group);
+	if (ctrl == NULL || g == NULL)
+		return -1;
+	if (ctrl->byte[i] == SWISS_CTRL_DELETED)
+		table->deleted--;
+	ctrl->byte[i] = swiss_hash_ctrl(hash);
+	g->slot[i].tuple = tuple;
+	g->slot[i].hash = hash;
+	table->count++;
+	return 0;
+}
+
+/** Free the slot at the given position. */
+static int
+swiss_table_delete(struct swiss_table *table, uint32_t pos)
+{
+	uint32_t group = pos / SWISS_GROUP_SIZE;
+	uint32_t i = pos % SWISS_GROUP_SIZE;
+	struct swiss_ctrl *ctrl = matras_touch(&table->ctrl, group);
+	if (ctrl == NULL)
+		return -1;
+	assert(ctrl->byte[i] >= 0);
+	/*
+	 * A probe sequence stops at a group with an EMPTY slot,
+	 * so if there's one in this group, no sequence passes
+	 * through it and the slot may be marked EMPTY as well.
+	 */
+	if (swiss_ctrl_match(ctrl, SWISS_CTRL_EMPTY) != 0) {
+		ctrl->byte[i] = SWISS_CTRL_EMPTY;
+	} else {
+		ctrl->byte[i] = SWISS_CTRL_DELETED;
+		table->deleted++;
+	}
+	table->count--;
+	return 0;
+}
+
+struct memtx_swiss_index {
+	struct index base;
+	/** The table new tuples are inserted to. */
+	struct swiss_table *table;
+	/**
+	 * The table tuples are being moved from to @table after
+	 * the index has grown, NULL if none. Positions of its slots
+	 * follow those of @table, see memtx_swiss_index_at().
+	 */
+	struct swiss_table *old_table;
+	/** Number of groups of @old_table moved so far. */
+	uint32_t move_pos;
+	/**
+	 * The table being allocated for the index to grow into,
+	 * NULL if none. Not used until all its groups have been
+	 * allocated.
+	 */
+	struct swiss_table *new_table;
+	struct memtx_gc_task gc_task;
+	/** Position of the next tuple to free on drop. */
+	uint32_t gc_pos;
+};
+
+/** Number of slots of the index, including ones of old_table. */
+static inline uint32_t
+memtx_swiss_index_slot_count(struct memtx_swiss_index *index)
+{
+	uint32_t size = swiss_table_size(index->table);
+	if (index->old_table != NULL)
+		size += swiss_table_size(index->old_table);
+	return size;
+}
+
+/**
+ * Return the table storing the slot at the given index position
+ * and convert the position to a position in the table.
+ */
+static inline struct swiss_table *
+memtx_swiss_index_table(struct memtx_swiss_index *index, uint32_t *pos)
+{
+	uint32_t size = swiss_table_size(index->table);
+	if (*pos < size)
+		return index->table;
+	assert(index->old_table != NULL);
+	*pos -= size;
+	return index->old_table;
+}
+
+/** Tuple stored at the given position, NULL if the slot is free. */
+static inline struct tuple *
+memtx_swiss_index_at(struct memtx_swiss_index *index, uint32_t pos)
+{
+	struct swiss_table *table = memtx_swiss_index_table(index, &pos);
+	return swiss_table_get(table, pos);
+}
+
+/** Find a tuple matching a key. Return its position or SWISS_END. */
+static uint32_t
+memtx_swiss_index_find_key(struct memtx_swiss_index *index, uint32_t hash,
+			   const char *key)
+{
+	struct key_def *key_def = index->base.def->key_def;
+	uint32_t pos = swiss_table_find_key(index->table, hash, key, key_def);
+	if (pos != SWISS_END || index->old_table == NULL)
+		return pos;
+	pos = swiss_table_find_key(index->old_table, hash, key, key_def);
+	if (pos == SWISS_END)
+		return SWISS_END;
+	return swiss_table_size(index->table) + pos;
+}
+
+/** Index counterpart of swiss_table_find_tuple(). */
+static uint32_t
+memtx_swiss_index_find_tuple(struct memtx_swiss_index *index, uint32_t hash,
+			     struct tuple *tuple, struct key_def *key_def)
+{
+	uint32_t pos = swiss_table_find_tuple(index->table, hash, tuple,
+					      key_def);
+	if (pos != SWISS_END || index->old_table == NULL)
+		return pos;
+	pos = swiss_table_find_tuple(index->old_table, hash, tuple, key_def);
+	if (pos == SWISS_END)
+		return SWISS_END;
+	return swiss_table_size(index->table) + pos;
+}
+
+/** Move tuples of a group of the old table to the new one. */
+static int
+swiss_table_move_group(struct swiss_table *table, struct swiss_table *old,
+		       uint32_t group)
+{
+	uint32_t mask = swiss_ctrl_match_free(swiss_table_ctrl(old, group)) ^
+			0xffff;
+	if (mask == 0)
+		return 0;
+	/*
+	 * Make sure the slots can be freed before copying them
+	 * so that a tuple never ends up in both tables.
+	 */
+	if (matras_touch(&old->ctrl, group) == NULL)
+		goto fail;
+	struct swiss_group *g = swiss_table_group(old, group);
+	do {
+		int i = swiss_mask_next(&mask);
+		struct swiss_slot *slot = &g->slot[i];
+		if (swiss_table_insert(table, slot->hash, slot->tuple) != 0)
+			goto fail;
+		int rc = swiss_table_delete(old, group * SWISS_GROUP_SIZE + i);
+		assert(rc == 0); (void) rc;
+	} while (mask != 0);
+	return 0;
+fail:
+	diag_set(OutOfMemory, MEMTX_EXTENT_SIZE, "memtx_index_extent_alloc",
+		 "swiss table");
+	return -1;
+}
+
+/**
+ * Advance the growth of an index, if any: allocate a few groups
+ * of the new table or move a few groups of the old one.
+ */
+static int
+memtx_swiss_index_grow_step(struct memtx_swiss_index *index)
+{
+	struct swiss_table *table = index->new_table;
+	if (table != NULL) {
+		if (swiss_table_alloc(table, SWISS_GROW_STEP) != 0)
+			return -1;
+		if (table->alloc_count < table->group_count)
+			return 0;
+		assert(index->old_table == NULL);
+		index->old_table = index->table;
+		index->table = table;
+		index->new_table = NULL;
+		index->move_pos = 0;
+		return 0;
+	}
+	struct swiss_table *old = index->old_table;
+	if (old == NULL)
+		return 0;
+	uint32_t end = MIN(index->move_pos + SWISS_GROW_STEP,
+			   old->group_count);
+	for (; index->move_pos < end; index->move_pos++) {
+		if (swiss_table_move_group(index->table, old,
+					   index->move_pos) != 0)
+			return -1;
+	}
+	if (index->move_pos < old->group_count)
+		return 0;
+	assert(old->count == 0);
+	/*
+	 * Snapshot iterators may still be reading the old table,
+	 * in which case it's freed by the last of them.
+	 */
+	index->old_table = NULL;
+	swiss_table_unref(old);
+	return 0;
+}
+
+/**
+ * Make sure the table of an index has room for @a count more
+ * tuples. The index starts growing to a bigger table when the
+ * current one gets 3/4 full, and the growth is advanced by one
+ * step per call. Only if there's no room left at all, e.g. when
+ * a lot of tuples are reserved at once, the growth is completed
+ * right away.
+ */
+static int
+memtx_swiss_index_grow(struct memtx_swiss_index *index, uint32_t count)
+{
+	if (memtx_swiss_index_grow_step(index) != 0)
+		return -1;
+	while (true) {
+		struct swiss_table *table = index->table;
+		struct swiss_table *old = index->old_table;
+		/* Tuples of the old table will be moved here, too. */
+		uint32_t total = table->count + count +
+				 (old != NULL ? old->count : 0);
+		if (total + table->deleted <=
+		    swiss_table_grow_threshold(table->group_count))
+			return 0;
+		if (index->new_table == NULL && old == NULL) {
+			/*
+			 * If the table is mostly filled with DELETED
+			 * slots, purge them rather than grow the table.
+			 */
+			uint32_t group_count = table->group_count;
+			while (total > swiss_table_capacity(group_count) / 2) {
+				if (group_count >
+				    UINT32_MAX / SWISS_GROUP_SIZE / 4) {
+					diag_set(OutOfMemory, (ssize_t)total,
+						 "swiss_table", "key");
+					return -1;
+				}
+				group_count *= 2;
+			}
+			struct memtx_engine *memtx =
+				(struct memtx_engine *)index->base.engine;
+			index->new_table = swiss_table_new(memtx, group_count);
+			if (index->new_table == NULL)
+				return -1;
+		}
+		if (total + table->deleted <=
+		    swiss_table_capacity(table->group_count))
+			return 0;
+		while (index->new_table != NULL || index->old_table != NULL) {
+			if (memtx_swiss_index_grow_step(index) != 0)
+				return -1;
+		}
+	}
+}
+
+/* {{{ MemtxSwiss Iterators ***************************************/
+
+struct swiss_iterator {
+	struct iterator base; /* Must be the first member. */
+	struct memtx_swiss_index *index;
+	/** Position of the next slot to examine. */
+	uint32_t pos;
+	/** Key hash and key, looked up on the first call. */
+	uint32_t hash;
+	const char *key;
+	/** Memory pool the iterator was allocated from. */
+	struct mempool *pool;
+};
+
+static_assert(sizeof(struct swiss_iterator) <= MEMTX_ITERATOR_SIZE,
+	      "sizeof(struct swiss_iterator) must be less than or equal "
+	      "to MEMTX_ITERATOR_SIZE");
+
+static void
+swiss_iterator_free(struct iterator *iterator)
+{
+	assert(iterator->free == swiss_iterator_free);
+	struct swiss_iterator *it = (struct swiss_iterator *) iterator;
+	mempool_free(it->pool, it);
+}
+
+static int
+swiss_iterator_ge(struct iterator *ptr, struct tuple **ret)
+{
+	assert(ptr->free == swiss_iterator_free);
+	struct swiss_iterator *it = (struct swiss_iterator *) ptr;
+	uint32_t size = memtx_swiss_index_slot_count(it->index);
+	*ret = NULL;
+	while (it->pos < size && *ret == NULL)
+		*ret = memtx_swiss_index_at(it->index, it->pos++);
+	return 0;
+}
+
+static int
+swiss_iterator_gt(struct iterator *ptr, struct tuple **ret)
+{
+	assert(ptr->free == swiss_iterator_free);
+	struct swiss_iterator *it = (struct swiss_iterator *) ptr;
+	ptr->next = swiss_iterator_ge;
+	it->pos = memtx_swiss_index_find_key(it->index, it->hash, it->key);
+	if (it->pos == SWISS_END) {
+		*ret = NULL;
+		return 0;
+	}
+	it->pos++;
+	return swiss_iterator_ge(ptr, ret);
+}
+
+static int
+swiss_iterator_eq_next(MAYBE_UNUSED struct iterator *it, struct tuple **ret)
+{
+	*ret = NULL;
+	return 0;
+}
+
+static int
+swiss_iterator_eq(struct iterator *ptr, struct tuple **ret)
+{
+	assert(ptr->free == swiss_iterator_free);
+	struct swiss_iterator *it = (struct swiss_iterator *) ptr;
+	ptr->next = swiss_iterator_eq_next;
+	uint32_t pos = memtx_swiss_index_find_key(it->index, it->hash, it->key);
+	*ret = pos != SWISS_END ? memtx_swiss_index_at(it->index, pos) : NULL;
+	return 0;
+}
+
+/* }}} */
+
+/* {{{ MemtxSwiss -- implementation of all hashes. ********************/
+
+static void
+memtx_swiss_index_free(struct memtx_swiss_index *index)
+{
+	swiss_table_unref(index->table);
+	if (index->old_table != NULL)
+		swiss_table_unref(index->old_table);
+	if (index->new_table != NULL)
+		swiss_table_unref(index->new_table);
+	free(index);
+}
+
+static void
+memtx_swiss_index_gc_run(struct memtx_gc_task *task, bool *done)
+{
+	/*
+	 * Yield every 1K tuples to keep latency < 0.1 ms.
+	 * Yield more often in debug mode.
+	 */
+#ifdef NDEBUG
+	enum { YIELD_LOOPS = 1000 };
+#else
+	enum { YIELD_LOOPS = 10 };
+#endif
+
+	struct memtx_swiss_index *index = container_of(task,
+			struct memtx_swiss_index, gc_task);
+	uint32_t size = memtx_swiss_index_slot_count(index);
+
+	unsigned int loops = 0;
+	while (index->gc_pos < size) {
+		struct tuple *tuple = memtx_swiss_index_at(index,
+							   index->gc_pos++);
+		if (tuple == NULL)
+			continue;
+		tuple_unref(tuple);
+		if (++loops >= YIELD_LOOPS) {
+			*done = false;
+			return;
+		}
+	}
+	*done = true;
+}
+
+static void
+memtx_swiss_index_gc_free(struct memtx_gc_task *task)
+{
+	struct memtx_swiss_index *index = container_of(task,
+			struct memtx_swiss_index, gc_task);
+	memtx_swiss_index_free(index);
+}
+
+static const struct memtx_gc_task_vtab memtx_swiss_index_gc_vtab = {
+	.run = memtx_swiss_index_gc_run,
+	.free = memtx_swiss_index_gc_free,
+};
+
+static void
+memtx_swiss_index_destroy(struct index *base)
+{
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+	if (base->def->iid == 0) {
+		/*
+		 * Primary index. We need to free all tuples stored
+		 * in the index, which may take a while. Schedule a
+		 * background task in order not to block tx thread.
+		 */
+		index->gc_task.vtab = &memtx_swiss_index_gc_vtab;
+		index->gc_pos = 0;
+		memtx_engine_schedule_gc(memtx, &index->gc_task);
+	} else {
+		/*
+		 * Secondary index. Destruction is fast, no need to
+		 * hand over to background fiber.
+		 */
+		memtx_swiss_index_free(index);
+	}
+}
+
+static ssize_t
+memtx_swiss_index_size(struct index *base)
+{
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+	ssize_t size = index->table->count;
+	if (index->old_table != NULL)
+		size += index->old_table->count;
+	return size;
+}
+
+static ssize_t
+memtx_swiss_index_bsize(struct index *base)
+{
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+	struct swiss_table *tables[] = {
+		index->table, index->old_table, index->new_table,
+	};
+	size_t extent_count = 0;
+	for (unsigned i = 0; i < lengthof(tables); i++) {
+		if (tables[i] == NULL)
+			continue;
+		extent_count += matras_extent_count(&tables[i]->ctrl) +
+				matras_extent_count(&tables[i]->groups);
+	}
+	return extent_count * MEMTX_EXTENT_SIZE;
+}
+
+static int
+memtx_swiss_index_random(struct index *base, uint32_t rnd,
+			 struct tuple **result)
+{
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+
+	*result = NULL;
+	if (memtx_swiss_index_size(base) == 0)
+		return 0;
+	uint32_t size = memtx_swiss_index_slot_count(index);
+	rnd %= size;
+	while ((*result = memtx_swiss_index_at(index, rnd)) == NULL)
+		rnd = (rnd + 1) % size;
+	return 0;
+}
+
+static ssize_t
+memtx_swiss_index_count(struct index *base, enum iterator_type type,
+			const char *key, uint32_t part_count)
+{
+	if (type == ITER_ALL)
+		return memtx_swiss_index_size(base); /* optimization */
+	return generic_index_count(base, type, key, part_count);
+}
+
+static int
+memtx_swiss_index_get(struct index *base, const char *key,
+		      uint32_t part_count, struct tuple **result)
+{
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+	struct key_def *key_def = base->def->key_def;
+
+	assert(base->def->opts.is_unique &&
+	       part_count == key_def->part_count);
+	(void) part_count;
+
+	uint32_t h = key_hash(key, key_def);
+	uint32_t pos = memtx_swiss_index_find_key(index, h, key);
+	*result = pos != SWISS_END ? memtx_swiss_index_at(index, pos) : NULL;
+	return 0;
+}
+
+static int
+memtx_swiss_index_get_many(struct index *base, const char **keys,
+			   uint32_t key_count, struct port *port)
+{
+	/* Number of lookups whose group loads overlap. */
+	enum { SWISS_BATCH = 16 };
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+	struct swiss_table *table = index->table;
+	struct key_def *key_def = base->def->key_def;
+	assert(base->def->opts.is_unique);
+	const char *key[SWISS_BATCH];
+	uint32_t hash[SWISS_BATCH];
+	for (uint32_t start = 0; start < key_count; start += SWISS_BATCH) {
+		uint32_t n = MIN(key_count - start, (uint32_t)SWISS_BATCH);
+		for (uint32_t i = 0; i < n; i++) {
+			key[i] = keys[start + i];
+			uint32_t part_count = mp_decode_array(&key[i]);
+			assert(part_count == key_def->part_count);
+			(void)part_count;
+			hash[i] = key_hash(key[i], key_def);
+			swiss_table_prefetch(table, hash[i]);
+		}
+		for (uint32_t i = 0; i < n; i++) {
+			uint32_t pos = memtx_swiss_index_find_key(index, hash[i],
+								  key[i]);
+			if (pos == SWISS_END)
+				continue;
+			if (port_tuple_add(port,
+					   memtx_swiss_index_at(index, pos)) != 0)
+				return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+memtx_swiss_index_replace(struct index *base, struct tuple *old_tuple,
+			  struct tuple *new_tuple, enum dup_replace_mode mode,
+			  struct tuple **result)
+{
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+	struct key_def *key_def = base->def->key_def;
+
+	if (new_tuple) {
+		uint32_t h = tuple_hash(new_tuple, key_def);
+		uint32_t pos = memtx_swiss_index_find_tuple(index, h,
+							    new_tuple, key_def);
+		struct tuple *dup_tuple = pos != SWISS_END ?
+			memtx_swiss_index_at(index, pos) : NULL;
+		uint32_t errcode = replace_check_dup(old_tuple,
+						     dup_tuple, mode);
+		if (errcode) {
+			struct space *sp = space_cache_find(base->def->space_id);
+			if (sp != NULL)
+				diag_set(ClientError, errcode, base->def->name,
+					 space_name(sp));
+			return -1;
+		}
+		if (dup_tuple) {
+			/* Equal keys have equal hashes. */
+			struct swiss_table *table =
+				memtx_swiss_index_table(index, &pos);
+			uint32_t group = pos / SWISS_GROUP_SIZE;
+			struct swiss_group *g = matras_touch(&table->groups,
+							     group);
+			if (g == NULL) {
+				diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+					 "memtx_index_extent_alloc",
+					 "swiss table");
+				return -1;
+			}
+			g->slot[pos % SWISS_GROUP_SIZE].tuple = new_tuple;
+			*result = dup_tuple;
+			return 0;
+		}
+
+		int rc = memtx_swiss_index_grow(index, 1);
+		ERROR_INJECT(ERRINJ_INDEX_ALLOC, {
+			if (rc == 0) {
+				diag_set(OutOfMemory,
+					 (ssize_t)index->table->count,
+					 "swiss_table", "key");
+			}
+			rc = -1;
+		});
+		if (rc != 0)
+			return -1;
+		if (swiss_table_insert(index->table, h, new_tuple) != 0) {
+			diag_set(OutOfMemory, MEMTX_EXTENT_SIZE,
+				 "memtx_index_extent_alloc", "swiss table");
+			return -1;
+		}
+	}
+
+	if (old_tuple) {
+		uint32_t h = tuple_hash(old_tuple, key_def);
+		uint32_t pos = memtx_swiss_index_find_tuple(index, h,
+							    old_tuple, NULL);
+		assert(pos != SWISS_END);
+		struct swiss_table *table = memtx_swiss_index_table(index, &pos);
+		int rc = swiss_table_delete(table, pos);
+		assert(rc == 0); (void) rc;
+	}
+	*result = old_tuple;
+	return 0;
+}
+
+static struct iterator *
+memtx_swiss_index_create_iterator(struct index *base, enum iterator_type type,
+				  const char *key, uint32_t part_count)
+{
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+	struct memtx_engine *memtx = (struct memtx_engine *)base->engine;
+
+	assert(part_count == 0 || key != NULL);
+
+	struct swiss_iterator *it = mempool_alloc(&memtx->iterator_pool);
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(struct swiss_iterator),
+			 "memtx_swiss_index", "iterator");
+		return NULL;
+	}
+	iterator_create(&it->base, base);
+	it->pool = &memtx->iterator_pool;
+	it->base.free = swiss_iterator_free;
+	it->index = index;
+	it->pos = 0;
+	it->key = key;
+	it->hash = part_count != 0 ? key_hash(key, base->def->key_def) : 0;
+
+	switch (type) {
+	case ITER_GT:
+		if (part_count != 0)
+			it->base.next = swiss_iterator_gt;
+		else
+			it->base.next = swiss_iterator_ge;
+		break;
+	case ITER_ALL:
+		it->base.next = swiss_iterator_ge;
+		break;
+	case ITER_EQ:
+		assert(part_count > 0);
+		it->base.next = swiss_iterator_eq;
+		break;
+	default:
+		diag_set(UnsupportedIndexFeature, base->def,
+			 "requested iterator type");
+		mempool_free(&memtx->iterator_pool, it);
+		return NULL;
+	}
+	return (struct iterator *)it;
+}
+
+static int
+memtx_swiss_index_reserve(struct index *base, uint32_t size_hint)
+{
+	uint32_t count = memtx_swiss_index_size(base);
+	if (size_hint <= count)
+		return 0;
+	return memtx_swiss_index_grow((struct memtx_swiss_index *)base,
+				      size_hint - count);
+}
+
+/** A frozen table read by a snapshot iterator. */
+struct swiss_table_view {
+	struct swiss_table *table;
+	struct matras_view ctrl_view;
+	struct matras_view groups_view;
+	/** Number of groups at the time the view was taken. */
+	uint32_t group_count;
+};
+
+struct swiss_snapshot_iterator {
+	struct snapshot_iterator base;
+	/**
+	 * Views of the index tables: the current one and, if the
+	 * index was growing, the one tuples were being moved from.
+	 */
+	struct swiss_table_view view[2];
+	uint32_t view_count;
+	/** View being read. */
+	uint32_t view_pos;
+	/** Position of the next slot to examine in the view. */
+	uint32_t pos;
+	/** Buffer for data of compressed tuples. */
+	char *buf;
+	size_t buf_size;
+};
+
+static void
+swiss_table_view_create(struct swiss_table_view *view,
+			struct swiss_table *table)
+{
+	view->table = table;
+	table->refs++;
+	view->group_count = table->group_count;
+	matras_create_read_view(&table->ctrl, &view->ctrl_view);
+	matras_create_read_view(&table->groups, &view->groups_view);
+}
+
+static void
+swiss_table_view_destroy(struct swiss_table_view *view)
+{
+	matras_destroy_read_view(&view->table->ctrl, &view->ctrl_view);
+	matras_destroy_read_view(&view->table->groups, &view->groups_view);
+	swiss_table_unref(view->table);
+}
+
+/**
+ * Destroy read view and free snapshot iterator.
+ * Virtual method of snapshot iterator.
+ * @sa index_vtab::create_snapshot_iterator.
+ */
+static void
+swiss_snapshot_iterator_free(struct snapshot_iterator *iterator)
+{
+	assert(iterator->free == swiss_snapshot_iterator_free);
+	struct swiss_snapshot_iterator *it =
+		(struct swiss_snapshot_iterator *) iterator;
+	for (uint32_t i = 0; i < it->view_count; i++)
+		swiss_table_view_destroy(&it->view[i]);
+	free(it->buf);
+	free(iterator);
+}
+
+/**
+ * Get next tuple from snapshot iterator.
+ * Virtual method of snapshot iterator.
+ * @sa index_vtab::create_snapshot_iterator.
+ */
+static const char *
+swiss_snapshot_iterator_next(struct snapshot_iterator *iterator,
+			     uint32_t *size)
+{
+	assert(iterator->free == swiss_snapshot_iterator_free);
+	struct swiss_snapshot_iterator *it =
+		(struct swiss_snapshot_iterator *) iterator;
+	for (; it->view_pos < it->view_count; it->view_pos++, it->pos = 0) {
+		struct swiss_table_view *view = &it->view[it->view_pos];
+		struct swiss_table *table = view->table;
+		while (it->pos < view->group_count * SWISS_GROUP_SIZE) {
+			uint32_t group = it->pos / SWISS_GROUP_SIZE;
+			uint32_t i = it->pos % SWISS_GROUP_SIZE;
+			it->pos++;
+			struct swiss_ctrl *ctrl = matras_view_get(
+				&table->ctrl, &view->ctrl_view, group);
+			if (ctrl->byte[i] < 0)
+				continue;
+			struct swiss_group *g = matras_view_get(
+				&table->groups, &view->groups_view, group);
+			return tuple_data_range_to(g->slot[i].tuple, &it->buf,
+						   &it->buf_size, size);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Create an ALL iterator with personal read view so further
+ * index modifications will not affect the iteration results.
+ * Must be destroyed by iterator->free after usage.
+ */
+static struct snapshot_iterator *
+memtx_swiss_index_create_snapshot_iterator(struct index *base)
+{
+	struct memtx_swiss_index *index = (struct memtx_swiss_index *)base;
+	struct swiss_snapshot_iterator *it = (struct swiss_snapshot_iterator *)
+		calloc(1, sizeof(*it));
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(struct swiss_snapshot_iterator),
+			 "memtx_swiss_index", "iterator");
+		return NULL;
+	}
+
+	it->base.next = swiss_snapshot_iterator_next;
+	it->base.free = swiss_snapshot_iterator_free;
+	/*
+	 * A tuple is stored in exactly one of the tables, so
+	 * reading both of them yields every tuple once.
+	 */
+	swiss_table_view_create(&it->view[it->view_count++], index->table);
+	if (index->old_table != NULL) {
+		swiss_table_view_create(&it->view[it->view_count++],
+					index->old_table);
+	}
+	return (struct snapshot_iterator *) it;
+}
+
+static const struct index_vtab memtx_swiss_index_vtab = {
+	/* .destroy = */ memtx_swiss_index_destroy,
+	/* .commit_create = */ generic_index_commit_create,
+	/* .abort_create = */ generic_index_abort_create,
+	/* .commit_modify = */ generic_index_commit_modify,
+	/* .commit_drop = */ generic_index_commit_drop,
+	/* .update_def = */ generic_index_update_def,
+	/* .depends_on_pk = */ generic_index_depends_on_pk,
+	/* .def_change_requires_rebuild = */
+		memtx_index_def_change_requires_rebuild,
+	/* .size = */ memtx_swiss_index_size,
+	/* .bsize = */ memtx_swiss_index_bsize,
+	/* .min = */ generic_index_min,
+	/* .max = */ generic_index_max,
+	/* .random = */ memtx_swiss_index_random,
+	/* .count = */ memtx_swiss_index_count,
+	/* .get = */ memtx_swiss_index_get,
+	/* .get_many = */ memtx_swiss_index_get_many,
+	/* .replace = */ memtx_swiss_index_replace,
+	/* .create_iterator = */ memtx_swiss_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
+	/* .create_snapshot_iterator = */
+		memtx_swiss_index_create_snapshot_iterator,
+	/* .stat = */ generic_index_stat,
+	/* .compact = */ generic_index_compact,
+	/* .reset_stat = */ generic_index_reset_stat,
+	/* .begin_build = */ generic_index_begin_build,
+	/* .reserve = */ memtx_swiss_index_reserve,
+	/* .build_next = */ generic_index_build_next,
+	/* .end_build = */ generic_index_end_build,
+};
+
+struct index *
+memtx_swiss_index_new(struct memtx_engine *memtx, struct index_def *def)
+{
+	struct memtx_swiss_index *index =
+		(struct memtx_swiss_index *)calloc(1, sizeof(*index));
+	if (index == NULL) {
+		diag_set(OutOfMemory, sizeof(*index),
+			 "malloc", "struct memtx_swiss_index");
+		return NULL;
+	}
+	index->table = swiss_table_new(memtx, 1);
+	if (index->table == NULL) {
+		free(index);
+		return NULL;
+	}
+	if (swiss_table_alloc(index->table, 1) != 0) {
+		swiss_table_unref(index->table);
+		free(index);
+		return NULL;
+	}
+	if (index_create(&index->base, (struct engine *)memtx,
+			 &memtx_swiss_index_vtab, def) != 0) {
+		swiss_table_unref(index->table);
+		free(index);
+		return NULL;
+	}
+	return &index->base;
+}
+
+/* }}} */
@@ -36,6 +36,7 @@
 #include "memory.h"
 #include "fiber.h"
 #include "tuple.h"
+#include "port.h"
 #include <third_party/qsort_arg.h>
 #include <small/mempool.h>
 
@@ -47,20 +48,207 @@ struct memtx_tree_key_data {
 	const char *key;
 	/** Number of msgpacked search fields. */
 	uint32_t part_count;
-	/** Comparison hint, see tuple_hint(). */
+	/** Comparison hint, see memtx_tree_key_hint(). */
 	hint_t hint;
 };
 
+/**
+ * Number of bits of a packed BPS tree element used for storing a
+ * tuple pointer. Tuples are normally aligned by 4 bytes and user
+ * space addresses don't exceed 2^48, so the two lowest and the 16
+ * highest bits of a pointer are omitted. A tuple that doesn't
+ * meet these conditions is stored unpacked, without a hint, see
+ * MEMTX_TREE_UNPACKED.
+ */
+#define MEMTX_TREE_TUPLE_BITS 46
+/** Alignment of a tuple pointer, see MEMTX_TREE_TUPLE_BITS. */
+#define MEMTX_TREE_TUPLE_SHIFT 2
+/**
+ * The highest bit of a BPS tree element is set if the element
+ * stores a raw tuple pointer in the remaining bits and no hint.
+ */
+#define MEMTX_TREE_UNPACKED (1ULL << 63)
+/** Number of bits of a BPS tree element used for storing a hint. */
+#define MEMTX_TREE_HINT_BITS (63 - MEMTX_TREE_TUPLE_BITS)
+/**
+ * Max number of entries a tuple may have in a multikey index:
+ * for multikey indexes the hint bits store the index of the
+ * key in the multikey array.
+ */
+#define MEMTX_TREE_MULTIKEY_MAX (1U << MEMTX_TREE_HINT_BITS)
+
 /**
  * Struct that is used as a elem in BPS tree definition.
+ *
+ * Since an index may have tens of millions of elements, it is
+ * important to keep them small, so a tuple pointer and a hint
+ * are packed in one 64-bit word: the low MEMTX_TREE_TUPLE_BITS
+ * store the tuple pointer, the rest but the highest bit is taken
+ * by the hint shrunk with hint_pack(). A shrunk hint is less
+ * selective, but it is still good enough to avoid most tuple
+ * comparisons.
  */
 struct memtx_tree_data {
-	/* Tuple that this node is represents. */
-	struct tuple *tuple;
-	/** Comparison hint, see key_hint(). */
-	hint_t hint;
+	/** Tuple and comparison hint, see memtx_tree_data_create(). */
+	uint64_t word;
 };
 
+static_assert(sizeof(struct memtx_tree_data) == sizeof(uint64_t),
+	      "memtx_tree_data must be packed into 8 bytes");
+
+/** Create a BPS tree element that refers to no tuple. */
+static inline void
+memtx_tree_data_clear(struct memtx_tree_data *data)
+{
+	data->word = 0;
+}
+
+/**
+ * Return true if a tuple pointer can be packed in a BPS tree
+ * element along with a hint, see MEMTX_TREE_TUPLE_BITS.
+ */
+static inline bool
+memtx_tree_tuple_is_packable(struct tuple *tuple)
+{
+	uint64_t ptr = (uintptr_t)tuple;
+	return ptr % (1 << MEMTX_TREE_TUPLE_SHIFT) == 0 &&
+	       (ptr >> (MEMTX_TREE_TUPLE_BITS + MEMTX_TREE_TUPLE_SHIFT)) == 0;
+}
+
+/**
+ * Create a BPS tree element. For a multikey index, the hint must
+ * be the index of the key in the multikey array, for other indexes
+ * it must be a tuple hint, see tuple_hint(). A multikey index can't
+ * store a tuple that is not packable, see memtx_tree_check_multikey().
+ */
+static inline void
+memtx_tree_data_create(struct memtx_tree_data *data, struct tuple *tuple,
+		       hint_t hint, struct key_def *cmp_def)
+{
+	uint64_t ptr = (uintptr_t)tuple;
+	if (!memtx_tree_tuple_is_packable(tuple)) {
+		assert(!key_def_is_multikey(cmp_def));
+		if ((ptr & MEMTX_TREE_UNPACKED) != 0)
+			panic("tuple address %p is out of range", tuple);
+		data->word = MEMTX_TREE_UNPACKED | ptr;
+		return;
+	}
+	ptr >>= MEMTX_TREE_TUPLE_SHIFT;
+	uint64_t packed;
+	if (key_def_is_multikey(cmp_def)) {
+		assert(hint < MEMTX_TREE_MULTIKEY_MAX);
+		packed = hint;
+	} else {
+		packed = hint_pack(hint, MEMTX_TREE_HINT_BITS);
+	}
+	data->word = packed << MEMTX_TREE_TUPLE_BITS | ptr;
+}
+
+/** Return the tuple a BPS tree element refers to. */
+static inline struct tuple *
+memtx_tree_data_tuple(const struct memtx_tree_data *data)
+{
+	if ((data->word & MEMTX_TREE_UNPACKED) != 0) {
+		uint64_t ptr = data->word & ~MEMTX_TREE_UNPACKED;
+		return (struct tuple *)(uintptr_t)ptr;
+	}
+	uint64_t ptr = data->word & ((1ULL << MEMTX_TREE_TUPLE_BITS) - 1);
+	return (struct tuple *)(uintptr_t)(ptr << MEMTX_TREE_TUPLE_SHIFT);
+}
+
+/**
+ * Return the hint stored in a BPS tree element. For a multikey
+ * index it's the index of the key in the multikey array. For other
+ * indexes it's the tuple hint passed to memtx_tree_data_create()
+ * after going through hint_pack() and hint_unpack() or HINT_NONE
+ * if the element is unpacked.
+ */
+static inline hint_t
+memtx_tree_data_hint(const struct memtx_tree_data *data,
+		     struct key_def *cmp_def)
+{
+	if ((data->word & MEMTX_TREE_UNPACKED) != 0)
+		return HINT_NONE;
+	uint32_t packed = data->word >> MEMTX_TREE_TUPLE_BITS;
+	if (key_def_is_multikey(cmp_def))
+		return packed;
+	return hint_unpack(packed, MEMTX_TREE_HINT_BITS);
+}
+
+/**
+ * Compute the hint of a search key. Since hints stored in the tree
+ * are shrunk, so must be key hints, see hint_pack().
+ */
+static inline hint_t
+memtx_tree_key_hint(const char *key, uint32_t part_count,
+		    struct key_def *cmp_def)
+{
+	hint_t hint = key_hint(key, part_count, cmp_def);
+	if (key_def_is_multikey(cmp_def))
+		return hint;
+	return hint_unpack(hint_pack(hint, MEMTX_TREE_HINT_BITS),
+			   MEMTX_TREE_HINT_BITS);
+}
+
+static inline int
+memtx_tree_data_compare(const struct memtx_tree_data *a,
+			const struct memtx_tree_data *b,
+			struct key_def *cmp_def)
+{
+	return tuple_compare(memtx_tree_data_tuple(a),
+			     memtx_tree_data_hint(a, cmp_def),
+			     memtx_tree_data_tuple(b),
+			     memtx_tree_data_hint(b, cmp_def), cmp_def);
+}
+
+static inline int
+memtx_tree_data_compare_with_key(const struct memtx_tree_data *a,
+				 const struct memtx_tree_key_data *key,
+				 struct key_def *cmp_def)
+{
+	return tuple_compare_with_key(memtx_tree_data_tuple(a),
+				      memtx_tree_data_hint(a, cmp_def),
+				      key->key, key->part_count, key->hint,
+				      cmp_def);
+}
+
+/**
+ * Compare a BPS tree element with a search key when a tree view
+ * is read by a thread other than tx, see memtx_tree_index_view.
+ * Unlike memtx_tree_data_compare_with_key(), it doesn't use the
+ * tuple format, which belongs to tx and may be gone by the time,
+ * but extracts the key from the tuple data. Both the key and the
+ * key definition are those of the view, @a key->key includes the
+ * MessagePack array header.
+ */
+static inline int
+memtx_tree_view_compare_with_key(const struct memtx_tree_data *a,
+				 const struct memtx_tree_key_data *key,
+				 struct key_def *key_def)
+{
+	struct tuple *tuple = memtx_tree_data_tuple(a);
+	/*
+	 * Indexed fields of a compressed tuple are stored
+	 * uncompressed, see struct tuple_compressed.
+	 */
+	const char *data = (const char *)tuple + tuple->data_offset;
+	const char *data_end = data + (tuple->is_compressed ?
+				       tuple_compressed(tuple)->prefix_size :
+				       tuple->bsize);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	const char *tuple_key = tuple_extract_key_raw(data, data_end, key_def,
+						      MULTIKEY_NONE, NULL);
+	if (tuple_key == NULL) {
+		diag_log();
+		panic("failed to extract a tuple key");
+	}
+	int rc = key_compare(tuple_key, HINT_NONE, key->key, HINT_NONE,
+			     key_def);
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 /**
  * Test whether BPS tree elements are identical i.e. represent
  * the same tuple at the same position in the tree.
@@ -73,21 +261,22 @@ static bool
 memtx_tree_data_identical(const struct memtx_tree_data *a,
 			  const struct memtx_tree_data *b)
 {
-	return a->tuple == b->tuple && a->hint == b->hint;
+	return a->word == b->word;
 }
 
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
-#define BPS_TREE_COMPARE(a, b, arg)\
-	tuple_compare((&a)->tuple, (&a)->hint, (&b)->tuple, (&b)->hint, arg)
+#define BPS_TREE_COMPARE(a, b, arg) memtx_tree_data_compare(&(a), &(b), arg)
 #define BPS_TREE_COMPARE_KEY(a, b, arg)\
-	tuple_compare_with_key((&a)->tuple, (&a)->hint, (b)->key,\
-			       (b)->part_count, (b)->hint, arg)
+	memtx_tree_data_compare_with_key(&(a), b, arg)
+#define BPS_TREE_VIEW_COMPARE_KEY(a, b, arg)\
+	memtx_tree_view_compare_with_key(&(a), b, arg)
 #define BPS_TREE_IDENTICAL(a, b) memtx_tree_data_identical(&a, &b)
 #define bps_tree_elem_t struct memtx_tree_data
 #define bps_tree_key_t struct memtx_tree_key_data *
 #define bps_tree_arg_t struct key_def *
+#define BPS_INNER_CARD
 
 #include "salad/bps_tree.h"
 
@@ -96,16 +285,20 @@ memtx_tree_data_identical(const struct memtx_tree_data *a,
 #undef BPS_TREE_EXTENT_SIZE
 #undef BPS_TREE_COMPARE
 #undef BPS_TREE_COMPARE_KEY
+#undef BPS_TREE_VIEW_COMPARE_KEY
 #undef BPS_TREE_IDENTICAL
 #undef bps_tree_elem_t
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
+#undef BPS_INNER_CARD
 
 struct memtx_tree_index {
 	struct index base;
 	struct memtx_tree tree;
 	struct memtx_tree_data *build_array;
 	size_t build_array_size, build_array_alloc_size;
+	/** Set if build_array has been sorted in advance. */
+	bool build_array_is_sorted;
 	struct memtx_gc_task gc_task;
 	struct memtx_tree_iterator gc_iterator;
 };
@@ -121,11 +314,29 @@ memtx_tree_cmp_def(struct memtx_tree *tree)
 static int
 memtx_tree_qcompare(const void* a, const void *b, void *c)
 {
-	const struct memtx_tree_data *data_a = a;
-	const struct memtx_tree_data *data_b = b;
-	struct key_def *key_def = c;
-	return tuple_compare(data_a->tuple, data_a->hint, data_b->tuple,
-			     data_b->hint, key_def);
+	return memtx_tree_data_compare(a, b, c);
+}
+
+/**
+ * Check that all entries of a tuple in a multikey index can be
+ * stored in the tree, see MEMTX_TREE_MULTIKEY_MAX. The multikey
+ * array index takes the place of the hint, so the tuple must be
+ * packable, see memtx_tree_tuple_is_packable().
+ */
+static int
+memtx_tree_check_multikey(struct tuple *tuple, uint32_t multikey_count)
+{
+	if (!memtx_tree_tuple_is_packable(tuple)) {
+		diag_set(ClientError, ER_UNSUPPORTED, "Multikey index",
+			 tt_sprintf("tuple address %p", tuple));
+		return -1;
+	}
+	if (multikey_count <= MEMTX_TREE_MULTIKEY_MAX)
+		return 0;
+	diag_set(ClientError, ER_UNSUPPORTED, "Multikey index",
+		 tt_sprintf("arrays of more than %u elements",
+			    (unsigned)MEMTX_TREE_MULTIKEY_MAX));
+	return -1;
 }
 
 /* {{{ MemtxTree Iterators ****************************************/
@@ -135,6 +346,8 @@ struct tree_iterator {
 	struct index_def *index_def;
 	struct memtx_tree_iterator tree_iterator;
 	enum iterator_type type;
+	/** Number of tuples to skip on start. */
+	uint32_t offset;
 	struct memtx_tree_key_data key_data;
 	struct memtx_tree_data current;
 	/** Memory pool the iterator was allocated from. */
@@ -159,7 +372,7 @@ static void
 tree_iterator_free(struct iterator *iterator)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	struct tuple *tuple = it->current.tuple;
+	struct tuple *tuple = memtx_tree_data_tuple(&it->current);
 	if (tuple != NULL)
 		tuple_unref(tuple);
 	mempool_free(it->pool, it);
@@ -177,7 +390,7 @@ static int
 tree_iterator_next(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current.tuple != NULL);
+	assert(memtx_tree_data_tuple(&it->current) != NULL);
 	struct memtx_tree_data *check =
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (check == NULL || !memtx_tree_data_identical(check, &it->current)) {
@@ -187,15 +400,15 @@ tree_iterator_next(struct iterator *iterator, struct tuple **ret)
 	} else {
 		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
 	}
-	tuple_unref(it->current.tuple);
+	tuple_unref(memtx_tree_data_tuple(&it->current));
 	struct memtx_tree_data *res =
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (res == NULL) {
 		iterator->next = tree_iterator_dummie;
-		it->current.tuple = NULL;
+		memtx_tree_data_clear(&it->current);
 		*ret = NULL;
 	} else {
-		*ret = res->tuple;
+		*ret = memtx_tree_data_tuple(res);
 		tuple_ref(*ret);
 		it->current = *res;
 	}
@@ -206,7 +419,7 @@ static int
 tree_iterator_prev(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current.tuple != NULL);
+	assert(memtx_tree_data_tuple(&it->current) != NULL);
 	struct memtx_tree_data *check =
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (check == NULL || !memtx_tree_data_identical(check, &it->current)) {
@@ -214,15 +427,15 @@ tree_iterator_prev(struct iterator *iterator, struct tuple **ret)
 			memtx_tree_lower_bound_elem(it->tree, it->current, NULL);
 	}
 	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current.tuple);
+	tuple_unref(memtx_tree_data_tuple(&it->current));
 	struct memtx_tree_data *res =
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res) {
 		iterator->next = tree_iterator_dummie;
-		it->current.tuple = NULL;
+		memtx_tree_data_clear(&it->current);
 		*ret = NULL;
 	} else {
-		*ret = res->tuple;
+		*ret = memtx_tree_data_tuple(res);
 		tuple_ref(*ret);
 		it->current = *res;
 	}
@@ -233,7 +446,7 @@ static int
 tree_iterator_next_equal(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current.tuple != NULL);
+	assert(memtx_tree_data_tuple(&it->current) != NULL);
 	struct memtx_tree_data *check =
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (check == NULL || !memtx_tree_data_identical(check, &it->current)) {
@@ -242,21 +455,18 @@ tree_iterator_next_equal(struct iterator *iterator, struct tuple **ret)
 	} else {
 		memtx_tree_iterator_next(it->tree, &it->tree_iterator);
 	}
-	tuple_unref(it->current.tuple);
+	tuple_unref(memtx_tree_data_tuple(&it->current));
 	struct memtx_tree_data *res =
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	/* Use user key def to save a few loops. */
 	if (res == NULL ||
-	    tuple_compare_with_key(res->tuple, res->hint,
-				   it->key_data.key,
-				   it->key_data.part_count,
-				   it->key_data.hint,
-				   it->index_def->key_def) != 0) {
+	    memtx_tree_data_compare_with_key(res, &it->key_data,
+					     it->index_def->key_def) != 0) {
 		iterator->next = tree_iterator_dummie;
-		it->current.tuple = NULL;
+		memtx_tree_data_clear(&it->current);
 		*ret = NULL;
 	} else {
-		*ret = res->tuple;
+		*ret = memtx_tree_data_tuple(res);
 		tuple_ref(*ret);
 		it->current = *res;
 	}
@@ -267,7 +477,7 @@ static int
 tree_iterator_prev_equal(struct iterator *iterator, struct tuple **ret)
 {
 	struct tree_iterator *it = tree_iterator(iterator);
-	assert(it->current.tuple != NULL);
+	assert(memtx_tree_data_tuple(&it->current) != NULL);
 	struct memtx_tree_data *check =
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (check == NULL || !memtx_tree_data_identical(check, &it->current)) {
@@ -275,21 +485,18 @@ tree_iterator_prev_equal(struct iterator *iterator, struct tuple **ret)
 			memtx_tree_lower_bound_elem(it->tree, it->current, NULL);
 	}
 	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	tuple_unref(it->current.tuple);
+	tuple_unref(memtx_tree_data_tuple(&it->current));
 	struct memtx_tree_data *res =
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	/* Use user key def to save a few loops. */
 	if (res == NULL ||
-	    tuple_compare_with_key(res->tuple, res->hint,
-				   it->key_data.key,
-				   it->key_data.part_count,
-				   it->key_data.hint,
-				   it->index_def->key_def) != 0) {
+	    memtx_tree_data_compare_with_key(res, &it->key_data,
+					     it->index_def->key_def) != 0) {
 		iterator->next = tree_iterator_dummie;
-		it->current.tuple = NULL;
+		memtx_tree_data_clear(&it->current);
 		*ret = NULL;
 	} else {
-		*ret = res->tuple;
+		*ret = memtx_tree_data_tuple(res);
 		tuple_ref(*ret);
 		it->current = *res;
 	}
@@ -299,7 +506,7 @@ tree_iterator_prev_equal(struct iterator *iterator, struct tuple **ret)
 static void
 tree_iterator_set_next_method(struct tree_iterator *it)
 {
-	assert(it->current.tuple != NULL);
+	assert(memtx_tree_data_tuple(&it->current) != NULL);
 	switch (it->type) {
 	case ITER_EQ:
 		it->base.next = tree_iterator_next_equal;
@@ -324,6 +531,48 @@ tree_iterator_set_next_method(struct tree_iterator *it)
 	}
 }
 
+/**
+ * Position the iterator to the first tuple that is to be
+ * returned after skipping it->offset tuples of the result set.
+ * Uses subtree cardinalities of the tree, so it doesn't depend
+ * on the offset value. Return false if the result set is empty.
+ */
+static bool
+tree_iterator_start_at_offset(struct tree_iterator *it)
+{
+	const struct memtx_tree *tree = it->tree;
+	enum iterator_type type = it->type;
+	size_t size = memtx_tree_size(tree);
+	size_t pos;
+	if (it->key_data.key == NULL) {
+		pos = iterator_type_is_reverse(type) ? size : 0;
+	} else if (type == ITER_ALL || type == ITER_EQ ||
+		   type == ITER_GE || type == ITER_LT) {
+		memtx_tree_lower_bound_get_offset(tree, &it->key_data,
+						  NULL, &pos);
+	} else { // ITER_GT, ITER_REQ, ITER_LE
+		memtx_tree_upper_bound_get_offset(tree, &it->key_data,
+						  NULL, &pos);
+	}
+	if (iterator_type_is_reverse(type)) {
+		/* pos is the number of tuples before the result set end. */
+		if (pos <= it->offset)
+			return false;
+		pos -= it->offset + 1;
+	} else {
+		pos += it->offset;
+	}
+	it->tree_iterator = memtx_tree_iterator_at(tree, pos);
+	if (it->key_data.key == NULL || (type != ITER_EQ && type != ITER_REQ))
+		return true;
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(tree, &it->tree_iterator);
+	/* The offset may lead us out of the equal range. */
+	return res != NULL &&
+	       memtx_tree_data_compare_with_key(res, &it->key_data,
+						it->index_def->key_def) == 0;
+}
+
 static int
 tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 {
@@ -333,8 +582,11 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 	const struct memtx_tree *tree = it->tree;
 	enum iterator_type type = it->type;
 	bool exact = false;
-	assert(it->current.tuple == NULL);
-	if (it->key_data.key == 0) {
+	assert(memtx_tree_data_tuple(&it->current) == NULL);
+	if (it->offset != 0) {
+		if (!tree_iterator_start_at_offset(it))
+			return 0;
+	} else if (it->key_data.key == 0) {
 		if (iterator_type_is_reverse(it->type))
 			it->tree_iterator = memtx_tree_iterator_last(tree);
 		else
@@ -374,7 +626,7 @@ tree_iterator_start(struct iterator *iterator, struct tuple **ret)
 		memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	*ret = res->tuple;
+	*ret = memtx_tree_data_tuple(res);
 	tuple_ref(*ret);
 	it->current = *res;
 	tree_iterator_set_next_method(it);
@@ -416,7 +668,7 @@ memtx_tree_index_gc_run(struct memtx_gc_task *task, bool *done)
 		struct memtx_tree_data *res =
 			memtx_tree_iterator_get_elem(tree, itr);
 		memtx_tree_iterator_next(tree, itr);
-		tuple_unref(res->tuple);
+		tuple_unref(memtx_tree_data_tuple(res));
 		if (++loops >= YIELD_LOOPS) {
 			*done = false;
 			return;
@@ -503,7 +755,7 @@ memtx_tree_index_random(struct index *base, uint32_t rnd, struct tuple **result)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	struct memtx_tree_data *res = memtx_tree_random(&index->tree, rnd);
-	*result = res != NULL ? res->tuple : NULL;
+	*result = res != NULL ? memtx_tree_data_tuple(res) : NULL;
 	return 0;
 }
 
@@ -511,9 +763,47 @@ static ssize_t
 memtx_tree_index_count(struct index *base, enum iterator_type type,
 		       const char *key, uint32_t part_count)
 {
-	if (type == ITER_ALL)
+	if (type > ITER_GT) {
+		diag_set(UnsupportedIndexFeature, base->def,
+			 "requested iterator type");
+		return -1;
+	}
+	if (type == ITER_ALL || part_count == 0)
 		return memtx_tree_index_size(base); /* optimization */
-	return generic_index_count(base, type, key, part_count);
+	/*
+	 * The tree maintains subtree cardinalities, so the number
+	 * of tuples in any range is a difference of two offsets.
+	 */
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	struct memtx_tree_key_data key_data;
+	key_data.key = key;
+	key_data.part_count = part_count;
+	key_data.hint = memtx_tree_key_hint(key, part_count, cmp_def);
+	size_t size = memtx_tree_size(&index->tree);
+	size_t lower = 0, upper = 0;
+	if (type != ITER_GT && type != ITER_LE)
+		memtx_tree_lower_bound_get_offset(&index->tree, &key_data,
+						  NULL, &lower);
+	if (type != ITER_GE && type != ITER_LT)
+		memtx_tree_upper_bound_get_offset(&index->tree, &key_data,
+						  NULL, &upper);
+	switch (type) {
+	case ITER_EQ:
+	case ITER_REQ:
+		return upper - lower;
+	case ITER_GE:
+		return size - lower;
+	case ITER_GT:
+		return size - upper;
+	case ITER_LE:
+		return upper;
+	case ITER_LT:
+		return lower;
+	default:
+		unreachable();
+	}
+	return 0;
 }
 
 static int
@@ -527,12 +817,94 @@ memtx_tree_index_get(struct index *base, const char *key,
 	struct memtx_tree_key_data key_data;
 	key_data.key = key;
 	key_data.part_count = part_count;
-	key_data.hint = key_hint(key, part_count, cmp_def);
+	key_data.hint = memtx_tree_key_hint(key, part_count, cmp_def);
 	struct memtx_tree_data *res = memtx_tree_find(&index->tree, &key_data);
-	*result = res != NULL ? res->tuple : NULL;
+	*result = res != NULL ? memtx_tree_data_tuple(res) : NULL;
 	return 0;
 }
 
+/** A key of a batched lookup, see memtx_tree_index_get_many(). */
+struct memtx_tree_batch_key {
+	/** Key passed to the tree. */
+	struct memtx_tree_key_data key_data;
+	/** Key with the MessagePack array header. */
+	const char *raw;
+	/** Tree element found by the key or NULL. */
+	struct memtx_tree_data *found;
+};
+
+static int
+memtx_tree_batch_key_cmp(const void *a, const void *b, void *arg)
+{
+	const struct memtx_tree_batch_key *key_a = container_of(
+		*(struct memtx_tree_key_data * const *)a,
+		struct memtx_tree_batch_key, key_data);
+	const struct memtx_tree_batch_key *key_b = container_of(
+		*(struct memtx_tree_key_data * const *)b,
+		struct memtx_tree_batch_key, key_data);
+	return key_compare(key_a->raw, key_a->key_data.hint,
+			   key_b->raw, key_b->key_data.hint,
+			   (struct key_def *)arg);
+}
+
+static int
+memtx_tree_index_get_many(struct index *base, const char **keys,
+			  uint32_t key_count, struct port *port)
+{
+	assert(base->def->opts.is_unique);
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = key_count * (sizeof(struct memtx_tree_batch_key) +
+				   sizeof(struct memtx_tree_key_data *) +
+				   sizeof(struct memtx_tree_data *));
+	struct memtx_tree_batch_key *batch = region_aligned_alloc(region, size,
+					alignof(struct memtx_tree_batch_key));
+	if (batch == NULL) {
+		diag_set(OutOfMemory, size, "region", "get_many");
+		return -1;
+	}
+	struct memtx_tree_key_data **sorted =
+		(struct memtx_tree_key_data **)(batch + key_count);
+	struct memtx_tree_data **found =
+		(struct memtx_tree_data **)(sorted + key_count);
+	for (uint32_t i = 0; i < key_count; i++) {
+		const char *key = keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		assert(part_count == base->def->key_def->part_count);
+		batch[i].key_data.key = key;
+		batch[i].key_data.part_count = part_count;
+		batch[i].key_data.hint = memtx_tree_key_hint(key, part_count,
+							     cmp_def);
+		batch[i].raw = keys[i];
+		sorted[i] = &batch[i].key_data;
+	}
+	/*
+	 * Sorted keys share the upper levels of their paths
+	 * in the tree so the batched descent touches fewer
+	 * distinct blocks.
+	 */
+	qsort_arg(sorted, key_count, sizeof(sorted[0]),
+		  memtx_tree_batch_key_cmp, cmp_def);
+	memtx_tree_find_batch(&index->tree, sorted, key_count, found);
+	for (uint32_t i = 0; i < key_count; i++) {
+		container_of(sorted[i], struct memtx_tree_batch_key,
+			     key_data)->found = found[i];
+	}
+	int rc = 0;
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (batch[i].found != NULL &&
+		    port_tuple_add(port,
+				   memtx_tree_data_tuple(batch[i].found)) != 0) {
+			rc = -1;
+			break;
+		}
+	}
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 static int
 memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			 struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -542,10 +914,10 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	if (new_tuple) {
 		struct memtx_tree_data new_data;
-		new_data.tuple = new_tuple;
-		new_data.hint = tuple_hint(new_tuple, cmp_def);
+		memtx_tree_data_create(&new_data, new_tuple,
+				       tuple_hint(new_tuple, cmp_def), cmp_def);
 		struct memtx_tree_data dup_data;
-		dup_data.tuple = NULL;
+		memtx_tree_data_clear(&dup_data);
 
 		/* Try to optimistically replace the new_tuple. */
 		int tree_res = memtx_tree_insert(&index->tree, new_data,
@@ -556,11 +928,12 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 			return -1;
 		}
 
+		struct tuple *dup_tuple = memtx_tree_data_tuple(&dup_data);
 		uint32_t errcode = replace_check_dup(old_tuple,
-						     dup_data.tuple, mode);
+						     dup_tuple, mode);
 		if (errcode) {
 			memtx_tree_delete(&index->tree, new_data);
-			if (dup_data.tuple != NULL)
+			if (dup_tuple != NULL)
 				memtx_tree_insert(&index->tree, dup_data, NULL);
 			struct space *sp = space_cache_find(base->def->space_id);
 			if (sp != NULL)
@@ -568,15 +941,15 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 					 space_name(sp));
 			return -1;
 		}
-		if (dup_data.tuple != NULL) {
-			*result = dup_data.tuple;
+		if (dup_tuple != NULL) {
+			*result = dup_tuple;
 			return 0;
 		}
 	}
 	if (old_tuple) {
 		struct memtx_tree_data old_data;
-		old_data.tuple = old_tuple;
-		old_data.hint = tuple_hint(old_tuple, cmp_def);
+		memtx_tree_data_create(&old_data, old_tuple,
+				       tuple_hint(old_tuple, cmp_def), cmp_def);
 		memtx_tree_delete(&index->tree, old_data);
 	}
 	*result = old_tuple;
@@ -594,28 +967,29 @@ memtx_tree_index_replace_multikey_one(struct memtx_tree_index *index,
 			enum dup_replace_mode mode, int multikey_idx,
 			struct tuple **replaced_tuple)
 {
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	struct memtx_tree_data new_data, dup_data;
-	new_data.tuple = new_tuple;
-	new_data.hint = multikey_idx;
-	dup_data.tuple = NULL;
+	memtx_tree_data_create(&new_data, new_tuple, multikey_idx, cmp_def);
+	memtx_tree_data_clear(&dup_data);
 	if (memtx_tree_insert(&index->tree, new_data, &dup_data) != 0) {
 		diag_set(OutOfMemory, MEMTX_EXTENT_SIZE, "memtx_tree_index",
 			 "replace");
 		return -1;
 	}
 	int errcode = 0;
-	if (dup_data.tuple == new_tuple) {
+	struct tuple *dup_tuple = memtx_tree_data_tuple(&dup_data);
+	if (dup_tuple == new_tuple) {
 		/*
 		 * When tuple contains the same key multiple
 		 * times, the previous key occurrence is pushed
 		 * out of the index.
 		 */
-		dup_data.tuple = NULL;
-	} else if ((errcode = replace_check_dup(old_tuple, dup_data.tuple,
+		dup_tuple = NULL;
+	} else if ((errcode = replace_check_dup(old_tuple, dup_tuple,
 					        mode)) != 0) {
 		/* Rollback replace. */
 		memtx_tree_delete(&index->tree, new_data);
-		if (dup_data.tuple != NULL)
+		if (dup_tuple != NULL)
 			memtx_tree_insert(&index->tree, dup_data, NULL);
 		struct space *sp = space_cache_find(index->base.def->space_id);
 		if (sp != NULL) {
@@ -624,7 +998,7 @@ memtx_tree_index_replace_multikey_one(struct memtx_tree_index *index,
 		}
 		return -1;
 	}
-	*replaced_tuple = dup_data.tuple;
+	*replaced_tuple = dup_tuple;
 	return 0;
 }
 
@@ -644,15 +1018,15 @@ memtx_tree_index_replace_multikey_rollback(struct memtx_tree_index *index,
 			struct tuple *new_tuple, struct tuple *replaced_tuple,
 			int err_multikey_idx)
 {
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	struct memtx_tree_data data;
 	if (replaced_tuple != NULL) {
 		/* Restore replaced tuple index occurrences. */
-		struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
-		data.tuple = replaced_tuple;
 		uint32_t multikey_count =
 			tuple_multikey_count(replaced_tuple, cmp_def);
 		for (int i = 0; (uint32_t) i < multikey_count; i++) {
-			data.hint = i;
+			memtx_tree_data_create(&data, replaced_tuple, i,
+					       cmp_def);
 			memtx_tree_insert(&index->tree, data, NULL);
 		}
 	}
@@ -660,9 +1034,8 @@ memtx_tree_index_replace_multikey_rollback(struct memtx_tree_index *index,
 	 * Rollback new_tuple insertion by multikey index
 	 * [0, multikey_idx).
 	 */
-	data.tuple = new_tuple;
 	for (int i = 0; i < err_multikey_idx; i++) {
-		data.hint = i;
+		memtx_tree_data_create(&data, new_tuple, i, cmp_def);
 		memtx_tree_delete_identical(&index->tree, data);
 	}
 }
@@ -679,6 +1052,8 @@ memtx_tree_index_replace_multikey(struct index *base, struct tuple *old_tuple,
 		int multikey_idx = 0, err = 0;
 		uint32_t multikey_count =
 			tuple_multikey_count(new_tuple, cmp_def);
+		if (memtx_tree_check_multikey(new_tuple, multikey_count) != 0)
+			return -1;
 		for (; (uint32_t) multikey_idx < multikey_count;
 		     multikey_idx++) {
 			struct tuple *replaced_tuple;
@@ -705,11 +1080,10 @@ memtx_tree_index_replace_multikey(struct index *base, struct tuple *old_tuple,
 	}
 	if (old_tuple != NULL) {
 		struct memtx_tree_data data;
-		data.tuple = old_tuple;
 		uint32_t multikey_count =
 			tuple_multikey_count(old_tuple, cmp_def);
 		for (int i = 0; (uint32_t) i < multikey_count; i++) {
-			data.hint = i;
+			memtx_tree_data_create(&data, old_tuple, i, cmp_def);
 			memtx_tree_delete_identical(&index->tree, data);
 		}
 	}
@@ -751,16 +1125,31 @@ memtx_tree_index_create_iterator(struct index *base, enum iterator_type type,
 	it->base.next = tree_iterator_start;
 	it->base.free = tree_iterator_free;
 	it->type = type;
+	it->offset = 0;
 	it->key_data.key = key;
 	it->key_data.part_count = part_count;
-	it->key_data.hint = key_hint(key, part_count, cmp_def);
+	it->key_data.hint = memtx_tree_key_hint(key, part_count, cmp_def);
 	it->index_def = base->def;
 	it->tree = &index->tree;
 	it->tree_iterator = memtx_tree_invalid_iterator();
-	it->current.tuple = NULL;
+	memtx_tree_data_clear(&it->current);
 	return (struct iterator *)it;
 }
 
+static struct iterator *
+memtx_tree_index_create_iterator_with_offset(struct index *base,
+					     enum iterator_type type,
+					     const char *key,
+					     uint32_t part_count,
+					     uint32_t offset)
+{
+	struct iterator *it = memtx_tree_index_create_iterator(base, type,
+							       key, part_count);
+	if (it != NULL)
+		tree_iterator(it)->offset = offset;
+	return it;
+}
+
 static void
 memtx_tree_index_begin_build(struct index *base)
 {
@@ -818,8 +1207,8 @@ memtx_tree_index_build_array_append(struct memtx_tree_index *index,
 	}
 	struct memtx_tree_data *elem =
 		&index->build_array[index->build_array_size++];
-	elem->tuple = tuple;
-	elem->hint = hint;
+	memtx_tree_data_create(elem, tuple, hint,
+			       memtx_tree_cmp_def(&index->tree));
 	return 0;
 }
 
@@ -838,6 +1227,8 @@ memtx_tree_index_build_next_multikey(struct index *base, struct tuple *tuple)
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	uint32_t multikey_count = tuple_multikey_count(tuple, cmp_def);
+	if (memtx_tree_check_multikey(tuple, multikey_count) != 0)
+		return -1;
 	for (uint32_t multikey_idx = 0; multikey_idx < multikey_count;
 	     multikey_idx++) {
 		if (memtx_tree_index_build_array_append(index, tuple,
@@ -858,13 +1249,10 @@ memtx_tree_index_build_array_deduplicate(struct memtx_tree_index *index)
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	size_t w_idx = 0, r_idx = 1;
 	while (r_idx < index->build_array_size) {
-		if (index->build_array[w_idx].tuple !=
-		    index->build_array[r_idx].tuple ||
-		    tuple_compare(index->build_array[w_idx].tuple,
-				  index->build_array[w_idx].hint,
-				  index->build_array[r_idx].tuple,
-				  index->build_array[r_idx].hint,
-				  cmp_def) != 0) {
+		struct memtx_tree_data *w = &index->build_array[w_idx];
+		struct memtx_tree_data *r = &index->build_array[r_idx];
+		if (memtx_tree_data_tuple(w) != memtx_tree_data_tuple(r) ||
+		    memtx_tree_data_compare(w, r, cmp_def) != 0) {
 			/* Do not override the element itself. */
 			if (++w_idx == r_idx)
 				continue;
@@ -875,13 +1263,73 @@ memtx_tree_index_build_array_deduplicate(struct memtx_tree_index *index)
 	index->build_array_size = w_idx + 1;
 }
 
-static void
-memtx_tree_index_end_build(struct index *base)
+void
+memtx_tree_index_sort_build_array(struct index *base)
 {
 	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
 	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
 	qsort_arg(index->build_array, index->build_array_size,
 		  sizeof(index->build_array[0]), memtx_tree_qcompare, cmp_def);
+	index->build_array_is_sorted = true;
+}
+
+int
+memtx_tree_index_check_build_array(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	if (!base->def->opts.is_unique)
+		return 0;
+	if (!index->build_array_is_sorted)
+		memtx_tree_index_sort_build_array(base);
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	for (size_t i = 1; i < index->build_array_size; i++) {
+		struct memtx_tree_data *prev = &index->build_array[i - 1];
+		struct memtx_tree_data *curr = &index->build_array[i];
+		/* Multikey keys of the same tuple are deduplicated. */
+		if (memtx_tree_data_tuple(prev) ==
+		    memtx_tree_data_tuple(curr) ||
+		    memtx_tree_data_compare(prev, curr, cmp_def) != 0)
+			continue;
+		struct space *sp = space_cache_find(base->def->space_id);
+		if (sp != NULL)
+			diag_set(ClientError, ER_TUPLE_FOUND, base->def->name,
+				 space_name(sp));
+		return -1;
+	}
+	return 0;
+}
+
+/** Free the build array of an index. */
+static void
+memtx_tree_index_free_build_array(struct memtx_tree_index *index)
+{
+	free(index->build_array);
+	index->build_array = NULL;
+	index->build_array_size = 0;
+	index->build_array_alloc_size = 0;
+	index->build_array_is_sorted = false;
+}
+
+void
+memtx_tree_index_abort_build(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	if (base->def->iid == 0) {
+		/* Tuples are referenced by the primary index. */
+		for (size_t i = 0; i < index->build_array_size; i++)
+			tuple_unref(memtx_tree_data_tuple(
+					&index->build_array[i]));
+	}
+	memtx_tree_index_free_build_array(index);
+}
+
+static void
+memtx_tree_index_end_build(struct index *base)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	if (!index->build_array_is_sorted)
+		memtx_tree_index_sort_build_array(base);
 	if (key_def_is_multikey(cmp_def)) {
 		/*
 		 * Multikey index may have equal(in terms of
@@ -894,17 +1342,16 @@ memtx_tree_index_end_build(struct index *base)
 	}
 	memtx_tree_build(&index->tree, index->build_array,
 			 index->build_array_size);
-
-	free(index->build_array);
-	index->build_array = NULL;
-	index->build_array_size = 0;
-	index->build_array_alloc_size = 0;
+	memtx_tree_index_free_build_array(index);
 }
 
 struct tree_snapshot_iterator {
 	struct snapshot_iterator base;
 	struct memtx_tree *tree;
 	struct memtx_tree_iterator tree_iterator;
+	/** Buffer for data of compressed tuples. */
+	char *buf;
+	size_t buf_size;
 };
 
 static void
@@ -915,6 +1362,7 @@ tree_snapshot_iterator_free(struct snapshot_iterator *iterator)
 		(struct tree_snapshot_iterator *)iterator;
 	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
 	memtx_tree_iterator_destroy(tree, &it->tree_iterator);
+	free(it->buf);
 	free(iterator);
 }
 
@@ -929,7 +1377,8 @@ tree_snapshot_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
 	if (res == NULL)
 		return NULL;
 	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return tuple_data_range(res->tuple, size);
+	return tuple_data_range_to(memtx_tree_data_tuple(res), &it->buf,
+				   &it->buf_size, size);
 }
 
 /**
@@ -974,8 +1423,11 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_many = */ memtx_tree_index_get_many,
 	/* .replace = */ memtx_tree_index_replace,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		memtx_tree_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
@@ -1004,8 +1456,11 @@ static const struct index_vtab memtx_tree_index_multikey_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_many = */ memtx_tree_index_get_many,
 	/* .replace = */ memtx_tree_index_replace_multikey,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		memtx_tree_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		memtx_tree_index_create_snapshot_iterator,
 	/* .stat = */ generic_index_stat,
@@ -1017,6 +1472,136 @@ static const struct index_vtab memtx_tree_index_multikey_vtab = {
 	/* .end_build = */ memtx_tree_index_end_build,
 };
 
+/**
+ * A frozen TREE index which may be read from any thread,
+ * see memtx_tree_index_view_new().
+ */
+struct memtx_tree_index_view {
+	struct memtx_tree *tree;
+	struct memtx_tree_view view;
+};
+
+struct memtx_tree_index_view *
+memtx_tree_index_view_new(struct index *base, struct key_def *key_def)
+{
+	assert(base->vtab == &memtx_tree_index_vtab);
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct memtx_tree_index_view *view = malloc(sizeof(*view));
+	if (view == NULL) {
+		diag_set(OutOfMemory, sizeof(*view), "malloc",
+			 "struct memtx_tree_index_view");
+		return NULL;
+	}
+	view->tree = &index->tree;
+	memtx_tree_view_create(&index->tree, &view->view);
+	view->view.arg = key_def;
+	return view;
+}
+
+void
+memtx_tree_index_view_delete(struct memtx_tree_index_view *view)
+{
+	memtx_tree_view_destroy(view->tree, &view->view);
+	free(view);
+}
+
+struct tree_view_iterator {
+	struct snapshot_iterator base;
+	struct memtx_tree_index_view *view;
+	struct memtx_tree_iterator tree_iterator;
+	/** Set for reverse iterators. */
+	bool is_reverse;
+	/** Set for EQ and REQ: stop at a tuple not matching the key. */
+	bool is_eq;
+	/** Search key, with the MessagePack array header. */
+	struct memtx_tree_key_data key_data;
+	/** Buffer for data of compressed tuples. */
+	char *buf;
+	size_t buf_size;
+};
+
+static void
+tree_view_iterator_free(struct snapshot_iterator *iterator)
+{
+	assert(iterator->free == tree_view_iterator_free);
+	struct tree_view_iterator *it = (struct tree_view_iterator *)iterator;
+	free(it->buf);
+	free(it);
+}
+
+static const char *
+tree_view_iterator_next(struct snapshot_iterator *iterator, uint32_t *size)
+{
+	assert(iterator->free == tree_view_iterator_free);
+	struct tree_view_iterator *it = (struct tree_view_iterator *)iterator;
+	struct memtx_tree *tree = it->view->tree;
+	struct memtx_tree_data *res =
+		memtx_tree_iterator_get_elem(tree, &it->tree_iterator);
+	if (res == NULL)
+		return NULL;
+	if (it->is_eq &&
+	    memtx_tree_view_compare_with_key(res, &it->key_data,
+					     it->view->view.arg) != 0) {
+		it->tree_iterator = memtx_tree_invalid_iterator();
+		return NULL;
+	}
+	if (it->is_reverse)
+		memtx_tree_iterator_prev(tree, &it->tree_iterator);
+	else
+		memtx_tree_iterator_next(tree, &it->tree_iterator);
+	return tuple_data_range_to(memtx_tree_data_tuple(res), &it->buf,
+				   &it->buf_size, size);
+}
+
+struct snapshot_iterator *
+memtx_tree_index_view_create_iterator(struct memtx_tree_index_view *view,
+				      enum iterator_type type,
+				      const char *key, uint32_t part_count)
+{
+	assert(type == ITER_EQ || type == ITER_REQ ||
+	       type == ITER_GE || type == ITER_GT ||
+	       type == ITER_LE || type == ITER_LT);
+	struct tree_view_iterator *it = calloc(1, sizeof(*it));
+	if (it == NULL) {
+		diag_set(OutOfMemory, sizeof(*it), "malloc",
+			 "struct tree_view_iterator");
+		return NULL;
+	}
+	it->base.next = tree_view_iterator_next;
+	it->base.free = tree_view_iterator_free;
+	it->view = view;
+	it->is_reverse = iterator_type_is_reverse(type);
+	it->is_eq = part_count > 0 && (type == ITER_EQ || type == ITER_REQ);
+	it->key_data.key = key;
+	it->key_data.part_count = part_count;
+	it->key_data.hint = HINT_NONE;
+
+	struct memtx_tree *tree = view->tree;
+	struct memtx_tree_view *tree_view = &view->view;
+	if (part_count == 0) {
+		it->tree_iterator = it->is_reverse ?
+			memtx_tree_view_last(tree, tree_view) :
+			memtx_tree_view_first(tree, tree_view);
+		return &it->base;
+	}
+	/*
+	 * Reverse iterators start at the element preceding
+	 * the bound, like tree_iterator_start() does.
+	 */
+	bool upper = type == ITER_GT || type == ITER_REQ || type == ITER_LE;
+	it->tree_iterator = upper ?
+		memtx_tree_view_upper_bound(tree, tree_view, &it->key_data) :
+		memtx_tree_view_lower_bound(tree, tree_view, &it->key_data);
+	if (it->is_reverse) {
+		if (memtx_tree_iterator_is_invalid(&it->tree_iterator))
+			it->tree_iterator = memtx_tree_view_last(tree,
+								 tree_view);
+		else
+			memtx_tree_iterator_prev(tree, &it->tree_iterator);
+	}
+	return &it->base;
+}
+
 struct index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def)
 {
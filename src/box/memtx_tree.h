@@ -31,17 +31,77 @@
  * SUCH DAMAGE.
  */
 
+#include <stdint.h>
+#include "iterator_type.h"
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct index;
 struct index_def;
+struct key_def;
 struct memtx_engine;
+struct memtx_tree_index_view;
+struct snapshot_iterator;
 
 struct index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Sort tuples collected by build_next() of a tree index being
+ * built, so that end_build() only has to construct the tree.
+ * Touches nothing but the build array and tuples, hence may
+ * be called from a thread other than tx, provided the index
+ * isn't used concurrently.
+ */
+void
+memtx_tree_index_sort_build_array(struct index *index);
+
+/**
+ * Check that tuples collected by build_next() of a unique
+ * tree index have no duplicates, sorting them if needed.
+ * Unlike snapshot recovery, bulk load can't trust its input.
+ */
+int
+memtx_tree_index_check_build_array(struct index *index);
+
+/**
+ * Drop tuples collected by build_next() of a tree index,
+ * leaving the index empty. Tuples are unreferenced if the
+ * index is primary.
+ */
+void
+memtx_tree_index_abort_build(struct index *index);
+
+/**
+ * Freeze a tree index so that it may be read from any thread
+ * while tx goes on modifying it. @a key_def is used to compare
+ * keys instead of the index key definition and must outlive
+ * the view. Tuples of the view and the index memory must be
+ * kept alive by an open memtx read view, see
+ * memtx_engine_open_read_view(), which has to be opened before
+ * the tree is frozen and closed after the view is deleted.
+ */
+struct memtx_tree_index_view *
+memtx_tree_index_view_new(struct index *index, struct key_def *key_def);
+
+/** Delete a view created with memtx_tree_index_view_new(). */
+void
+memtx_tree_index_view_delete(struct memtx_tree_index_view *view);
+
+/**
+ * Create an iterator over a tree index view. @a key includes
+ * the MessagePack array header, @a part_count must be positive
+ * unless the iterator type is GE or LE. Data of the tuples is
+ * returned by snapshot_iterator::next(). May be called from
+ * any thread.
+ */
+struct snapshot_iterator *
+memtx_tree_index_view_create_iterator(struct memtx_tree_index_view *view,
+				      enum iterator_type type,
+				      const char *key, uint32_t part_count);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -0,0 +1,400 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "read_view.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <msgpuck.h>
+#include <small/rlist.h>
+
+#include "tt_pthread.h"
+#include "clock.h"
+#include "diag.h"
+#include "fiber.h"
+#include "say.h"
+#include "trivia/util.h"
+
+#include "box.h"
+#include "engine.h"
+#include "index.h"
+#include "iterator_type.h"
+#include "key_def.h"
+#include "memtx_engine.h"
+#include "memtx_tree.h"
+#include "schema.h"
+#include "space.h"
+#include "vclock.h"
+
+double read_view_staleness = 1;
+
+/** A space in a read view. */
+struct read_view_space {
+	uint32_t id;
+	/** A copy of the primary key definition. */
+	struct key_def *key_def;
+	/** Frozen primary key. */
+	struct memtx_tree_index_view *index;
+};
+
+struct read_view {
+	/** Reference counter, protected by read_view_mutex. */
+	int refs;
+	/** clock_monotonic() when the view was created. */
+	double timestamp;
+	/** Schema version when the view was created. */
+	uint32_t schema_version;
+	/**
+	 * Signature of the instance vclock when the view was
+	 * created. If it hasn't changed since, nothing has been
+	 * written to the spaces of the view, unless some of them
+	 * are temporary.
+	 */
+	int64_t signature;
+	/** Set if the view has a temporary space. */
+	bool has_temporary;
+	/** Spaces of the view, sorted by id. */
+	struct read_view_space *spaces;
+	uint32_t space_count;
+	/** memtx read view keeping the frozen indexes alive. */
+	struct memtx_read_view *memtx;
+	/** Link in read_view_retired. */
+	struct rlist in_retired;
+};
+
+/** The read view to serve SELECTs from. */
+static struct read_view *read_view_current;
+/**
+ * Views replaced by a newer one, which may still be used by
+ * reader threads. A view must be deleted in tx, so they are
+ * collected by the refresh fiber once unreferenced.
+ */
+static struct rlist read_view_retired;
+/** Protects read_view_current and view reference counters. */
+static pthread_mutex_t read_view_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** Fiber refreshing the read view. */
+static struct fiber *read_view_fiber;
+
+static struct memtx_engine *
+read_view_memtx(void)
+{
+	return (struct memtx_engine *)engine_by_name("memtx");
+}
+
+static void
+read_view_delete(struct read_view *rv)
+{
+	for (uint32_t i = 0; i < rv->space_count; i++) {
+		struct read_view_space *space = &rv->spaces[i];
+		if (space->index != NULL)
+			memtx_tree_index_view_delete(space->index);
+		if (space->key_def != NULL)
+			key_def_delete(space->key_def);
+	}
+	free(rv->spaces);
+	/* Indexes must be unfrozen before their memory is freed. */
+	if (rv->memtx != NULL)
+		memtx_engine_close_read_view(read_view_memtx(), rv->memtx);
+	free(rv);
+}
+
+static int
+read_view_add_space(struct space *sp, void *data)
+{
+	if (!sp->def->opts.is_read_view || !space_is_memtx(sp))
+		return 0;
+	struct index *pk = space_index(sp, 0);
+	/*
+	 * Only a TREE can be frozen and searched from other
+	 * threads, requests to other spaces are served by tx.
+	 */
+	if (pk == NULL || pk->def->type != TREE)
+		return 0;
+	struct read_view *rv = (struct read_view *)data;
+	if (space_is_temporary(sp))
+		rv->has_temporary = true;
+	struct read_view_space *spaces = realloc(rv->spaces,
+				(rv->space_count + 1) * sizeof(*spaces));
+	if (spaces == NULL) {
+		diag_set(OutOfMemory, (rv->space_count + 1) * sizeof(*spaces),
+			 "realloc", "struct read_view_space");
+		return -1;
+	}
+	rv->spaces = spaces;
+	struct read_view_space *space = &spaces[rv->space_count++];
+	memset(space, 0, sizeof(*space));
+	space->id = space_id(sp);
+	space->key_def = key_def_dup(pk->def->key_def);
+	if (space->key_def == NULL)
+		return -1;
+	space->index = memtx_tree_index_view_new(pk, space->key_def);
+	if (space->index == NULL)
+		return -1;
+	return 0;
+}
+
+static int
+read_view_space_cmp_id(const void *a, const void *b)
+{
+	const struct read_view_space *s1 = (const struct read_view_space *)a;
+	const struct read_view_space *s2 = (const struct read_view_space *)b;
+	return s1->id < s2->id ? -1 : s1->id > s2->id;
+}
+
+/** Delete retired views which aren't used any more. */
+static void
+read_view_collect(void)
+{
+	struct read_view *rv, *tmp;
+	rlist_foreach_entry_safe(rv, &read_view_retired, in_retired, tmp) {
+		tt_pthread_mutex_lock(&read_view_mutex);
+		bool is_used = rv->refs > 0;
+		tt_pthread_mutex_unlock(&read_view_mutex);
+		if (is_used)
+			continue;
+		rlist_del_entry(rv, in_retired);
+		read_view_delete(rv);
+	}
+}
+
+/** Replace the current read view, retiring the old one. */
+static void
+read_view_set_current(struct read_view *rv)
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	struct read_view *old = read_view_current;
+	read_view_current = rv;
+	if (old != NULL)
+		old->refs--;
+	tt_pthread_mutex_unlock(&read_view_mutex);
+	if (old != NULL)
+		rlist_add_tail_entry(&read_view_retired, old, in_retired);
+	read_view_collect();
+}
+
+/**
+ * Create a new read view and make it current. The primary
+ * keys of the spaces are frozen, which takes no time, so
+ * the view is created in tx, like a checkpoint is started.
+ *
+ * Nothing is done if no space is marked with the read_view
+ * option, and if nothing has been written since the current
+ * view was created: then the view is only marked fresh.
+ */
+static int
+read_view_refresh(void)
+{
+	read_view_collect();
+	int64_t signature = vclock_sum(box_vclock);
+	struct read_view *current = read_view_current;
+	if (current != NULL && current->schema_version == schema_version &&
+	    current->signature == signature && !current->has_temporary) {
+		tt_pthread_mutex_lock(&read_view_mutex);
+		current->timestamp = clock_monotonic();
+		tt_pthread_mutex_unlock(&read_view_mutex);
+		return 0;
+	}
+	struct read_view *rv = calloc(1, sizeof(*rv));
+	if (rv == NULL) {
+		diag_set(OutOfMemory, sizeof(*rv), "calloc",
+			 "struct read_view");
+		return -1;
+	}
+	rv->refs = 1;
+	rv->timestamp = clock_monotonic();
+	rv->schema_version = schema_version;
+	rv->signature = signature;
+	rv->memtx = memtx_engine_open_read_view(read_view_memtx());
+	if (rv->memtx == NULL ||
+	    space_foreach(read_view_add_space, rv) != 0) {
+		read_view_delete(rv);
+		return -1;
+	}
+	if (rv->space_count == 0) {
+		read_view_delete(rv);
+		read_view_set_current(NULL);
+		return 0;
+	}
+	qsort(rv->spaces, rv->space_count, sizeof(*rv->spaces),
+	      read_view_space_cmp_id);
+	read_view_set_current(rv);
+	return 0;
+}
+
+static int
+read_view_f(va_list ap)
+{
+	(void)ap;
+	while (!fiber_is_cancelled()) {
+		if (read_view_refresh() != 0)
+			diag_log();
+		/*
+		 * Refresh twice per staleness period so that
+		 * the view is replaced before it gets stale.
+		 */
+		fiber_sleep(read_view_staleness / 2);
+	}
+	return 0;
+}
+
+void
+read_view_init(void)
+{
+	rlist_create(&read_view_retired);
+	read_view_fiber = fiber_new("read_view", read_view_f);
+	if (read_view_fiber == NULL)
+		panic("failed to start read view fiber");
+	fiber_start(read_view_fiber);
+}
+
+/** Find a space in a read view. */
+static struct read_view_space *
+read_view_find_space(struct read_view *rv, uint32_t space_id)
+{
+	uint32_t begin = 0, end = rv->space_count;
+	while (begin < end) {
+		uint32_t mid = begin + (end - begin) / 2;
+		if (rv->spaces[mid].id == space_id)
+			return &rv->spaces[mid];
+		if (rv->spaces[mid].id < space_id)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return NULL;
+}
+
+/** Return true if the view may serve SELECTs from the space. */
+static inline bool
+read_view_is_usable(struct read_view *rv, uint32_t space_id)
+{
+	return rv != NULL &&
+	       clock_monotonic() - rv->timestamp <= read_view_staleness &&
+	       read_view_find_space(rv, space_id) != NULL;
+}
+
+struct read_view *
+read_view_acquire(uint32_t space_id)
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	struct read_view *rv = read_view_current;
+	if (read_view_is_usable(rv, space_id))
+		rv->refs++;
+	else
+		rv = NULL;
+	tt_pthread_mutex_unlock(&read_view_mutex);
+	return rv;
+}
+
+void
+read_view_release(struct read_view *rv)
+{
+	/* The view is deleted in tx, see read_view_collect(). */
+	tt_pthread_mutex_lock(&read_view_mutex);
+	assert(rv->refs > 0);
+	rv->refs--;
+	tt_pthread_mutex_unlock(&read_view_mutex);
+}
+
+bool
+read_view_has_space(uint32_t space_id)
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	bool ret = read_view_is_usable(read_view_current, space_id);
+	tt_pthread_mutex_unlock(&read_view_mutex);
+	return ret;
+}
+
+uint32_t
+read_view_schema_version(struct read_view *rv)
+{
+	return rv->schema_version;
+}
+
+int
+read_view_select(struct read_view *rv, uint32_t space_id, int iterator,
+		 uint32_t offset, uint32_t limit, const char *key,
+		 const char *key_end, char **data, size_t *size)
+{
+	(void)key_end;
+	struct read_view_space *space = read_view_find_space(rv, space_id);
+	if (space == NULL || iterator < 0 || iterator > ITER_GT)
+		return -1;
+	enum iterator_type type = (enum iterator_type)iterator;
+	const char *parts = key;
+	uint32_t part_count = key != NULL ? mp_decode_array(&parts) : 0;
+	if (part_count > space->key_def->part_count ||
+	    key_validate_parts(space->key_def, parts, part_count, true) != 0)
+		return -1;
+	if (part_count == 0)
+		type = iterator_type_is_reverse(type) ? ITER_LE : ITER_GE;
+	else if (type == ITER_ALL)
+		/* A TREE treats ALL with a key as GE. */
+		type = ITER_GE;
+	struct snapshot_iterator *it =
+		memtx_tree_index_view_create_iterator(space->index, type,
+						      key, part_count);
+	if (it == NULL)
+		return -1;
+	char *buf = NULL;
+	size_t used = 0, capacity = 0;
+	int count = 0;
+	const char *tuple;
+	uint32_t tuple_size;
+	for (uint32_t i = 0; i < offset; i++) {
+		if (it->next(it, &tuple_size) == NULL)
+			break;
+	}
+	while ((uint32_t)count < limit &&
+	       (tuple = it->next(it, &tuple_size)) != NULL) {
+		if (capacity - used < tuple_size) {
+			capacity = MAX(capacity * 2, used + tuple_size);
+			char *new_buf = realloc(buf, capacity);
+			if (new_buf == NULL) {
+				count = -1;
+				break;
+			}
+			buf = new_buf;
+		}
+		memcpy(buf + used, tuple, tuple_size);
+		used += tuple_size;
+		count++;
+	}
+	it->free(it);
+	if (count < 0) {
+		free(buf);
+		return -1;
+	}
+	*data = buf != NULL ? buf : malloc(1);
+	if (*data == NULL)
+		return -1;
+	*size = used;
+	return count;
+}
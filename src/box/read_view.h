@@ -0,0 +1,109 @@
+#ifndef TARANTOOL_BOX_READ_VIEW_H_INCLUDED
+#define TARANTOOL_BOX_READ_VIEW_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * A read view is a frozen state of the primary keys of memtx
+ * spaces created with the read_view option. Only TREE keys are
+ * frozen, other spaces are served by tx. The view is refreshed
+ * by a background fiber in tx and may be used by any thread to
+ * serve SELECTs by the primary key without touching tx data.
+ * The data may be stale, but not older than the
+ * box.cfg.read_view_staleness seconds.
+ */
+struct read_view;
+
+/** Max age of a read view, in seconds. */
+extern double read_view_staleness;
+
+/**
+ * Start refreshing the read view in the background.
+ * Called in tx once the instance has been recovered.
+ */
+void
+read_view_init(void);
+
+/**
+ * Return a reference to the current read view if it includes
+ * the space and is fresh enough, NULL otherwise. Thread-safe.
+ */
+struct read_view *
+read_view_acquire(uint32_t space_id);
+
+/**
+ * Drop a reference taken by read_view_acquire(). Thread-safe.
+ * An unused view is deleted later, in tx.
+ */
+void
+read_view_release(struct read_view *rv);
+
+/**
+ * Return true if the space is included in the current read
+ * view and the view is fresh enough. Thread-safe.
+ */
+bool
+read_view_has_space(uint32_t space_id);
+
+/** Schema version at the time the read view was created. */
+uint32_t
+read_view_schema_version(struct read_view *rv);
+
+/**
+ * Look up tuples in the read view the way box_select() does.
+ * On success, MessagePack of the tuples found is stored in
+ * a buffer allocated with malloc() and returned in @a data
+ * and @a size, the caller must free it.
+ *
+ * @retval >=0 number of tuples found.
+ * @retval -1  the request can't be served from the read view:
+ *             the key is invalid, the iterator type is not
+ *             supported, or out of memory. It should be
+ *             executed in tx instead.
+ */
+int
+read_view_select(struct read_view *rv, uint32_t space_id, int iterator,
+		 uint32_t offset, uint32_t limit, const char *key,
+		 const char *key_end, char **data, size_t *size);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_READ_VIEW_H_INCLUDED */
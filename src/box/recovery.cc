@@ -213,6 +213,14 @@ gap_error:
 	goto out;
 }
 
+void
+recovery_forget_log(struct recovery *r)
+{
+	if (xlog_cursor_is_open(&r->cursor))
+		xlog_cursor_close(&r->cursor, false);
+	r->cursor.state = XLOG_CURSOR_NEW;
+}
+
 void
 recovery_delete(struct recovery *r)
 {
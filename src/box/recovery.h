@@ -88,6 +88,16 @@ recovery_stop_local(struct recovery *r);
 void
 recovery_finalize(struct recovery *r);
 
+/**
+ * Close the current WAL without running on_close_log triggers,
+ * because the caller is going to get the rest of the rows from
+ * elsewhere. The next call to recover_remaining_wals() will look
+ * up the WAL to read by the recovery vclock as if it were the
+ * first call.
+ */
+void
+recovery_forget_log(struct recovery *r);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
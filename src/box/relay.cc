@@ -42,6 +42,7 @@
 #include "coio.h"
 #include "coio_task.h"
 #include "engine.h"
+#include "memtx_engine.h"
 #include "gc.h"
 #include "iproto_constants.h"
 #include "recovery.h"
@@ -53,6 +54,17 @@
 #include "xrow_io.h"
 #include "xstream.h"
 #include "wal.h"
+#include "zstd.h"
+
+#include <small/ibuf.h>
+
+enum {
+	/**
+	 * Max size of a chunk of rows copied out of the WAL
+	 * tail at once.
+	 */
+	RELAY_WAL_TAIL_CHUNK = 256 * 1024,
+};
 
 /**
  * Cbus message to send status updates from relay to tx thread.
@@ -101,6 +113,13 @@ struct relay {
 	struct replica *replica;
 	/** WAL event watcher. */
 	struct wal_watcher wal_watcher;
+	/**
+	 * Position of the relay in the WAL tail or -1 if the
+	 * relay reads WAL files, see relay_send_wal_tail().
+	 */
+	int64_t wal_tail_seq;
+	/** Buffer for rows copied out of the WAL tail. */
+	struct ibuf wal_tail_buf;
 	/** Relay reader cond. */
 	struct fiber_cond reader_cond;
 	/** Relay diagnostics. */
@@ -132,6 +151,28 @@ struct relay {
 	double last_row_time;
 	/** Relay sync state. */
 	enum relay_state state;
+	/** Set if the replica has asked for compressed rows. */
+	bool compression;
+	/**
+	 * Context used to compress rows sent to the replica,
+	 * NULL unless the replica has asked for compression.
+	 */
+	ZSTD_CCtx *zctx;
+	/** Rows waiting to be compressed and sent in one batch. */
+	struct ibuf frame;
+	/** Time when the first row was added to the batch. */
+	double frame_time;
+	/** Buffer for a compressed batch of rows. */
+	struct ibuf zframe;
+	/** Size of the rows sent in compressed batches. */
+	size_t compression_raw_size;
+	/** Size of the compressed batches. */
+	size_t compression_zsize;
+	/**
+	 * Number of initial join rows to skip before sending,
+	 * used to resume fetching a snapshot shard.
+	 */
+	uint64_t skip_row_count;
 
 	struct {
 		/* Align to prevent false-sharing with tx thread */
@@ -165,9 +206,19 @@ relay_last_row_time(const struct relay *relay)
 	return relay->last_row_time;
 }
 
+void
+relay_compression_stat(const struct relay *relay, size_t *raw_size,
+		       size_t *zsize)
+{
+	*raw_size = relay->compression_raw_size;
+	*zsize = relay->compression_zsize;
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
+relay_flush(struct relay *relay);
+static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
@@ -284,7 +335,8 @@ relay_set_cord_name(int fd)
 }
 
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   struct engine *skip)
 {
 	struct relay *relay = relay_new(NULL);
 	if (relay == NULL)
@@ -296,7 +348,29 @@ relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
 		relay_delete(relay);
 	});
 
-	engine_join_xc(vclock, &relay->stream);
+	engine_join_except_xc(skip, vclock, &relay->stream);
+}
+
+void
+relay_fetch_snapshot(int fd, uint64_t sync, struct vclock *vclock,
+		     uint32_t shard, uint64_t offset)
+{
+	struct relay *relay = relay_new(NULL);
+	if (relay == NULL)
+		diag_raise();
+
+	relay_start(relay, fd, sync, relay_send_initial_join_row);
+	auto relay_guard = make_scoped_guard([=] {
+		relay_stop(relay);
+		relay_delete(relay);
+	});
+
+	relay->skip_row_count = offset;
+	struct memtx_engine *memtx =
+		(struct memtx_engine *)engine_by_name("memtx");
+	if (memtx_engine_join_shard(memtx, vclock, shard,
+				    &relay->stream) != 0)
+		diag_raise();
 }
 
 int
@@ -450,6 +524,57 @@ relay_set_error(struct relay *relay, struct error *e)
 		diag_add_error(&relay->diag, e);
 }
 
+/**
+ * Send the rows published to the WAL tail since the last call.
+ * Returns false if some of them have been evicted from the tail,
+ * in which case the relay has to read them from WAL files.
+ */
+static bool
+relay_send_wal_tail(struct relay *relay)
+{
+	struct recovery *r = relay->r;
+	struct ibuf *buf = &relay->wal_tail_buf;
+	while (true) {
+		ibuf_reset(buf);
+		int rc = wal_tail_read(&relay->wal_tail_seq, buf,
+				       RELAY_WAL_TAIL_CHUNK);
+		if (rc < 0)
+			diag_raise();
+		if (rc > 0)
+			return false;
+		if (ibuf_used(buf) == 0)
+			return true;
+		const char *pos = buf->rpos;
+		while (pos < buf->wpos) {
+			struct wal_tail_entry entry;
+			memcpy(&entry, pos, sizeof(entry));
+			pos += sizeof(entry);
+			if (entry.len == 0) {
+				/*
+				 * The WAL has been rotated. Account
+				 * it as if the relay had finished
+				 * reading the file.
+				 */
+				trigger_run_xc(&r->on_close_log, NULL);
+				continue;
+			}
+			struct xrow_header row;
+			if (xrow_header_decode(&row, &pos, pos + entry.len,
+					       true) != 0)
+				diag_raise();
+			/*
+			 * The rows published while the relay was
+			 * reading WAL files may have been sent
+			 * already, skip them.
+			 */
+			if (row.lsn <= vclock_get(&r->vclock, row.replica_id))
+				continue;
+			vclock_follow_xrow(&r->vclock, &row);
+			relay_send_row(&relay->stream, &row);
+		}
+	}
+}
+
 static void
 relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 {
@@ -467,8 +592,21 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 		return;
 	}
 	try {
+		if (relay->wal_tail_seq >= 0 && relay_send_wal_tail(relay))
+			return;
+		/*
+		 * The relay is behind the WAL tail. Catch up by
+		 * reading WAL files and switch over to the tail.
+		 * The directory index is stale if we got here
+		 * from the tail, so rescan it.
+		 */
+		bool scan_dir = relay->wal_tail_seq >= 0 ||
+				(events & WAL_EVENT_ROTATE) != 0;
+		relay->wal_tail_seq = wal_tail_seq();
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
-				       (events & WAL_EVENT_ROTATE) != 0);
+				       scan_dir);
+		if (relay->wal_tail_seq >= 0)
+			recovery_forget_log(relay->r);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -516,6 +654,8 @@ relay_send_heartbeat(struct relay *relay)
 	struct xrow_header row;
 	xrow_encode_timestamp(&row, instance_id, ev_now(loop()));
 	try {
+		/* Don't let the heartbeat overtake batched rows. */
+		relay_flush(relay);
 		relay_send(relay, &row);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
@@ -549,7 +689,24 @@ relay_subscribe_f(va_list ap)
 	};
 	trigger_add(&r->on_close_log, &on_close_log);
 
+	/* Setup compression if the replica has asked for it. */
+	ibuf_create(&relay->frame, &cord()->slabc,
+		    replication_compression_frame_size);
+	ibuf_create(&relay->zframe, &cord()->slabc,
+		    replication_compression_frame_size);
+	if (relay->compression) {
+		relay->zctx = ZSTD_createCCtx();
+		if (relay->zctx == NULL) {
+			diag_set(OutOfMemory, 0, "ZSTD_createCCtx", "zctx");
+			relay_set_error(relay, diag_last_error(diag_get()));
+			fiber_cancel(fiber());
+		}
+	}
+
 	/* Setup WAL watcher for sending new rows to the replica. */
+	relay->wal_tail_seq = -1;
+	ibuf_create(&relay->wal_tail_buf, &cord()->slabc,
+		    RELAY_WAL_TAIL_CHUNK);
 	wal_set_watcher(&relay->wal_watcher, relay->endpoint.name,
 			relay_process_wal_event, cbus_process);
 
@@ -579,8 +736,12 @@ relay_subscribe_f(va_list ap)
 		if (inj != NULL && inj->dparam != 0)
 			timeout = inj->dparam;
 
-		fiber_cond_wait_deadline(&relay->reader_cond,
-					 relay->last_row_time + timeout);
+		double deadline = relay->last_row_time + timeout;
+		if (ibuf_used(&relay->frame) > 0) {
+			deadline = MIN(deadline, relay->frame_time +
+				       replication_compression_frame_delay);
+		}
+		fiber_cond_wait_deadline(&relay->reader_cond, deadline);
 
 		/*
 		 * The fiber can be woken by IO cancel, by a timeout of
@@ -588,6 +749,17 @@ relay_subscribe_f(va_list ap)
 		 * Handle cbus messages first.
 		 */
 		cbus_process(&relay->endpoint);
+		/* Send the batched rows that have waited long enough. */
+		if (ibuf_used(&relay->frame) > 0 && !fiber_is_cancelled() &&
+		    ev_monotonic_now(loop()) - relay->frame_time >=
+		    replication_compression_frame_delay) {
+			try {
+				relay_flush(relay);
+			} catch (Exception *e) {
+				relay_set_error(relay, e);
+				fiber_cancel(fiber());
+			}
+		}
 		/* Check for a heartbeat timeout. */
 		if (ev_monotonic_now(loop()) - relay->last_row_time > timeout)
 			relay_send_heartbeat(relay);
@@ -628,6 +800,13 @@ relay_subscribe_f(va_list ap)
 	/* Clear garbage collector trigger and WAL watcher. */
 	trigger_clear(&on_close_log);
 	wal_clear_watcher(&relay->wal_watcher, cbus_process);
+	ibuf_destroy(&relay->wal_tail_buf);
+	ibuf_destroy(&relay->frame);
+	ibuf_destroy(&relay->zframe);
+	if (relay->zctx != NULL) {
+		ZSTD_freeCCtx(relay->zctx);
+		relay->zctx = NULL;
+	}
 
 	/* Join ack reader fiber. */
 	fiber_cancel(reader);
@@ -645,7 +824,8 @@ relay_subscribe_f(va_list ap)
 /** Replication acceptor fiber handler. */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_clock, uint32_t replica_version_id)
+		struct vclock *replica_clock, uint32_t replica_version_id,
+		bool compression)
 {
 	assert(replica->id != REPLICA_ID_NIL);
 	struct relay *relay = replica->relay;
@@ -668,6 +848,9 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 			        replica_clock);
 	vclock_copy(&relay->tx.vclock, replica_clock);
 	relay->version_id = replica_version_id;
+	relay->compression = compression;
+	relay->compression_raw_size = 0;
+	relay->compression_zsize = 0;
 
 	int rc = cord_costart(&relay->cord, "subscribe",
 			      relay_subscribe_f, relay);
@@ -698,6 +881,74 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 		fiber_sleep(inj->dparam);
 }
 
+/**
+ * Add a row to the batch of rows compressed for the replica.
+ * The batch is sent as soon as it exceeds the configured size
+ * or, see relay_subscribe_f(), its first row has waited for
+ * the configured delay.
+ */
+static void
+relay_send_compressed(struct relay *relay, struct xrow_header *packet)
+{
+	struct ibuf *frame = &relay->frame;
+	if (ibuf_used(frame) == 0)
+		relay->frame_time = ev_monotonic_now(loop());
+	packet->sync = relay->sync;
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec_xc(packet, iov);
+	for (int i = 0; i < iovcnt; i++) {
+		ibuf_reserve_xc(frame, iov[i].iov_len);
+		memcpy(frame->wpos, iov[i].iov_base, iov[i].iov_len);
+		frame->wpos += iov[i].iov_len;
+	}
+	fiber_gc();
+	if (ibuf_used(frame) >= (size_t) replication_compression_frame_size)
+		relay_flush(relay);
+}
+
+/**
+ * Compress the batched rows into a single zstd frame and send
+ * it to the replica, see IPROTO_COMPRESSED_ROWS.
+ */
+static void
+relay_flush(struct relay *relay)
+{
+	struct ibuf *frame = &relay->frame;
+	size_t size = ibuf_used(frame);
+	if (size == 0)
+		return;
+	struct ibuf *zframe = &relay->zframe;
+	ibuf_reset(zframe);
+	size_t zmax_size = ZSTD_compressBound(size);
+	char *zdata = (char *) ibuf_reserve_xc(zframe, zmax_size);
+	size_t zsize = ZSTD_compressCCtx(relay->zctx, zdata, zmax_size,
+					 frame->rpos, size,
+					 replication_compression_level);
+	if (ZSTD_isError(zsize))
+		tnt_raise(ClientError, ER_COMPRESSION, ZSTD_getErrorName(zsize));
+	ibuf_reset(frame);
+
+	char body[16];
+	char *data = body;
+	data = mp_encode_map(data, 1);
+	data = mp_encode_uint(data, IPROTO_FRAME);
+	data = mp_encode_binl(data, zsize);
+	assert(data <= body + sizeof(body));
+
+	struct xrow_header row;
+	memset(&row, 0, sizeof(row));
+	row.type = IPROTO_COMPRESSED_ROWS;
+	row.body[0].iov_base = body;
+	row.body[0].iov_len = data - body;
+	row.body[1].iov_base = zdata;
+	row.body[1].iov_len = zsize;
+	row.bodycnt = 2;
+	relay_send(relay, &row);
+
+	relay->compression_raw_size += size;
+	relay->compression_zsize += zsize;
+}
+
 static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 {
@@ -706,8 +957,17 @@ relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 	 * Ignore replica local requests as we don't need to promote
 	 * vclock while sending a snapshot.
 	 */
-	if (row->group_id != GROUP_LOCAL)
-		relay_send(relay, row);
+	if (row->group_id == GROUP_LOCAL)
+		return;
+	/*
+	 * The replica has already got these rows over a broken
+	 * connection.
+	 */
+	if (relay->skip_row_count > 0) {
+		relay->skip_row_count--;
+		return;
+	}
+	relay_send(relay, row);
 }
 
 /** Send a single row to the client. */
@@ -749,6 +1009,9 @@ relay_send_row(struct xstream *stream, struct xrow_header *packet)
 			say_warn("injected broken lsn: %lld",
 				 (long long) packet->lsn);
 		}
-		relay_send(relay, packet);
+		if (relay->zctx != NULL)
+			relay_send_compressed(relay, packet);
+		else
+			relay_send(relay, packet);
 	}
 }
@@ -31,12 +31,14 @@
  * SUCH DAMAGE.
  */
 
+#include <stddef.h>
 #include <stdint.h>
 
 #if defined(__cplusplus)
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+struct engine;
 struct relay;
 struct replica;
 struct tt_uuid;
@@ -93,6 +95,15 @@ relay_vclock(const struct relay *relay);
 double
 relay_last_row_time(const struct relay *relay);
 
+/**
+ * Returns the size of the rows the relay has compressed and
+ * the size they took on the wire. Both are zero unless the
+ * replica has asked for compression.
+ */
+void
+relay_compression_stat(const struct relay *relay, size_t *raw_size,
+		       size_t *zsize);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -103,9 +114,25 @@ relay_last_row_time(const struct relay *relay);
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
  * @param vclock    vclock of the last checkpoint
+ * @param skip      engine whose rows are not sent or NULL
  */
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock);
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   struct engine *skip);
+
+/**
+ * Send rows of a memtx snapshot shard to the replica
+ * (FETCH_SNAPSHOT request).
+ *
+ * @param fd        client connection
+ * @param sync      sync from incoming FETCH_SNAPSHOT request
+ * @param vclock    vclock of the checkpoint
+ * @param shard     snapshot shard
+ * @param offset    number of rows of the shard to skip
+ */
+void
+relay_fetch_snapshot(int fd, uint64_t sync, struct vclock *vclock,
+		     uint32_t shard, uint64_t offset);
 
 /**
  * Send final JOIN rows to the replica.
@@ -120,10 +147,13 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
 /**
  * Subscribe a replica to updates.
  *
+ * @param compression send rows compressed in batches
+ *
  * @return none.
  */
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
-		struct vclock *replica_vclock, uint32_t replica_version_id);
+		struct vclock *replica_vclock, uint32_t replica_version_id,
+		bool compression);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
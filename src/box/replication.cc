@@ -53,6 +53,11 @@ int replication_connect_quorum = REPLICATION_CONNECT_QUORUM_ALL;
 double replication_sync_lag = 10.0; /* seconds */
 double replication_sync_timeout = 300.0; /* seconds */
 bool replication_skip_conflict = false;
+bool replication_compression = false;
+int replication_compression_level = 3;
+int replication_compression_frame_size = 64 * 1024;
+double replication_compression_frame_delay = 0.01; /* seconds */
+int replication_join_connections = 0;
 
 struct replicaset replicaset;
 
@@ -89,7 +94,7 @@ replication_init(void)
 	vclock_create(&replicaset.vclock);
 	fiber_cond_create(&replicaset.applier.cond);
 	replicaset.replica_by_id = (struct replica **)calloc(VCLOCK_MAX, sizeof(struct replica *));
-	latch_create(&replicaset.applier.order_latch);
+	applier_init();
 }
 
 void
@@ -164,7 +169,6 @@ replica_new(void)
 	trigger_create(&replica->on_applier_state,
 		       replica_on_applier_state_f, NULL, NULL);
 	replica->applier_sync_state = APPLIER_DISCONNECTED;
-	latch_create(&replica->order_latch);
 	return replica;
 }
 
@@ -137,6 +137,34 @@ extern double replication_sync_timeout;
  */
 extern bool replication_skip_conflict;
 
+/**
+ * Ask masters to send rows compressed in batches, see
+ * IPROTO_COMPRESSED_ROWS.
+ */
+extern bool replication_compression;
+
+/** zstd compression level of rows sent to replicas. */
+extern int replication_compression_level;
+
+/**
+ * Max size of a batch of rows compressed for a replica.
+ * A batch is sent as soon as it exceeds the size.
+ */
+extern int replication_compression_frame_size;
+
+/**
+ * Max time a row may wait in a batch compressed for a replica
+ * before the batch is sent, in seconds.
+ */
+extern double replication_compression_frame_delay;
+
+/**
+ * Number of extra connections used to fetch the memtx
+ * snapshot from the master on initial join, 0 to receive
+ * the snapshot over the JOIN connection.
+ */
+extern int replication_join_connections;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
@@ -225,13 +253,6 @@ struct replicaset {
 		 * state.
 		 */
 		struct fiber_cond cond;
-		/*
-		 * The latch is used to order replication requests
-		 * running on behalf of all dead replicas
-		 * (replicas which have a server id but don't have
-		 * struct replica object).
-		 */
-		struct latch order_latch;
 	} applier;
 	/** Map of all known replica_id's to correspponding replica's. */
 	struct replica **replica_by_id;
@@ -277,8 +298,6 @@ struct replica {
 	 * separate from applier.
 	 */
 	enum applier_state applier_sync_state;
-	/* The latch is used to order replication requests. */
-	struct latch order_latch;
 };
 
 enum {
@@ -35,6 +35,11 @@ const char *sql_storage_engine_strs[] = {
 	[SQL_STORAGE_ENGINE_VINYL] = "vinyl",
 };
 
+const char *tuple_compression_strs[] = {
+	[TUPLE_COMPRESSION_NONE] = "none",
+	[TUPLE_COMPRESSION_ZSTD] = "zstd",
+};
+
 static const char *object_type_strs[] = {
 	/* [SC_UKNNOWN]         = */ "unknown",
 	/* [SC_UNIVERSE]        = */ "universe",
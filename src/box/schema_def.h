@@ -276,6 +276,18 @@ enum sql_storage_engine {
 
 extern const char *sql_storage_engine_strs[];
 
+/** Compression of big memtx tuples, see space_opts. */
+enum tuple_compression {
+	TUPLE_COMPRESSION_NONE = 0,
+	TUPLE_COMPRESSION_ZSTD = 1,
+	tuple_compression_MAX = 2
+};
+
+extern const char *tuple_compression_strs[];
+
+/** Max level of tuple compression, ZSTD_maxCLevel(). */
+enum { TUPLE_COMPRESSION_LEVEL_MAX = 22 };
+
 /**
  * Given a object type, return an entity type it belongs to.
  */
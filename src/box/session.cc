@@ -36,6 +36,7 @@
 #include "user.h"
 #include "error.h"
 #include "tt_static.h"
+#include "session_cursor.h"
 
 const char *session_type_strs[] = {
 	"background",
@@ -140,6 +141,9 @@ session_create(enum session_type type)
 	session_set_type(session, type);
 	session->sql_flags = default_flags;
 	session->sql_default_engine = SQL_STORAGE_ENGINE_MEMTX;
+	rlist_create(&session->cursors);
+	session->cursor_id_max = 0;
+	session->cursor_count = 0;
 
 	/* For on_connect triggers. */
 	credentials_init(&session->credentials, guest_user->auth_token,
@@ -230,6 +234,7 @@ void
 session_destroy(struct session *session)
 {
 	session_storage_cleanup(session->id);
+	session_cursor_delete_all(session);
 	struct mh_i64ptr_node_t node = { session->id, NULL };
 	mh_i64ptr_remove(session_registry, &node, NULL);
 	mempool_free(&session_pool, session);
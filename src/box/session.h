@@ -105,6 +105,12 @@ struct session {
 	struct credentials credentials;
 	/** Trigger for fiber on_stop to cleanup created on-demand session */
 	struct trigger fiber_on_stop;
+	/** Open cursors, linked by session_cursor::in_session. */
+	struct rlist cursors;
+	/** Id of the last cursor opened by the session. */
+	uint64_t cursor_id_max;
+	/** Number of open cursors, see SESSION_CURSOR_MAX. */
+	uint32_t cursor_count;
 };
 
 struct session_vtab {
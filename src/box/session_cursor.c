@@ -0,0 +1,127 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "session_cursor.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <msgpuck.h>
+
+#include "diag.h"
+#include "errcode.h"
+#include "index.h"
+#include "session.h"
+#include "tuple.h"
+
+struct session_cursor *
+session_cursor_new(struct session *session, uint32_t space_id,
+		   uint32_t index_id, int iterator, const char *key,
+		   const char *key_end)
+{
+	/* An empty key if the request has none. */
+	static const char empty_key[] = { (char) 0x90 };
+	if (key == NULL) {
+		key = empty_key;
+		key_end = empty_key + sizeof(empty_key);
+	}
+	if (session->cursor_count >= SESSION_CURSOR_MAX) {
+		diag_set(ClientError, ER_CURSOR_LIMIT, SESSION_CURSOR_MAX);
+		return NULL;
+	}
+	struct session_cursor *cursor = malloc(sizeof(*cursor));
+	if (cursor == NULL) {
+		diag_set(OutOfMemory, sizeof(*cursor), "malloc",
+			 "struct session_cursor");
+		return NULL;
+	}
+	cursor->it = box_index_iterator(space_id, index_id, iterator,
+					key, key_end);
+	if (cursor->it == NULL) {
+		free(cursor);
+		return NULL;
+	}
+	cursor->id = ++session->cursor_id_max;
+	cursor->session = session;
+	cursor->is_eof = false;
+	cursor->is_busy = false;
+	rlist_add_tail_entry(&session->cursors, cursor, in_session);
+	session->cursor_count++;
+	return cursor;
+}
+
+struct session_cursor *
+session_cursor_find(struct session *session, uint64_t id)
+{
+	struct session_cursor *cursor;
+	rlist_foreach_entry(cursor, &session->cursors, in_session) {
+		if (cursor->id != id)
+			continue;
+		if (cursor->is_busy) {
+			diag_set(ClientError, ER_CURSOR_BUSY,
+				 (unsigned long long) id);
+			return NULL;
+		}
+		return cursor;
+	}
+	diag_set(ClientError, ER_NO_SUCH_CURSOR, (unsigned long long) id);
+	return NULL;
+}
+
+int
+session_cursor_next(struct session_cursor *cursor, struct tuple **ret)
+{
+	*ret = NULL;
+	if (cursor->is_eof)
+		return 0;
+	if (iterator_next(cursor->it, ret) != 0)
+		return -1;
+	if (*ret == NULL)
+		cursor->is_eof = true;
+	return 0;
+}
+
+void
+session_cursor_delete(struct session_cursor *cursor)
+{
+	assert(!cursor->is_busy);
+	assert(cursor->session->cursor_count > 0);
+	cursor->session->cursor_count--;
+	rlist_del_entry(cursor, in_session);
+	iterator_delete(cursor->it);
+	free(cursor);
+}
+
+void
+session_cursor_delete_all(struct session *session)
+{
+	struct session_cursor *cursor, *tmp;
+	rlist_foreach_entry_safe(cursor, &session->cursors, in_session, tmp)
+		session_cursor_delete(cursor);
+}
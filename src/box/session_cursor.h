@@ -0,0 +1,123 @@
+#ifndef TARANTOOL_BOX_SESSION_CURSOR_H_INCLUDED
+#define TARANTOOL_BOX_SESSION_CURSOR_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <small/rlist.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct session;
+struct iterator;
+struct tuple;
+
+enum {
+	/** Max number of cursors a session may have open. */
+	SESSION_CURSOR_MAX = 1024,
+};
+
+/**
+ * A server-side cursor opened over iproto with
+ * IPROTO_CURSOR_OPEN. The client fetches the tuples page
+ * by page, so a big result set doesn't have to be put in
+ * the output buffer at once. A cursor belongs to the session
+ * which opened it and is deleted when the session is.
+ */
+struct session_cursor {
+	/** Id of the cursor, unique within the session. */
+	uint64_t id;
+	/** Session the cursor belongs to. */
+	struct session *session;
+	/** Iterator over the index the cursor was opened for. */
+	struct iterator *it;
+	/** Set when the iterator is exhausted. */
+	bool is_eof;
+	/**
+	 * Set while a page is being fetched. Reading a page
+	 * may yield, e.g. on a vinyl disk read, and the cursor
+	 * can't be fetched or closed by another request then.
+	 */
+	bool is_busy;
+	/** Link in session::cursors. */
+	struct rlist in_session;
+};
+
+/**
+ * Open a cursor over an index for a session. Checks access
+ * and the key the same way box_select() does. Fails with
+ * ER_CURSOR_LIMIT if the session has SESSION_CURSOR_MAX
+ * cursors open.
+ *
+ * @retval NULL Error, the diag is set.
+ */
+struct session_cursor *
+session_cursor_new(struct session *session, uint32_t space_id,
+		   uint32_t index_id, int iterator, const char *key,
+		   const char *key_end);
+
+/**
+ * Find a cursor of a session by id. A busy cursor isn't
+ * returned, since it may be neither fetched nor closed.
+ *
+ * @retval NULL ER_NO_SUCH_CURSOR or ER_CURSOR_BUSY, the diag
+ *              is set.
+ */
+struct session_cursor *
+session_cursor_find(struct session *session, uint64_t id);
+
+/**
+ * Get the next tuple of a cursor, NULL if the cursor
+ * is exhausted. May yield, the caller must mark the cursor
+ * busy.
+ *
+ * @retval  0 Success.
+ * @retval -1 Error, the diag is set.
+ */
+int
+session_cursor_next(struct session_cursor *cursor, struct tuple **ret);
+
+/** Close a cursor and free its iterator. */
+void
+session_cursor_delete(struct session_cursor *cursor);
+
+/** Close all cursors of a session. */
+void
+session_cursor_delete_all(struct session *session);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_SESSION_CURSOR_H_INCLUDED */
@@ -655,4 +655,13 @@ generic_space_invalidate(struct space *space)
 	(void)space;
 }
 
+int
+generic_space_bulk_load(struct space *space, struct bulk_load_source *source)
+{
+	(void)source;
+	diag_set(ClientError, ER_UNSUPPORTED, space->engine->name,
+		 "bulk load");
+	return -1;
+}
+
 /* }}} */
@@ -51,6 +51,20 @@ struct port;
 struct tuple;
 struct tuple_format;
 
+/** A source of tuples for space_bulk_load(). */
+struct bulk_load_source {
+	/**
+	 * Get the next tuple to load. The tuple must have the
+	 * format of the space being loaded.
+	 *
+	 * @param source       tuple source
+	 * @param[out] tuple   next tuple or NULL on EOF
+	 * @retval  0          success
+	 * @retval -1          error, diag is set
+	 */
+	int (*next)(struct bulk_load_source *source, struct tuple **tuple);
+};
+
 struct space_vtab {
 	/** Free a space instance. */
 	void (*destroy)(struct space *);
@@ -141,6 +155,12 @@ struct space_vtab {
 	 * This function isn't allowed to yield or fail.
 	 */
 	void (*invalidate)(struct space *space);
+	/**
+	 * Fill an empty space with tuples from the given source
+	 * bypassing transactions and WAL. On failure the space
+	 * is left empty.
+	 */
+	int (*bulk_load)(struct space *space, struct bulk_load_source *source);
 };
 
 struct space {
@@ -415,6 +435,12 @@ space_prepare_alter(struct space *old_space, struct space *new_space)
 	return new_space->vtab->prepare_alter(old_space, new_space);
 }
 
+static inline int
+space_bulk_load(struct space *space, struct bulk_load_source *source)
+{
+	return space->vtab->bulk_load(space, source);
+}
+
 static inline void
 space_invalidate(struct space *space)
 {
@@ -484,6 +510,7 @@ int generic_space_build_index(struct space *, struct index *,
 			      struct tuple_format *);
 int generic_space_prepare_alter(struct space *, struct space *);
 void generic_space_invalidate(struct space *);
+int generic_space_bulk_load(struct space *, struct bulk_load_source *);
 
 #if defined(__cplusplus)
 } /* extern "C" */
@@ -58,6 +58,10 @@ const struct space_opts space_opts_default = {
 	/* .view = */ false,
 	/* .sql        = */ NULL,
 	/* .checks     = */ NULL,
+	/* .compression = */ TUPLE_COMPRESSION_NONE,
+	/* .compression_threshold = */ 1024,
+	/* .compression_level = */ 3,
+	/* .is_read_view = */ false,
 };
 
 const struct opt_def space_opts_reg[] = {
@@ -67,6 +71,13 @@ const struct opt_def space_opts_reg[] = {
 	OPT_DEF("sql", OPT_STRPTR, struct space_opts, sql),
 	OPT_DEF_ARRAY("checks", struct space_opts, checks,
 		      checks_array_decode),
+	OPT_DEF_ENUM("compression", tuple_compression, struct space_opts,
+		     compression, NULL),
+	OPT_DEF("compression_threshold", OPT_UINT32, struct space_opts,
+		compression_threshold),
+	OPT_DEF("compression_level", OPT_UINT32, struct space_opts,
+		compression_level),
+	OPT_DEF("read_view", OPT_BOOL, struct space_opts, is_read_view),
 	OPT_END,
 };
 
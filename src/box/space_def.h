@@ -73,6 +73,22 @@ struct space_opts {
 	char *sql;
 	/** SQL Checks expressions list. */
 	struct ExprList *checks;
+	/**
+	 * Compression of tuples which are at least
+	 * compression_threshold bytes long. Fields covered by
+	 * indexes are never compressed. Supported by memtx.
+	 */
+	enum tuple_compression compression;
+	/** Min size of a tuple to compress, in bytes. */
+	uint32_t compression_threshold;
+	/** Zstd compression level. */
+	uint32_t compression_level;
+	/**
+	 * SELECTs by the primary key of the space may be served
+	 * by reader threads from a periodically refreshed read
+	 * view, see read_view.h. Supported by memtx.
+	 */
+	bool is_read_view;
 };
 
 extern const struct space_opts space_opts_default;
@@ -32,6 +32,7 @@
 #include "field_def.h"
 #include "cfg.h"
 #include "sql.h"
+#include "sql_stmt_cache.h"
 #include "sql/sqlInt.h"
 #include "sql/tarantoolInt.h"
 #include "sql/vdbeInt.h"
@@ -75,6 +76,7 @@ sql_init()
 		panic("failed to initialize SQL subsystem");
 
 	assert(db != NULL);
+	sql_stmt_cache_init();
 }
 
 void
@@ -177,8 +179,12 @@ const void *tarantoolsqlPayloadFetch(BtCursor *pCur, u32 *pAmt)
 	       pCur->curFlags & BTCF_TEphemCursor);
 	assert(pCur->last_tuple != NULL);
 
-	*pAmt = box_tuple_bsize(pCur->last_tuple);
-	return tuple_data(pCur->last_tuple);
+	/*
+	 * The row may be read after other cursors have moved, so
+	 * a compressed tuple is decompressed to the cursor buffer.
+	 */
+	return tuple_data_range_to(pCur->last_tuple, &pCur->tuple_buf,
+				   &pCur->tuple_buf_size, pAmt);
 }
 
 const void *
@@ -188,6 +194,12 @@ tarantoolsqlTupleColumnFast(BtCursor *pCur, u32 fieldno, u32 *field_size)
 	       pCur->curFlags & BTCF_TEphemCursor);
 	assert(pCur->last_tuple != NULL);
 
+	/*
+	 * A field of a compressed tuple may be read from a buffer
+	 * other than the one returned by tarantoolsqlPayloadFetch().
+	 */
+	if (pCur->last_tuple->is_compressed)
+		return NULL;
 	struct tuple_format *format = tuple_format(pCur->last_tuple);
 	if (fieldno >= tuple_format_field_count(format) ||
 	    tuple_format_field(format, fieldno)->offset_slot ==
@@ -1218,6 +1230,11 @@ sql_debug_info(struct info_handler *h)
 	info_append_int(h, "sql_sort_count", sql_sort_count);
 	info_append_int(h, "sql_found_count", sql_found_count);
 	info_append_int(h, "sql_xfer_count", sql_xfer_count);
+	struct sql_stmt_cache_stat cache_stat;
+	sql_stmt_cache_stat(&cache_stat);
+	info_append_int(h, "sql_cache_size", cache_stat.size);
+	info_append_int(h, "sql_cache_hits", cache_stat.hits);
+	info_append_int(h, "sql_cache_misses", cache_stat.misses);
 	info_end(h);
 }
 
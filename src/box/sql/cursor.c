@@ -42,6 +42,9 @@ sql_cursor_cleanup(struct BtCursor *cursor)
 		tuple_unref(cursor->last_tuple);
 	free(cursor->key);
 	cursor->key = NULL;
+	free(cursor->tuple_buf);
+	cursor->tuple_buf = NULL;
+	cursor->tuple_buf_size = 0;
 	cursor->iter = NULL;
 	cursor->last_tuple = NULL;
 	cursor->eState = CURSOR_INVALID;
@@ -50,6 +50,9 @@ struct BtCursor {
 	enum iterator_type iter_type;
 	struct tuple *last_tuple;
 	char *key;		/* Saved key that was cursor last known position */
+	/** Decompressed data of last_tuple if it is compressed. */
+	char *tuple_buf;
+	size_t tuple_buf_size;
 };
 
 void sqlCursorZero(BtCursor *);
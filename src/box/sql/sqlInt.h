@@ -605,6 +605,12 @@ sql_column_value(sql_stmt *,
 int
 sql_finalize(sql_stmt * pStmt);
 
+int
+sql_reset(sql_stmt * pStmt);
+
+int
+sql_clear_bindings(sql_stmt * pStmt);
+
 int
 sql_exec(sql *,	/* An open database */
 	     const char *sql,	/* SQL to be evaluated */
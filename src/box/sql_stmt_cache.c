@@ -0,0 +1,392 @@
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "sql_stmt_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <small/rlist.h>
+
+#include "assoc.h"
+#include "diag.h"
+#include "errcode.h"
+#include "execute.h"
+#include "say.h"
+#include "schema.h"
+#include "session.h"
+#include "sql/sqlInt.h"
+
+/** A statement in the cache. */
+struct stmt_cache_entry {
+	/**
+	 * Id of the statement. Ids are never reused, so an id
+	 * refers to the same text while the statement stays in
+	 * the cache.
+	 */
+	uint32_t id;
+	/** Schema version the statement was compiled for. */
+	uint32_t schema_version;
+	/** Session SQL flags the statement was compiled with. */
+	uint32_t sql_flags;
+	/** Session default engine the statement was compiled with. */
+	uint8_t sql_default_engine;
+	/** Compiled statement. */
+	struct sql_stmt *stmt;
+	/** Set while the statement is being executed. */
+	bool is_busy;
+	/** Set if the statement was prepared by a client. */
+	bool is_prepared;
+	/**
+	 * Link in sql_stmt_cache::lru, sql_stmt_cache::prepared
+	 * or sql_stmt_cache::busy.
+	 */
+	struct rlist in_cache;
+	/** Length of the statement text. */
+	uint32_t sql_len;
+	/** Statement text, as it was sent by the client. */
+	char sql[0];
+};
+
+static struct sql_stmt_cache {
+	/** Statement id -> struct stmt_cache_entry. */
+	struct mh_i32ptr_t *by_id;
+	/** Statement text -> struct stmt_cache_entry. */
+	struct mh_strnptr_t *by_sql;
+	/** Idle statements executed by text, the most recently used first. */
+	struct rlist lru;
+	/** Idle prepared statements, the most recently used first. */
+	struct rlist prepared;
+	/** Statements being executed. */
+	struct rlist busy;
+	/** Number of statements in the cache that weren't prepared. */
+	uint32_t size;
+	/** Number of prepared statements in the cache. */
+	uint32_t prepared_size;
+	/** Max number of statements of each kind in the cache. */
+	uint32_t size_max;
+	/** Id of the last statement added to the cache. */
+	uint32_t id_max;
+	/** Number of executions of a cached statement. */
+	uint64_t hits;
+	/** Number of executions that had to compile a statement. */
+	uint64_t misses;
+} cache;
+
+void
+sql_stmt_cache_init(void)
+{
+	cache.by_id = mh_i32ptr_new();
+	cache.by_sql = mh_strnptr_new();
+	if (cache.by_id == NULL || cache.by_sql == NULL)
+		panic("failed to allocate SQL statement cache");
+	rlist_create(&cache.lru);
+	rlist_create(&cache.prepared);
+	rlist_create(&cache.busy);
+}
+
+static struct stmt_cache_entry *
+sql_stmt_cache_find(uint32_t id)
+{
+	mh_int_t k = mh_i32ptr_find(cache.by_id, id, NULL);
+	if (k == mh_end(cache.by_id))
+		return NULL;
+	return (struct stmt_cache_entry *) mh_i32ptr_node(cache.by_id, k)->val;
+}
+
+static struct stmt_cache_entry *
+sql_stmt_cache_find_sql(const char *sql, uint32_t len)
+{
+	mh_int_t k = mh_strnptr_find_inp(cache.by_sql, sql, len);
+	if (k == mh_end(cache.by_sql))
+		return NULL;
+	return (struct stmt_cache_entry *) mh_strnptr_node(cache.by_sql,
+							   k)->val;
+}
+
+/**
+ * Add an entry for a statement text to the cache.
+ *
+ * @retval NULL Memory error, the diag is not set.
+ */
+static struct stmt_cache_entry *
+stmt_cache_entry_new(const char *sql, uint32_t len)
+{
+	struct stmt_cache_entry *entry = malloc(sizeof(*entry) + len);
+	if (entry == NULL)
+		return NULL;
+	memcpy(entry->sql, sql, len);
+	entry->sql_len = len;
+	/* Skip ids still in use after a wrap around. */
+	do {
+		entry->id = ++cache.id_max;
+	} while (entry->id == 0 || sql_stmt_cache_find(entry->id) != NULL);
+	struct mh_i32ptr_node_t id_node = { entry->id, entry };
+	mh_int_t k = mh_i32ptr_put(cache.by_id, &id_node, NULL, NULL);
+	if (k == mh_end(cache.by_id)) {
+		free(entry);
+		return NULL;
+	}
+	struct mh_strnptr_node_t sql_node = {
+		entry->sql, len, mh_strn_hash(entry->sql, len), entry
+	};
+	if (mh_strnptr_put(cache.by_sql, &sql_node, NULL, NULL) ==
+	    mh_end(cache.by_sql)) {
+		mh_i32ptr_del(cache.by_id, k, NULL);
+		free(entry);
+		return NULL;
+	}
+	entry->schema_version = 0;
+	entry->sql_flags = 0;
+	entry->sql_default_engine = 0;
+	entry->stmt = NULL;
+	entry->is_busy = false;
+	entry->is_prepared = false;
+	rlist_create(&entry->in_cache);
+	cache.size++;
+	return entry;
+}
+
+static void
+stmt_cache_entry_delete(struct stmt_cache_entry *entry)
+{
+	assert(!entry->is_busy);
+	mh_int_t k = mh_i32ptr_find(cache.by_id, entry->id, NULL);
+	assert(k != mh_end(cache.by_id));
+	mh_i32ptr_del(cache.by_id, k, NULL);
+	k = mh_strnptr_find_inp(cache.by_sql, entry->sql, entry->sql_len);
+	assert(k != mh_end(cache.by_sql));
+	mh_strnptr_del(cache.by_sql, k, NULL);
+	rlist_del_entry(entry, in_cache);
+	sql_finalize(entry->stmt);
+	if (entry->is_prepared)
+		cache.prepared_size--;
+	else
+		cache.size--;
+	free(entry);
+}
+
+/**
+ * Check if a cached statement may be run by the current
+ * session. The compiled code depends on the schema and on the
+ * session SQL settings, such as full_column_names.
+ */
+static bool
+stmt_cache_entry_is_valid(const struct stmt_cache_entry *entry)
+{
+	struct session *session = current_session();
+	return entry->schema_version == box_schema_version() &&
+	       entry->sql_flags == session->sql_flags &&
+	       entry->sql_default_engine == session->sql_default_engine;
+}
+
+/** Mark a cached statement as being executed. */
+static void
+stmt_cache_entry_take(struct stmt_cache_entry *entry)
+{
+	assert(!entry->is_busy);
+	entry->is_busy = true;
+	rlist_move_entry(&cache.busy, entry, in_cache);
+}
+
+/**
+ * Mark a cached statement as prepared, so that it is evicted
+ * only by other prepared statements, and return its id. Does
+ * nothing if @a id is NULL.
+ */
+static void
+stmt_cache_entry_prepare(struct stmt_cache_entry *entry, uint32_t *id)
+{
+	if (id == NULL)
+		return;
+	*id = entry->id;
+	if (entry->is_prepared)
+		return;
+	entry->is_prepared = true;
+	cache.size--;
+	cache.prepared_size++;
+	if (!entry->is_busy)
+		rlist_move_entry(&cache.prepared, entry, in_cache);
+}
+
+/** Evict the least recently used idle statements. */
+static void
+sql_stmt_cache_trim(void)
+{
+	while (cache.size > cache.size_max && !rlist_empty(&cache.lru)) {
+		struct stmt_cache_entry *entry =
+			rlist_last_entry(&cache.lru, struct stmt_cache_entry,
+					 in_cache);
+		stmt_cache_entry_delete(entry);
+	}
+	while (cache.prepared_size > cache.size_max &&
+	       !rlist_empty(&cache.prepared)) {
+		struct stmt_cache_entry *entry =
+			rlist_last_entry(&cache.prepared,
+					 struct stmt_cache_entry, in_cache);
+		stmt_cache_entry_delete(entry);
+	}
+}
+
+void
+sql_stmt_cache_set_size(uint32_t size)
+{
+	cache.size_max = size;
+	sql_stmt_cache_trim();
+}
+
+/**
+ * Get a statement for the text from the cache or compile it.
+ * @param sql Statement text.
+ * @param len Length of @a sql.
+ * @param[out] id If not NULL, the statement is prepared: it is
+ *             pinned in the cache and its id is returned. It is
+ *             an error then if the statement can't be cached.
+ *
+ * @retval NULL Error, the diag is set.
+ */
+static struct sql_stmt *
+stmt_cache_acquire(const char *sql, uint32_t len, uint32_t *id)
+{
+	struct stmt_cache_entry *entry = sql_stmt_cache_find_sql(sql, len);
+	if (entry != NULL && !entry->is_busy &&
+	    stmt_cache_entry_is_valid(entry)) {
+		cache.hits++;
+		stmt_cache_entry_take(entry);
+		stmt_cache_entry_prepare(entry, id);
+		return entry->stmt;
+	}
+	cache.misses++;
+	struct session *session = current_session();
+	uint32_t sql_flags = session->sql_flags;
+	uint8_t sql_default_engine = session->sql_default_engine;
+	/*
+	 * Note, @a sql may point to the text stored in the
+	 * entry, so the entry must stay until the statement
+	 * is compiled.
+	 */
+	struct sql_stmt *stmt = sql_stmt_compile(sql, len);
+	if (stmt == NULL)
+		return NULL;
+	if (session->sql_flags != sql_flags ||
+	    session->sql_default_engine != sql_default_engine) {
+		/*
+		 * A PRAGMA changes the session settings when it
+		 * is compiled, so it can't be run from the cache.
+		 */
+		if (id == NULL)
+			return stmt;
+		sql_finalize(stmt);
+		diag_set(ClientError, ER_UNSUPPORTED, "PREPARE",
+			 "statements changing session settings");
+		return NULL;
+	}
+	if (entry == NULL) {
+		entry = stmt_cache_entry_new(sql, len);
+		if (entry == NULL && id == NULL)
+			return stmt;
+		if (entry == NULL) {
+			sql_finalize(stmt);
+			diag_set(OutOfMemory, sizeof(*entry) + len, "malloc",
+				 "struct stmt_cache_entry");
+			return NULL;
+		}
+	} else if (entry->is_busy) {
+		/* Run a private copy, the cached one is in use. */
+		stmt_cache_entry_prepare(entry, id);
+		return stmt;
+	} else {
+		/* The cached statement is stale. */
+		sql_finalize(entry->stmt);
+	}
+	entry->stmt = stmt;
+	entry->schema_version = box_schema_version();
+	entry->sql_flags = sql_flags;
+	entry->sql_default_engine = sql_default_engine;
+	stmt_cache_entry_take(entry);
+	stmt_cache_entry_prepare(entry, id);
+	return stmt;
+}
+
+struct sql_stmt *
+sql_stmt_cache_acquire(const char *sql, uint32_t len)
+{
+	return stmt_cache_acquire(sql, len, NULL);
+}
+
+struct sql_stmt *
+sql_stmt_cache_acquire_by_id(uint32_t id)
+{
+	struct stmt_cache_entry *entry = sql_stmt_cache_find(id);
+	if (entry == NULL) {
+		diag_set(ClientError, ER_NO_SUCH_STATEMENT, id);
+		return NULL;
+	}
+	return stmt_cache_acquire(entry->sql, entry->sql_len, NULL);
+}
+
+int
+sql_stmt_cache_prepare(const char *sql, uint32_t len, uint32_t *id)
+{
+	struct sql_stmt *stmt = stmt_cache_acquire(sql, len, id);
+	if (stmt == NULL)
+		return -1;
+	sql_stmt_cache_release(stmt);
+	return 0;
+}
+
+void
+sql_stmt_cache_release(struct sql_stmt *stmt)
+{
+	/*
+	 * Only a few statements are executed at once, so it is
+	 * fine to look the entry up in the list of busy ones.
+	 */
+	struct stmt_cache_entry *entry;
+	rlist_foreach_entry(entry, &cache.busy, in_cache) {
+		if (entry->stmt != stmt)
+			continue;
+		sql_reset(stmt);
+		sql_clear_bindings(stmt);
+		entry->is_busy = false;
+		rlist_move_entry(entry->is_prepared ? &cache.prepared :
+				 &cache.lru, entry, in_cache);
+		sql_stmt_cache_trim();
+		return;
+	}
+	sql_finalize(stmt);
+}
+
+void
+sql_stmt_cache_stat(struct sql_stmt_cache_stat *stat)
+{
+	stat->size = cache.size + cache.prepared_size;
+	stat->hits = cache.hits;
+	stat->misses = cache.misses;
+}
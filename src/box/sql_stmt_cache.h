@@ -0,0 +1,135 @@
+#ifndef TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED
+#define TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED
+/*
+ * Copyright 2010-2019, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct sql_stmt;
+
+/**
+ * A cache of compiled SQL statements shared by all sessions.
+ * A statement is looked up by its text, or by its id if it was
+ * prepared. Ids are assigned from a counter and never reused,
+ * so an id always refers to the text it was returned for. The
+ * same text gets the same id while it stays in the cache, an
+ * evicted statement has to be prepared again.
+ *
+ * A cached statement is taken out of the cache for the time it
+ * is executed, because a VDBE can't be run by two fibers at
+ * once. A request for a statement that is being executed gets
+ * a private copy, which is not cached. Prepared statements and
+ * statements executed by text are evicted separately, so ad hoc
+ * requests can't push prepared statements out: the least
+ * recently used statements of a kind are evicted when there are
+ * more than box.cfg.sql_cache_size of them. A statement
+ * compiled for an older schema or other session SQL settings
+ * is recompiled on the next use.
+ */
+
+/** Statement cache statistics, shown in box.stat.sql(). */
+struct sql_stmt_cache_stat {
+	/** Number of statements in the cache. */
+	uint32_t size;
+	/** Number of executions of a cached statement. */
+	uint64_t hits;
+	/** Number of executions that had to compile a statement. */
+	uint64_t misses;
+};
+
+/** Initialize the statement cache. */
+void
+sql_stmt_cache_init(void);
+
+/**
+ * Set the maximal number of statements in the cache. Idle
+ * statements beyond the limit are evicted at once.
+ */
+void
+sql_stmt_cache_set_size(uint32_t size);
+
+/**
+ * Get a statement for the text from the cache or compile it.
+ * The statement must be returned with sql_stmt_cache_release().
+ * @param sql Statement text.
+ * @param len Length of @a sql.
+ *
+ * @retval NULL Compilation error, the diag is set.
+ */
+struct sql_stmt *
+sql_stmt_cache_acquire(const char *sql, uint32_t len);
+
+/**
+ * Get a statement from the cache by id, compiling it again if
+ * it is busy or stale.
+ *
+ * @retval NULL ER_NO_SUCH_STATEMENT or compilation error, the
+ *         diag is set.
+ */
+struct sql_stmt *
+sql_stmt_cache_acquire_by_id(uint32_t id);
+
+/**
+ * Compile a statement and put it to the cache, or find it
+ * there, for sql_stmt_cache_acquire_by_id().
+ * @param sql Statement text.
+ * @param len Length of @a sql.
+ * @param[out] id Id of the statement.
+ *
+ * @retval  0 Success.
+ * @retval -1 Compilation or memory error, or the statement
+ *            can't be cached, the diag is set.
+ */
+int
+sql_stmt_cache_prepare(const char *sql, uint32_t len, uint32_t *id);
+
+/**
+ * Return a statement got with sql_stmt_cache_acquire(). A
+ * cached statement is reset and becomes available for other
+ * requests, a private one is finalized.
+ */
+void
+sql_stmt_cache_release(struct sql_stmt *stmt);
+
+/** Get statement cache statistics. */
+void
+sql_stmt_cache_stat(struct sql_stmt_cache_stat *stat);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_SQL_STMT_CACHE_H_INCLUDED */
@@ -39,6 +39,8 @@
 #include "tuple_update.h"
 #include "coll_id_cache.h"
 
+#include <zstd.h>
+
 static struct mempool tuple_iterator_pool;
 static struct small_alloc runtime_alloc;
 
@@ -69,6 +71,32 @@ static struct tuple_format_vtab tuple_format_runtime_vtab = {
 	runtime_tuple_new,
 };
 
+enum {
+	/** Number of tuples kept decompressed at once. */
+	TUPLE_DECOMPRESS_CACHE_SIZE = 32,
+};
+
+/** A tuple kept decompressed by tuple_decompress(). */
+struct tuple_decompress_entry {
+	/** The tuple, NULL if the entry is unused. */
+	struct tuple *tuple;
+	/** Decompressed MessagePack. */
+	char *data;
+	/** Size of @data buffer. */
+	size_t size;
+};
+
+/**
+ * Tuples decompressed by tuple_decompress(). Entries are reused
+ * in FIFO order, so memory taken by decompressed data doesn't
+ * depend on the number of tuples read.
+ */
+static struct {
+	struct tuple_decompress_entry entry[TUPLE_DECOMPRESS_CACHE_SIZE];
+	/** Entry to reuse next. */
+	uint32_t next;
+} tuple_decompress_cache;
+
 static struct tuple *
 runtime_tuple_new(struct tuple_format *format, const char *data, const char *end)
 {
@@ -93,6 +121,7 @@ runtime_tuple_new(struct tuple_format *format, const char *data, const char *end
 	}
 
 	tuple->refs = 0;
+	tuple->is_compressed = false;
 	tuple->bsize = data_len;
 	tuple->format_id = tuple_format_id(format);
 	tuple_format_ref(format);
@@ -117,6 +146,96 @@ runtime_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	smfree(&runtime_alloc, tuple, total);
 }
 
+int
+tuple_decompress_raw(struct tuple *tuple, char *buf)
+{
+	struct tuple_compressed *compressed = tuple_compressed(tuple);
+	const char *raw = (const char *) tuple + tuple->data_offset;
+	memcpy(buf, raw, compressed->prefix_size);
+	size_t size = tuple->bsize - compressed->prefix_size;
+	size_t rc = ZSTD_decompress(buf + compressed->prefix_size, size,
+				    raw + compressed->prefix_size,
+				    compressed->zsize);
+	if (ZSTD_isError(rc)) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 ZSTD_getErrorName(rc));
+		return -1;
+	}
+	if (rc != size) {
+		diag_set(ClientError, ER_DECOMPRESSION, "size mismatch");
+		return -1;
+	}
+	return 0;
+}
+
+int
+tuple_decompress_to(struct tuple *tuple, char **buf, size_t *buf_size)
+{
+	if (*buf_size < tuple->bsize) {
+		char *new_buf = realloc(*buf, tuple->bsize);
+		if (new_buf == NULL) {
+			diag_set(OutOfMemory, tuple->bsize, "realloc",
+				 "tuple data");
+			return -1;
+		}
+		*buf = new_buf;
+		*buf_size = tuple->bsize;
+	}
+	return tuple_decompress_raw(tuple, *buf);
+}
+
+const char *
+tuple_decompress(struct tuple *tuple)
+{
+	assert(tuple->is_compressed);
+	struct tuple_decompress_entry *entry = tuple_decompress_cache.entry;
+	for (int i = 0; i < TUPLE_DECOMPRESS_CACHE_SIZE; i++) {
+		if (entry[i].tuple == tuple)
+			return entry[i].data;
+	}
+	entry = &entry[tuple_decompress_cache.next];
+	tuple_decompress_cache.next = (tuple_decompress_cache.next + 1) %
+				      TUPLE_DECOMPRESS_CACHE_SIZE;
+	entry->tuple = NULL;
+	if (tuple_decompress_to(tuple, &entry->data, &entry->size) != 0)
+		return NULL;
+	entry->tuple = tuple;
+	return entry->data;
+}
+
+void
+tuple_decompress_forget(struct tuple *tuple)
+{
+	struct tuple_decompress_entry *entry = tuple_decompress_cache.entry;
+	for (int i = 0; i < TUPLE_DECOMPRESS_CACHE_SIZE; i++) {
+		if (entry[i].tuple == tuple)
+			entry[i].tuple = NULL;
+	}
+}
+
+const char *
+tuple_decompress_nofail(struct tuple *tuple)
+{
+	const char *data = tuple_decompress(tuple);
+	if (data == NULL) {
+		diag_log();
+		panic("failed to decompress a tuple");
+	}
+	return data;
+}
+
+const char *
+tuple_data_for_key_slow(struct tuple *tuple, struct key_def *key_def)
+{
+	assert(tuple->is_compressed);
+	uint32_t index_field_count = tuple_format(tuple)->index_field_count;
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		if (key_def->parts[i].fieldno >= index_field_count)
+			return tuple_decompress_nofail(tuple);
+	}
+	return (const char *) tuple + tuple->data_offset;
+}
+
 int
 tuple_validate_raw(struct tuple_format *format, const char *tuple)
 {
@@ -365,6 +484,9 @@ tuple_free(void)
 	mempool_destroy(&tuple_iterator_pool);
 	small_alloc_destroy(&runtime_alloc);
 
+	for (int i = 0; i < TUPLE_DECOMPRESS_CACHE_SIZE; i++)
+		free(tuple_decompress_cache.entry[i].data);
+
 	tuple_format_free();
 
 	coll_id_cache_destroy();
@@ -612,7 +734,9 @@ ssize_t
 tuple_to_buf(struct tuple *tuple, char *buf, size_t size)
 {
 	uint32_t bsize;
-	const char *data = tuple_data_range(tuple, &bsize);
+	const char *data = tuple_data_range_checked(tuple, &bsize);
+	if (data == NULL)
+		return -1;
 	if (likely(bsize <= size)) {
 		memcpy(buf, data, bsize);
 	}
@@ -296,6 +296,11 @@ box_tuple_upsert(box_tuple_t *tuple, const char *expr, const char *expr_end);
  * +---------------------------------------data_offset
  *
  * Each 'off_i' is the offset to the i-th indexed field.
+ *
+ * A compressed tuple has struct tuple_compressed between
+ * struct tuple and the field map, and only a prefix of its
+ * MessagePack covering all indexed fields is stored as is,
+ * see tuple_data_for_field().
  */
 struct PACKED tuple
 {
@@ -319,7 +324,11 @@ struct PACKED tuple
 	/**
 	 * Offset to the MessagePack from the begin of the tuple.
 	 */
-	uint16_t data_offset;
+	uint16_t data_offset : 15;
+	/**
+	 * The tuple is compressed, see struct tuple_compressed.
+	 */
+	bool is_compressed : 1;
 	/**
 	 * Engine specific fields and offsets array concatenated
 	 * with MessagePack fields array.
@@ -327,22 +336,107 @@ struct PACKED tuple
 	 */
 };
 
+/**
+ * Header of a compressed tuple. MessagePack of the tuple is
+ * split in two: a prefix of fields covered by indexes, which
+ * is stored as is, and the rest, which is compressed and
+ * follows the prefix. The whole MessagePack is decompressed
+ * on access to a small cache shared by all tuples, see
+ * tuple_decompress().
+ */
+struct PACKED tuple_compressed {
+	/** Size of the MessagePack prefix stored as is. */
+	uint32_t prefix_size;
+	/** Size of the compressed rest of the MessagePack. */
+	uint32_t zsize;
+};
+
+/** Header of a compressed tuple. */
+static inline struct tuple_compressed *
+tuple_compressed(struct tuple *tuple)
+{
+	assert(tuple->is_compressed);
+	return (struct tuple_compressed *)((char *)tuple +
+					   sizeof(struct tuple));
+}
+
 /** Size of the tuple including size of struct tuple. */
 static inline size_t
 tuple_size(struct tuple *tuple)
 {
 	/* data_offset includes sizeof(struct tuple). */
+	if (unlikely(tuple->is_compressed)) {
+		struct tuple_compressed *compressed = tuple_compressed(tuple);
+		return tuple->data_offset + compressed->prefix_size +
+		       compressed->zsize;
+	}
 	return tuple->data_offset + tuple->bsize;
 }
 
 /**
- * Get pointer to MessagePack data of the tuple.
+ * Decompress MessagePack of a compressed tuple. The data is
+ * kept in a cache of a few recently decompressed tuples and is
+ * valid until the tuple is deleted or as many other tuples are
+ * decompressed, so it must be used right away. Must be called
+ * only from the tx thread.
+ * @param tuple tuple.
+ * @retval NULL memory or decompression error, the diag is set.
+ * @return MessagePack array.
+ */
+const char *
+tuple_decompress(struct tuple *tuple);
+
+/**
+ * Drop decompressed data of a tuple from the cache used by
+ * tuple_decompress(). Must be called when a compressed tuple
+ * is deleted.
+ */
+void
+tuple_decompress_forget(struct tuple *tuple);
+
+/**
+ * tuple_decompress() for accessors which can't fail, such as
+ * comparators. Panics on error, which may be only an OOM of
+ * the runtime arena or a memory corruption.
+ */
+const char *
+tuple_decompress_nofail(struct tuple *tuple);
+
+/**
+ * Decompress MessagePack of a compressed tuple to a buffer of
+ * tuple->bsize bytes.
+ * @retval 0 success.
+ * @retval -1 decompression error.
+ */
+int
+tuple_decompress_raw(struct tuple *tuple, char *buf);
+
+/**
+ * Decompress MessagePack of a compressed tuple to a buffer
+ * owned by the caller, so that can be used by threads other
+ * than tx, e.g. to write a snapshot, or when the data must
+ * outlive the tuple_decompress() cache.
+ * @param tuple tuple.
+ * @param buf buffer, reallocated if it is shorter than the
+ *        tuple data.
+ * @param buf_size size of @a buf.
+ * @retval 0 success.
+ * @retval -1 memory or decompression error.
+ */
+int
+tuple_decompress_to(struct tuple *tuple, char **buf, size_t *buf_size);
+
+/**
+ * Get pointer to MessagePack data of the tuple. A compressed
+ * tuple is decompressed with tuple_decompress_nofail().
  * @param tuple tuple.
  * @return MessagePack array.
  */
 static inline const char *
 tuple_data(struct tuple *tuple)
 {
+	if (unlikely(tuple->is_compressed))
+		return tuple_decompress_nofail(tuple);
 	return (const char *) tuple + tuple->data_offset;
 }
 
@@ -365,9 +459,49 @@ static inline const char *
 tuple_data_range(struct tuple *tuple, uint32_t *p_size)
 {
 	*p_size = tuple->bsize;
+	return tuple_data(tuple);
+}
+
+/**
+ * Like tuple_data_range(), but fails instead of panicking if
+ * a compressed tuple can't be decompressed.
+ * @param tuple tuple.
+ * @param[out] p_size Size in bytes of the MessagePack array.
+ * @retval NULL memory error, the diag is set.
+ * @return MessagePack array.
+ */
+static inline const char *
+tuple_data_range_checked(struct tuple *tuple, uint32_t *p_size)
+{
+	*p_size = tuple->bsize;
+	if (unlikely(tuple->is_compressed))
+		return tuple_decompress(tuple);
 	return (const char *) tuple + tuple->data_offset;
 }
 
+/**
+ * Like tuple_data_range(), but decompresses a compressed
+ * tuple to the given buffer, see tuple_decompress_to().
+ * @param tuple tuple.
+ * @param buf buffer, must be freed by the caller.
+ * @param buf_size size of @a buf.
+ * @param[out] p_size Size of MessagePack data.
+ * @return MessagePack array.
+ */
+static inline const char *
+tuple_data_range_to(struct tuple *tuple, char **buf, size_t *buf_size,
+		    uint32_t *p_size)
+{
+	*p_size = tuple->bsize;
+	if (likely(!tuple->is_compressed))
+		return (const char *) tuple + tuple->data_offset;
+	if (tuple_decompress_to(tuple, buf, buf_size) != 0) {
+		diag_log();
+		panic("failed to decompress a tuple");
+	}
+	return *buf;
+}
+
 /**
  * Format a tuple into string.
  * Example: [1, 2, "string"]
@@ -417,6 +551,48 @@ tuple_format(struct tuple *tuple)
 	return format;
 }
 
+/**
+ * Get pointer to MessagePack data of the tuple to read
+ * a field. Fields covered by indexes of the tuple format are
+ * read from a compressed tuple without decompression.
+ * @param tuple tuple.
+ * @param fieldno number of the root field to read.
+ * @return MessagePack array, which may be valid only up to
+ *         the field.
+ */
+static inline const char *
+tuple_data_for_field(struct tuple *tuple, uint32_t fieldno)
+{
+	if (likely(!tuple->is_compressed))
+		return (const char *) tuple + tuple->data_offset;
+	if (fieldno < tuple_format(tuple)->index_field_count)
+		return (const char *) tuple + tuple->data_offset;
+	return tuple_decompress_nofail(tuple);
+}
+
+/**
+ * Slow path of tuple_data_for_key() for compressed tuples.
+ */
+const char *
+tuple_data_for_key_slow(struct tuple *tuple, struct key_def *key_def);
+
+/**
+ * Get pointer to MessagePack data of the tuple to read
+ * fields of a key. Comparators and key extractors use it,
+ * so that index lookups don't decompress tuples.
+ * @param tuple tuple.
+ * @param key_def key definition.
+ * @return MessagePack array, which may be valid only up to
+ *         the last field of the key.
+ */
+static inline const char *
+tuple_data_for_key(struct tuple *tuple, struct key_def *key_def)
+{
+	if (likely(!tuple->is_compressed))
+		return (const char *) tuple + tuple->data_offset;
+	return tuple_data_for_key_slow(tuple, key_def);
+}
+
 /**
  * Instantiate a new engine-independent tuple from raw MsgPack Array data
  * using runtime arena. Use this function to create a standalone tuple
@@ -495,7 +671,7 @@ tuple_field_map(struct tuple *tuple)
 static inline uint32_t
 tuple_field_count(struct tuple *tuple)
 {
-	const char *data = tuple_data(tuple);
+	const char *data = tuple_data_for_field(tuple, 0);
 	return mp_decode_array(&data);
 }
 
@@ -619,7 +795,8 @@ tuple_field_raw(struct tuple_format *format, const char *tuple,
 static inline const char *
 tuple_field(struct tuple *tuple, uint32_t fieldno)
 {
-	return tuple_field_raw(tuple_format(tuple), tuple_data(tuple),
+	return tuple_field_raw(tuple_format(tuple),
+			       tuple_data_for_field(tuple, fieldno),
 			       tuple_field_map(tuple), fieldno);
 }
 
@@ -683,7 +860,8 @@ static inline const char *
 tuple_field_by_part(struct tuple *tuple, struct key_part *part,
 		    int multikey_idx)
 {
-	return tuple_field_raw_by_part(tuple_format(tuple), tuple_data(tuple),
+	return tuple_field_raw_by_part(tuple_format(tuple),
+				       tuple_data_for_field(tuple, part->fieldno),
 				       tuple_field_map(tuple), part,
 				       multikey_idx);
 }
@@ -711,7 +889,8 @@ tuple_raw_multikey_count(struct tuple_format *format, const char *data,
 static inline uint32_t
 tuple_multikey_count(struct tuple *tuple, struct key_def *key_def)
 {
-	return tuple_raw_multikey_count(tuple_format(tuple), tuple_data(tuple),
+	return tuple_raw_multikey_count(tuple_format(tuple),
+					tuple_data_for_key(tuple, key_def),
 					tuple_field_map(tuple), key_def);
 }
 
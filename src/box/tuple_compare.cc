@@ -463,8 +463,8 @@ tuple_compare_slowpath(struct tuple *tuple_a, hint_t tuple_a_hint,
 	if (!is_multikey && (rc = hint_cmp(tuple_a_hint, tuple_b_hint)) != 0)
 		return rc;
 	struct key_part *part = key_def->parts;
-	const char *tuple_a_raw = tuple_data(tuple_a);
-	const char *tuple_b_raw = tuple_data(tuple_b);
+	const char *tuple_a_raw = tuple_data_for_key(tuple_a, key_def);
+	const char *tuple_b_raw = tuple_data_for_key(tuple_b, key_def);
 	if (key_def->part_count == 1 && part->fieldno == 0 &&
 	    (!has_json_paths || part->path == NULL)) {
 		/*
@@ -623,7 +623,7 @@ tuple_compare_with_key_slowpath(struct tuple *tuple, hint_t tuple_hint,
 		return rc;
 	struct key_part *part = key_def->parts;
 	struct tuple_format *format = tuple_format(tuple);
-	const char *tuple_raw = tuple_data(tuple);
+	const char *tuple_raw = tuple_data_for_key(tuple, key_def);
 	const uint32_t *field_map = tuple_field_map(tuple);
 	enum mp_type a_type, b_type;
 	if (likely(part_count == 1)) {
@@ -773,7 +773,7 @@ tuple_compare_with_key_sequential(struct tuple *tuple, hint_t tuple_hint,
 	int rc = hint_cmp(tuple_hint, key_hint);
 	if (rc != 0)
 		return rc;
-	const char *tuple_key = tuple_data(tuple);
+	const char *tuple_key = tuple_data_for_key(tuple, key_def);
 	uint32_t field_count = mp_decode_array(&tuple_key);
 	uint32_t cmp_part_count;
 	if (has_optional_parts && field_count < part_count) {
@@ -840,9 +840,9 @@ tuple_compare_sequential(struct tuple *tuple_a, hint_t tuple_a_hint,
 	int rc = hint_cmp(tuple_a_hint, tuple_b_hint);
 	if (rc != 0)
 		return rc;
-	const char *key_a = tuple_data(tuple_a);
+	const char *key_a = tuple_data_for_key(tuple_a, key_def);
 	uint32_t fc_a = mp_decode_array(&key_a);
-	const char *key_b = tuple_data(tuple_b);
+	const char *key_b = tuple_data_for_key(tuple_b, key_def);
 	uint32_t fc_b = mp_decode_array(&key_b);
 	if (!has_optional_parts && !is_nullable) {
 		assert(fc_a >= key_def->part_count);
@@ -981,12 +981,12 @@ struct FieldCompare<IDX, TYPE, IDX2, TYPE2, MORE_TYPES...>
 		} else {
 			if ((r = field_compare<TYPE>(&field_a, &field_b)) != 0)
 				return r;
-			field_a = tuple_field_raw(format_a, tuple_data(tuple_a),
-						  tuple_field_map(tuple_a),
-						  IDX2);
-			field_b = tuple_field_raw(format_b, tuple_data(tuple_b),
-						  tuple_field_map(tuple_b),
-						  IDX2);
+			field_a = tuple_field_raw(format_a,
+					tuple_data_for_field(tuple_a, IDX2),
+					tuple_field_map(tuple_a), IDX2);
+			field_b = tuple_field_raw(format_b,
+					tuple_data_for_field(tuple_b, IDX2),
+					tuple_field_map(tuple_b), IDX2);
 		}
 		return FieldCompare<IDX2, TYPE2, MORE_TYPES...>::
 			compare(tuple_a, tuple_b, format_a,
@@ -1016,7 +1016,7 @@ struct TupleCompare
 {
 	static int compare(struct tuple *tuple_a, hint_t tuple_a_hint,
 			   struct tuple *tuple_b, hint_t tuple_b_hint,
-			   struct key_def *)
+			   struct key_def *key_def)
 	{
 		int rc = hint_cmp(tuple_a_hint, tuple_b_hint);
 		if (rc != 0)
@@ -1024,9 +1024,11 @@ struct TupleCompare
 		struct tuple_format *format_a = tuple_format(tuple_a);
 		struct tuple_format *format_b = tuple_format(tuple_b);
 		const char *field_a, *field_b;
-		field_a = tuple_field_raw(format_a, tuple_data(tuple_a),
+		field_a = tuple_field_raw(format_a,
+					  tuple_data_for_key(tuple_a, key_def),
 					  tuple_field_map(tuple_a), IDX);
-		field_b = tuple_field_raw(format_b, tuple_data(tuple_b),
+		field_b = tuple_field_raw(format_b,
+					  tuple_data_for_key(tuple_b, key_def),
 					  tuple_field_map(tuple_b), IDX);
 		return FieldCompare<IDX, TYPE, MORE_TYPES...>::
 			compare(tuple_a, tuple_b, format_a,
@@ -1038,15 +1040,15 @@ template <int TYPE, int ...MORE_TYPES>
 struct TupleCompare<0, TYPE, MORE_TYPES...> {
 	static int compare(struct tuple *tuple_a, hint_t tuple_a_hint,
 			   struct tuple *tuple_b, hint_t tuple_b_hint,
-			   struct key_def *)
+			   struct key_def *key_def)
 	{
 		int rc = hint_cmp(tuple_a_hint, tuple_b_hint);
 		if (rc != 0)
 			return rc;
 		struct tuple_format *format_a = tuple_format(tuple_a);
 		struct tuple_format *format_b = tuple_format(tuple_b);
-		const char *field_a = tuple_data(tuple_a);
-		const char *field_b = tuple_data(tuple_b);
+		const char *field_a = tuple_data_for_key(tuple_a, key_def);
+		const char *field_b = tuple_data_for_key(tuple_b, key_def);
 		mp_decode_array(&field_a);
 		mp_decode_array(&field_b);
 		return FieldCompare<0, TYPE, MORE_TYPES...>::compare(tuple_a, tuple_b,
@@ -1168,8 +1170,9 @@ struct FieldCompareWithKey<FLD_ID, IDX, TYPE, IDX2, TYPE2, MORE_TYPES...>
 			r = field_compare_with_key<TYPE>(&field, &key);
 			if (r || part_count == FLD_ID + 1)
 				return r;
-			field = tuple_field_raw(format, tuple_data(tuple),
-						tuple_field_map(tuple), IDX2);
+			field = tuple_field_raw(format,
+					tuple_data_for_field(tuple, IDX2),
+					tuple_field_map(tuple), IDX2);
 			mp_next(&key);
 		}
 		return FieldCompareWithKey<FLD_ID + 1, IDX2, TYPE2, MORE_TYPES...>::
@@ -1209,9 +1212,9 @@ struct TupleCompareWithKey
 		if (rc != 0)
 			return rc;
 		struct tuple_format *format = tuple_format(tuple);
-		const char *field = tuple_field_raw(format, tuple_data(tuple),
-						    tuple_field_map(tuple),
-						    IDX);
+		const char *field = tuple_field_raw(format,
+					tuple_data_for_key(tuple, key_def),
+					tuple_field_map(tuple), IDX);
 		return FieldCompareWithKey<FLD_ID, IDX, TYPE, MORE_TYPES...>::
 				compare(tuple, key, part_count,
 					key_def, format, field);
@@ -1232,7 +1235,7 @@ struct TupleCompareWithKey<0, 0, TYPE, MORE_TYPES...>
 		if (rc != 0)
 			return rc;
 		struct tuple_format *format = tuple_format(tuple);
-		const char *field = tuple_data(tuple);
+		const char *field = tuple_data_for_key(tuple, key_def);
 		mp_decode_array(&field);
 		return FieldCompareWithKey<0, 0, TYPE, MORE_TYPES...>::
 			compare(tuple, key, part_count,
@@ -1271,6 +1274,346 @@ static const comparator_with_key_signature cmp_wk_arr[] = {
 
 /* }}} tuple_compare_with_key */
 
+/* {{{ tuple_compare_typed */
+
+/**
+ * Pre-compiled comparators above are bound to both field numbers
+ * and types of key parts, so there are only a few of them. The
+ * comparators below are specialized only by types of key parts,
+ * which lets them serve composite keys of up to
+ * TYPED_PART_COUNT_MAX parts over any fields. A key part type
+ * falls into one of the classes listed below. The comparison
+ * function of each part is known at compile time, so there's no
+ * switch on the part type for each compared field.
+ */
+enum typed_part {
+	/** Unsigned or integer part. */
+	TYPED_PART_INTEGER,
+	/** Number part. */
+	TYPED_PART_NUMBER,
+	/** String part without collation. */
+	TYPED_PART_STRING,
+	/** String part with collation. */
+	TYPED_PART_STRING_COLL,
+	typed_part_MAX,
+};
+
+enum { TYPED_PART_COUNT_MAX = 4 };
+
+/**
+ * Return the class of a key part or typed_part_MAX if there
+ * is no specialized comparator for the part type.
+ */
+static enum typed_part
+typed_part_of(const struct key_part *part)
+{
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+		return TYPED_PART_INTEGER;
+	case FIELD_TYPE_NUMBER:
+		return TYPED_PART_NUMBER;
+	case FIELD_TYPE_STRING:
+		return part->coll != NULL ? TYPED_PART_STRING_COLL :
+					    TYPED_PART_STRING;
+	default:
+		return typed_part_MAX;
+	}
+}
+
+template <int TYPE>
+static inline int
+typed_field_compare(const char *field_a, const char *field_b,
+		    struct coll *coll);
+
+template <>
+inline int
+typed_field_compare<TYPED_PART_INTEGER>(const char *field_a,
+					const char *field_b, struct coll *)
+{
+	enum mp_type a_type = mp_typeof(*field_a);
+	enum mp_type b_type = mp_typeof(*field_b);
+	if (likely(a_type == MP_UINT && b_type == MP_UINT))
+		return mp_compare_uint(field_a, field_b);
+	return mp_compare_integer_with_type(field_a, a_type, field_b, b_type);
+}
+
+template <>
+inline int
+typed_field_compare<TYPED_PART_NUMBER>(const char *field_a,
+				       const char *field_b, struct coll *)
+{
+	return mp_compare_number(field_a, field_b);
+}
+
+template <>
+inline int
+typed_field_compare<TYPED_PART_STRING>(const char *field_a,
+				       const char *field_b, struct coll *)
+{
+	return mp_compare_str(field_a, field_b);
+}
+
+template <>
+inline int
+typed_field_compare<TYPED_PART_STRING_COLL>(const char *field_a,
+					    const char *field_b,
+					    struct coll *coll)
+{
+	return mp_compare_str_coll(field_a, field_b, coll);
+}
+
+namespace /* local symbols */ {
+
+/** Tuple data needed to look up key fields. */
+struct typed_tuple {
+	struct tuple_format *format;
+	const char *data;
+	const uint32_t *field_map;
+
+	typed_tuple(struct tuple *tuple, struct key_def *key_def)
+		: format(tuple_format(tuple)),
+		  data(tuple_data_for_key(tuple, key_def)),
+		  field_map(tuple_field_map(tuple)) {}
+
+	/**
+	 * Return the field of the key part following @a part,
+	 * given the field of @a part.
+	 */
+	inline const char *
+	next_field(const struct key_part *part, const char *field) const
+	{
+		const struct key_part *next = part + 1;
+		if (next->fieldno == part->fieldno + 1) {
+			mp_next(&field);
+			return field;
+		}
+		return tuple_field_raw(format, data, field_map, next->fieldno);
+	}
+};
+
+template <int ...TYPES> struct TypedCompare { };
+
+template <int TYPE, int ...MORE_TYPES>
+struct TypedCompare<TYPE, MORE_TYPES...>
+{
+	inline static int
+	compare(const struct typed_tuple *tuple_a, const char *field_a,
+		const struct typed_tuple *tuple_b, const char *field_b,
+		const struct key_part *part)
+	{
+		int rc = typed_field_compare<TYPE>(field_a, field_b,
+						   part->coll);
+		/* static if */
+		if (rc != 0 || sizeof...(MORE_TYPES) == 0)
+			return rc;
+		field_a = tuple_a->next_field(part, field_a);
+		field_b = tuple_b->next_field(part, field_b);
+		return TypedCompare<MORE_TYPES...>::
+			compare(tuple_a, field_a, tuple_b, field_b, part + 1);
+	}
+
+	inline static int
+	compare_with_key(const struct typed_tuple *tuple, const char *field,
+			 const char *key, uint32_t part_count,
+			 const struct key_part *part)
+	{
+		int rc = typed_field_compare<TYPE>(field, key, part->coll);
+		/* static if */
+		if (rc != 0 || sizeof...(MORE_TYPES) == 0 || part_count == 1)
+			return rc;
+		field = tuple->next_field(part, field);
+		mp_next(&key);
+		return TypedCompare<MORE_TYPES...>::
+			compare_with_key(tuple, field, key, part_count - 1,
+					 part + 1);
+	}
+};
+
+/** Terminates the recursion, never called. */
+template <>
+struct TypedCompare<>
+{
+	inline static int
+	compare(const struct typed_tuple *, const char *,
+		const struct typed_tuple *, const char *,
+		const struct key_part *)
+	{
+		unreachable();
+		return 0;
+	}
+
+	inline static int
+	compare_with_key(const struct typed_tuple *, const char *,
+			 const char *, uint32_t, const struct key_part *)
+	{
+		unreachable();
+		return 0;
+	}
+};
+
+template <int ...TYPES>
+static int
+tuple_compare_typed(struct tuple *tuple_a, hint_t tuple_a_hint,
+		    struct tuple *tuple_b, hint_t tuple_b_hint,
+		    struct key_def *key_def)
+{
+	assert(key_def->part_count == sizeof...(TYPES));
+	int rc = hint_cmp(tuple_a_hint, tuple_b_hint);
+	if (rc != 0)
+		return rc;
+	const struct key_part *part = key_def->parts;
+	struct typed_tuple a(tuple_a, key_def);
+	struct typed_tuple b(tuple_b, key_def);
+	const char *field_a = tuple_field_raw(a.format, a.data, a.field_map,
+					      part->fieldno);
+	const char *field_b = tuple_field_raw(b.format, b.data, b.field_map,
+					      part->fieldno);
+	return TypedCompare<TYPES...>::compare(&a, field_a, &b, field_b, part);
+}
+
+template <int ...TYPES>
+static int
+tuple_compare_with_key_typed(struct tuple *tuple, hint_t tuple_hint,
+			     const char *key, uint32_t part_count,
+			     hint_t key_hint, struct key_def *key_def)
+{
+	assert(key_def->part_count == sizeof...(TYPES));
+	assert(part_count <= key_def->part_count);
+	/* Part count can be 0 in wildcard searches. */
+	if (part_count == 0)
+		return 0;
+	int rc = hint_cmp(tuple_hint, key_hint);
+	if (rc != 0)
+		return rc;
+	const struct key_part *part = key_def->parts;
+	struct typed_tuple t(tuple, key_def);
+	const char *field = tuple_field_raw(t.format, t.data, t.field_map,
+					    part->fieldno);
+	return TypedCompare<TYPES...>::
+		compare_with_key(&t, field, key, part_count, part);
+}
+
+/** Checks if all TYPES are integer or string without collation. */
+template <int ...TYPES> struct TypedPartsAreBasic;
+
+template <>
+struct TypedPartsAreBasic<>
+{
+	static const bool value = true;
+};
+
+template <int TYPE, int ...MORE_TYPES>
+struct TypedPartsAreBasic<TYPE, MORE_TYPES...>
+{
+	static const bool value = (TYPE == TYPED_PART_INTEGER ||
+				   TYPE == TYPED_PART_STRING) &&
+				  TypedPartsAreBasic<MORE_TYPES...>::value;
+};
+
+/**
+ * Sets comparators for a key of parts of TYPES classes,
+ * is_instantiated tells if there are any.
+ */
+template <bool is_instantiated, int ...TYPES>
+struct TypedCompareSetter
+{
+	static bool
+	set(tuple_compare_t *cmp, tuple_compare_with_key_t *cmp_wk)
+	{
+		*cmp = tuple_compare_typed<TYPES...>;
+		*cmp_wk = tuple_compare_with_key_typed<TYPES...>;
+		return true;
+	}
+};
+
+template <int ...TYPES>
+struct TypedCompareSetter<false, TYPES...>
+{
+	static bool
+	set(tuple_compare_t *, tuple_compare_with_key_t *)
+	{
+		return false;
+	}
+};
+
+/**
+ * Walks key parts and picks the comparators instantiated for
+ * their classes. TYPES are the classes of the parts visited so
+ * far, is_last is set when there are TYPED_PART_COUNT_MAX of
+ * them. Keys of TYPED_PART_COUNT_MAX parts are rarely anything
+ * but integers and strings, so the comparators for them are
+ * instantiated only for integer and string parts, which saves
+ * a few hundred instantiations.
+ */
+template <bool is_last, int ...TYPES>
+struct TypedCompareSelector
+{
+	static bool
+	select(struct key_def *def, tuple_compare_t *cmp,
+	       tuple_compare_with_key_t *cmp_wk)
+	{
+		const uint32_t count = sizeof...(TYPES);
+		if (count == def->part_count)
+			return TypedCompareSetter<sizeof...(TYPES) != 0,
+						  TYPES...>::set(cmp, cmp_wk);
+		const bool next_is_last = count + 1 == TYPED_PART_COUNT_MAX;
+		switch (typed_part_of(&def->parts[count])) {
+		case TYPED_PART_INTEGER:
+			return TypedCompareSelector<next_is_last, TYPES...,
+						    TYPED_PART_INTEGER>::
+				select(def, cmp, cmp_wk);
+		case TYPED_PART_NUMBER:
+			return TypedCompareSelector<next_is_last, TYPES...,
+						    TYPED_PART_NUMBER>::
+				select(def, cmp, cmp_wk);
+		case TYPED_PART_STRING:
+			return TypedCompareSelector<next_is_last, TYPES...,
+						    TYPED_PART_STRING>::
+				select(def, cmp, cmp_wk);
+		case TYPED_PART_STRING_COLL:
+			return TypedCompareSelector<next_is_last, TYPES...,
+						    TYPED_PART_STRING_COLL>::
+				select(def, cmp, cmp_wk);
+		default:
+			return false;
+		}
+	}
+};
+
+template <int ...TYPES>
+struct TypedCompareSelector<true, TYPES...>
+{
+	static bool
+	select(struct key_def *def, tuple_compare_t *cmp,
+	       tuple_compare_with_key_t *cmp_wk)
+	{
+		assert(def->part_count == sizeof...(TYPES));
+		(void)def;
+		return TypedCompareSetter<TypedPartsAreBasic<TYPES...>::value,
+					  TYPES...>::set(cmp, cmp_wk);
+	}
+};
+
+} /* end of anonymous namespace */
+
+/**
+ * Find comparators specialized for types of the key parts.
+ * Return false if there's none, i.e. the key is too long,
+ * nullable, has JSON paths or parts of other types.
+ */
+static bool
+key_def_find_compare_func_typed(struct key_def *def, tuple_compare_t *cmp,
+				tuple_compare_with_key_t *cmp_wk)
+{
+	if (def->is_nullable || def->has_json_paths ||
+	    def->part_count == 0 || def->part_count > TYPED_PART_COUNT_MAX)
+		return false;
+	return TypedCompareSelector<false>::select(def, cmp, cmp_wk);
+}
+
+/* }}} tuple_compare_typed */
+
 /* {{{ tuple_hint */
 
 /**
@@ -1530,10 +1873,18 @@ field_hint_scalar(const char *field, struct coll *coll)
 	return HINT_NONE;
 }
 
-template <enum field_type type, bool is_nullable>
+/**
+ * Compute the hint of a key field. has_coll tells at compile time
+ * whether the key part has a collation, so that hint functions of
+ * string parts don't check it for each field.
+ */
+template <enum field_type type, bool is_nullable, bool has_coll>
 static inline hint_t
 field_hint(const char *field, struct coll *coll)
 {
+	assert(has_coll == (coll != NULL));
+	if (!has_coll)
+		coll = NULL;
 	if (is_nullable && mp_typeof(*field) == MP_NIL)
 		return hint_nil();
 	switch (type) {
@@ -1555,17 +1906,18 @@ field_hint(const char *field, struct coll *coll)
 	return HINT_NONE;
 }
 
-template <enum field_type type, bool is_nullable>
+template <enum field_type type, bool is_nullable, bool has_coll>
 static hint_t
 key_hint(const char *key, uint32_t part_count, struct key_def *key_def)
 {
 	assert(!key_def_is_multikey(key_def));
 	if (part_count == 0)
 		return HINT_NONE;
-	return field_hint<type, is_nullable>(key, key_def->parts->coll);
+	return field_hint<type, is_nullable, has_coll>(key,
+						      key_def->parts->coll);
 }
 
-template <enum field_type type, bool is_nullable>
+template <enum field_type type, bool is_nullable, bool has_coll>
 static hint_t
 tuple_hint(struct tuple *tuple, struct key_def *key_def)
 {
@@ -1574,7 +1926,8 @@ tuple_hint(struct tuple *tuple, struct key_def *key_def)
 						MULTIKEY_NONE);
 	if (is_nullable && field == NULL)
 		return hint_nil();
-	return field_hint<type, is_nullable>(field, key_def->parts->coll);
+	return field_hint<type, is_nullable, has_coll>(field,
+						      key_def->parts->coll);
 }
 
 static hint_t
@@ -1606,12 +1959,22 @@ tuple_hint_multikey(struct tuple *tuple, struct key_def *key_def)
 	return HINT_NONE;
 }
 
+template<enum field_type type, bool is_nullable, bool has_coll>
+static void
+key_def_set_hint_func(struct key_def *def)
+{
+	def->key_hint = key_hint<type, is_nullable, has_coll>;
+	def->tuple_hint = tuple_hint<type, is_nullable, has_coll>;
+}
+
 template<enum field_type type, bool is_nullable>
 static void
 key_def_set_hint_func(struct key_def *def)
 {
-	def->key_hint = key_hint<type, is_nullable>;
-	def->tuple_hint = tuple_hint<type, is_nullable>;
+	if (def->parts->coll != NULL)
+		key_def_set_hint_func<type, is_nullable, true>(def);
+	else
+		key_def_set_hint_func<type, is_nullable, false>(def);
 }
 
 template<enum field_type type>
@@ -1659,6 +2022,70 @@ key_def_set_hint_func(struct key_def *def)
 	}
 }
 
+/**
+ * Shrink an unsigned integer to the given number of bits so that
+ * the order of the results matches the order of the arguments.
+ * Small numbers are stored as is, big numbers are stored as the
+ * position of the most significant bit (6 bits) followed by the
+ * bits that follow it.
+ */
+static inline uint64_t
+hint_pack_uint(uint64_t u, int bits)
+{
+	int mantissa_bits = bits - 6;
+	assert(mantissa_bits > 0);
+	if (u < (1ULL << mantissa_bits))
+		return u;
+	int msb = 63 - __builtin_clzll(u);
+	uint64_t exp = msb - mantissa_bits + 1;
+	uint64_t mantissa = (u >> (msb - mantissa_bits)) &
+			    ((1ULL << mantissa_bits) - 1);
+	return exp << mantissa_bits | mantissa;
+}
+
+uint32_t
+hint_pack(hint_t hint, int bits)
+{
+	assert(bits > HINT_CLASS_BITS + 8 && bits < 32);
+	if (hint == HINT_NONE)
+		return (1U << bits) - 1;
+	int value_bits = bits - HINT_CLASS_BITS;
+	uint64_t c = hint >> HINT_VALUE_BITS;
+	uint64_t val = hint & HINT_VALUE_MAX;
+	uint64_t packed;
+	switch (c) {
+	case MP_CLASS_NIL:
+	case MP_CLASS_BOOL:
+		packed = val;
+		break;
+	case MP_CLASS_NUMBER: {
+		/*
+		 * Most numbers stored in indexes are close to 0, so
+		 * rather than cutting off the low bits, store the
+		 * sign and the magnitude in a floating point manner.
+		 */
+		int64_t i = (int64_t)val + HINT_VALUE_INT_MIN;
+		uint64_t sign = 1ULL << (value_bits - 1);
+		if (i >= 0)
+			packed = sign | hint_pack_uint(i, value_bits - 1);
+		else
+			packed = sign - 1 - hint_pack_uint(-(i + 1),
+							   value_bits - 1);
+		break;
+	}
+	case MP_CLASS_STR:
+	case MP_CLASS_BIN:
+		/* Keep the first characters of the string. */
+		packed = val >> (HINT_VALUE_BYTES * CHAR_BIT - value_bits);
+		break;
+	default:
+		packed = val >> (HINT_VALUE_BITS - value_bits);
+		break;
+	}
+	assert(packed < (1ULL << value_bits));
+	return (uint32_t)(c << value_bits | packed);
+}
+
 /* }}} tuple_hint */
 
 static void
@@ -1667,17 +2094,19 @@ key_def_set_compare_func_fast(struct key_def *def)
 	assert(!def->is_nullable);
 	assert(!def->has_optional_parts);
 	assert(!def->has_json_paths);
-	assert(!key_def_has_collation(def));
 
 	tuple_compare_t cmp = NULL;
 	tuple_compare_with_key_t cmp_wk = NULL;
 	bool is_sequential = key_def_is_sequential(def);
 
 	/*
-	 * Use pre-compiled comparators if available, otherwise
-	 * fall back on generic comparators.
+	 * Use pre-compiled comparators if available, then the
+	 * ones specialized by part types, otherwise fall back on
+	 * generic comparators. Pre-compiled comparators don't
+	 * support collations.
 	 */
-	for (uint32_t k = 0; k < lengthof(cmp_arr); k++) {
+	bool has_collation = key_def_has_collation(def);
+	for (uint32_t k = 0; k < lengthof(cmp_arr) && !has_collation; k++) {
 		uint32_t i = 0;
 		for (; i < def->part_count; i++)
 			if (def->parts[i].fieldno != cmp_arr[k].p[i * 2] ||
@@ -1688,7 +2117,7 @@ key_def_set_compare_func_fast(struct key_def *def)
 			break;
 		}
 	}
-	for (uint32_t k = 0; k < lengthof(cmp_wk_arr); k++) {
+	for (uint32_t k = 0; k < lengthof(cmp_wk_arr) && !has_collation; k++) {
 		uint32_t i = 0;
 		for (; i < def->part_count; i++) {
 			if (def->parts[i].fieldno != cmp_wk_arr[k].p[i * 2] ||
@@ -1700,6 +2129,15 @@ key_def_set_compare_func_fast(struct key_def *def)
 			break;
 		}
 	}
+	tuple_compare_t typed_cmp;
+	tuple_compare_with_key_t typed_cmp_wk;
+	if ((cmp == NULL || cmp_wk == NULL) &&
+	    key_def_find_compare_func_typed(def, &typed_cmp, &typed_cmp_wk)) {
+		if (cmp == NULL)
+			cmp = typed_cmp;
+		if (cmp_wk == NULL)
+			cmp_wk = typed_cmp_wk;
+	}
 	if (cmp == NULL) {
 		cmp = is_sequential ?
 			tuple_compare_sequential<false, false> :
@@ -1755,18 +2193,14 @@ key_def_set_compare_func_json(struct key_def *def)
 void
 key_def_set_compare_func(struct key_def *def)
 {
-	if (!key_def_has_collation(def) &&
-	    !def->is_nullable && !def->has_json_paths) {
+	if (!def->is_nullable && !def->has_json_paths) {
 		key_def_set_compare_func_fast(def);
 	} else if (!def->has_json_paths) {
-		if (def->is_nullable && def->has_optional_parts) {
+		assert(def->is_nullable);
+		if (def->has_optional_parts)
 			key_def_set_compare_func_plain<true, true>(def);
-		} else if (def->is_nullable && !def->has_optional_parts) {
+		else
 			key_def_set_compare_func_plain<true, false>(def);
-		} else {
-			assert(!def->is_nullable && !def->has_optional_parts);
-			key_def_set_compare_func_plain<false, false>(def);
-		}
 	} else {
 		if (def->is_nullable && def->has_optional_parts) {
 			key_def_set_compare_func_json<true, true>(def);
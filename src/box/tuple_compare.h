@@ -69,6 +69,32 @@ typedef uint64_t hint_t;
  */
 #define HINT_NONE ((hint_t)UINT64_MAX)
 
+/**
+ * Pack a comparison hint into the given number of bits, which
+ * must be greater than 12 and less than 32. Hints of
+ * different values may be packed to the same number, but the
+ * packing never breaks the hint order: if pack(h1) < pack(h2)
+ * then h1 < h2. HINT_NONE is packed to all ones.
+ *
+ * Note, packed hints may only be compared with each other or
+ * with hints that went through hint_unpack(), because the result
+ * of hint_unpack() isn't equal to the original hint.
+ */
+uint32_t
+hint_pack(hint_t hint, int bits);
+
+/**
+ * Convert a hint packed with hint_pack() back to a hint that
+ * can be passed to comparators.
+ */
+static inline hint_t
+hint_unpack(uint32_t packed, int bits)
+{
+	if (packed == (1U << bits) - 1)
+		return HINT_NONE;
+	return (hint_t)packed << (sizeof(hint_t) * 8 - bits);
+}
+
 /**
  * Initialize comparator functions for the key_def.
  * @param key_def key definition
@@ -41,7 +41,9 @@ int
 tuple_to_obuf(struct tuple *tuple, struct obuf *buf)
 {
 	uint32_t bsize;
-	const char *data = tuple_data_range(tuple, &bsize);
+	const char *data = tuple_data_range_checked(tuple, &bsize);
+	if (data == NULL)
+		return -1;
 	if (obuf_dup(buf, data, bsize) != bsize) {
 		diag_set(OutOfMemory, bsize, "tuple_to_obuf", "dup");
 		return -1;
@@ -94,7 +94,7 @@ tuple_extract_key_sequential(struct tuple *tuple, struct key_def *key_def,
 	assert(key_def_is_sequential(key_def));
 	assert(!has_optional_parts || key_def->is_nullable);
 	assert(has_optional_parts == key_def->has_optional_parts);
-	const char *data = tuple_data(tuple);
+	const char *data = tuple_data_for_key(tuple, key_def);
 	const char *data_end = data + tuple->bsize;
 	return tuple_extract_key_sequential_raw<has_optional_parts>(data,
 								    data_end,
@@ -121,7 +121,7 @@ tuple_extract_key_slowpath(struct tuple *tuple, struct key_def *key_def,
 	assert(is_multikey == key_def_is_multikey(key_def));
 	assert(!key_def_is_multikey(key_def) || multikey_idx != MULTIKEY_NONE);
 	assert(mp_sizeof_nil() == 1);
-	const char *data = tuple_data(tuple);
+	const char *data = tuple_data_for_key(tuple, key_def);
 	uint32_t part_count = key_def->part_count;
 	uint32_t bsize = mp_sizeof_array(part_count);
 	struct tuple_format *format = tuple_format(tuple);
@@ -436,7 +436,7 @@ tuple_key_contains_null(struct tuple *tuple, struct key_def *def,
 			int multikey_idx)
 {
 	struct tuple_format *format = tuple_format(tuple);
-	const char *data = tuple_data(tuple);
+	const char *data = tuple_data_for_key(tuple, def);
 	const uint32_t *field_map = tuple_field_map(tuple);
 	for (struct key_part *part = def->parts, *end = part + def->part_count;
 	     part < end; ++part) {
@@ -37,6 +37,7 @@
 #include "json/json.h"
 #include "tuple_dictionary.h"
 #include "field_map.h"
+#include "schema_def.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -49,6 +50,12 @@ void
 tuple_format_free();
 
 enum { FORMAT_ID_MAX = UINT16_MAX - 1, FORMAT_ID_NIL = UINT16_MAX };
+
+/**
+ * Max size of a field map. It leaves room for headers in front
+ * of the field map within 15 bits of tuple->data_offset.
+ */
+enum { TUPLE_FIELD_MAP_SIZE_MAX = INT16_MAX - 64 };
 enum { FORMAT_REF_MAX = INT32_MAX};
 
 /*
@@ -173,6 +180,16 @@ struct tuple_format {
 	 * in progress.
 	 */
 	bool is_temporary;
+	/**
+	 * Compression of tuples of this format, which is done
+	 * by the engine for tuples not shorter than
+	 * compression_threshold.
+	 */
+	enum tuple_compression compression;
+	/** Min size of a tuple to compress. */
+	uint32_t compression_threshold;
+	/** Zstd compression level. */
+	uint32_t compression_level;
 	/**
 	 * This format belongs to ephemeral space and thus might
 	 * be shared with other ephemeral spaces.
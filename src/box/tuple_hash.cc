@@ -370,7 +370,7 @@ tuple_hash_slowpath(struct tuple *tuple, struct key_def *key_def)
 	uint32_t total_size = 0;
 	uint32_t prev_fieldno = key_def->parts[0].fieldno;
 	struct tuple_format *format = tuple_format(tuple);
-	const char *tuple_raw = tuple_data(tuple);
+	const char *tuple_raw = tuple_data_for_key(tuple, key_def);
 	const uint32_t *field_map = tuple_field_map(tuple);
 	const char *field;
 	if (has_json_paths) {
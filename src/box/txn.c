@@ -33,6 +33,7 @@
 #include "tuple.h"
 #include "journal.h"
 #include <fiber.h>
+#include "fiber_cond.h"
 #include "xrow.h"
 
 double too_long_threshold;
@@ -326,8 +327,9 @@ fail:
 	return -1;
 }
 
-static int64_t
-txn_write_to_wal(struct txn *txn)
+/** Create a journal entry containing all redo rows of a txn. */
+static struct journal_entry *
+txn_journal_entry_new(struct txn *txn)
 {
 	assert(txn->n_new_rows + txn->n_applier_rows > 0);
 
@@ -335,7 +337,7 @@ txn_write_to_wal(struct txn *txn)
 						      txn->n_applier_rows,
 						      &txn->region);
 	if (req == NULL)
-		return -1;
+		return NULL;
 
 	struct txn_stmt *stmt;
 	struct xrow_header **remote_row = req->rows;
@@ -351,6 +353,15 @@ txn_write_to_wal(struct txn *txn)
 	}
 	assert(remote_row == req->rows + txn->n_applier_rows);
 	assert(local_row == remote_row + txn->n_new_rows);
+	return req;
+}
+
+static int64_t
+txn_write_to_wal(struct txn *txn)
+{
+	struct journal_entry *req = txn_journal_entry_new(txn);
+	if (req == NULL)
+		return -1;
 
 	ev_tstamp start = ev_monotonic_now(loop());
 	int64_t res = journal_write(req);
@@ -379,10 +390,13 @@ txn_write_to_wal(struct txn *txn)
 	return res;
 }
 
-int
-txn_commit(struct txn *txn)
+/**
+ * Check that a transaction can be committed and prepare it
+ * for writing to WAL.
+ */
+static int
+txn_prepare(struct txn *txn)
 {
-	assert(txn == in_txn());
 	/*
 	 * If transaction has been started in SQL, deferred
 	 * foreign key constraints must not be violated.
@@ -392,7 +406,7 @@ txn_commit(struct txn *txn)
 		struct sql_txn *sql_txn = txn->psql_txn;
 		if (sql_txn->fk_deferred_count != 0) {
 			diag_set(ClientError, ER_FOREIGN_KEY_CONSTRAINT);
-			goto fail;
+			return -1;
 		}
 	}
 	/*
@@ -401,14 +415,18 @@ txn_commit(struct txn *txn)
 	 */
 	if (txn->engine != NULL) {
 		if (engine_prepare(txn->engine, txn) != 0)
-			goto fail;
+			return -1;
 	}
+	return 0;
+}
 
-	if (txn->n_new_rows + txn->n_applier_rows > 0) {
-		txn->signature = txn_write_to_wal(txn);
-		if (txn->signature < 0)
-			goto fail;
-	}
+/**
+ * Complete a transaction that has been written to WAL: run
+ * commit triggers and commit it in the engine.
+ */
+static void
+txn_complete_commit(struct txn *txn)
+{
 	/*
 	 * The transaction is in the binary log. No action below
 	 * may throw. In case an error has happened, there is
@@ -430,7 +448,50 @@ txn_commit(struct txn *txn)
 	struct txn_stmt *stmt;
 	stailq_foreach_entry(stmt, &txn->stmts, next)
 		txn_stmt_unref_tuples(stmt);
+}
 
+/** Run rollback triggers of a transaction, if any. */
+static void
+txn_run_rollback_triggers(struct txn *txn)
+{
+	/* Rollback triggers must not throw. */
+	if (txn->has_triggers &&
+	    trigger_run(&txn->on_rollback, txn) != 0) {
+		diag_log();
+		unreachable();
+		panic("rollback trigger failed");
+	}
+}
+
+/**
+ * Complete a transaction that has been aborted: run rollback
+ * triggers and roll it back in the engine.
+ */
+static void
+txn_complete_rollback(struct txn *txn)
+{
+	txn_run_rollback_triggers(txn);
+	if (txn->engine)
+		engine_rollback(txn->engine, txn);
+
+	struct txn_stmt *stmt;
+	stailq_foreach_entry(stmt, &txn->stmts, next)
+		txn_stmt_unref_tuples(stmt);
+}
+
+int
+txn_commit(struct txn *txn)
+{
+	assert(txn == in_txn());
+	if (txn_prepare(txn) != 0)
+		goto fail;
+
+	if (txn->n_new_rows + txn->n_applier_rows > 0) {
+		txn->signature = txn_write_to_wal(txn);
+		if (txn->signature < 0)
+			goto fail;
+	}
+	txn_complete_commit(txn);
 	fiber_set_txn(fiber(), NULL);
 	txn_free(txn);
 	return 0;
@@ -439,6 +500,223 @@ fail:
 	return -1;
 }
 
+/**
+ * Copy redo rows of a transaction to the transaction region.
+ * Rows of Lua requests are encoded on the fiber region while
+ * rows of remote requests are stored in network buffers, but
+ * an asynchronously committed transaction outlives both.
+ */
+static int
+txn_copy_rows(struct txn *txn)
+{
+	struct txn_stmt *stmt;
+	stailq_foreach_entry(stmt, &txn->stmts, next) {
+		if (stmt->row == NULL)
+			continue;
+		struct xrow_header *row;
+		row = region_alloc_object(&txn->region, struct xrow_header);
+		if (row == NULL) {
+			diag_set(OutOfMemory, sizeof(*row),
+				 "region", "struct xrow_header");
+			return -1;
+		}
+		*row = *stmt->row;
+		for (int i = 0; i < row->bodycnt; i++) {
+			size_t len = row->body[i].iov_len;
+			void *body = region_alloc(&txn->region, len);
+			if (body == NULL) {
+				diag_set(OutOfMemory, len, "region", "row body");
+				return -1;
+			}
+			memcpy(body, row->body[i].iov_base, len);
+			row->body[i].iov_base = body;
+		}
+		stmt->row = row;
+	}
+	return 0;
+}
+
+enum {
+	/**
+	 * Maximum number of asynchronously committed
+	 * transactions which are being written to WAL.
+	 */
+	TXN_ASYNC_MAX = 1024,
+};
+
+/** Asynchronously committed transactions. */
+static struct {
+	/** Number of transactions being written or completed. */
+	int count;
+	/** Signaled when a transaction is completed. */
+	struct fiber_cond cond;
+	/**
+	 * Written transactions waiting for their triggers to
+	 * be run by the fiber, linked by txn::in_async_queue.
+	 */
+	struct stailq queue;
+	/** Signaled when a transaction is queued. */
+	struct fiber_cond queue_cond;
+	/** Fiber which completes the queued transactions. */
+	struct fiber *fiber;
+} txn_async;
+
+/**
+ * Run commit or rollback triggers of an asynchronously
+ * committed transaction which has been written to WAL or
+ * failed to be written, and free it. A failed transaction
+ * has already been rolled back in the engine by
+ * txn_async_write_done().
+ */
+static void
+txn_async_complete(struct txn *txn)
+{
+	/*
+	 * Triggers expect the transaction to be attached
+	 * to the current fiber, see box.on_commit().
+	 */
+	struct txn *prev_txn = in_txn();
+	fiber_set_txn(fiber(), txn);
+	if (txn->signature < 0) {
+		txn_run_rollback_triggers(txn);
+		struct txn_stmt *stmt;
+		stailq_foreach_entry(stmt, &txn->stmts, next)
+			txn_stmt_unref_tuples(stmt);
+	} else {
+		txn_complete_commit(txn);
+	}
+	fiber_set_txn(fiber(), prev_txn);
+	txn_free(txn);
+	assert(txn_async.count > 0);
+	txn_async.count--;
+	fiber_cond_signal(&txn_async.cond);
+}
+
+/**
+ * Complete queued transactions in order. Triggers, e.g. Lua
+ * box.on_commit() ones, may yield, so they can't be run from
+ * the journal callback.
+ */
+static int
+txn_async_f(va_list ap)
+{
+	(void)ap;
+	while (true) {
+		if (stailq_empty(&txn_async.queue)) {
+			fiber_cond_wait(&txn_async.queue_cond);
+			continue;
+		}
+		struct txn *txn = stailq_shift_entry(&txn_async.queue,
+						     struct txn,
+						     in_async_queue);
+		txn_async_complete(txn);
+		fiber_gc();
+	}
+	return 0;
+}
+
+static int
+txn_async_init(void)
+{
+	txn_async.fiber = fiber_new("txn_async", txn_async_f);
+	if (txn_async.fiber == NULL)
+		return -1;
+	txn_async.count = 0;
+	fiber_cond_create(&txn_async.cond);
+	fiber_cond_create(&txn_async.queue_cond);
+	stailq_create(&txn_async.queue);
+	fiber_start(txn_async.fiber);
+	return 0;
+}
+
+/**
+ * Journal callback invoked when an asynchronously committed
+ * transaction has been written to WAL or failed to be written.
+ * A transaction without triggers is completed right away,
+ * unless there are queued ones, which must be completed first.
+ */
+static void
+txn_async_write_done(struct journal_entry *entry, void *arg)
+{
+	struct txn *txn = arg;
+	txn->signature = entry->res;
+	if (txn->signature < 0) {
+		say_error("failed to write asynchronously committed "
+			  "transaction %lld to WAL, rolling it back",
+			  (long long)txn->id);
+		/*
+		 * Undo the changes right here rather than in the
+		 * fiber: tx_schedule_rollback() rolls back a failed
+		 * batch in reverse order and resumes transactions
+		 * waiting for the write synchronously, so deferring
+		 * the undo would apply it out of order. Only the
+		 * triggers, which may yield, are deferred.
+		 */
+		if (txn->engine != NULL)
+			engine_rollback(txn->engine, txn);
+	}
+	if (!txn->has_triggers && stailq_empty(&txn_async.queue)) {
+		txn_async_complete(txn);
+		return;
+	}
+	stailq_add_tail_entry(&txn_async.queue, txn, in_async_queue);
+	fiber_cond_signal(&txn_async.queue_cond);
+}
+
+int
+txn_commit_async(struct txn *txn)
+{
+	assert(txn == in_txn());
+	if (txn->n_new_rows + txn->n_applier_rows == 0 ||
+	    (txn->engine != NULL &&
+	     (txn->engine->flags & ENGINE_SUPPORTS_ASYNC_COMMIT) == 0))
+		return txn_commit(txn);
+
+	if (txn_async.fiber == NULL && txn_async_init() != 0)
+		goto fail;
+	struct journal_entry *req;
+	if (txn_prepare(txn) != 0 || txn_copy_rows(txn) != 0 ||
+	    (req = txn_journal_entry_new(txn)) == NULL)
+		goto fail;
+	/*
+	 * Don't let too many transactions pile up in memory if
+	 * WAL can't keep up, like synchronous ones can't. The
+	 * transaction is prepared and its changes may be seen
+	 * by others, so it can't be rolled back on cancel any
+	 * more: it must reach WAL in order. Hence the wait is
+	 * not cancellable.
+	 */
+	if (txn_async.count >= TXN_ASYNC_MAX) {
+		bool cancellable = fiber_set_cancellable(false);
+		while (txn_async.count >= TXN_ASYNC_MAX)
+			fiber_cond_wait(&txn_async.cond);
+		fiber_set_cancellable(cancellable);
+	}
+	req->on_done = txn_async_write_done;
+	req->on_done_arg = txn;
+	/*
+	 * From now on the transaction belongs to the journal
+	 * and is freed by the callback, which may be invoked
+	 * before journal_async_write() returns.
+	 */
+	fiber_set_txn(fiber(), NULL);
+	txn_async.count++;
+	if (journal_async_write(req) != 0) {
+		txn_async.count--;
+		fiber_set_txn(fiber(), txn);
+		txn_rollback();
+		/* See the comment in txn_write_to_wal(). */
+		fiber_reschedule();
+		diag_set(ClientError, ER_WAL_IO);
+		diag_log();
+		return -1;
+	}
+	return 0;
+fail:
+	txn_rollback();
+	return -1;
+}
+
 void
 txn_rollback_stmt()
 {
@@ -457,19 +735,7 @@ txn_rollback()
 	struct txn *txn = in_txn();
 	if (txn == NULL)
 		return;
-	/* Rollback triggers must not throw. */
-	if (txn->has_triggers &&
-	    trigger_run(&txn->on_rollback, txn) != 0) {
-		diag_log();
-		unreachable();
-		panic("rollback trigger failed");
-	}
-	if (txn->engine)
-		engine_rollback(txn->engine, txn);
-
-	struct txn_stmt *stmt;
-	stailq_foreach_entry(stmt, &txn->stmts, next)
-		txn_stmt_unref_tuples(stmt);
+	txn_complete_rollback(txn);
 
 	/** Free volatile txn memory. */
 	fiber_gc();
@@ -544,6 +810,21 @@ box_txn_commit()
 	return rc;
 }
 
+int
+box_txn_commit_async(void)
+{
+	struct txn *txn = in_txn();
+	if (txn == NULL)
+		return 0;
+	if (txn->in_sub_stmt) {
+		diag_set(ClientError, ER_COMMIT_IN_SUB_STMT);
+		return -1;
+	}
+	int rc = txn_commit_async(txn);
+	fiber_gc();
+	return rc;
+}
+
 int
 box_txn_rollback()
 {
@@ -200,6 +200,11 @@ struct txn {
 	 /** Commit and rollback triggers */
 	struct rlist on_commit, on_rollback;
 	struct sql_txn *psql_txn;
+	/**
+	 * Link in the queue of asynchronously committed
+	 * transactions waiting for their triggers to be run.
+	 */
+	struct stailq_entry in_async_queue;
 };
 
 /* Pointer to the current transaction (if any) */
@@ -226,6 +231,25 @@ txn_begin(bool is_autocommit);
 int
 txn_commit(struct txn *txn);
 
+/**
+ * Commit a transaction without waiting for it to be written
+ * to WAL. The changes are visible right away, while the redo
+ * rows are queued for writing in the same order as rows of
+ * synchronous transactions. Once the write is done, commit or,
+ * if the write fails, rollback triggers of the transaction are
+ * run. Transactions of engines that don't support asynchronous
+ * commit (see ENGINE_SUPPORTS_ASYNC_COMMIT) are committed
+ * synchronously. Yields if TXN_ASYNC_MAX transactions are
+ * being written already, until one of them completes. The
+ * wait can't be cancelled.
+ * @pre txn == in_txn()
+ *
+ * Return 0 if the transaction has been queued. On error,
+ * rollback the transaction and return -1.
+ */
+int
+txn_commit_async(struct txn *txn);
+
 /** Rollback a transaction, if any. */
 void
 txn_rollback();
@@ -398,6 +422,15 @@ txn_vdbe()
  * arguments
  */
 
+/**
+ * Commit the current transaction without waiting for the WAL
+ * write, see txn_commit_async().
+ * @retval 0 - success
+ * @retval -1 - failed to prepare or to queue the transaction.
+ */
+int
+box_txn_commit_async(void);
+
 /** \cond public */
 
 /**
@@ -65,6 +65,7 @@
 #include "engine.h"
 #include "space.h"
 #include "index.h"
+#include "port.h"
 #include "schema.h"
 #include "xstream.h"
 #include "info/info.h"
@@ -598,6 +599,16 @@ vinyl_engine_check_space_def(struct space_def *def)
 			 def->name, "engine does not support temporary flag");
 		return -1;
 	}
+	if (def->opts.compression != TUPLE_COMPRESSION_NONE) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support compression");
+		return -1;
+	}
+	if (def->opts.is_read_view) {
+		diag_set(ClientError, ER_ALTER_SPACE,
+			 def->name, "engine does not support read view");
+		return -1;
+	}
 	return 0;
 }
 
@@ -4031,6 +4042,127 @@ vinyl_index_get(struct index *index, const char *key,
 	return 0;
 }
 
+/** Batched point lookup shared by a few fibers. */
+struct vy_get_many {
+	struct vy_lsm *lsm;
+	struct vy_tx *tx;
+	const struct vy_read_view **rv;
+	/** Keys to look up, MessagePack arrays. */
+	const char **keys;
+	uint32_t key_count;
+	/** Index of the next key to look up. */
+	uint32_t next;
+	/** Found tuples, referenced, in the order of keys. */
+	struct tuple **results;
+};
+
+/**
+ * Look up keys of a batch until it is exhausted. Since a lookup
+ * yields while reading disk, a few fibers running this function
+ * keep reads of different keys in flight at the same time.
+ */
+static int
+vy_get_many_process(struct vy_get_many *batch)
+{
+	while (batch->next < batch->key_count) {
+		uint32_t i = batch->next++;
+		if (batch->tx != NULL && batch->tx->state == VINYL_TX_ABORT) {
+			diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+			batch->next = batch->key_count;
+			return -1;
+		}
+		const char *key = batch->keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		if (vy_get_by_raw_key(batch->lsm, batch->tx, batch->rv,
+				      key, part_count,
+				      &batch->results[i]) != 0) {
+			batch->next = batch->key_count;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+vy_get_many_f(va_list ap)
+{
+	struct vy_get_many *batch = va_arg(ap, struct vy_get_many *);
+	return vy_get_many_process(batch);
+}
+
+static int
+vinyl_index_get_many(struct index *index, const char **keys,
+		     uint32_t key_count, struct port *port)
+{
+	/* Max number of fibers looking up keys of one batch. */
+	enum { VY_GET_MANY_FIBERS = 16 };
+	assert(index->def->opts.is_unique);
+
+	struct vy_lsm *lsm = vy_lsm(index);
+	struct vy_env *env = vy_env(index->engine);
+	struct vy_tx *tx = in_txn() ? in_txn()->engine_tx : NULL;
+	const struct vy_read_view **rv = (tx != NULL ? vy_tx_read_view(tx) :
+					  &env->xm->p_global_read_view);
+
+	if (tx != NULL && tx->state == VINYL_TX_ABORT) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		return -1;
+	}
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = key_count * sizeof(struct tuple *);
+	struct vy_get_many batch;
+	batch.results = region_alloc(region, size);
+	if (batch.results == NULL) {
+		diag_set(OutOfMemory, size, "region", "results");
+		return -1;
+	}
+	memset(batch.results, 0, size);
+	batch.lsm = lsm;
+	batch.tx = tx;
+	batch.rv = rv;
+	batch.keys = keys;
+	batch.key_count = key_count;
+	batch.next = 0;
+
+	/*
+	 * Make sure the LSM tree isn't deleted while we are
+	 * reading from it.
+	 */
+	vy_lsm_ref(lsm);
+	struct fiber *workers[VY_GET_MANY_FIBERS - 1];
+	uint32_t worker_count = MIN(key_count, (uint32_t)VY_GET_MANY_FIBERS);
+	/* The current fiber is a worker, too. */
+	worker_count = worker_count > 0 ? worker_count - 1 : 0;
+	for (uint32_t i = 0; i < worker_count; i++) {
+		workers[i] = fiber_new("vinyl.get_many", vy_get_many_f);
+		if (workers[i] == NULL) {
+			worker_count = i;
+			break;
+		}
+		fiber_set_joinable(workers[i], true);
+		fiber_start(workers[i], &batch);
+	}
+	int rc = vy_get_many_process(&batch);
+	for (uint32_t i = 0; i < worker_count; i++) {
+		if (fiber_join(workers[i]) != 0)
+			rc = -1;
+	}
+	vy_lsm_unref(lsm);
+
+	for (uint32_t i = 0; i < key_count; i++) {
+		struct tuple *tuple = batch.results[i];
+		if (tuple == NULL)
+			continue;
+		if (rc == 0 && port_tuple_add(port, tuple) != 0)
+			rc = -1;
+		tuple_unref(tuple);
+	}
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 /*** }}} Cursor */
 
 /* {{{ Index build */
@@ -4703,6 +4835,7 @@ static const struct space_vtab vinyl_space_vtab = {
 	/* .swap_index = */ vinyl_space_swap_index,
 	/* .prepare_alter = */ vinyl_space_prepare_alter,
 	/* .invalidate = */ vinyl_space_invalidate,
+	/* .bulk_load = */ generic_space_bulk_load,
 };
 
 static const struct index_vtab vinyl_index_vtab = {
@@ -4722,8 +4855,11 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ vinyl_index_get,
+	/* .get_many = */ vinyl_index_get_many,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
+	/* .create_iterator_with_offset = */
+		generic_index_create_iterator_with_offset,
 	/* .create_snapshot_iterator = */
 		generic_index_create_snapshot_iterator,
 	/* .stat = */ vinyl_index_stat,
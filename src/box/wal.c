@@ -43,6 +43,12 @@
 #include "cbus.h"
 #include "coio_task.h"
 #include "replication.h"
+#include "latency.h"
+#include "histogram.h"
+#include "info/info.h"
+#include "third_party/tarantool_eio.h"
+#include "tt_pthread.h"
+#include "small/ibuf.h"
 
 enum {
 	/**
@@ -56,6 +62,12 @@ enum {
 	WAL_FALLOCATE_LEN = 1024 * 1024,
 };
 
+/**
+ * Weight of a new observation in the moving averages used for
+ * adjusting the group commit target, see wal_update_target().
+ */
+static const double WAL_AVG_WEIGHT = 0.2;
+
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
 
 int wal_dir_lock = -1;
@@ -63,6 +75,9 @@ int wal_dir_lock = -1;
 static int64_t
 wal_write(struct journal *, struct journal_entry *);
 
+static int
+wal_async_write(struct journal *, struct journal_entry *);
+
 static int64_t
 wal_write_in_wal_mode_none(struct journal *, struct journal_entry *);
 
@@ -91,6 +106,49 @@ struct wal_writer
 	struct cpipe wal_pipe;
 	/** A memory pool for messages. */
 	struct mempool msg_pool;
+	/**
+	 * A setting from instance configuration -
+	 * wal_group_commit_delay. If it is set, requests are
+	 * collected in a batch, which is sent to the WAL thread
+	 * when the WAL thread is idle, or the batch has reached
+	 * the target size, or the batch has waited for this long,
+	 * whichever comes first. See wal_group_add().
+	 */
+	double group_commit_delay;
+	/**
+	 * A setting from instance configuration -
+	 * wal_group_commit_size, the upper bound of the target
+	 * batch size, in bytes.
+	 */
+	int64_t group_commit_size;
+	/**
+	 * Target batch size, in bytes: the amount of data that
+	 * comes in while the WAL thread writes a batch.
+	 */
+	int64_t group_target;
+	/** The batch being collected, not sent yet. */
+	struct wal_msg *group;
+	/** Sends the batch being collected when it expires. */
+	struct ev_timer group_timer;
+	/** Number of batches sent to the WAL thread. */
+	int in_flight;
+	/** Moving average of batch write time, in seconds. */
+	double write_time_avg;
+	/** Moving average of the input rate, in bytes per second. */
+	double input_rate_avg;
+	/** Size of requests queued since input_time. */
+	int64_t input_size;
+	/** Time when input_size was reset. */
+	double input_time;
+	/** Number of batches written to disk. */
+	int64_t batch_count;
+	/** Histogram of written batch sizes, in bytes. */
+	struct histogram *batch_size;
+	/**
+	 * Batch write latency. In fsync mode, files are opened
+	 * with O_SYNC, so this is the fsync latency.
+	 */
+	struct latency write_latency;
 	/* ----------------- wal ------------------- */
 	/** A setting from instance configuration - rows_per_wal */
 	int64_t wal_max_rows;
@@ -144,6 +202,21 @@ struct wal_writer
 	bool checkpoint_triggered;
 	/** The current WAL file. */
 	struct xlog current_wal;
+	/**
+	 * A setting from instance configuration - wal_spare_files:
+	 * the number of spare WAL files to keep preallocated, so
+	 * that rotation neither creates a file nor allocates disk
+	 * space for it, see wal_refill_spares().
+	 */
+	int spare_max;
+	/**
+	 * Ids of spare files ready for use are in range
+	 * [spare_first, spare_last).
+	 */
+	uint64_t spare_first;
+	uint64_t spare_last;
+	/** Set while a coio thread is creating a spare file. */
+	bool spare_in_progress;
 	/**
 	 * Used if there was a WAL I/O error and we need to
 	 * keep adding all incoming requests to the rollback
@@ -171,6 +244,10 @@ struct wal_msg {
 	struct stailq rollback;
 	/** vclock after the batch processed. */
 	struct vclock vclock;
+	/** Number of bytes written to disk. */
+	int64_t write_size;
+	/** Time it took to write the batch, in seconds. */
+	double write_time;
 };
 
 /**
@@ -182,6 +259,58 @@ struct vy_log_writer {
 };
 
 static struct vy_log_writer vy_log_writer;
+/** Slot of the WAL tail ring, see struct wal_tail. */
+struct wal_tail_slot {
+	/** Offset of the encoded row in wal_tail::data. */
+	uint64_t offset;
+	/** Size of the encoded row, 0 for a rotation mark. */
+	uint32_t len;
+};
+
+/**
+ * Rows recently written to the WAL, published by the WAL thread
+ * and read by relays, see wal_tail_read().
+ */
+struct wal_tail {
+	/** Serializes the WAL thread and readers. */
+	pthread_mutex_t mutex;
+	/**
+	 * Number of readers copying rows without the mutex, see
+	 * wal_tail_read(). The data buffer can't be freed until
+	 * they are done.
+	 */
+	int readers;
+	/** Signaled when the last reader is done copying. */
+	pthread_cond_t readers_cond;
+	/** Ring of entry slots, the number of slots is a power of 2. */
+	struct wal_tail_slot *slots;
+	uint32_t slot_mask;
+	/** Entries with sequence numbers in [first, last) are kept. */
+	int64_t first;
+	int64_t last;
+	/** Ring buffer of encoded rows, NULL if the tail is disabled. */
+	char *data;
+	size_t data_size;
+	/**
+	 * Rows are stored at ever growing offsets taken modulo
+	 * data_size, bytes in range [begin, end) are in use.
+	 */
+	uint64_t begin;
+	uint64_t end;
+};
+
+enum {
+	/**
+	 * Expected size of an encoded row, used to choose the
+	 * number of WAL tail slots for the given tail size.
+	 */
+	WAL_TAIL_ROW_SIZE_EST = 128,
+};
+
+static struct wal_tail wal_tail = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.readers_cond = PTHREAD_COND_INITIALIZER,
+};
 static struct wal_writer wal_writer_singleton;
 
 enum wal_mode
@@ -209,6 +338,8 @@ wal_msg_create(struct wal_msg *batch)
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
 	vclock_create(&batch->vclock);
+	batch->write_size = 0;
+	batch->write_time = 0;
 }
 
 static struct wal_msg *
@@ -217,6 +348,19 @@ wal_msg(struct cmsg *msg)
 	return msg->route == wal_request_route ? (struct wal_msg *) msg : NULL;
 }
 
+static struct wal_msg *
+wal_msg_new(struct wal_writer *writer)
+{
+	struct wal_msg *batch = mempool_alloc(&writer->msg_pool);
+	if (batch == NULL) {
+		diag_set(OutOfMemory, sizeof(struct wal_msg),
+			 "region", "struct wal_msg");
+		return NULL;
+	}
+	wal_msg_create(batch);
+	return batch;
+}
+
 /** Write a request to a log in a single transaction. */
 static ssize_t
 xlog_write_entry(struct xlog *l, struct journal_entry *entry)
@@ -251,6 +395,10 @@ xlog_write_entry(struct xlog *l, struct journal_entry *entry)
  * this ensures that, in case of rollback, requests are
  * rolled back in strict reverse order, producing
  * a consistent database state.
+ *
+ * Completion callbacks of asynchronous requests are run
+ * right away. Since they may free the request, the queue
+ * is iterated in a safe manner.
  */
 static void
 tx_schedule_queue(struct stailq *queue)
@@ -259,9 +407,72 @@ tx_schedule_queue(struct stailq *queue)
 	 * fiber_wakeup() is faster than fiber_call() when there
 	 * are many ready fibers.
 	 */
-	struct journal_entry *req;
-	stailq_foreach_entry(req, queue, fifo)
-		fiber_wakeup(req->fiber);
+	struct journal_entry *req, *next;
+	stailq_foreach_entry_safe(req, next, queue, fifo)
+		journal_entry_complete(req);
+}
+
+/**
+ * Send the batch being collected to the WAL thread.
+ */
+static void
+wal_send_group(struct wal_writer *writer)
+{
+	struct wal_msg *batch = writer->group;
+	if (batch == NULL)
+		return;
+	writer->group = NULL;
+	ev_timer_stop(loop(), &writer->group_timer);
+	writer->in_flight++;
+	cpipe_push(&writer->wal_pipe, &batch->base);
+}
+
+static void
+wal_group_timer_cb(ev_loop *loop, ev_timer *timer, int events)
+{
+	(void)loop;
+	(void)events;
+	wal_send_group((struct wal_writer *)timer->data);
+}
+
+/** Update a moving average with a new observation. */
+static inline void
+wal_avg_update(double *avg, double value)
+{
+	if (*avg == 0)
+		*avg = value;
+	else
+		*avg += WAL_AVG_WEIGHT * (value - *avg);
+}
+
+/**
+ * Account a batch returned by the WAL thread in statistics
+ * and adjust the group commit target.
+ *
+ * A batch sent while the WAL thread is busy waits until the
+ * WAL thread is done with the previous one anyway, so there's
+ * no point in sending it before it has collected what comes
+ * in while a batch is written: average input rate times
+ * average write time.
+ */
+static void
+wal_update_target(struct wal_writer *writer, struct wal_msg *batch)
+{
+	if (batch->write_size > 0) {
+		writer->batch_count++;
+		histogram_collect(writer->batch_size, batch->write_size);
+		latency_collect(&writer->write_latency, batch->write_time);
+		wal_avg_update(&writer->write_time_avg, batch->write_time);
+	}
+	double now = ev_monotonic_now(loop());
+	if (now > writer->input_time) {
+		double rate = writer->input_size / (now - writer->input_time);
+		wal_avg_update(&writer->input_rate_avg, rate);
+		writer->input_size = 0;
+		writer->input_time = now;
+	}
+	double target = writer->input_rate_avg * writer->write_time_avg;
+	writer->group_target = MIN(target, writer->group_commit_size);
 }
 
 /**
@@ -280,12 +491,22 @@ tx_schedule_commit(struct cmsg *msg)
 	 * wal_msg memory disappears after the first
 	 * iteration of tx_schedule_queue loop.
 	 */
-	if (! stailq_empty(&batch->rollback)) {
+	bool is_rollback = !stailq_empty(&batch->rollback);
+	if (is_rollback) {
 		/* Closes the input valve. */
 		stailq_concat(&writer->rollback, &batch->rollback);
 	}
 	/* Update the tx vclock to the latest written by wal. */
 	vclock_copy(&replicaset.vclock, &batch->vclock);
+	wal_update_target(writer, batch);
+	/*
+	 * Send the collected batch if the WAL thread is idle now.
+	 * In case of rollback, send it right away, so that the
+	 * WAL thread rolls it back along with the failed batch.
+	 */
+	assert(writer->in_flight > 0);
+	if (--writer->in_flight == 0 || is_rollback)
+		wal_send_group(writer);
 	tx_schedule_queue(&batch->commit);
 	mempool_free(&writer->msg_pool, container_of(msg, struct wal_msg, base));
 }
@@ -303,8 +524,21 @@ tx_schedule_rollback(struct cmsg *msg)
 	 * in-memory database state.
 	 */
 	stailq_reverse(&writer->rollback);
-	/* Must not yield. */
-	tx_schedule_queue(&writer->rollback);
+	/*
+	 * Asynchronous requests are rolled back by their
+	 * completion callbacks right away, so to keep the order,
+	 * the fibers waiting for synchronous requests must roll
+	 * back their transactions right away too, hence
+	 * fiber_call() instead of fiber_wakeup(). A fiber yields
+	 * back as soon as it has done its part of the rollback.
+	 */
+	struct journal_entry *req, *next;
+	stailq_foreach_entry_safe(req, next, &writer->rollback, fifo) {
+		if (req->on_done != NULL)
+			journal_entry_complete(req);
+		else
+			fiber_call(req->fiber);
+	}
 	stailq_create(&writer->rollback);
 	if (msg != &writer->in_rollback)
 		mempool_free(&writer->msg_pool,
@@ -346,7 +580,7 @@ tx_notify_checkpoint(struct cmsg *msg)
  * encapsulate the details just in case we may use
  * more writers in the future.
  */
-static void
+static int
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		  const char *wal_dirname, int64_t wal_max_rows,
 		  int64_t wal_max_size, const struct tt_uuid *instance_uuid,
@@ -356,8 +590,13 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	writer->wal_mode = wal_mode;
 	writer->wal_max_rows = wal_max_rows;
 	writer->wal_max_size = wal_max_size;
-	journal_create(&writer->base, wal_mode == WAL_NONE ?
-		       wal_write_in_wal_mode_none : wal_write, NULL);
+	if (wal_mode == WAL_NONE) {
+		journal_create(&writer->base, wal_write_in_wal_mode_none,
+			       NULL, NULL);
+	} else {
+		journal_create(&writer->base, wal_write, wal_async_write,
+			       NULL);
+	}
 
 	struct xlog_opts opts = xlog_opts_default;
 	opts.sync_is_async = true;
@@ -373,6 +612,24 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 	writer->checkpoint_threshold = INT64_MAX;
 	writer->checkpoint_triggered = false;
 
+	writer->spare_max = 0;
+	writer->spare_first = 0;
+	writer->spare_last = 0;
+	writer->spare_in_progress = false;
+
+	writer->group_commit_delay = 0;
+	writer->group_commit_size = 0;
+	writer->group_target = 0;
+	writer->group = NULL;
+	ev_timer_init(&writer->group_timer, wal_group_timer_cb, 0, 0);
+	writer->group_timer.data = writer;
+	writer->in_flight = 0;
+	writer->write_time_avg = 0;
+	writer->input_rate_avg = 0;
+	writer->input_size = 0;
+	writer->input_time = ev_monotonic_now(loop());
+	writer->batch_count = 0;
+
 	vclock_create(&writer->vclock);
 	vclock_create(&writer->checkpoint_vclock);
 	rlist_create(&writer->watchers);
@@ -382,6 +639,25 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	mempool_create(&writer->msg_pool, &cord()->slabc,
 		       sizeof(struct wal_msg));
+
+	static int64_t batch_size_buckets[] = {
+		1 << 7, 1 << 8, 1 << 9, 1 << 10, 1 << 11, 1 << 12,
+		1 << 13, 1 << 14, 1 << 15, 1 << 16, 1 << 17, 1 << 18,
+		1 << 19, 1 << 20, 1 << 21, 1 << 22, 1 << 23, 1 << 24,
+		1 << 25, 1 << 26,
+	};
+	writer->batch_size = histogram_new(batch_size_buckets,
+					   lengthof(batch_size_buckets));
+	if (writer->batch_size == NULL)
+		goto fail;
+	if (latency_create(&writer->write_latency) != 0)
+		goto fail_latency;
+	return 0;
+fail_latency:
+	histogram_delete(writer->batch_size);
+fail:
+	xdir_destroy(&writer->wal_dir);
+	return -1;
 }
 
 /** Destroy a WAL writer structure. */
@@ -389,6 +665,17 @@ static void
 wal_writer_destroy(struct wal_writer *writer)
 {
 	xdir_destroy(&writer->wal_dir);
+	struct wal_tail *tail = &wal_tail;
+	tt_pthread_mutex_lock(&tail->mutex);
+	char *data = tail->data;
+	struct wal_tail_slot *slots = tail->slots;
+	tail->data = NULL;
+	tail->slots = NULL;
+	tt_pthread_mutex_unlock(&tail->mutex);
+	free(data);
+	free(slots);
+	histogram_delete(writer->batch_size);
+	latency_destroy(&writer->write_latency);
 }
 
 /** WAL writer thread routine. */
@@ -474,9 +761,11 @@ wal_init(enum wal_mode wal_mode, const char *wal_dirname, int64_t wal_max_rows,
 
 	/* Initialize the state. */
 	struct wal_writer *writer = &wal_writer_singleton;
-	wal_writer_create(writer, wal_mode, wal_dirname, wal_max_rows,
-			  wal_max_size, instance_uuid, on_garbage_collection,
-			  on_checkpoint_threshold);
+	if (wal_writer_create(writer, wal_mode, wal_dirname, wal_max_rows,
+			      wal_max_size, instance_uuid,
+			      on_garbage_collection,
+			      on_checkpoint_threshold) != 0)
+		return -1;
 
 	/* Start WAL thread. */
 	if (cord_costart(&writer->cord, "wal", wal_writer_f, NULL) != 0)
@@ -504,6 +793,13 @@ wal_enable(void)
 	if (xdir_scan(&writer->wal_dir))
 		return -1;
 
+	/*
+	 * Spare files left from the previous run may be
+	 * incomplete, remove them. The pool is refilled once
+	 * wal_spare_files is applied.
+	 */
+	xdir_collect_spares(&writer->wal_dir);
+
 	/* Open the most recent WAL file. */
 	if (wal_open(writer) != 0)
 		return -1;
@@ -518,6 +814,7 @@ wal_free(void)
 {
 	struct wal_writer *writer = &wal_writer_singleton;
 
+	wal_send_group(writer);
 	cbus_stop_loop(&writer->wal_pipe);
 
 	if (cord_join(&writer->cord)) {
@@ -534,6 +831,7 @@ wal_sync(void)
 	struct wal_writer *writer = &wal_writer_singleton;
 	if (writer->wal_mode == WAL_NONE)
 		return;
+	wal_send_group(writer);
 	cbus_flush(&writer->wal_pipe, &writer->tx_prio_pipe, NULL);
 }
 
@@ -588,6 +886,11 @@ wal_begin_checkpoint(struct wal_checkpoint *checkpoint)
 		diag_set(ClientError, ER_CHECKPOINT_ROLLBACK);
 		return -1;
 	}
+	/*
+	 * The checkpoint vclock must include all requests
+	 * whose changes are visible in memory.
+	 */
+	wal_send_group(writer);
 	bool cancellable = fiber_set_cancellable(false);
 	int rc = cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
 			   &checkpoint->base, wal_begin_checkpoint_f, NULL,
@@ -665,6 +968,181 @@ wal_set_checkpoint_threshold(int64_t threshold)
 	fiber_set_cancellable(cancellable);
 }
 
+/** Create a spare WAL file. Runs in a coio thread. */
+static void
+wal_create_spare_f(eio_req *req)
+{
+	struct wal_writer *writer = (struct wal_writer *)req->data;
+	/*
+	 * The WAL thread doesn't change spare_last until
+	 * the request completes, so it's safe to read it here.
+	 */
+	req->result = xdir_create_spare(&writer->wal_dir,
+					writer->spare_last,
+					writer->wal_max_size);
+	if (req->result != 0)
+		diag_log();
+}
+
+static void
+wal_refill_spares(struct wal_writer *writer);
+
+static int
+wal_create_spare_done(eio_req *req)
+{
+	struct wal_writer *writer = (struct wal_writer *)req->data;
+	writer->spare_in_progress = false;
+	/* On failure, retry on the next rotation. */
+	if (req->result == 0) {
+		writer->spare_last++;
+		wal_refill_spares(writer);
+	}
+	return 0;
+}
+
+/**
+ * Start creating a spare WAL file in a coio thread unless
+ * the pool is full. Spare files are created one by one,
+ * each one refills the pool on completion.
+ */
+static void
+wal_refill_spares(struct wal_writer *writer)
+{
+	if (writer->spare_in_progress ||
+	    writer->spare_last - writer->spare_first >=
+	    (uint64_t)writer->spare_max)
+		return;
+	writer->spare_in_progress = true;
+	eio_custom(wal_create_spare_f, 0, wal_create_spare_done, writer);
+}
+
+/**
+ * Remove the oldest spare file. If @sync is set, the file is
+ * removed before the function returns, otherwise it is removed
+ * in a coio thread.
+ */
+static void
+wal_remove_spare(struct wal_writer *writer, bool sync)
+{
+	assert(writer->spare_first < writer->spare_last);
+	const char *filename = xdir_format_spare_filename(&writer->wal_dir,
+							  writer->spare_first++);
+	if (!sync)
+		eio_unlink(filename, 0, NULL, NULL);
+	else if (unlink(filename) != 0 && errno != ENOENT)
+		say_syserror("error while removing %s", filename);
+}
+
+struct wal_set_spare_files_msg {
+	struct cbus_call_msg base;
+	int spare_files;
+};
+
+static int
+wal_set_spare_files_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_spare_files_msg *msg;
+	msg = (struct wal_set_spare_files_msg *)data;
+	writer->spare_max = msg->spare_files;
+	while (writer->spare_last - writer->spare_first >
+	       (uint64_t)writer->spare_max)
+		wal_remove_spare(writer, false);
+	wal_refill_spares(writer);
+	return 0;
+}
+
+void
+wal_set_spare_files(int spare_files)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_spare_files_msg msg;
+	msg.spare_files = spare_files;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_spare_files_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+struct wal_set_compression_level_msg {
+	struct cbus_call_msg base;
+	int level;
+};
+
+static int
+wal_set_compression_level_f(struct cbus_call_msg *data)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	struct wal_set_compression_level_msg *msg;
+	msg = (struct wal_set_compression_level_msg *)data;
+	writer->wal_dir.opts.compression_level = msg->level;
+	if (xlog_is_open(&writer->current_wal))
+		writer->current_wal.opts.compression_level = msg->level;
+	return 0;
+}
+
+void
+wal_set_compression_level(int level)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	struct wal_set_compression_level_msg msg;
+	msg.level = level;
+	bool cancellable = fiber_set_cancellable(false);
+	cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+		  &msg.base, wal_set_compression_level_f, NULL,
+		  TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+}
+
+void
+wal_set_group_commit(double delay, int64_t size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->group_commit_delay = delay;
+	writer->group_commit_size = size;
+	/* Start with the max, it is adjusted after the next write. */
+	writer->group_target = size;
+	if (delay == 0)
+		wal_send_group(writer);
+}
+
+void
+wal_stat(struct info_handler *h)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	info_begin(h);
+	info_append_int(h, "batch_count", writer->batch_count);
+	info_table_begin(h, "batch_size");
+	info_append_int(h, "p50",
+			histogram_percentile(writer->batch_size, 50));
+	info_append_int(h, "p90",
+			histogram_percentile(writer->batch_size, 90));
+	info_append_int(h, "p99",
+			histogram_percentile(writer->batch_size, 99));
+	info_table_end(h); /* batch_size */
+	info_table_begin(h, "write_latency");
+	info_append_double(h, "p50", latency_get(&writer->write_latency, 50));
+	info_append_double(h, "p90", latency_get(&writer->write_latency, 90));
+	info_append_double(h, "p99", latency_get(&writer->write_latency, 99));
+	info_table_end(h); /* write_latency */
+	info_append_int(h, "group_target", writer->group_target);
+	info_end(h);
+}
+
+void
+wal_reset_stat(void)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	writer->batch_count = 0;
+	histogram_reset(writer->batch_size);
+	latency_reset(&writer->write_latency);
+}
+
 struct wal_gc_msg
 {
 	struct cbus_call_msg base;
@@ -713,6 +1191,271 @@ wal_collect_garbage(const struct vclock *vclock)
 	fiber_set_cancellable(cancellable);
 }
 
+/**
+ * Drop all entries of the WAL tail. A sequence number is skipped
+ * so that a reader positioned at the end of the tail notices the
+ * gap. Called with the mutex locked.
+ */
+static void
+wal_tail_reset(struct wal_tail *tail)
+{
+	tail->last++;
+	tail->first = tail->last;
+	tail->begin = tail->end;
+}
+
+/** Evict the oldest entry. Called with the mutex locked. */
+static void
+wal_tail_evict(struct wal_tail *tail)
+{
+	assert(tail->first < tail->last);
+	tail->first++;
+	tail->begin = tail->first < tail->last ?
+		      tail->slots[tail->first & tail->slot_mask].offset :
+		      tail->end;
+}
+
+static void
+wal_tail_copy_in(struct wal_tail *tail, const void *src, size_t len)
+{
+	size_t pos = tail->end % tail->data_size;
+	size_t n = MIN(len, tail->data_size - pos);
+	memcpy(tail->data + pos, src, n);
+	memcpy(tail->data, (const char *)src + n, len - n);
+	tail->end += len;
+}
+
+static void
+wal_tail_copy_out(const char *data, size_t data_size, uint64_t offset,
+		  char *dst, size_t len)
+{
+	size_t pos = offset % data_size;
+	size_t n = MIN(len, data_size - pos);
+	memcpy(dst, data + pos, n);
+	memcpy(dst + n, data, len - n);
+}
+
+/**
+ * Append an entry of the given size to the WAL tail, evicting
+ * old entries to make room for it. Called with the mutex locked.
+ */
+static struct wal_tail_slot *
+wal_tail_append(struct wal_tail *tail, size_t len)
+{
+	assert(len <= tail->data_size);
+	while (tail->first < tail->last &&
+	       (tail->end + len - tail->begin > tail->data_size ||
+		tail->last - tail->first > tail->slot_mask))
+		wal_tail_evict(tail);
+	struct wal_tail_slot *slot;
+	slot = &tail->slots[tail->last++ & tail->slot_mask];
+	slot->offset = tail->end;
+	slot->len = len;
+	return slot;
+}
+
+static void
+wal_tail_append_row(struct wal_tail *tail, struct xrow_header *row)
+{
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_header_encode(row, 0, iov, 0);
+	if (iovcnt < 0) {
+		/* Readers will fall back on WAL files. */
+		diag_log();
+		diag_clear(diag_get());
+		wal_tail_reset(tail);
+		return;
+	}
+	size_t len = 0;
+	for (int i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+	if (len > tail->data_size) {
+		/* The row is too big, readers have to use WAL files. */
+		wal_tail_reset(tail);
+		return;
+	}
+	wal_tail_append(tail, len);
+	for (int i = 0; i < iovcnt; i++)
+		wal_tail_copy_in(tail, iov[i].iov_base, iov[i].iov_len);
+}
+
+/**
+ * Publish rows of the given journal entries, which have been
+ * written to the current WAL, to the WAL tail.
+ */
+static void
+wal_tail_publish(struct wal_writer *writer, struct stailq *entries)
+{
+	struct wal_tail *tail = &wal_tail;
+	/* The tail is only reconfigured by the WAL thread. */
+	if (tail->data == NULL)
+		return;
+	tt_pthread_mutex_lock(&tail->mutex);
+	if (rlist_empty(&writer->watchers)) {
+		/* Nobody is going to read the rows. */
+		wal_tail_reset(tail);
+	} else {
+		struct journal_entry *entry;
+		stailq_foreach_entry(entry, entries, fifo) {
+			for (int i = 0; i < entry->n_rows; i++)
+				wal_tail_append_row(tail, entry->rows[i]);
+		}
+	}
+	tt_pthread_mutex_unlock(&tail->mutex);
+}
+
+/** Publish a WAL rotation mark to the WAL tail. */
+static void
+wal_tail_publish_rotation(void)
+{
+	struct wal_tail *tail = &wal_tail;
+	if (tail->data == NULL)
+		return;
+	tt_pthread_mutex_lock(&tail->mutex);
+	wal_tail_append(tail, 0);
+	tt_pthread_mutex_unlock(&tail->mutex);
+}
+
+int64_t
+wal_tail_seq(void)
+{
+	struct wal_tail *tail = &wal_tail;
+	tt_pthread_mutex_lock(&tail->mutex);
+	int64_t seq = tail->data != NULL ? tail->last : -1;
+	tt_pthread_mutex_unlock(&tail->mutex);
+	return seq;
+}
+
+int
+wal_tail_read(int64_t *seq, struct ibuf *buf, size_t size)
+{
+	struct wal_tail *tail = &wal_tail;
+	tt_pthread_mutex_lock(&tail->mutex);
+	if (tail->data == NULL || *seq < tail->first || *seq > tail->last) {
+		tt_pthread_mutex_unlock(&tail->mutex);
+		return 1;
+	}
+	/*
+	 * Only reserve room for the entries and fill in their
+	 * headers under the mutex. Rows are copied without it so
+	 * as not to stall the WAL thread, which may overwrite
+	 * them meanwhile, so the copy is checked afterwards.
+	 */
+	size_t start = ibuf_used(buf);
+	int64_t end = *seq;
+	uint64_t offset = tail->slots[end & tail->slot_mask].offset;
+	size_t copied = 0;
+	while (end < tail->last && copied < size) {
+		struct wal_tail_slot *slot;
+		slot = &tail->slots[end & tail->slot_mask];
+		struct wal_tail_entry entry;
+		entry.len = slot->len;
+		size_t entry_size = sizeof(entry) + entry.len;
+		char *p = (char *)ibuf_alloc(buf, entry_size);
+		if (p == NULL) {
+			tt_pthread_mutex_unlock(&tail->mutex);
+			buf->wpos = buf->rpos + start;
+			diag_set(OutOfMemory, entry_size, "ibuf_alloc",
+				 "WAL tail entry");
+			return -1;
+		}
+		memcpy(p, &entry, sizeof(entry));
+		copied += entry_size;
+		end++;
+	}
+	const char *data = tail->data;
+	size_t data_size = tail->data_size;
+	tail->readers++;
+	tt_pthread_mutex_unlock(&tail->mutex);
+
+	/* Rows of consecutive entries are stored contiguously. */
+	char *p = buf->rpos + start;
+	while (p < buf->wpos) {
+		struct wal_tail_entry entry;
+		memcpy(&entry, p, sizeof(entry));
+		p += sizeof(entry);
+		wal_tail_copy_out(data, data_size, offset, p, entry.len);
+		p += entry.len;
+		offset += entry.len;
+	}
+
+	int rc = 0;
+	tt_pthread_mutex_lock(&tail->mutex);
+	if (--tail->readers == 0)
+		tt_pthread_cond_broadcast(&tail->readers_cond);
+	if (*seq < tail->first) {
+		/* The rows were evicted while being copied. */
+		buf->wpos = buf->rpos + start;
+		rc = 1;
+	} else {
+		*seq = end;
+	}
+	tt_pthread_mutex_unlock(&tail->mutex);
+	return rc;
+}
+
+struct wal_set_tail_size_msg {
+	struct cbus_call_msg base;
+	int64_t size;
+};
+
+static int
+wal_set_tail_size_f(struct cbus_call_msg *data)
+{
+	struct wal_tail *tail = &wal_tail;
+	struct wal_set_tail_size_msg *msg;
+	msg = (struct wal_set_tail_size_msg *)data;
+	char *new_data = NULL;
+	struct wal_tail_slot *new_slots = NULL;
+	uint32_t slot_count = 1;
+	if (msg->size > 0) {
+		while (slot_count < msg->size / WAL_TAIL_ROW_SIZE_EST)
+			slot_count *= 2;
+		new_data = malloc(msg->size);
+		if (new_data == NULL) {
+			diag_set(OutOfMemory, msg->size, "malloc",
+				 "WAL tail");
+			return -1;
+		}
+		new_slots = malloc(slot_count * sizeof(*new_slots));
+		if (new_slots == NULL) {
+			free(new_data);
+			diag_set(OutOfMemory, slot_count * sizeof(*new_slots),
+				 "malloc", "WAL tail slots");
+			return -1;
+		}
+	}
+	tt_pthread_mutex_lock(&tail->mutex);
+	SWAP(tail->data, new_data);
+	SWAP(tail->slots, new_slots);
+	tail->data_size = msg->size;
+	tail->slot_mask = slot_count - 1;
+	wal_tail_reset(tail);
+	/* Readers may still be copying from the old buffer. */
+	while (tail->readers > 0)
+		tt_pthread_cond_wait(&tail->readers_cond, &tail->mutex);
+	tt_pthread_mutex_unlock(&tail->mutex);
+	free(new_data);
+	free(new_slots);
+	return 0;
+}
+
+int
+wal_set_tail_size(int64_t size)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return 0;
+	struct wal_set_tail_size_msg msg;
+	msg.size = size;
+	bool cancellable = fiber_set_cancellable(false);
+	int rc = cbus_call(&writer->wal_pipe, &writer->tx_prio_pipe,
+			   &msg.base, wal_set_tail_size_f, NULL,
+			   TIMEOUT_INFINITY);
+	fiber_set_cancellable(cancellable);
+	return rc;
+}
+
 static void
 wal_notify_watchers(struct wal_writer *writer, unsigned events);
 
@@ -751,7 +1494,24 @@ wal_opt_rotate(struct wal_writer *writer)
 	if (xlog_is_open(&writer->current_wal))
 		return 0;
 
-	if (xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
+	/*
+	 * Take a spare file if there's one, fall back on
+	 * creating a new file if it fails.
+	 */
+	if (writer->spare_first < writer->spare_last) {
+		if (xdir_create_xlog_from_spare(&writer->wal_dir,
+						&writer->current_wal,
+						&writer->vclock,
+						writer->spare_first) == 0) {
+			writer->spare_first++;
+		} else {
+			diag_log();
+			/* Don't leave a broken spare file behind. */
+			wal_remove_spare(writer, true);
+		}
+	}
+	if (!xlog_is_open(&writer->current_wal) &&
+	    xdir_create_xlog(&writer->wal_dir, &writer->current_wal,
 			     &writer->vclock) != 0) {
 		diag_log();
 		return -1;
@@ -762,7 +1522,9 @@ wal_opt_rotate(struct wal_writer *writer)
 	 */
 	xdir_add_vclock(&writer->wal_dir, &writer->vclock);
 
+	wal_tail_publish_rotation();
 	wal_notify_watchers(writer, WAL_EVENT_ROTATE);
+	wal_refill_spares(writer);
 	return 0;
 }
 
@@ -807,6 +1569,11 @@ retry:
 	}
 	if (errno != ENOSPC)
 		goto error;
+	if (writer->spare_first < writer->spare_last) {
+		/* Spare files are the first to go. */
+		wal_remove_spare(writer, true);
+		goto retry;
+	}
 	if (!xdir_has_garbage(&writer->wal_dir, gc_lsn))
 		goto error;
 
@@ -987,6 +1754,8 @@ wal_write_to_disk(struct cmsg *msg)
 	 */
 
 	struct xlog *l = &writer->current_wal;
+	double start_time = ev_monotonic_time();
+	int64_t start_size = writer->checkpoint_wal_size;
 
 	/*
 	 * Iterate over requests (transactions)
@@ -1016,6 +1785,8 @@ wal_write_to_disk(struct cmsg *msg)
 	writer->checkpoint_wal_size += rc;
 	last_committed = stailq_last(&wal_msg->commit);
 	vclock_merge(&writer->vclock, &vclock_diff);
+	wal_msg->write_size = writer->checkpoint_wal_size - start_size;
+	wal_msg->write_time = ev_monotonic_time() - start_time;
 
 	/*
 	 * Notify TX if the checkpoint threshold has been exceeded.
@@ -1070,6 +1841,7 @@ done:
 		stailq_concat(&wal_msg->rollback, &rollback);
 		wal_writer_begin_rollback(writer);
 	}
+	wal_tail_publish(writer, &wal_msg->commit);
 	fiber_gc();
 	wal_notify_watchers(writer, WAL_EVENT_WRITE);
 }
@@ -1123,14 +1895,41 @@ wal_writer_f(va_list ap)
 }
 
 /**
- * WAL writer main entry point: queue a single request
- * to be written to disk and wait until this task is completed.
+ * Add a request to the batch being collected for group commit
+ * and send the batch to the WAL thread if the WAL thread is
+ * idle or the batch is big enough. Otherwise the batch is sent
+ * when the WAL thread is done with the previous batches or the
+ * group commit delay expires, whichever comes first.
  */
-int64_t
-wal_write(struct journal *journal, struct journal_entry *entry)
+static int
+wal_group_add(struct wal_writer *writer, struct journal_entry *entry)
 {
-	struct wal_writer *writer = (struct wal_writer *) journal;
+	struct wal_msg *batch = writer->group;
+	if (batch == NULL) {
+		batch = wal_msg_new(writer);
+		if (batch == NULL)
+			return -1;
+		writer->group = batch;
+		ev_timer_set(&writer->group_timer,
+			     writer->group_commit_delay, 0);
+		ev_timer_start(loop(), &writer->group_timer);
+	}
+	stailq_add_tail_entry(&batch->commit, entry, fifo);
+	batch->approx_len += entry->approx_len;
+	if (writer->in_flight == 0 ||
+	    (int64_t)batch->approx_len >= writer->group_target)
+		wal_send_group(writer);
+	return 0;
+}
 
+/**
+ * Queue a single request to be written to disk. The issuer
+ * is notified with journal_entry_complete() once the request
+ * is written or rolled back.
+ */
+static int
+wal_queue_entry(struct wal_writer *writer, struct journal_entry *entry)
+{
 	ERROR_INJECT_RETURN(ERRINJ_WAL_IO);
 
 	if (! stailq_empty(&writer->rollback)) {
@@ -1147,6 +1946,10 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 		return -1;
 	}
 
+	writer->input_size += entry->approx_len;
+	if (writer->group_commit_delay > 0)
+		return wal_group_add(writer, entry);
+
 	struct wal_msg *batch;
 	if (!stailq_empty(&writer->wal_pipe.input) &&
 	    (batch = wal_msg(stailq_first_entry(&writer->wal_pipe.input,
@@ -1154,24 +1957,34 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 
 		stailq_add_tail_entry(&batch->commit, entry, fifo);
 	} else {
-		batch = (struct wal_msg *)mempool_alloc(&writer->msg_pool);
-		if (batch == NULL) {
-			diag_set(OutOfMemory, sizeof(struct wal_msg),
-				 "region", "struct wal_msg");
+		batch = wal_msg_new(writer);
+		if (batch == NULL)
 			return -1;
-		}
-		wal_msg_create(batch);
 		/*
 		 * Sic: first add a request, then push the batch,
 		 * since cpipe_push() may pass the batch to WAL
 		 * thread right away.
 		 */
 		stailq_add_tail_entry(&batch->commit, entry, fifo);
+		writer->in_flight++;
 		cpipe_push(&writer->wal_pipe, &batch->base);
 	}
 	batch->approx_len += entry->approx_len;
 	writer->wal_pipe.n_input += entry->n_rows * XROW_IOVMAX;
 	cpipe_flush_input(&writer->wal_pipe);
+	return 0;
+}
+
+/**
+ * WAL writer main entry point: queue a single request
+ * to be written to disk and wait until this task is completed.
+ */
+int64_t
+wal_write(struct journal *journal, struct journal_entry *entry)
+{
+	struct wal_writer *writer = (struct wal_writer *) journal;
+	if (wal_queue_entry(writer, entry) != 0)
+		return -1;
 	/**
 	 * It's not safe to spuriously wakeup this fiber
 	 * since in that case it will ignore a possible
@@ -1184,6 +1997,18 @@ wal_write(struct journal *journal, struct journal_entry *entry)
 	return entry->res;
 }
 
+/**
+ * Queue a single request to be written to disk and return
+ * without waiting for the write to complete. The request
+ * on_done callback is invoked once it is done.
+ */
+static int
+wal_async_write(struct journal *journal, struct journal_entry *entry)
+{
+	struct wal_writer *writer = (struct wal_writer *) journal;
+	return wal_queue_entry(writer, entry);
+}
+
 int64_t
 wal_write_in_wal_mode_none(struct journal *journal,
 			   struct journal_entry *entry)
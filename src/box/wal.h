@@ -40,6 +40,8 @@
 struct fiber;
 struct wal_writer;
 struct tt_uuid;
+struct info_handler;
+struct ibuf;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
@@ -164,6 +166,53 @@ void
 wal_clear_watcher(struct wal_watcher *watcher,
 		  void (*process_cb)(struct cbus_endpoint *));
 
+/**
+ * WAL tail is a bounded in-memory ring of rows recently written
+ * to the WAL, kept encoded. Rows are published to it by the WAL
+ * thread after they hit the disk, so that watchers that are
+ * caught up can read them from memory instead of re-reading WAL
+ * files. Every row gets a sequence number. A WAL rotation is
+ * published as a mark, an entry without a row.
+ */
+struct wal_tail_entry {
+	/** Size of the encoded row that follows, 0 for a mark. */
+	uint32_t len;
+};
+
+/**
+ * Return the sequence number that will be assigned to the next
+ * entry published to the WAL tail or -1 if the tail is disabled.
+ * May be called from any thread.
+ *
+ * A watcher that has read WAL files after calling this function
+ * can continue from the tail at the returned position: all rows
+ * published before it are on disk.
+ */
+int64_t
+wal_tail_seq(void);
+
+/**
+ * Copy entries of the WAL tail starting at @a seq to @a buf,
+ * each as struct wal_tail_entry followed by the encoded row.
+ * Stops when the end of the tail is reached or at least @a size
+ * bytes are copied, @a seq is advanced past the copied entries.
+ * May be called from any thread.
+ *
+ * @retval  0 Success. Nothing is copied if there's no new entries.
+ * @retval  1 Entries at @a seq have been evicted from the tail,
+ *            the caller has to read them from WAL files.
+ * @retval -1 Memory error.
+ */
+int
+wal_tail_read(int64_t *seq, struct ibuf *buf, size_t size);
+
+/**
+ * Set the size of the WAL tail, 0 disables it. The entries
+ * published so far are dropped.
+ */
+int
+wal_set_tail_size(int64_t size);
+
 void
 wal_atfork();
 
@@ -218,6 +267,42 @@ wal_commit_checkpoint(struct wal_checkpoint *checkpoint);
 void
 wal_set_checkpoint_threshold(int64_t threshold);
 
+/**
+ * Configure group commit: if @delay is not 0, requests are
+ * collected in batches of up to @size bytes, each request
+ * waiting for at most @delay seconds.
+ */
+void
+wal_set_group_commit(double delay, int64_t size);
+
+/**
+ * Report WAL statistics: batch size and write latency
+ * histograms and the current group commit target.
+ */
+void
+wal_stat(struct info_handler *h);
+
+/**
+ * Reset WAL statistics.
+ */
+void
+wal_reset_stat(void);
+
+/**
+ * Set the number of spare WAL files to keep preallocated.
+ * Rotation takes a spare file instead of creating a new one,
+ * the pool is refilled in background.
+ */
+void
+wal_set_spare_files(int spare_files);
+
+/**
+ * Set zstd compression level of WAL files, 0 disables
+ * compression. Applies to the current WAL file too.
+ */
+void
+wal_set_compression_level(int level);
+
 /**
  * Remove WAL files that are not needed by consumers reading
  * rows at @vclock or newer.
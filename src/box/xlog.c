@@ -32,6 +32,7 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <sys/mman.h>
 
 #include "fiber.h"
 #include "exception.h"
@@ -87,6 +88,19 @@ enum {
 	 * Maybe this should be a configuration option.
 	 */
 	XLOG_TX_COMPRESS_THRESHOLD = 2 * 1024,
+	/**
+	 * Min size of a chunk of an xlog tx compressed by
+	 * a helper thread. Smaller chunks don't pay for the
+	 * thread handoff and worsen the compression ratio.
+	 */
+	XLOG_TX_COMPRESS_CHUNK = 32 * 1024,
+	/**
+	 * Max number of chunks an xlog tx is split into: a chunk
+	 * per thread plus a chunk per obuf iovec at most, since
+	 * chunks don't span iovecs.
+	 */
+	XLOG_TX_COMPRESS_CHUNK_MAX = XLOG_COMPRESSION_THREADS_MAX + 1 +
+				     SMALL_OBUF_IOV_MAX,
 };
 
 const struct xlog_opts xlog_opts_default = {
@@ -95,6 +109,7 @@ const struct xlog_opts xlog_opts_default = {
 	.free_cache = false,
 	.sync_is_async = false,
 	.no_compression = false,
+	.compression_level = XLOG_COMPRESSION_LEVEL_DEFAULT,
 };
 
 /* {{{ struct xlog_meta */
@@ -113,7 +128,14 @@ enum {
 #define VCLOCK_KEY "VClock"
 #define VERSION_KEY "Version"
 #define PREV_VCLOCK_KEY "PrevVClock"
+#define SHARD_COUNT_KEY "Shards"
 
+/**
+ * Format version of sharded snapshots. Readers that don't
+ * support shards must refuse to load them rather than ignore
+ * the SHARD_COUNT_KEY and load a part of the data.
+ */
+static const char v14[] = "0.14";
 static const char v13[] = "0.13";
 static const char v12[] = "0.12";
 
@@ -133,6 +155,7 @@ xlog_meta_create(struct xlog_meta *meta, const char *filetype,
 		vclock_copy(&meta->prev_vclock, prev_vclock);
 	else
 		vclock_clear(&meta->prev_vclock);
+	meta->shard_count = 0;
 }
 
 /**
@@ -156,7 +179,8 @@ xlog_meta_format(const struct xlog_meta *meta, char *buf, int size)
 		"%s\n"
 		VERSION_KEY ": %s\n"
 		INSTANCE_UUID_KEY ": %s\n",
-		meta->filetype, v13, PACKAGE_VERSION,
+		meta->filetype, meta->shard_count > 0 ? v14 : v13,
+		PACKAGE_VERSION,
 		tt_uuid_str(&meta->instance_uuid));
 	if (vclock_is_set(&meta->vclock)) {
 		SNPRINT(total, snprintf, buf, size, VCLOCK_KEY ": %s\n",
@@ -166,6 +190,10 @@ xlog_meta_format(const struct xlog_meta *meta, char *buf, int size)
 		SNPRINT(total, snprintf, buf, size, PREV_VCLOCK_KEY ": %s\n",
 			vclock_to_string(&meta->prev_vclock));
 	}
+	if (meta->shard_count > 0) {
+		SNPRINT(total, snprintf, buf, size, SHARD_COUNT_KEY ": %u\n",
+			(unsigned)meta->shard_count);
+	}
 	SNPRINT(total, snprintf, buf, size, "\n");
 	assert(total > 0);
 	return total;
@@ -235,7 +263,7 @@ xlog_meta_parse(struct xlog_meta *meta, const char **data,
 	assert(pos <= end);
 
 	/*
-	 * Parse version string, i.e. "0.12" or "0.13"
+	 * Parse version string, i.e. "0.12", "0.13" or "0.14"
 	 */
 	char version[10];
 	eol = (const char *)memchr(pos, '\n', end - pos);
@@ -248,7 +276,8 @@ xlog_meta_parse(struct xlog_meta *meta, const char **data,
 	pos = eol + 1;
 	assert(pos <= end);
 	if (strncmp(version, v12, sizeof(v12)) != 0 &&
-	    strncmp(version, v13, sizeof(v13)) != 0) {
+	    strncmp(version, v13, sizeof(v13)) != 0 &&
+	    strncmp(version, v14, sizeof(v14)) != 0) {
 		diag_set(XlogError,
 			  "unsupported file format version %s",
 			  version);
@@ -307,6 +336,18 @@ xlog_meta_parse(struct xlog_meta *meta, const char **data,
 			 */
 			if (parse_vclock(val, val_end, &meta->prev_vclock) != 0)
 				return -1;
+		} else if (xlog_meta_key_equal(key, key_end, SHARD_COUNT_KEY)) {
+			/*
+			 * Shards: <count>
+			 */
+			char *shard_end;
+			unsigned long count = strtoul(val, &shard_end, 10);
+			if (shard_end != val_end || count == 0 ||
+			    count > UINT32_MAX) {
+				diag_set(XlogError, "can't parse shard count");
+				return -1;
+			}
+			meta->shard_count = count;
 		} else if (xlog_meta_key_equal(key, key_end, VERSION_KEY)) {
 			/* Ignore Version: for now */
 		} else {
@@ -438,7 +479,15 @@ int
 xdir_open_cursor(struct xdir *dir, int64_t signature,
 		 struct xlog_cursor *cursor)
 {
-	const char *filename = xdir_format_filename(dir, signature, NONE);
+	return xdir_open_shard_cursor(dir, signature, 0, cursor);
+}
+
+int
+xdir_open_shard_cursor(struct xdir *dir, int64_t signature, uint32_t shard,
+		       struct xlog_cursor *cursor)
+{
+	const char *filename = xdir_format_shard_filename(dir, signature,
+							  shard, NONE);
 	int fd = open(filename, O_RDONLY);
 	if (fd < 0) {
 		diag_set(SystemError, "failed to open '%s' file", filename);
@@ -656,6 +705,18 @@ xdir_format_filename(struct xdir *dir, int64_t signature,
 					      inprogress_suffix : "");
 }
 
+const char *
+xdir_format_shard_filename(struct xdir *dir, int64_t signature,
+			   uint32_t shard, enum log_suffix suffix)
+{
+	if (shard == 0)
+		return xdir_format_filename(dir, signature, suffix);
+	return tt_snprintf(PATH_MAX + 1, "%s/%020lld.%u%s%s",
+			   dir->dirname, (long long) signature,
+			   (unsigned) shard, dir->filename_ext,
+			   suffix == INPROGRESS ? inprogress_suffix : "");
+}
+
 static void
 xdir_say_gc(int result, int errorno, const char *filename)
 {
@@ -674,6 +735,72 @@ xdir_complete_gc(eio_req *req)
 	return 0;
 }
 
+int
+xdir_read_shard_count(const char *filename, uint32_t *shard_count)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to open file '%s'", filename);
+		return -1;
+	}
+	char meta_buf[XLOG_META_LEN_MAX];
+	ssize_t len = fio_read(fd, meta_buf, sizeof(meta_buf));
+	close(fd);
+	if (len < 0) {
+		diag_set(SystemError, "failed to read file '%s'", filename);
+		return -1;
+	}
+	struct xlog_meta meta;
+	const char *pos = meta_buf;
+	ssize_t rc = xlog_meta_parse(&meta, &pos, meta_buf + len);
+	if (rc > 0)
+		diag_set(XlogError, "Unexpected end of file");
+	if (rc != 0)
+		return -1;
+	*shard_count = meta.shard_count;
+	return 0;
+}
+
+/**
+ * Remove a snapshot file along with its shards, if any.
+ * The number of shards isn't kept in the directory index,
+ * so it is read from the meta of the snapshot file. Shards
+ * go first so that a failure in the middle never leaves
+ * orphaned shards behind.
+ */
+static int
+xdir_unlink_snap(const char *filename)
+{
+	uint32_t shard_count = 0;
+	if (xdir_read_shard_count(filename, &shard_count) != 0)
+		diag_log();
+	const char *ext = strrchr(filename, '.');
+	assert(ext != NULL);
+	char path[PATH_MAX];
+	for (uint32_t shard = 1; shard < shard_count; shard++) {
+		snprintf(path, sizeof(path), "%.*s.%u%s",
+			 (int)(ext - filename), filename,
+			 (unsigned)shard, ext);
+		xdir_say_gc(unlink(path), errno, path);
+	}
+	return unlink(filename);
+}
+
+static void
+xdir_do_unlink_snap(eio_req *req)
+{
+	req->result = xdir_unlink_snap((const char *)req->data);
+	req->errorno = errno;
+}
+
+static int
+xdir_complete_gc_snap(eio_req *req)
+{
+	xdir_say_gc(req->result, req->errorno, (const char *)req->data);
+	free(req->data);
+	return 0;
+}
+
 void
 xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 {
@@ -682,10 +809,20 @@ xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 	       vclock_sum(vclock) < signature) {
 		const char *filename =
 			xdir_format_filename(dir, vclock_sum(vclock), NONE);
-		if (flags & XDIR_GC_ASYNC)
-			eio_unlink(filename, 0, xdir_complete_gc, NULL);
-		else
-			xdir_say_gc(unlink(filename), errno, filename);
+		char *snap_filename;
+		if (dir->type != SNAP) {
+			if (flags & XDIR_GC_ASYNC)
+				eio_unlink(filename, 0, xdir_complete_gc, NULL);
+			else
+				xdir_say_gc(unlink(filename), errno, filename);
+		} else if ((flags & XDIR_GC_ASYNC) &&
+			   (snap_filename = strdup(filename)) != NULL) {
+			eio_custom(xdir_do_unlink_snap, 0,
+				   xdir_complete_gc_snap, snap_filename);
+		} else {
+			xdir_say_gc(xdir_unlink_snap(filename), errno,
+				    filename);
+		}
 		vclockset_remove(&dir->index, vclock);
 		free(vclock);
 
@@ -694,8 +831,9 @@ xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 	}
 }
 
-void
-xdir_collect_inprogress(struct xdir *xdir)
+/** Remove files with the given suffix from a directory. */
+static void
+xdir_remove_by_suffix(struct xdir *xdir, const char *suffix)
 {
 	const char *dirname = xdir->dirname;
 	DIR *dh = opendir(dirname);
@@ -707,7 +845,7 @@ xdir_collect_inprogress(struct xdir *xdir)
 	struct dirent *dent;
 	while ((dent = readdir(dh)) != NULL) {
 		char *ext = strrchr(dent->d_name, '.');
-		if (ext == NULL || strcmp(ext, inprogress_suffix) != 0)
+		if (ext == NULL || strcmp(ext, suffix) != 0)
 			continue;
 
 		char path[PATH_MAX];
@@ -720,6 +858,91 @@ xdir_collect_inprogress(struct xdir *xdir)
 	closedir(dh);
 }
 
+void
+xdir_collect_inprogress(struct xdir *xdir)
+{
+	xdir_remove_by_suffix(xdir, inprogress_suffix);
+}
+
+void
+xdir_collect_spares(struct xdir *dir)
+{
+	xdir_remove_by_suffix(dir, spare_suffix);
+}
+
+const char *
+xdir_format_spare_filename(struct xdir *dir, uint64_t id)
+{
+	return tt_snprintf(PATH_MAX, "%s/%020llu%s%s", dir->dirname,
+			   (unsigned long long) id, dir->filename_ext,
+			   spare_suffix);
+}
+
+/**
+ * Sync the directory so that files created or renamed in it
+ * survive a system crash.
+ */
+static int
+xdir_sync(struct xdir *dir)
+{
+	int fd = open(dir->dirname, O_RDONLY);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to open directory '%s'",
+			 dir->dirname);
+		return -1;
+	}
+	if (fsync(fd) != 0) {
+		diag_set(SystemError, "%s: fsync failed", dir->dirname);
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	return 0;
+}
+
+int
+xdir_create_spare(struct xdir *dir, uint64_t id, size_t size)
+{
+	char filename[PATH_MAX];
+	snprintf(filename, sizeof(filename), "%s",
+		 xdir_format_spare_filename(dir, id));
+	int fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0) {
+		diag_set(SystemError, "failed to create file '%s'",
+			 filename);
+		return -1;
+	}
+#ifdef HAVE_FALLOCATE
+	/*
+	 * Keep the file size zero: the file is going to become
+	 * an xlog, and readers treat everything before EOF as
+	 * valid data, see xlog_fallocate().
+	 */
+	if (fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, size) != 0 &&
+	    errno != ENOSYS && errno != EOPNOTSUPP) {
+		diag_set(SystemError, "%s: can't allocate disk space",
+			 filename);
+		goto fail;
+	}
+#else
+	(void)size;
+#endif /* HAVE_FALLOCATE */
+	if (fsync(fd) != 0) {
+		diag_set(SystemError, "%s: fsync failed", filename);
+		goto fail;
+	}
+	close(fd);
+	if (xdir_sync(dir) != 0) {
+		unlink(filename);
+		return -1;
+	}
+	return 0;
+fail:
+	close(fd);
+	unlink(filename);
+	return -1;
+}
+
 void
 xdir_add_vclock(struct xdir *xdir, const struct vclock *vclock)
 {
@@ -800,9 +1023,14 @@ xlog_destroy(struct xlog *xlog)
 	xlog->fd = -1;
 }
 
-int
-xlog_create(struct xlog *xlog, const char *name, int flags,
-	    const struct xlog_meta *meta, const struct xlog_opts *opts)
+/**
+ * Create a new xlog file or, if @spare is not NULL, take over
+ * the given spare file, see xdir_create_spare().
+ */
+static int
+xlog_create_file(struct xlog *xlog, const char *name, const char *spare,
+		 int flags, const struct xlog_meta *meta,
+		 const struct xlog_opts *opts)
 {
 	char meta_buf[XLOG_META_LEN_MAX];
 	int meta_len;
@@ -824,7 +1052,22 @@ xlog_create(struct xlog *xlog, const char *name, int flags,
 	xlog->is_inprogress = true;
 	snprintf(xlog->filename, PATH_MAX, "%s%s", name, inprogress_suffix);
 
-	flags |= O_RDWR | O_CREAT | O_EXCL;
+	flags |= O_RDWR;
+	if (spare == NULL) {
+		flags |= O_CREAT | O_EXCL;
+	} else if (access(xlog->filename, F_OK) == 0) {
+		errno = EEXIST;
+		diag_set(SystemError, "file '%s' already exists",
+			 xlog->filename);
+		goto err_open;
+	} else if (rename(spare, xlog->filename) != 0) {
+		/*
+		 * The disk space of a spare file is already
+		 * allocated, so taking it over costs a rename.
+		 */
+		diag_set(SystemError, "failed to rename '%s' file", spare);
+		goto err_open;
+	}
 
 	/*
 	 * Open the <lsn>.<suffix>.inprogress file.
@@ -841,6 +1084,8 @@ xlog_create(struct xlog *xlog, const char *name, int flags,
 		say_syserror("open, [%s]", xlog->filename);
 		diag_set(SystemError, "failed to create file '%s'",
 			 xlog->filename);
+		if (spare != NULL)
+			unlink(xlog->filename);
 		goto err_open;
 	}
 
@@ -859,6 +1104,17 @@ xlog_create(struct xlog *xlog, const char *name, int flags,
 	}
 
 	xlog->offset = meta_len; /* first log starts after meta */
+	if (spare != NULL) {
+		/*
+		 * The spare file has disk space allocated beyond
+		 * EOF, account it so that xlog_write_eof() frees
+		 * what is left unused.
+		 */
+		struct stat st;
+		if (fstat(xlog->fd, &st) == 0 &&
+		    (off_t)st.st_blocks * 512 > xlog->offset)
+			xlog->allocated = st.st_blocks * 512 - xlog->offset;
+	}
 	return 0;
 err_write:
 	close(xlog->fd);
@@ -869,6 +1125,13 @@ err:
 	return -1;
 }
 
+int
+xlog_create(struct xlog *xlog, const char *name, int flags,
+	    const struct xlog_meta *meta, const struct xlog_opts *opts)
+{
+	return xlog_create_file(xlog, name, NULL, flags, meta, opts);
+}
+
 int
 xlog_open(struct xlog *xlog, const char *name, const struct xlog_opts *opts)
 {
@@ -959,13 +1222,37 @@ xdir_touch_xlog(struct xdir *dir, const struct vclock *vclock)
 	return 0;
 }
 
+static int
+xdir_create_xlog_file(struct xdir *dir, struct xlog *xlog,
+		      const char *filename, const char *spare,
+		      const struct xlog_meta *meta)
+{
+	if (xlog_create_file(xlog, filename, spare, dir->open_wflags,
+			     meta, &dir->opts) != 0)
+		return -1;
+
+	/* Rename xlog file */
+	if (dir->suffix != INPROGRESS && xlog_rename(xlog)) {
+		int save_errno = errno;
+		xlog_close(xlog, false);
+		errno = save_errno;
+		return -1;
+	}
+
+	return 0;
+}
+
 /**
  * In case of error, writes a message to the error log
  * and sets errno.
  */
-int
-xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
-		 const struct vclock *vclock)
+/**
+ * Create a new xlog in the given directory, taking over the
+ * spare file @spare if it is not NULL.
+ */
+static int
+xdir_create_xlog_impl(struct xdir *dir, struct xlog *xlog,
+		      const struct vclock *vclock, const char *spare)
 {
 	int64_t signature = vclock_sum(vclock);
 	assert(signature >= 0);
@@ -984,21 +1271,59 @@ xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 			 vclock, prev_vclock);
 
 	const char *filename = xdir_format_filename(dir, signature, NONE);
-	if (xlog_create(xlog, filename, dir->open_wflags, &meta,
-			&dir->opts) != 0)
-		return -1;
+	return xdir_create_xlog_file(dir, xlog, filename, spare, &meta);
+}
 
-	/* Rename xlog file */
-	if (dir->suffix != INPROGRESS && xlog_rename(xlog)) {
-		int save_errno = errno;
-		xlog_close(xlog, false);
-		errno = save_errno;
-		return -1;
-	}
+/**
+ * In case of error, writes a message to the error log
+ * and sets errno.
+ */
+int
+xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
+		 const struct vclock *vclock)
+{
+	return xdir_create_xlog_impl(dir, xlog, vclock, NULL);
+}
 
+int
+xdir_create_xlog_from_spare(struct xdir *dir, struct xlog *xlog,
+			    const struct vclock *vclock, uint64_t spare_id)
+{
+	char spare[PATH_MAX];
+	snprintf(spare, sizeof(spare), "%s",
+		 xdir_format_spare_filename(dir, spare_id));
+	if (xdir_create_xlog_impl(dir, xlog, vclock, spare) != 0)
+		return -1;
+	/*
+	 * Persist the rename of the spare file. The new xlog is
+	 * usable anyway, so a failure is not fatal.
+	 */
+	if (xdir_sync(dir) != 0)
+		diag_log();
 	return 0;
 }
 
+int
+xdir_create_xlog_shard(struct xdir *dir, struct xlog *xlog,
+		       const struct vclock *vclock,
+		       uint32_t shard, uint32_t shard_count)
+{
+	int64_t signature = vclock_sum(vclock);
+	assert(signature >= 0);
+	assert(dir->type == SNAP);
+	assert(shard < shard_count);
+	assert(!tt_uuid_is_nil(dir->instance_uuid));
+
+	struct xlog_meta meta;
+	xlog_meta_create(&meta, dir->filetype, dir->instance_uuid,
+			 vclock, NULL);
+	meta.shard_count = shard_count;
+
+	const char *filename = xdir_format_shard_filename(dir, signature,
+							  shard, NONE);
+	return xdir_create_xlog_file(dir, xlog, filename, NULL, &meta);
+}
+
 ssize_t
 xlog_fallocate(struct xlog *log, size_t len)
 {
@@ -1034,6 +1359,243 @@ xlog_fallocate(struct xlog *log, size_t len)
 #endif /* HAVE_FALLOCATE */
 }
 
+/**
+ * Encode an xlog tx fixheader: the magic, the length and the
+ * checksum of the data following it, padded to
+ * XLOG_FIXHEADER_SIZE.
+ */
+static void
+xlog_fixheader_encode(char *fixheader, log_magic_t magic, size_t len,
+		      uint32_t crc32c)
+{
+	*(log_magic_t *)fixheader = magic;
+	char *data = fixheader + sizeof(log_magic_t);
+	data = mp_encode_uint(data, len);
+	/* Encode crc32 for previous row */
+	data = mp_encode_uint(data, 0);
+	/* Encode crc32 for current row */
+	data = mp_encode_uint(data, crc32c);
+	/*
+	 * Encode a padding, to ensure the resulting
+	 * fixheader always has the same size.
+	 */
+	ssize_t padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
+	if (padding > 0) {
+		data = mp_encode_strl(data, padding - 1);
+		if (padding > 1) {
+			memset(data, 0, padding - 1);
+			data += padding - 1;
+		}
+	}
+}
+
+/* {{{ Compression helper threads */
+
+/** A chunk of an xlog tx, compressed as a separate zstd frame. */
+struct xlog_zchunk {
+	/** Uncompressed data. */
+	const char *src;
+	size_t src_size;
+	/** Output buffer, ZSTD_compressBound(src_size) bytes. */
+	char *dst;
+	size_t dst_size;
+	/** Size of the compressed data or a zstd error code. */
+	size_t zsize;
+	/** crc32c of the compressed data. */
+	uint32_t crc32c;
+};
+
+/** Chunks of an xlog tx compressed by helper threads. */
+struct xlog_zjob {
+	struct xlog_zchunk *chunks;
+	int chunk_count;
+	/** zstd compression level. */
+	int level;
+	/** Index of the next chunk to compress. */
+	int next;
+	/** Number of compressed chunks. */
+	int done;
+	/** Signaled when all chunks have been compressed. */
+	pthread_cond_t cond;
+	/** Link in xlog_zpool::jobs. */
+	struct rlist in_pool;
+};
+
+static struct xlog_zpool {
+	/** Protects all members of the pool and its jobs. */
+	pthread_mutex_t mutex;
+	/** Signaled when a job is queued or the pool is stopped. */
+	pthread_cond_t cond;
+	/** Jobs having chunks no one has taken yet. */
+	struct rlist jobs;
+	/** Helper threads. */
+	struct cord *threads;
+	int thread_count;
+	/** Set when the helper threads must exit. */
+	bool is_stopped;
+} xlog_zpool = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.jobs = RLIST_HEAD_INITIALIZER(xlog_zpool.jobs),
+};
+
+static void
+xlog_zchunk_compress(struct xlog_zchunk *chunk, ZSTD_CCtx *zctx, int level)
+{
+	chunk->zsize = ZSTD_compressCCtx(zctx, chunk->dst, chunk->dst_size,
+					 chunk->src, chunk->src_size, level);
+	if (!ZSTD_isError(chunk->zsize))
+		chunk->crc32c = crc32_calc(0, chunk->dst, chunk->zsize);
+}
+
+/**
+ * Take the next chunk of a job. The job is dequeued once its
+ * last chunk is taken. Called with the pool mutex locked.
+ */
+static struct xlog_zchunk *
+xlog_zjob_take(struct xlog_zjob *job)
+{
+	assert(job->next < job->chunk_count);
+	struct xlog_zchunk *chunk = &job->chunks[job->next++];
+	if (job->next == job->chunk_count)
+		rlist_del_entry(job, in_pool);
+	return chunk;
+}
+
+/**
+ * Mark a chunk of a job compressed. Called with the pool mutex
+ * locked.
+ */
+static void
+xlog_zjob_complete(struct xlog_zjob *job)
+{
+	if (++job->done == job->chunk_count)
+		tt_pthread_cond_signal(&job->cond);
+}
+
+static void *
+xlog_zpool_f(void *arg)
+{
+	(void)arg;
+	struct xlog_zpool *pool = &xlog_zpool;
+	/*
+	 * If we fail to create a context, just exit: the
+	 * thread writing an xlog compresses whatever chunks
+	 * the helpers don't take.
+	 */
+	ZSTD_CCtx *zctx = ZSTD_createCCtx();
+	if (zctx == NULL) {
+		say_error("failed to create compression context");
+		return NULL;
+	}
+	tt_pthread_mutex_lock(&pool->mutex);
+	while (true) {
+		while (!pool->is_stopped && rlist_empty(&pool->jobs))
+			tt_pthread_cond_wait(&pool->cond, &pool->mutex);
+		if (pool->is_stopped)
+			break;
+		struct xlog_zjob *job = rlist_first_entry(&pool->jobs,
+							  struct xlog_zjob,
+							  in_pool);
+		struct xlog_zchunk *chunk = xlog_zjob_take(job);
+		tt_pthread_mutex_unlock(&pool->mutex);
+		xlog_zchunk_compress(chunk, zctx, job->level);
+		tt_pthread_mutex_lock(&pool->mutex);
+		xlog_zjob_complete(job);
+	}
+	tt_pthread_mutex_unlock(&pool->mutex);
+	ZSTD_freeCCtx(zctx);
+	return NULL;
+}
+
+/**
+ * Compress all chunks of a job, with the help of the pool
+ * threads. The calling thread compresses chunks too, with
+ * @zctx, so the job completes even if no helper is free.
+ */
+static void
+xlog_zpool_run(struct xlog_zjob *job, ZSTD_CCtx *zctx)
+{
+	struct xlog_zpool *pool = &xlog_zpool;
+	job->next = 0;
+	job->done = 0;
+	tt_pthread_cond_init(&job->cond, NULL);
+	tt_pthread_mutex_lock(&pool->mutex);
+	rlist_add_tail_entry(&pool->jobs, job, in_pool);
+	tt_pthread_cond_broadcast(&pool->cond);
+	while (job->next < job->chunk_count) {
+		struct xlog_zchunk *chunk = xlog_zjob_take(job);
+		tt_pthread_mutex_unlock(&pool->mutex);
+		xlog_zchunk_compress(chunk, zctx, job->level);
+		tt_pthread_mutex_lock(&pool->mutex);
+		xlog_zjob_complete(job);
+	}
+	while (job->done < job->chunk_count)
+		tt_pthread_cond_wait(&job->cond, &pool->mutex);
+	tt_pthread_mutex_unlock(&pool->mutex);
+	tt_pthread_cond_destroy(&job->cond);
+}
+
+int
+xlog_compression_start(int thread_count)
+{
+	struct xlog_zpool *pool = &xlog_zpool;
+	assert(pool->thread_count == 0);
+	assert(thread_count <= XLOG_COMPRESSION_THREADS_MAX);
+	if (thread_count == 0)
+		return 0;
+	pool->threads = calloc(thread_count, sizeof(*pool->threads));
+	if (pool->threads == NULL) {
+		diag_set(OutOfMemory, thread_count * sizeof(*pool->threads),
+			 "calloc", "struct cord");
+		return -1;
+	}
+	pool->is_stopped = false;
+	for (int i = 0; i < thread_count; i++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "xlog_zip.%d", i);
+		if (cord_start(&pool->threads[i], name,
+			       xlog_zpool_f, NULL) != 0) {
+			xlog_compression_stop();
+			return -1;
+		}
+		pool->thread_count++;
+	}
+	return 0;
+}
+
+void
+xlog_compression_stop(void)
+{
+	struct xlog_zpool *pool = &xlog_zpool;
+	tt_pthread_mutex_lock(&pool->mutex);
+	pool->is_stopped = true;
+	tt_pthread_cond_broadcast(&pool->cond);
+	tt_pthread_mutex_unlock(&pool->mutex);
+	for (int i = 0; i < pool->thread_count; i++) {
+		if (cord_join(&pool->threads[i]) != 0)
+			panic_syserror("failed to join a compression thread");
+	}
+	free(pool->threads);
+	pool->threads = NULL;
+	pool->thread_count = 0;
+}
+
+/**
+ * Return the number of chunks to split an xlog tx of the given
+ * size into for compression in helper threads, 1 if the tx
+ * should be compressed by the writing thread alone.
+ */
+static int
+xlog_zpool_chunk_count(size_t size)
+{
+	size_t count = MIN((size_t)xlog_zpool.thread_count + 1,
+			   size / XLOG_TX_COMPRESS_CHUNK);
+	return MAX(count, 1);
+}
+
+/* }}} */
+
 /**
  * Write a sequence of uncompressed xrow objects.
  *
@@ -1048,14 +1610,6 @@ xlog_tx_write_plain(struct xlog *log)
 	 * now populate it with data.
 	 */
 	char *fixheader = (char *)log->obuf.iov[0].iov_base;
-	*(log_magic_t *)fixheader = row_marker;
-	char *data = fixheader + sizeof(log_magic_t);
-
-	data = mp_encode_uint(data,
-			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE);
-	/* Encode crc32 for previous row */
-	data = mp_encode_uint(data, 0);
-	/* Encode crc32 for current row */
 	uint32_t crc32c = 0;
 	struct iovec *iov;
 	size_t offset = XLOG_FIXHEADER_SIZE;
@@ -1065,19 +1619,9 @@ xlog_tx_write_plain(struct xlog *log)
 				    iov->iov_len - offset);
 		offset = 0;
 	}
-	data = mp_encode_uint(data, crc32c);
-	/*
-	 * Encode a padding, to ensure the resulting
-	 * fixheader always has the same size.
-	 */
-	ssize_t padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
-	if (padding > 0) {
-		data = mp_encode_strl(data, padding - 1);
-		if (padding > 1) {
-			memset(data, 0, padding - 1);
-			data += padding - 1;
-		}
-	}
+	xlog_fixheader_encode(fixheader, row_marker,
+			      obuf_size(&log->obuf) - XLOG_FIXHEADER_SIZE,
+			      crc32c);
 
 	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
@@ -1093,6 +1637,105 @@ xlog_tx_write_plain(struct xlog *log)
 	return obuf_size(&log->obuf);
 }
 
+/**
+ * Write a compressed block of xrow objects, compressed in
+ * @chunk_count chunks by the compression helper threads and
+ * this thread. Each chunk is a separate zstd frame: the reader
+ * decompresses a sequence of frames as one stream. The chunk
+ * checksums are combined into the block checksum.
+ *
+ * @retval -1  error
+ * @retval >= 0 the number of bytes written
+ */
+static off_t
+xlog_tx_write_zstd_parallel(struct xlog *log, int chunk_count)
+{
+	struct xlog_zchunk chunks[XLOG_TX_COMPRESS_CHUNK_MAX];
+	struct iovec iov[XLOG_TX_COMPRESS_CHUNK_MAX + 1];
+
+	char *fixheader = (char *)obuf_alloc(&log->zbuf,
+					     XLOG_FIXHEADER_SIZE);
+	if (fixheader == NULL) {
+		diag_set(OutOfMemory, XLOG_FIXHEADER_SIZE, "runtime arena",
+			 "compression buffer");
+		goto error;
+	}
+	iov[0].iov_base = fixheader;
+	iov[0].iov_len = XLOG_FIXHEADER_SIZE;
+
+	/*
+	 * Split the rows in chunks of about the same size.
+	 * A chunk doesn't span obuf iovecs. Output buffers are
+	 * allocated here, since obuf isn't thread-safe.
+	 */
+	size_t chunk_size = DIV_ROUND_UP(obuf_size(&log->obuf) -
+					 XLOG_FIXHEADER_SIZE, chunk_count);
+	struct xlog_zjob job;
+	job.chunks = chunks;
+	job.chunk_count = 0;
+	job.level = log->opts.compression_level;
+	size_t offset = XLOG_FIXHEADER_SIZE;
+	for (struct iovec *v = log->obuf.iov; v->iov_len; ++v) {
+		const char *src = (char *)v->iov_base + offset;
+		size_t len = v->iov_len - offset;
+		offset = 0;
+		while (len > 0) {
+			assert(job.chunk_count < XLOG_TX_COMPRESS_CHUNK_MAX);
+			struct xlog_zchunk *chunk =
+				&chunks[job.chunk_count++];
+			chunk->src = src;
+			chunk->src_size = MIN(len, chunk_size);
+			chunk->dst_size = ZSTD_compressBound(chunk->src_size);
+			chunk->dst = (char *)obuf_alloc(&log->zbuf,
+							chunk->dst_size);
+			if (chunk->dst == NULL) {
+				diag_set(OutOfMemory, chunk->dst_size,
+					 "runtime arena",
+					 "compression buffer");
+				goto error;
+			}
+			src += chunk->src_size;
+			len -= chunk->src_size;
+		}
+	}
+
+	xlog_zpool_run(&job, log->zctx);
+
+	uint32_t crc32c = 0;
+	size_t zsize = 0;
+	for (int i = 0; i < job.chunk_count; i++) {
+		struct xlog_zchunk *chunk = &chunks[i];
+		if (ZSTD_isError(chunk->zsize)) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 ZSTD_getErrorName(chunk->zsize));
+			goto error;
+		}
+		crc32c = crc32_combine(crc32c, chunk->crc32c, chunk->zsize);
+		zsize += chunk->zsize;
+		iov[i + 1].iov_base = chunk->dst;
+		iov[i + 1].iov_len = chunk->zsize;
+	}
+	xlog_fixheader_encode(fixheader, zrow_marker, zsize, crc32c);
+
+	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
+		diag_set(ClientError, ER_INJECTION, "xlog write injection");
+		goto error;
+	});
+
+	ssize_t written;
+	written = fio_writevn(log->fd, iov, job.chunk_count + 1);
+	if (written < 0) {
+		diag_set(SystemError, "failed to write to '%s' file",
+			 log->filename);
+		goto error;
+	}
+	obuf_reset(&log->zbuf);
+	return written;
+error:
+	obuf_reset(&log->zbuf);
+	return -1;
+}
+
 /**
  * Write a compressed block of xrow objects.
  * @retval -1  error
@@ -1101,13 +1744,16 @@ xlog_tx_write_plain(struct xlog *log)
 static off_t
 xlog_tx_write_zstd(struct xlog *log)
 {
+	int chunk_count = xlog_zpool_chunk_count(obuf_size(&log->obuf));
+	if (chunk_count > 1)
+		return xlog_tx_write_zstd_parallel(log, chunk_count);
+
 	char *fixheader = (char *)obuf_alloc(&log->zbuf,
 					     XLOG_FIXHEADER_SIZE);
 
 	uint32_t crc32c = 0;
 	struct iovec *iov;
-	/* 3 is compression level. */
-	ZSTD_compressBegin(log->zctx, 3);
+	ZSTD_compressBegin(log->zctx, log->opts.compression_level);
 	size_t offset = XLOG_FIXHEADER_SIZE;
 	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
 		/* Estimate max output buffer size. */
@@ -1147,25 +1793,9 @@ xlog_tx_write_zstd(struct xlog *log)
 		offset = 0;
 	}
 
-	*(log_magic_t *)fixheader = zrow_marker;
-	char *data;
-	data = fixheader + sizeof(log_magic_t);
-	data = mp_encode_uint(data,
-			      obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE);
-	/* Encode crc32 for previous row */
-	data = mp_encode_uint(data, 0);
-	/* Encode crc32 for current row */
-	data = mp_encode_uint(data, crc32c);
-	/* Encode padding */
-	ssize_t padding;
-	padding = XLOG_FIXHEADER_SIZE - (data - fixheader);
-	if (padding > 0) {
-		data = mp_encode_strl(data, padding - 1);
-		if (padding > 1) {
-			memset(data, 0, padding - 1);
-			data += padding - 1;
-		}
-	}
+	xlog_fixheader_encode(fixheader, zrow_marker,
+			      obuf_size(&log->zbuf) - XLOG_FIXHEADER_SIZE,
+			      crc32c);
 
 	ERROR_INJECT(ERRINJ_WAL_WRITE_DISK, {
 		diag_set(ClientError, ER_INJECTION, "xlog write injection");
@@ -1203,7 +1833,7 @@ xlog_tx_write(struct xlog *log)
 		return 0;
 	ssize_t written;
 
-	if (!log->opts.no_compression &&
+	if (!log->opts.no_compression && log->opts.compression_level > 0 &&
 	    obuf_size(&log->obuf) >= XLOG_TX_COMPRESS_THRESHOLD) {
 		written = xlog_tx_write_zstd(log);
 	} else {
@@ -1493,6 +2123,8 @@ xlog_atfork(struct xlog *xlog)
 /* {{{ struct xlog_cursor */
 
 #define XLOG_READ_AHEAD		(1 << 14)
+/** Read ahead and drop behind step of a mapped file. */
+#define XLOG_MMAP_READAHEAD	(1 << 20)
 
 /**
  * Ensure that at least count bytes are in read buffer
@@ -1506,8 +2138,8 @@ xlog_cursor_ensure(struct xlog_cursor *cursor, size_t count)
 {
 	if (ibuf_used(&cursor->rbuf) >= count)
 		return 0;
-	/* in-memory mode */
-	if (cursor->fd < 0)
+	/* in-memory mode or the whole file is mapped */
+	if (cursor->fd < 0 || cursor->map != NULL)
 		return 1;
 
 	size_t to_load = count - ibuf_used(&cursor->rbuf);
@@ -1717,14 +2349,18 @@ xlog_tx_decode(const char *data, const char *data_end,
 }
 
 /**
+ * Create a tx cursor. If @copy is false, the caller guarantees
+ * that the data outlives the tx cursor and uncompressed rows are
+ * decoded in place.
+ *
  * @retval -1 error
  * @retval 0 success
  * @retval >0 how many bytes we will have for continue
  */
-ssize_t
-xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
-		      const char **data, const char *data_end,
-		      ZSTD_DStream *zdctx)
+static ssize_t
+xlog_tx_cursor_create_impl(struct xlog_tx_cursor *tx_cursor,
+			   const char **data, const char *data_end,
+			   ZSTD_DStream *zdctx, bool copy)
 {
 	const char *rpos = *data;
 	struct xlog_fixheader fixheader;
@@ -1737,12 +2373,18 @@ xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
 	if ((data_end - rpos) < (ptrdiff_t)fixheader.len)
 		return fixheader.len - (data_end - rpos);
 
+	bool is_garbage = false;
 	ERROR_INJECT(ERRINJ_XLOG_GARBAGE, {
-		*((char *)rpos + fixheader.len / 2) = ~*((char *)rpos + fixheader.len / 2);
+		/* A mapped file is read-only. */
+		if (copy)
+			*((char *)rpos + fixheader.len / 2) = ~*((char *)rpos + fixheader.len / 2);
+		else
+			is_garbage = true;
 	});
 
 	/* Validate checksum */
-	if (crc32_calc(0, rpos, fixheader.len) != fixheader.crc32c) {
+	if (is_garbage ||
+	    crc32_calc(0, rpos, fixheader.len) != fixheader.crc32c) {
 		diag_set(XlogError, "tx checksum mismatch");
 		return -1;
 	}
@@ -1750,6 +2392,18 @@ xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
 
 	ibuf_create(&tx_cursor->rows, &cord()->slabc,
 		    XLOG_TX_AUTOCOMMIT_THRESHOLD);
+	if (fixheader.magic == row_marker && !copy) {
+		/*
+		 * Let the rows buffer span the data. It owns
+		 * no memory, so destroying it is a no-op.
+		 */
+		tx_cursor->rows.rpos = (char *)rpos;
+		tx_cursor->rows.wpos = (char *)rpos + fixheader.len;
+		tx_cursor->rows.end = tx_cursor->rows.wpos;
+		*data = (char *)rpos + fixheader.len;
+		tx_cursor->size = ibuf_used(&tx_cursor->rows);
+		return 0;
+	}
 	if (fixheader.magic == row_marker) {
 		void *dst = ibuf_alloc(&tx_cursor->rows, fixheader.len);
 		if (dst == NULL) {
@@ -1788,6 +2442,15 @@ xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
 	return 0;
 }
 
+ssize_t
+xlog_tx_cursor_create(struct xlog_tx_cursor *tx_cursor,
+		      const char **data, const char *data_end,
+		      ZSTD_DStream *zdctx)
+{
+	return xlog_tx_cursor_create_impl(tx_cursor, data, data_end,
+					  zdctx, true);
+}
+
 int
 xlog_tx_cursor_next_row(struct xlog_tx_cursor *tx_cursor,
 		        struct xrow_header *xrow)
@@ -1843,6 +2506,81 @@ xlog_cursor_find_tx_magic(struct xlog_cursor *i)
 	return 0;
 }
 
+/**
+ * Read ahead the mapped file past the cursor position and drop
+ * the pages the cursor has left behind, so that the mapping
+ * doesn't add up to RSS. Rows of the previous tx are no longer
+ * referenced at this point.
+ */
+static void
+xlog_cursor_advise(struct xlog_cursor *i)
+{
+	assert(i->map != NULL);
+	size_t offset = i->rbuf.rpos - i->map;
+	if (i->map_readahead > 0 &&
+	    offset < i->map_dropped + XLOG_MMAP_READAHEAD / 2)
+		return;
+	size_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+	size_t drop = offset & ~page_mask;
+	if (drop > i->map_dropped) {
+		madvise(i->map + i->map_dropped, drop - i->map_dropped,
+			MADV_DONTNEED);
+		i->map_dropped = drop;
+	}
+	size_t readahead = MIN(offset + XLOG_MMAP_READAHEAD, i->map_size);
+	readahead = (readahead + page_mask) & ~page_mask;
+	if (readahead > i->map_readahead) {
+		madvise(i->map + i->map_readahead,
+			readahead - i->map_readahead, MADV_WILLNEED);
+		i->map_readahead = readahead;
+	}
+}
+
+/**
+ * Map the file of a cursor into memory if it is finished,
+ * i.e. ends with the eof marker. A file being written to may
+ * be truncated after a write error, and accessing a mapping
+ * past the end of file raises SIGBUS, so such a file is read
+ * into the read buffer.
+ *
+ * @retval 0 the file is mapped
+ * @retval 1 the file must be read into the read buffer
+ */
+static int
+xlog_cursor_mmap(struct xlog_cursor *i)
+{
+	struct stat st;
+	if (fstat(i->fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+	    st.st_size < (off_t)sizeof(log_magic_t))
+		return 1;
+	log_magic_t magic;
+	if (fio_pread(i->fd, &magic, sizeof(magic),
+		      st.st_size - sizeof(magic)) != (ssize_t)sizeof(magic) ||
+	    magic != eof_marker)
+		return 1;
+	void *map = MAP_FAILED;
+	struct errinj *inj = errinj(ERRINJ_XLOG_MMAP, ERRINJ_BOOL);
+	if (inj != NULL && inj->bparam)
+		errno = ENOMEM;
+	else
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, i->fd, 0);
+	if (map == MAP_FAILED) {
+		say_syserror("failed to map '%s' file", i->name);
+		return 1;
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	i->map = (char *)map;
+	i->map_size = st.st_size;
+	i->map_readahead = 0;
+	i->map_dropped = 0;
+	i->rbuf.rpos = i->map;
+	i->rbuf.wpos = i->map + i->map_size;
+	i->rbuf.end = i->rbuf.wpos;
+	i->read_offset = i->map_size;
+	xlog_cursor_advise(i);
+	return 0;
+}
+
 int
 xlog_cursor_next_tx(struct xlog_cursor *i)
 {
@@ -1860,10 +2598,14 @@ xlog_cursor_next_tx(struct xlog_cursor *i)
 		goto eof_found;
 	}
 
+	if (i->map != NULL)
+		xlog_cursor_advise(i);
+
 	ssize_t to_load;
-	while ((to_load = xlog_tx_cursor_create(&i->tx_cursor,
+	while ((to_load = xlog_tx_cursor_create_impl(&i->tx_cursor,
 						(const char **)&i->rbuf.rpos,
-						i->rbuf.wpos, i->zdctx)) > 0) {
+						i->rbuf.wpos, i->zdctx,
+						i->map == NULL)) > 0) {
 		/* not enough data in read buffer */
 		int rc = xlog_cursor_ensure(i, ibuf_used(&i->rbuf) + to_load);
 		if (rc < 0)
@@ -1948,8 +2690,10 @@ xlog_cursor_openfd(struct xlog_cursor *i, int fd, const char *name)
 {
 	memset(i, 0, sizeof(*i));
 	i->fd = fd;
+	snprintf(i->name, PATH_MAX, "%s", name);
 	ibuf_create(&i->rbuf, &cord()->slabc,
 		    XLOG_TX_AUTOCOMMIT_THRESHOLD << 1);
+	xlog_cursor_mmap(i);
 
 	ssize_t rc;
 	/*
@@ -1968,7 +2712,6 @@ xlog_cursor_openfd(struct xlog_cursor *i, int fd, const char *name)
 		diag_set(XlogError, "Unexpected end of file, run with 'force_recovery = true'");
 		goto error;
 	}
-	snprintf(i->name, PATH_MAX, "%s", name);
 	i->zdctx = ZSTD_createDStream();
 	if (i->zdctx == NULL) {
 		diag_set(ClientError, ER_DECOMPRESSION,
@@ -1978,7 +2721,10 @@ xlog_cursor_openfd(struct xlog_cursor *i, int fd, const char *name)
 	i->state = XLOG_CURSOR_ACTIVE;
 	return 0;
 error:
-	ibuf_destroy(&i->rbuf);
+	if (i->map != NULL)
+		munmap(i->map, i->map_size);
+	else
+		ibuf_destroy(&i->rbuf);
 	return -1;
 }
 
@@ -2046,9 +2792,12 @@ xlog_cursor_close(struct xlog_cursor *i, bool reuse_fd)
 	if (i->fd >= 0 && !reuse_fd)
 		close(i->fd);
 	assert(i->rbuf.slabc == &cord()->slabc);
-	ibuf_destroy(&i->rbuf);
 	if (i->state == XLOG_CURSOR_TX)
 		xlog_tx_cursor_destroy(&i->tx_cursor);
+	if (i->map != NULL)
+		munmap(i->map, i->map_size);
+	else
+		ibuf_destroy(&i->rbuf);
 	ZSTD_freeDStream(i->zdctx);
 	i->state = (i->state == XLOG_CURSOR_EOF ?
 		    XLOG_CURSOR_EOF_CLOSED : XLOG_CURSOR_CLOSED);
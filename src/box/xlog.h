@@ -49,6 +49,15 @@ struct xrow_header;
 extern "C" {
 #endif /* defined(__cplusplus) */
 
+enum {
+	/** Default zstd compression level of xlog files. */
+	XLOG_COMPRESSION_LEVEL_DEFAULT = 3,
+	/** Max zstd compression level. */
+	XLOG_COMPRESSION_LEVEL_MAX = 22,
+	/** Max number of xlog compression helper threads. */
+	XLOG_COMPRESSION_THREADS_MAX = 32,
+};
+
 /**
  * This structure combines all xlog write options set on xlog
  * creation.
@@ -82,10 +91,36 @@ struct xlog_opts {
 	 * to be read frequently, e.g. L1 run files in Vinyl.
 	 */
 	bool no_compression;
+	/**
+	 * zstd compression level, 0 disables compression.
+	 * Unlike the other options, may be changed for an open
+	 * xlog, takes effect on the next write.
+	 */
+	int compression_level;
 };
 
 extern const struct xlog_opts xlog_opts_default;
 
+/**
+ * Start @thread_count helper threads that compress big xlog
+ * transactions together with the thread writing the xlog:
+ * a transaction is split in chunks compressed independently,
+ * and the chunks are written as one block. Without helper
+ * threads a transaction is compressed by the writing thread
+ * alone. Must be called before any xlog is written.
+ *
+ * Return 0 on success, -1 on failure.
+ */
+int
+xlog_compression_start(int thread_count);
+
+/**
+ * Stop the xlog compression helper threads. Must be called
+ * after all xlogs have been closed.
+ */
+void
+xlog_compression_stop(void);
+
 /* {{{ log dir */
 
 /**
@@ -111,6 +146,11 @@ enum log_suffix { NONE, INPROGRESS };
  */
 #define inprogress_suffix ".inprogress"
 
+/**
+ * Suffix added to path of spare files, see xdir_create_spare().
+ */
+#define spare_suffix ".spare"
+
 /**
  * A handle for a data directory with write ahead logs, snapshots,
  * vylogs.
@@ -203,6 +243,45 @@ const char *
 xdir_format_filename(struct xdir *dir, int64_t signature,
 		     enum log_suffix suffix);
 
+/**
+ * Return a file name of a shard of a sharded snapshot.
+ * Shard 0 is the snapshot file itself, i.e. the one named
+ * by xdir_format_filename(), other shards are named
+ * <signature>.<shard><filename_ext> and are ignored by
+ * xdir_scan().
+ */
+const char *
+xdir_format_shard_filename(struct xdir *dir, int64_t signature,
+			   uint32_t shard, enum log_suffix suffix);
+
+/**
+ * Return a file name of a spare file, see xdir_create_spare().
+ * Spare files are named <id><filename_ext>.spare and are
+ * ignored by xdir_scan().
+ */
+const char *
+xdir_format_spare_filename(struct xdir *dir, uint64_t id);
+
+/**
+ * Create a spare file to be turned into a new xlog later with
+ * xdir_create_xlog_from_spare() and allocate @size bytes of
+ * disk space for it. The file and the directory are synced,
+ * so that a file created from it doesn't need any metadata
+ * updates until it grows beyond @size. Blocking, meant to be
+ * called from a coio thread.
+ *
+ * @retval 0 if OK
+ * @retval -1 if error, diag is set
+ */
+int
+xdir_create_spare(struct xdir *dir, uint64_t id, size_t size);
+
+/**
+ * Remove spare files left in the specified directory.
+ */
+void
+xdir_collect_spares(struct xdir *dir);
+
 /**
  * Return true if the given directory index has files whose
  * signature is less than specified.
@@ -235,6 +314,9 @@ enum {
 /**
  * Remove files whose signature is less than specified.
  * For possible values of @flags see XDIR_GC_*.
+ *
+ * Shards of sharded snapshots are removed along with
+ * the snapshot files they belong to.
  */
 void
 xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags);
@@ -311,6 +393,12 @@ struct xlog_meta {
 	 * directory for missing WALs.
 	 */
 	struct vclock prev_vclock;
+	/**
+	 * Text file header: the number of files a sharded
+	 * snapshot consists of or 0 if the snapshot isn't
+	 * sharded. @sa xdir_create_xlog_shard().
+	 */
+	uint32_t shard_count;
 };
 
 /**
@@ -426,6 +514,39 @@ int
 xdir_create_xlog(struct xdir *dir, struct xlog *xlog,
 		 const struct vclock *vclock);
 
+/**
+ * Same as xdir_create_xlog(), but instead of creating a new
+ * file, take over the spare file @spare_id created with
+ * xdir_create_spare(). The disk space allocated for the spare
+ * file is accounted in xlog::allocated.
+ *
+ * @retval 0 if OK
+ * @retval -1 if error
+ */
+int
+xdir_create_xlog_from_spare(struct xdir *dir, struct xlog *xlog,
+			    const struct vclock *vclock, uint64_t spare_id);
+
+/**
+ * Create a file for one shard of a sharded snapshot.
+ * All shards share the same vclock and store the total
+ * number of shards in the header so that recovery can
+ * check that the set is complete.
+ *
+ * @param xdir xdir, must be of SNAP type
+ * @param[out] xlog xlog structure
+ * @param vclock        vclock of the snapshot
+ * @param shard         shard number, 0 for the main file
+ * @param shard_count   total number of shards
+ *
+ * @retval 0 if OK
+ * @retval -1 if error
+ */
+int
+xdir_create_xlog_shard(struct xdir *dir, struct xlog *xlog,
+		       const struct vclock *vclock,
+		       uint32_t shard, uint32_t shard_count);
+
 /**
  * Create new xlog writer based on fd.
  * @param fd            file descriptor
@@ -658,7 +779,10 @@ struct xlog_cursor
 	int fd;
 	/** associated file name */
 	char name[PATH_MAX];
-	/** file read buffer */
+	/**
+	 * file read buffer; for a mapped file, spans the mapping
+	 * and owns no memory
+	 */
 	struct ibuf rbuf;
 	/** file read position */
 	off_t read_offset;
@@ -666,6 +790,20 @@ struct xlog_cursor
 	struct xlog_tx_cursor tx_cursor;
 	/** ZSTD context for decompression */
 	ZSTD_DStream *zdctx;
+	/**
+	 * The file mapped into memory or NULL. A finished file,
+	 * i.e. one ending with the eof marker, is never written
+	 * to again, so it is read through a mapping instead of
+	 * the read buffer, and uncompressed rows are decoded
+	 * right from the mapping.
+	 */
+	char *map;
+	/** Size of the mapping. */
+	size_t map_size;
+	/** The mapping is advised to be read ahead up to here. */
+	size_t map_readahead;
+	/** Pages of the mapping before this offset are dropped. */
+	size_t map_dropped;
 };
 
 /**
@@ -813,6 +951,24 @@ int
 xdir_open_cursor(struct xdir *dir, int64_t signature,
 		 struct xlog_cursor *cursor);
 
+/**
+ * Read the number of shards from the meta of a snapshot file,
+ * 0 if the snapshot isn't sharded.
+ * @retval 0 success
+ * @retval -1 error, check diag
+ */
+int
+xdir_read_shard_count(const char *filename, uint32_t *shard_count);
+
+/**
+ * Open cursor for a shard of a sharded snapshot, shard 0
+ * being the snapshot file itself.
+ * @sa xdir_open_cursor(), xdir_format_shard_filename()
+ */
+int
+xdir_open_shard_cursor(struct xdir *dir, int64_t signature, uint32_t shard,
+		       struct xlog_cursor *cursor);
+
 /** }}} */
 
 #if defined(__cplusplus)
@@ -436,6 +436,54 @@ iproto_reply_vclock(struct obuf *out, const struct vclock *vclock,
 	return 0;
 }
 
+int
+iproto_reply_cursor(struct obuf *out, uint64_t cursor_id,
+		    uint64_t sync, uint32_t schema_version)
+{
+	size_t max_size = IPROTO_HEADER_LEN + mp_sizeof_map(1) +
+		mp_sizeof_uint(IPROTO_CURSOR_ID) + mp_sizeof_uint(cursor_id);
+
+	char *buf = obuf_alloc(out, max_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, max_size, "obuf_alloc", "buf");
+		return -1;
+	}
+
+	char *data = buf + IPROTO_HEADER_LEN;
+	data = mp_encode_map(data, 1);
+	data = mp_encode_uint(data, IPROTO_CURSOR_ID);
+	data = mp_encode_uint(data, cursor_id);
+	assert((size_t)(data - buf) == max_size);
+
+	iproto_header_encode(buf, IPROTO_OK, sync, schema_version,
+			     max_size - IPROTO_HEADER_LEN);
+	return 0;
+}
+
+int
+iproto_reply_prepare(struct obuf *out, uint32_t stmt_id,
+		     uint64_t sync, uint32_t schema_version)
+{
+	size_t max_size = IPROTO_HEADER_LEN + mp_sizeof_map(1) +
+		mp_sizeof_uint(IPROTO_STMT_ID) + mp_sizeof_uint(stmt_id);
+
+	char *buf = obuf_alloc(out, max_size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, max_size, "obuf_alloc", "buf");
+		return -1;
+	}
+
+	char *data = buf + IPROTO_HEADER_LEN;
+	data = mp_encode_map(data, 1);
+	data = mp_encode_uint(data, IPROTO_STMT_ID);
+	data = mp_encode_uint(data, stmt_id);
+	assert((size_t)(data - buf) == max_size);
+
+	iproto_header_encode(buf, IPROTO_OK, sync, schema_version,
+			     max_size - IPROTO_HEADER_LEN);
+	return 0;
+}
+
 int
 iproto_reply_vote(struct obuf *out, const struct ballot *ballot,
 		  uint64_t sync, uint32_t schema_version)
@@ -573,9 +621,11 @@ error:
 	uint32_t map_size = mp_decode_map(&data);
 	request->sql_text = NULL;
 	request->bind = NULL;
+	bool has_stmt_id = false;
 	for (uint32_t i = 0; i < map_size; ++i) {
 		uint8_t key = *data;
-		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT) {
+		if (key != IPROTO_SQL_BIND && key != IPROTO_SQL_TEXT &&
+		    key != IPROTO_STMT_ID) {
 			mp_check(&data, end);   /* skip the key */
 			mp_check(&data, end);   /* skip the value */
 			continue;
@@ -583,12 +633,22 @@ error:
 		const char *value = ++data;     /* skip the key */
 		if (mp_check(&data, end) != 0)  /* check the value */
 			goto error;
-		if (key == IPROTO_SQL_BIND)
+		if (key == IPROTO_SQL_BIND) {
 			request->bind = value;
-		else
+		} else if (key == IPROTO_SQL_TEXT) {
 			request->sql_text = value;
+		} else {
+			if (mp_typeof(*value) != MP_UINT)
+				goto error;
+			uint64_t stmt_id = mp_decode_uint(&value);
+			if (stmt_id > UINT32_MAX)
+				goto error;
+			request->stmt_id = stmt_id;
+			has_stmt_id = true;
+		}
 	}
-	if (request->sql_text == NULL) {
+	if (request->sql_text == NULL &&
+	    (!has_stmt_id || row->type == IPROTO_PREPARE)) {
 		xrow_on_decode_err(row->body[0].iov_base, end, ER_MISSING_REQUEST_FIELD,
 			 iproto_key_name(IPROTO_SQL_TEXT));
 		return -1;
@@ -598,6 +658,59 @@ error:
 	return 0;
 }
 
+int
+xrow_decode_cursor(const struct xrow_header *row,
+		   struct cursor_request *request)
+{
+	if (row->bodycnt == 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "missing request body");
+		return -1;
+	}
+	assert(row->bodycnt == 1);
+	const char *data = (const char *) row->body[0].iov_base;
+	const char *end = data + row->body[0].iov_len;
+	assert((end - data) > 0);
+
+	if (mp_typeof(*data) != MP_MAP || mp_check_map(data, end) > 0) {
+error:
+		xrow_on_decode_err(row->body[0].iov_base, end, ER_INVALID_MSGPACK,
+				   "packet body");
+		return -1;
+	}
+
+	uint32_t map_size = mp_decode_map(&data);
+	bool has_cursor_id = false;
+	request->cursor_id = 0;
+	request->limit = UINT32_MAX;
+	for (uint32_t i = 0; i < map_size; ++i) {
+		if (mp_typeof(*data) != MP_UINT)
+			goto error;
+		uint64_t key = mp_decode_uint(&data);
+		const char *value = data;
+		if (mp_check(&data, end) != 0)
+			goto error;
+		if (key != IPROTO_CURSOR_ID && key != IPROTO_LIMIT)
+			continue;
+		if (mp_typeof(*value) != MP_UINT)
+			goto error;
+		if (key == IPROTO_CURSOR_ID) {
+			request->cursor_id = mp_decode_uint(&value);
+			has_cursor_id = true;
+		} else {
+			request->limit = mp_decode_uint(&value);
+		}
+	}
+	if (data != end)
+		goto error;
+	if (!has_cursor_id) {
+		xrow_on_decode_err(row->body[0].iov_base, end,
+				   ER_MISSING_REQUEST_FIELD,
+				   iproto_key_name(IPROTO_CURSOR_ID));
+		return -1;
+	}
+	return 0;
+}
+
 void
 iproto_reply_sql(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		 uint32_t schema_version)
@@ -1141,7 +1254,7 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock)
+		      const struct vclock *vclock, bool compression)
 {
 	memset(row, 0, sizeof(*row));
 	size_t size = XROW_BODY_LEN_MAX + mp_sizeof_vclock(vclock);
@@ -1151,7 +1264,7 @@ xrow_encode_subscribe(struct xrow_header *row,
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 4);
+	data = mp_encode_map(data, compression ? 5 : 4);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -1160,6 +1273,11 @@ xrow_encode_subscribe(struct xrow_header *row,
 	data = mp_encode_vclock(data, vclock);
 	data = mp_encode_uint(data, IPROTO_SERVER_VERSION);
 	data = mp_encode_uint(data, tarantool_version_id());
+	if (compression) {
+		/* Older masters ignore the key. */
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_bool(data, true);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1171,7 +1289,8 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id)
+		      uint32_t *version_id, bool *compression,
+		      uint32_t *shard_count)
 {
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
@@ -1234,6 +1353,26 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 			}
 			*version_id = mp_decode_uint(&d);
 			break;
+		case IPROTO_COMPRESSION:
+			if (compression == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_BOOL) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid COMPRESSION");
+				return -1;
+			}
+			*compression = mp_decode_bool(&d);
+			break;
+		case IPROTO_SHARD_COUNT:
+			if (shard_count == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_UINT) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid SHARD_COUNT");
+				return -1;
+			}
+			*shard_count = mp_decode_uint(&d);
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
@@ -1242,7 +1381,8 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 }
 
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 uint32_t connection_count)
 {
 	memset(row, 0, sizeof(*row));
 
@@ -1253,10 +1393,15 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 1);
+	data = mp_encode_map(data, connection_count > 0 ? 2 : 1);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
 	/* Greet the remote replica with our replica UUID */
 	data = xrow_encode_uuid(data, instance_uuid);
+	if (connection_count > 0) {
+		/* Older masters ignore the key. */
+		data = mp_encode_uint(data, IPROTO_SHARD_COUNT);
+		data = mp_encode_uint(data, connection_count);
+	}
 	assert(data <= buf + size);
 
 	row->body[0].iov_base = buf;
@@ -1290,6 +1435,134 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 	return 0;
 }
 
+int
+xrow_encode_join_response(struct xrow_header *row,
+			  const struct vclock *vclock, uint32_t shard_count)
+{
+	memset(row, 0, sizeof(*row));
+	size_t size = mp_sizeof_map(2) +
+		      mp_sizeof_uint(IPROTO_VCLOCK) + mp_sizeof_vclock(vclock) +
+		      mp_sizeof_uint(IPROTO_SHARD_COUNT) +
+		      mp_sizeof_uint(shard_count);
+	char *buf = (char *) region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, shard_count > 0 ? 2 : 1);
+	data = mp_encode_uint(data, IPROTO_VCLOCK);
+	data = mp_encode_vclock(data, vclock);
+	if (shard_count > 0) {
+		data = mp_encode_uint(data, IPROTO_SHARD_COUNT);
+		data = mp_encode_uint(data, shard_count);
+	}
+	assert(data <= buf + size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	row->type = IPROTO_OK;
+	return 0;
+}
+
+int
+xrow_encode_fetch_snapshot(struct xrow_header *row,
+			   const struct vclock *vclock, uint32_t shard,
+			   uint64_t offset)
+{
+	memset(row, 0, sizeof(*row));
+	size_t size = mp_sizeof_map(3) +
+		      mp_sizeof_uint(IPROTO_VCLOCK) + mp_sizeof_vclock(vclock) +
+		      mp_sizeof_uint(IPROTO_SHARD) + mp_sizeof_uint(shard) +
+		      mp_sizeof_uint(IPROTO_OFFSET) + mp_sizeof_uint(offset);
+	char *buf = (char *) region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, 3);
+	data = mp_encode_uint(data, IPROTO_VCLOCK);
+	data = mp_encode_vclock(data, vclock);
+	data = mp_encode_uint(data, IPROTO_SHARD);
+	data = mp_encode_uint(data, shard);
+	data = mp_encode_uint(data, IPROTO_OFFSET);
+	data = mp_encode_uint(data, offset);
+	assert(data <= buf + size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	row->type = IPROTO_FETCH_SNAPSHOT;
+	return 0;
+}
+
+int
+xrow_decode_fetch_snapshot(struct xrow_header *row, struct vclock *vclock,
+			   uint32_t *shard, uint64_t *offset)
+{
+	if (row->bodycnt == 0) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
+		return -1;
+	}
+	assert(row->bodycnt == 1);
+	const char * const data = (const char *) row->body[0].iov_base;
+	const char *end = data + row->body[0].iov_len;
+	const char *d = data;
+	if (mp_check(&d, end) != 0 || mp_typeof(*data) != MP_MAP) {
+		xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+				   "request body");
+		return -1;
+	}
+
+	bool has_vclock = false;
+	*shard = 0;
+	*offset = 0;
+	d = data;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT) {
+			mp_next(&d); /* key */
+			mp_next(&d); /* value */
+			continue;
+		}
+		uint64_t key = mp_decode_uint(&d);
+		switch (key) {
+		case IPROTO_VCLOCK:
+			if (mp_decode_vclock(&d, vclock) != 0) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid VCLOCK");
+				return -1;
+			}
+			has_vclock = true;
+			break;
+		case IPROTO_SHARD:
+			if (mp_typeof(*d) != MP_UINT) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid SHARD");
+				return -1;
+			}
+			*shard = mp_decode_uint(&d);
+			break;
+		case IPROTO_OFFSET:
+			if (mp_typeof(*d) != MP_UINT) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid OFFSET");
+				return -1;
+			}
+			*offset = mp_decode_uint(&d);
+			break;
+		default:
+			mp_next(&d); /* value */
+		}
+	}
+	if (!has_vclock) {
+		xrow_on_decode_err(data, end, ER_MISSING_REQUEST_FIELD,
+				   iproto_key_name(IPROTO_VCLOCK));
+		return -1;
+	}
+	return 0;
+}
+
 int
 xrow_encode_subscribe_response(struct xrow_header *row,
 			       const struct tt_uuid *replicaset_uuid,
@@ -297,6 +297,7 @@ xrow_encode_vote(struct xrow_header *row);
  * @param replicaset_uuid Replica set uuid.
  * @param instance_uuid Instance uuid.
  * @param vclock Replication clock.
+ * @param compression Ask for a compressed stream of rows.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -305,7 +306,7 @@ int
 xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
-		      const struct vclock *vclock);
+		      const struct vclock *vclock, bool compression);
 
 /**
  * Decode SUBSCRIBE command.
@@ -314,6 +315,8 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] instance_uuid.
  * @param[out] vclock.
  * @param[out] version_id.
+ * @param[out] compression.
+ * @param[out] shard_count.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -321,33 +324,101 @@ xrow_encode_subscribe(struct xrow_header *row,
 int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
-		      uint32_t *version_id);
+		      uint32_t *version_id, bool *compression,
+		      uint32_t *shard_count);
 
 /**
  * Encode JOIN command.
  * @param[out] row Row to encode into.
  * @param instance_uuid.
+ * @param connection_count Number of connections used to fetch
+ *        the snapshot with IPROTO_FETCH_SNAPSHOT or 0 to get it
+ *        in the initial data stream.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
  */
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid);
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 uint32_t connection_count);
 
 /**
  * Decode JOIN command.
  * @param row Row to decode.
  * @param[out] instance_uuid.
+ * @param[out] connection_count.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
  */
 static inline int
-xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 uint32_t *connection_count)
 {
-	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL,
+				     NULL, connection_count);
 }
 
+/**
+ * Encode a response to JOIN command.
+ * @param row[out] Row to encode into.
+ * @param vclock Vclock of the checkpoint sent to the replica.
+ * @param shard_count Number of shards of the snapshot or 0 if
+ *        the replica hasn't asked to fetch it.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_join_response(struct xrow_header *row,
+			  const struct vclock *vclock, uint32_t shard_count);
+
+/**
+ * Decode a response to JOIN command.
+ * @param row Row to decode.
+ * @param[out] vclock.
+ * @param[out] shard_count.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+static inline int
+xrow_decode_join_response(struct xrow_header *row, struct vclock *vclock,
+			  uint32_t *shard_count)
+{
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL,
+				     shard_count);
+}
+
+/**
+ * Encode FETCH_SNAPSHOT command.
+ * @param[out] row Row to encode into.
+ * @param vclock Vclock of the checkpoint.
+ * @param shard Snapshot shard.
+ * @param offset Number of rows of the shard to skip.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_fetch_snapshot(struct xrow_header *row,
+			   const struct vclock *vclock, uint32_t shard,
+			   uint64_t offset);
+
+/**
+ * Decode FETCH_SNAPSHOT command.
+ * @param row Row to decode.
+ * @param[out] vclock.
+ * @param[out] shard.
+ * @param[out] offset.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+int
+xrow_decode_fetch_snapshot(struct xrow_header *row, struct vclock *vclock,
+			   uint32_t *shard, uint64_t *offset);
+
 /**
  * Encode end of stream command (a response to JOIN command).
  * @param row[out] Row to encode into.
@@ -370,7 +441,8 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 static inline int
 xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL,
+				     NULL);
 }
 
 /**
@@ -401,7 +473,8 @@ xrow_decode_subscribe_response(struct xrow_header *row,
 			       struct tt_uuid *replicaset_uuid,
 			       struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL);
+	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL,
+				     NULL, NULL);
 }
 
 /**
@@ -494,6 +567,34 @@ int
 iproto_reply_vclock(struct obuf *out, const struct vclock *vclock,
 		    uint64_t sync, uint32_t schema_version);
 
+/**
+ * Encode a reply to IPROTO_PREPARE.
+ * @param out Encode to.
+ * @param stmt_id Id of the prepared statement.
+ * @param sync Request sync.
+ * @param schema_version.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+iproto_reply_prepare(struct obuf *out, uint32_t stmt_id,
+		     uint64_t sync, uint32_t schema_version);
+
+/**
+ * Encode a reply to IPROTO_CURSOR_OPEN.
+ * @param out Encode to.
+ * @param cursor_id Id of the opened cursor.
+ * @param sync Request sync.
+ * @param schema_version.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+iproto_reply_cursor(struct obuf *out, uint64_t cursor_id,
+		    uint64_t sync, uint32_t schema_version);
+
 /**
  * Encode a reply to an IPROTO_VOTE request.
  * @param out Buffer to write to.
@@ -516,16 +617,21 @@ int
 iproto_reply_error(struct obuf *out, const struct error *e, uint64_t sync,
 		   uint32_t schema_version);
 
-/** EXECUTE request. */
+/** EXECUTE and PREPARE requests. */
 struct sql_request {
-	/** SQL statement text. */
+	/**
+	 * SQL statement text, NULL if EXECUTE runs a prepared
+	 * statement.
+	 */
 	const char *sql_text;
+	/** Id of the prepared statement if there is no text. */
+	uint32_t stmt_id;
 	/** MessagePack array of parameters. */
 	const char *bind;
 };
 
 /**
- * Parse the EXECUTE request.
+ * Parse the EXECUTE or PREPARE request.
  * @param row Encoded data.
  * @param[out] request Request to decode to.
  *
@@ -535,6 +641,26 @@ struct sql_request {
 int
 xrow_decode_sql(const struct xrow_header *row, struct sql_request *request);
 
+/** CURSOR_FETCH and CURSOR_CLOSE requests. */
+struct cursor_request {
+	/** Id of the cursor. */
+	uint64_t cursor_id;
+	/** Max number of tuples to fetch, UINT32_MAX if not set. */
+	uint32_t limit;
+};
+
+/**
+ * Parse the CURSOR_FETCH or CURSOR_CLOSE request.
+ * @param row Encoded data.
+ * @param[out] request Request to decode to.
+ *
+ * @retval  0 Sucess.
+ * @retval -1 Format error.
+ */
+int
+xrow_decode_cursor(const struct xrow_header *row,
+		   struct cursor_request *request);
+
 /**
  * Write the SQL header.
  * @param buf Out buffer.
@@ -763,10 +889,10 @@ static inline void
 xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
-			 const struct vclock *vclock)
+			 const struct vclock *vclock, bool compression)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock) != 0)
+				  vclock, compression) != 0)
 		diag_raise();
 }
 
@@ -775,27 +901,67 @@ static inline void
 xrow_decode_subscribe_xc(struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 		         struct tt_uuid *instance_uuid, struct vclock *vclock,
-			 uint32_t *replica_version_id)
+			 uint32_t *replica_version_id, bool *compression)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, replica_version_id) != 0)
+				  vclock, replica_version_id,
+				  compression, NULL) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_encode_join. */
 static inline void
 xrow_encode_join_xc(struct xrow_header *row,
-		    const struct tt_uuid *instance_uuid)
+		    const struct tt_uuid *instance_uuid,
+		    uint32_t connection_count)
 {
-	if (xrow_encode_join(row, instance_uuid) != 0)
+	if (xrow_encode_join(row, instance_uuid, connection_count) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_decode_join. */
 static inline void
-xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		    uint32_t *connection_count)
+{
+	if (xrow_decode_join(row, instance_uuid, connection_count) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_join_response. */
+static inline void
+xrow_encode_join_response_xc(struct xrow_header *row,
+			     const struct vclock *vclock, uint32_t shard_count)
+{
+	if (xrow_encode_join_response(row, vclock, shard_count) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_join_response. */
+static inline void
+xrow_decode_join_response_xc(struct xrow_header *row, struct vclock *vclock,
+			     uint32_t *shard_count)
+{
+	if (xrow_decode_join_response(row, vclock, shard_count) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_fetch_snapshot. */
+static inline void
+xrow_encode_fetch_snapshot_xc(struct xrow_header *row,
+			      const struct vclock *vclock, uint32_t shard,
+			      uint64_t offset)
+{
+	if (xrow_encode_fetch_snapshot(row, vclock, shard, offset) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_fetch_snapshot. */
+static inline void
+xrow_decode_fetch_snapshot_xc(struct xrow_header *row, struct vclock *vclock,
+			      uint32_t *shard, uint64_t *offset)
 {
-	if (xrow_decode_join(row, instance_uuid) != 0)
+	if (xrow_decode_fetch_snapshot(row, vclock, shard, offset) != 0)
 		diag_raise();
 }
 
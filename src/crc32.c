@@ -48,3 +48,72 @@ crc32_init()
 	crc32_calc = &crc32c;
 #endif
 }
+
+enum {
+	/** crc32c (Castagnoli) polynomial, reversed. */
+	CRC32C_POLY = 0x82F63B78,
+};
+
+static uint32_t
+gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+{
+	uint32_t sum = 0;
+	while (vec != 0) {
+		if (vec & 1)
+			sum ^= *mat;
+		vec >>= 1;
+		mat++;
+	}
+	return sum;
+}
+
+static void
+gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+{
+	for (int n = 0; n < 32; n++)
+		square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+uint32_t
+crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2)
+{
+	/*
+	 * crc32_calc() doesn't invert the register, so the crc
+	 * of a concatenation is the crc of the first buffer
+	 * shifted by @len2 zero bytes xor the crc of the second
+	 * one. The shift is done by applying a GF(2) matrix
+	 * operator for 2^n zero bits, squared on each step,
+	 * like zlib does.
+	 */
+	uint32_t even[32];
+	uint32_t odd[32];
+	if (len2 == 0)
+		return crc1 ^ crc2;
+
+	/* The operator for one zero bit. */
+	odd[0] = CRC32C_POLY;
+	uint32_t row = 1;
+	for (int n = 1; n < 32; n++) {
+		odd[n] = row;
+		row <<= 1;
+	}
+	/* The operator for two zero bits. */
+	gf2_matrix_square(even, odd);
+	/* The operator for four zero bits. */
+	gf2_matrix_square(odd, even);
+
+	/* Apply @len2 zero bytes to @crc1. */
+	do {
+		gf2_matrix_square(even, odd);
+		if (len2 & 1)
+			crc1 = gf2_matrix_times(even, crc1);
+		len2 >>= 1;
+		if (len2 == 0)
+			break;
+		gf2_matrix_square(odd, even);
+		if (len2 & 1)
+			crc1 = gf2_matrix_times(odd, crc1);
+		len2 >>= 1;
+	} while (len2 != 0);
+	return crc1 ^ crc2;
+}
@@ -47,6 +47,14 @@ extern crc32_func crc32_calc;
 
 void crc32_init();
 
+/**
+ * Given crc32c of two buffers @a and @b, the latter @len2 bytes
+ * long, return crc32c of their concatenation, i.e. the value
+ * crc32_calc(crc32_calc(0, a, len1), b, len2) would return.
+ */
+uint32_t
+crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
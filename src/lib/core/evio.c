@@ -392,6 +392,26 @@ evio_service_bind(struct evio_service *service, const char *uri)
 	return -1;
 }
 
+void
+evio_service_attach(struct evio_service *dst, const struct evio_service *src)
+{
+	assert(! ev_is_active(&dst->ev));
+	strcpy(dst->host, src->host);
+	strcpy(dst->serv, src->serv);
+	dst->addrstorage = src->addrstorage;
+	dst->addr_len = src->addr_len;
+	ev_io_set(&dst->ev, src->ev.fd, EV_READ);
+	ev_io_start(dst->loop, &dst->ev);
+}
+
+void
+evio_service_detach(struct evio_service *service)
+{
+	if (ev_is_active(&service->ev))
+		ev_io_stop(service->loop, &service->ev);
+	ev_io_set(&service->ev, -1, 0);
+}
+
 /** It's safe to stop a service which is not started yet. */
 void
 evio_service_stop(struct evio_service *service)
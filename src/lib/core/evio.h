@@ -121,6 +121,19 @@ evio_service_listen(struct evio_service *service);
 void
 evio_service_stop(struct evio_service *service);
 
+/**
+ * Start accepting connections on the socket of a listening
+ * service in the loop of another service. Several services
+ * attached to the same socket share the incoming connections.
+ * The source service must outlive the attached one.
+ */
+void
+evio_service_attach(struct evio_service *dst, const struct evio_service *src);
+
+/** Stop accepting connections, but don't close the socket. */
+void
+evio_service_detach(struct evio_service *service);
+
 int
 evio_socket(struct ev_io *coio, int domain, int type, int protocol);
 
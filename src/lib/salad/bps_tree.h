@@ -158,6 +158,12 @@
  * struct bps_tree_iterator bps_tree_lower_bound_elem(tree, elem, exact);
  * struct bps_tree_iterator bps_tree_upper_bound_elem(tree, elem, exact);
  * size_t bps_tree_approxiamte_count(tree, key);
+ * // only if BPS_INNER_CARD is defined:
+ * struct bps_tree_iterator bps_tree_iterator_at(tree, offset);
+ * struct bps_tree_iterator bps_tree_lower_bound_get_offset(tree, key, exact,
+ *							     offset);
+ * struct bps_tree_iterator bps_tree_upper_bound_get_offset(tree, key, exact,
+ *							     offset);
  * bps_tree_elem_t *bps_tree_iterator_get_elem(tree, itr);
  * bool bps_tree_iterator_next(tree, itr);
  * bool bps_tree_iterator_prev(tree, itr);
@@ -274,6 +280,22 @@
 #error "BPS_TREE_COMPARE_KEY must be defined"
 #endif
 
+/**
+ * Optional function to compare an element with a key when
+ * a tree view is searched, see struct bps_tree_view. It gets
+ * the argument the view was created with. May be defined if
+ * BPS_TREE_COMPARE_KEY uses data that is owned by the thread
+ * modifying the tree, while views are read by other threads.
+ * BPS_TREE_COMPARE_KEY is used if not defined.
+ */
+#ifdef BPS_TREE_VIEW_COMPARE_KEY
+#define bps_tree_view_compare_key(a, b, arg) \
+	BPS_TREE_VIEW_COMPARE_KEY(a, b, arg)
+#else
+#define bps_tree_view_compare_key(a, b, arg) \
+	BPS_TREE_COMPARE_KEY(a, b, arg)
+#endif
+
 /**
  * Test if bps_tree_elem_t a and b represent exactly the
  * same data.
@@ -291,6 +313,17 @@
  * #define BPS_BLOCK_LINEAR_SEARCH
  */
 
+/**
+ * A switch that makes every inner block store the number of
+ * elements (cardinality) of each of its child subtrees. It costs
+ * a bit of memory in inner blocks and a bit of work on each
+ * modification, but allows to find the position of an element
+ * and an element by its position in logarithmic time, and thus
+ * to count elements in any range without iteration.
+ * To turn it on,
+ * #define BPS_INNER_CARD
+ */
+
 /**
  * A switch that enables collection of executions of different
  * branches of code. Used only for debug purposes, I hope you
@@ -303,6 +336,7 @@
 /* {{{ BPS-tree internal settings */
 typedef int16_t bps_tree_pos_t;
 typedef uint32_t bps_tree_block_id_t;
+typedef uint64_t bps_tree_block_card_t;
 /* }}} */
 
 /* {{{ Compile time utils */
@@ -350,6 +384,7 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_inner _bps(inner)
 #define bps_garbage _bps(garbage)
 #define bps_tree_iterator _api_name(iterator)
+#define bps_tree_view _api_name(view)
 #define bps_inner_path_elem _bps(inner_path_elem)
 #define bps_leaf_path_elem _bps(leaf_path_elem)
 
@@ -357,6 +392,7 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_build _api_name(build)
 #define bps_tree_destroy _api_name(destroy)
 #define bps_tree_find _api_name(find)
+#define bps_tree_find_batch _api_name(find_batch)
 #define bps_tree_insert _api_name(insert)
 #define bps_tree_insert_get_iterator _api_name(insert_get_iterator)
 #define bps_tree_delete _api_name(delete)
@@ -374,11 +410,20 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_lower_bound_elem _api_name(lower_bound_elem)
 #define bps_tree_upper_bound_elem _api_name(upper_bound_elem)
 #define bps_tree_approximate_count _api_name(approximate_count)
+#define bps_tree_iterator_at _api_name(iterator_at)
+#define bps_tree_lower_bound_get_offset _api_name(lower_bound_get_offset)
+#define bps_tree_upper_bound_get_offset _api_name(upper_bound_get_offset)
 #define bps_tree_iterator_get_elem _api_name(iterator_get_elem)
 #define bps_tree_iterator_next _api_name(iterator_next)
 #define bps_tree_iterator_prev _api_name(iterator_prev)
 #define bps_tree_iterator_freeze _api_name(iterator_freeze)
 #define bps_tree_iterator_destroy _api_name(iterator_destroy)
+#define bps_tree_view_create _api_name(view_create)
+#define bps_tree_view_destroy _api_name(view_destroy)
+#define bps_tree_view_first _api_name(view_first)
+#define bps_tree_view_last _api_name(view_last)
+#define bps_tree_view_lower_bound _api_name(view_lower_bound)
+#define bps_tree_view_upper_bound _api_name(view_upper_bound)
 #define bps_tree_debug_check _api_name(debug_check)
 #define bps_tree_print _api_name(print)
 #define bps_tree_debug_check_internal_functions \
@@ -397,9 +442,17 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_restore_block_ver _bps_tree(restore_block_ver)
 #define bps_tree_root _bps_tree(root)
 #define bps_tree_touch_block _bps_tree(touch_block)
+#define bps_tree_block_card _bps_tree(block_card)
+#define bps_tree_build_cards _bps_tree(build_cards)
+#define bps_tree_update_card_leaf _bps_tree(update_card_leaf)
+#define bps_tree_update_card_inner _bps_tree(update_card_inner)
+#define bps_tree_add_card_path _bps_tree(add_card_path)
+#define bps_tree_refresh_cards_inner _bps_tree(refresh_cards_inner)
 #define bps_tree_find_ins_point_key _bps_tree(find_ins_point_key)
 #define bps_tree_find_ins_point_elem _bps_tree(find_ins_point_elem)
 #define bps_tree_find_after_ins_point_key _bps_tree(find_after_ins_point_key)
+#define bps_tree_view_find_ins_point_key _bps_tree(view_find_ins_point_key)
+#define bps_tree_view_bound _bps_tree(view_bound)
 #define bps_tree_find_after_ins_point_elem _bps_tree(find_after_ins_point_elem)
 #define bps_tree_get_leaf_safe _bps_tree(get_leaf_safe)
 #define bps_tree_garbage_push _bps_tree(garbage_push)
@@ -552,6 +605,24 @@ struct bps_tree_iterator {
 	struct matras_view view;
 };
 
+/**
+ * Tree view. Keeps the state of a tree at the time it was
+ * created, like a frozen iterator does, but may also be searched.
+ * A view may be read by any thread, provided it is created and
+ * destroyed by the thread modifying the tree.
+ */
+struct bps_tree_view {
+	/* Version of matras memory the view refers to */
+	struct matras_view view;
+	/* Members of struct bps_tree at the time of creation */
+	bps_tree_block_id_t root_id;
+	bps_tree_block_id_t first_id, last_id;
+	bps_tree_block_id_t depth;
+	size_t size;
+	/* Argument for comparator, tree->arg unless changed */
+	bps_tree_arg_t arg;
+};
+
 /**
  * Pointer to function that allocates extent of size BPS_TREE_EXTENT_SIZE
  * BPS-tree properly handles with NULL result but could leak memory
@@ -608,6 +679,22 @@ bps_tree_destroy(struct bps_tree *tree);
 static inline bps_tree_elem_t *
 bps_tree_find(const struct bps_tree *tree, bps_tree_key_t key);
 
+/**
+ * @brief Find elements equal to a batch of keys. Lookups of different
+ *  keys descend the tree level by level together, and a block needed by
+ *  a lookup at the next level is prefetched while other lookups are
+ *  being processed, so that cache misses of different lookups overlap.
+ *  Sorted keys make the best use of it, as their paths share blocks.
+ * @param tree - pointer to a tree
+ * @param keys - array of keys that will be compared with elements
+ * @param count - number of keys
+ * @param results - array of @a count pointers that receive pointers to
+ *  the first equal elements or NULL for keys that aren't found
+ */
+static inline void
+bps_tree_find_batch(const struct bps_tree *tree, bps_tree_key_t *keys,
+		    size_t count, bps_tree_elem_t **results);
+
 /**
  * @brief Insert an element to the tree or replace an element in the tree
  * In case of replacing, if 'replaced' argument is not null,
@@ -789,6 +876,51 @@ bps_tree_upper_bound_elem(const struct bps_tree *tree, bps_tree_elem_t key,
 static inline size_t
 bps_tree_approximate_count(const struct bps_tree *tree, bps_tree_key_t key);
 
+#ifdef BPS_INNER_CARD
+
+/**
+ * @brief Get an iterator to the element at the given position
+ *  of the tree, i.e. to the element that has exactly @a offset
+ *  elements before it. Logarithmic complexity.
+ * @param tree - pointer to a tree
+ * @param offset - position of the element
+ * @return - Iterator. Invalid if offset is not less than tree size.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset);
+
+/**
+ * @brief Same as bps_tree_lower_bound, but also gives the position
+ *  of the found element in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_lower_bound
+ * @param[out] offset - number of elements that are less than key.
+ * @return - Lower-bound iterator. Invalid if all elements are less than key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
+/**
+ * @brief Same as bps_tree_upper_bound, but also gives the position
+ *  of the found element in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @param exact - see bps_tree_upper_bound
+ * @param[out] offset - number of elements that are less than or
+ *  equal to key.
+ * @return - Upper-bound iterator. Invalid if all elements are less or equal
+ *  than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset);
+
+#endif /* BPS_INNER_CARD */
+
 /**
  * @brief Get a pointer to the element pointed by iterator.
  *  If iterator is detected as broken, it is invalidated and NULL returned.
@@ -843,6 +975,74 @@ bps_tree_iterator_freeze(struct bps_tree *tree, struct bps_tree_iterator *itr);
 static inline void
 bps_tree_iterator_destroy(struct bps_tree *tree, struct bps_tree_iterator *itr);
 
+/**
+ * @brief Create a view of the current state of a tree. Following
+ * tree modifications are not seen through the view. The view
+ * should be destroyed with a bps_tree_view_destroy call.
+ * @param tree - pointer to a tree
+ * @param view - view to initialize
+ */
+static inline void
+bps_tree_view_create(struct bps_tree *tree, struct bps_tree_view *view);
+
+/**
+ * @brief Destroy a view created with bps_tree_view_create.
+ * Iterators positioned in the view become invalid.
+ * @param tree - pointer to a tree
+ * @param view - view to destroy
+ */
+static inline void
+bps_tree_view_destroy(struct bps_tree *tree, struct bps_tree_view *view);
+
+/**
+ * @brief Get an iterator to the first element of a view. The
+ * iterator is invalidated when it goes past the end of the view.
+ * @param tree - pointer to a tree
+ * @param view - tree view
+ * @return - First iterator. Invalid if the view is empty.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_first(const struct bps_tree *tree,
+		    const struct bps_tree_view *view);
+
+/**
+ * @brief Get an iterator to the last element of a view.
+ * @param tree - pointer to a tree
+ * @param view - tree view
+ * @return - Last iterator. Invalid if the view is empty.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_last(const struct bps_tree *tree,
+		   const struct bps_tree_view *view);
+
+/**
+ * @brief Get an iterator to the first element of a view that is
+ * greater than or equal to the key.
+ * @param tree - pointer to a tree
+ * @param view - tree view
+ * @param key - key that will be compared with elements
+ * @return - Lower-bound iterator. Invalid if all elements are less
+ *  than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_lower_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key);
+
+/**
+ * @brief Get an iterator to the first element of a view that is
+ * greater than the key.
+ * @param tree - pointer to a tree
+ * @param view - tree view
+ * @param key - key that will be compared with elements
+ * @return - Upper-bound iterator. Invalid if all elements are less
+ *  than or equal to the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_upper_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key);
+
 #ifndef BPS_TREE_NO_DEBUG
 
 /**
@@ -923,7 +1123,11 @@ enum bps_tree_max_sizes {
 		/ sizeof(bps_tree_elem_t),
 	BPS_TREE_MAX_COUNT_IN_INNER =
 		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block))
-		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)),
+		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)
+#ifdef BPS_INNER_CARD
+		   + sizeof(bps_tree_block_card_t)
+#endif
+		  ),
 	BPS_TREE_MAX_DEPTH = 16
 };
 
@@ -969,6 +1173,10 @@ struct bps_inner {
 	bps_tree_elem_t elems[BPS_TREE_MAX_COUNT_IN_INNER - 1];
 	/* Corresponding child IDs */
 	bps_tree_block_id_t child_ids[BPS_TREE_MAX_COUNT_IN_INNER];
+#ifdef BPS_INNER_CARD
+	/* Number of elements in corresponding child subtrees */
+	bps_tree_block_card_t child_cards[BPS_TREE_MAX_COUNT_IN_INNER];
+#endif
 };
 
 /**
@@ -1090,6 +1298,12 @@ bps_tree_create(struct bps_tree *tree, bps_tree_arg_t arg,
 #endif
 }
 
+#ifdef BPS_INNER_CARD
+static inline bps_tree_block_card_t
+bps_tree_build_cards(struct bps_tree *tree, bps_tree_block_id_t block_id,
+		     bps_tree_block_id_t level);
+#endif
+
 /**
  * @brief Fills a new (asserted) tree with values from sorted array.
  *  Elements are copied from the array. Array is not checked to be sorted!
@@ -1229,6 +1443,9 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 	} else {
 		tree->root_id = root_if_inner_id;
 	}
+#ifdef BPS_INNER_CARD
+	bps_tree_build_cards(tree, tree->root_id, depth - 1);
+#endif
 	return 0;
 }
 
@@ -1304,6 +1521,51 @@ bps_tree_touch_block(struct bps_tree *tree, bps_tree_block_id_t id)
 	return (struct bps_block *)matras_touch(&tree->matras, id);
 }
 
+#ifdef BPS_INNER_CARD
+
+/**
+ * @brief Fill child_cards of all inner blocks of a freshly built
+ *  subtree. Used only in bps_tree_build.
+ * @param level - height of the block, 0 for leaves.
+ * @return - number of elements in the subtree.
+ */
+static inline bps_tree_block_card_t
+bps_tree_build_cards(struct bps_tree *tree, bps_tree_block_id_t block_id,
+		     bps_tree_block_id_t level)
+{
+	struct bps_block *block = bps_tree_restore_block(tree, block_id);
+	if (level == 0)
+		return block->size;
+	struct bps_inner *inner = (struct bps_inner *)block;
+	bps_tree_block_card_t res = 0;
+	for (bps_tree_pos_t i = 0; i < inner->header.size; i++) {
+		inner->child_cards[i] =
+			bps_tree_build_cards(tree, inner->child_ids[i],
+					     level - 1);
+		res += inner->child_cards[i];
+	}
+	return res;
+}
+
+/**
+ * @brief Number of elements in the subtree of the given block.
+ *  For an inner block that's the sum of its child cards.
+ */
+static inline bps_tree_block_card_t
+bps_tree_block_card(const struct bps_tree *tree, bps_tree_block_id_t block_id)
+{
+	struct bps_block *block = bps_tree_restore_block(tree, block_id);
+	if (block->type == BPS_TREE_BT_LEAF)
+		return block->size;
+	struct bps_inner *inner = (struct bps_inner *)block;
+	bps_tree_block_card_t res = 0;
+	for (bps_tree_pos_t i = 0; i < inner->header.size; i++)
+		res += inner->child_cards[i];
+	return res;
+}
+
+#endif /* BPS_INNER_CARD */
+
 /**
  * @brief Get a random element in a tree.
  * @param tree - pointer to a tree
@@ -1957,6 +2219,151 @@ bps_tree_approximate_count(const struct bps_tree *tree, bps_tree_key_t key)
 	return result;
 }
 
+#ifdef BPS_INNER_CARD
+
+/**
+ * @brief Get an iterator to the element at the given position
+ *  of the tree. See declaration for details.
+ */
+static inline struct bps_tree_iterator
+bps_tree_iterator_at(const struct bps_tree *tree, size_t offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	if (offset >= tree->size) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos = 0;
+		while (offset >= inner->child_cards[pos]) {
+			offset -= inner->child_cards[pos];
+			pos++;
+			assert(pos < inner->header.size);
+		}
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+	assert(offset < (size_t)block->size);
+	res.block_id = block_id;
+	res.pos = offset;
+	return res;
+}
+
+/**
+ * @brief Same as bps_tree_lower_bound, but also counts elements
+ *  that are less than the key. See declaration for details.
+ */
+static inline struct bps_tree_iterator
+bps_tree_lower_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	*offset = 0;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	size_t skipped = 0;
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_ins_point_key(tree, inner->elems,
+						  inner->header.size - 1,
+						  key, exact);
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			skipped += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_ins_point_key(tree, leaf->elems, leaf->header.size,
+					  key, exact);
+	*offset = skipped + pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief Same as bps_tree_upper_bound, but also counts elements
+ *  that are less than or equal to the key. See declaration for details.
+ */
+static inline struct bps_tree_iterator
+bps_tree_upper_bound_get_offset(const struct bps_tree *tree,
+				bps_tree_key_t key, bool *exact,
+				size_t *offset)
+{
+	struct bps_tree_iterator res;
+	matras_head_read_view(&res.view);
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	*offset = 0;
+	bool exact_test;
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	size_t skipped = 0;
+	struct bps_block *block = bps_tree_root(tree);
+	bps_tree_block_id_t block_id = tree->root_id;
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_after_ins_point_key(tree, inner->elems,
+							inner->header.size - 1,
+							key, &exact_test);
+		if (exact_test)
+			*exact = true;
+		for (bps_tree_pos_t j = 0; j < pos; j++)
+			skipped += inner->child_cards[j];
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block(tree, block_id);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_after_ins_point_key(tree, leaf->elems,
+						leaf->header.size,
+						key, &exact_test);
+	if (exact_test)
+		*exact = true;
+	*offset = skipped + pos;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+#endif /* BPS_INNER_CARD */
+
 /**
  * @brief Get a pointer to the element pointed by iterator.
  *  If iterator is detected as broken, it is invalidated and NULL returned.
@@ -2063,6 +2470,154 @@ bps_tree_iterator_destroy(struct bps_tree *tree, struct bps_tree_iterator *itr)
 	matras_destroy_read_view(&tree->matras, &itr->view);
 }
 
+/**
+ * @brief Create a view of the current state of a tree.
+ * @param tree - pointer to a tree
+ * @param view - view to initialize
+ */
+static inline void
+bps_tree_view_create(struct bps_tree *tree, struct bps_tree_view *view)
+{
+	matras_create_read_view(&tree->matras, &view->view);
+	view->root_id = tree->root_id;
+	view->first_id = tree->first_id;
+	view->last_id = tree->last_id;
+	view->depth = tree->depth;
+	view->size = tree->size;
+	view->arg = tree->arg;
+}
+
+/**
+ * @brief Destroy a view created with bps_tree_view_create.
+ * @param tree - pointer to a tree
+ * @param view - view to destroy
+ */
+static inline void
+bps_tree_view_destroy(struct bps_tree *tree, struct bps_tree_view *view)
+{
+	matras_destroy_read_view(&tree->matras, &view->view);
+}
+
+/**
+ * @brief Get an iterator to the first element of a view.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_first(const struct bps_tree *tree,
+		    const struct bps_tree_view *view)
+{
+	(void)tree;
+	struct bps_tree_iterator itr;
+	itr.block_id = view->first_id;
+	itr.pos = 0;
+	itr.view = view->view;
+	return itr;
+}
+
+/**
+ * @brief Get an iterator to the last element of a view.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_last(const struct bps_tree *tree,
+		   const struct bps_tree_view *view)
+{
+	(void)tree;
+	struct bps_tree_iterator itr;
+	itr.block_id = view->last_id;
+	itr.pos = (bps_tree_pos_t)(-1);
+	itr.view = view->view;
+	return itr;
+}
+
+/**
+ * @brief Find the lowest element in sorted array of a view that
+ * is greater than or equal to (greater than if @upper is set)
+ * the key.
+ */
+static inline bps_tree_pos_t
+bps_tree_view_find_ins_point_key(const struct bps_tree_view *view,
+				 bps_tree_elem_t *arr, size_t size,
+				 bps_tree_key_t key, bool upper)
+{
+	bps_tree_elem_t *begin = arr;
+	bps_tree_elem_t *end = arr + size;
+	while (begin != end) {
+		bps_tree_elem_t *mid = begin + (end - begin) / 2;
+		int res = bps_tree_view_compare_key(*mid, key, view->arg);
+		if (res > 0 || (res == 0 && !upper))
+			end = mid;
+		else
+			begin = mid + 1;
+	}
+	return (bps_tree_pos_t)(end - arr);
+}
+
+/**
+ * @brief Common part of bps_tree_view_lower_bound and
+ * bps_tree_view_upper_bound.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_bound(const struct bps_tree *tree,
+		    const struct bps_tree_view *view,
+		    bps_tree_key_t key, bool upper)
+{
+	struct bps_tree_iterator res;
+	res.view = view->view;
+	if (view->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	bps_tree_block_id_t block_id = view->root_id;
+	struct bps_block *block =
+		bps_tree_restore_block_ver(tree, block_id, &res.view);
+	for (bps_tree_block_id_t i = 0; i < view->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_view_find_ins_point_key(view, inner->elems,
+						       inner->header.size - 1,
+						       key, upper);
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block_ver(tree, block_id, &res.view);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_view_find_ins_point_key(view, leaf->elems,
+					       leaf->header.size, key, upper);
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief Get an iterator to the first element of a view that is
+ * greater than or equal to the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_lower_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key)
+{
+	return bps_tree_view_bound(tree, view, key, false);
+}
+
+/**
+ * @brief Get an iterator to the first element of a view that is
+ * greater than the key.
+ */
+static inline struct bps_tree_iterator
+bps_tree_view_upper_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key)
+{
+	return bps_tree_view_bound(tree, view, key, true);
+}
+
 /**
  * @brief Find the first element that is equal to the key (comparator returns 0)
  * @param tree - pointer to a tree
@@ -2095,6 +2650,61 @@ bps_tree_find(const struct bps_tree *tree, bps_tree_key_t key)
 		return 0;
 }
 
+/**
+ * @sa bps_tree_find_batch description
+ */
+static inline void
+bps_tree_find_batch(const struct bps_tree *tree, bps_tree_key_t *keys,
+		    size_t count, bps_tree_elem_t **results)
+{
+	/* Number of lookups done together. */
+	enum { BPS_TREE_FIND_BATCH = 16 };
+	if (tree->root_id == (bps_tree_block_id_t)(-1)) {
+		memset(results, 0, count * sizeof(*results));
+		return;
+	}
+	struct bps_block *blocks[BPS_TREE_FIND_BATCH];
+	for (size_t start = 0; start < count; start += BPS_TREE_FIND_BATCH) {
+		size_t n = count - start;
+		if (n > BPS_TREE_FIND_BATCH)
+			n = BPS_TREE_FIND_BATCH;
+		bps_tree_key_t *batch = keys + start;
+		struct bps_block *root = bps_tree_root(tree);
+		for (size_t j = 0; j < n; j++)
+			blocks[j] = root;
+		bool exact;
+		for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+			for (size_t j = 0; j < n; j++) {
+				struct bps_inner *inner =
+					(struct bps_inner *)blocks[j];
+				bps_tree_pos_t pos;
+				pos = bps_tree_find_ins_point_key(tree,
+						inner->elems,
+						inner->header.size - 1,
+						batch[j], &exact);
+				struct bps_block *block = bps_tree_restore_block(
+					tree, inner->child_ids[pos]);
+				/*
+				 * Binary search starts in the middle of
+				 * the block, after reading its header.
+				 */
+				__builtin_prefetch(block);
+				__builtin_prefetch((char *)block +
+						   BPS_TREE_BLOCK_SIZE / 2);
+				blocks[j] = block;
+			}
+		}
+		for (size_t j = 0; j < n; j++) {
+			struct bps_leaf *leaf = (struct bps_leaf *)blocks[j];
+			bps_tree_pos_t pos;
+			pos = bps_tree_find_ins_point_key(tree, leaf->elems,
+							  leaf->header.size,
+							  batch[j], &exact);
+			results[start + j] = exact ? leaf->elems + pos : NULL;
+		}
+	}
+}
+
 /**
  * @brief Add a block to the garbage for future reuse
  */
@@ -2334,6 +2944,95 @@ bps_tree_touch_path(struct bps_tree *tree,
 	}
 }
 
+#ifdef BPS_INNER_CARD
+
+/**
+ * @brief Set the card of a leaf in its parent to the size of the leaf.
+ *  Does nothing if the leaf is not linked to the parent yet (a new
+ *  block during split): its card is set when it's inserted into parent.
+ */
+static inline void
+bps_tree_update_card_leaf(struct bps_tree *tree,
+			  struct bps_leaf_path_elem *leaf_path_elem)
+{
+	struct bps_inner_path_elem *parent = leaf_path_elem->parent;
+	if (tree->root_id == (bps_tree_block_id_t)(-1) || !parent)
+		return;
+	bps_tree_pos_t pos = leaf_path_elem->pos_in_parent;
+	if (pos >= parent->block->header.size ||
+	    parent->block->child_ids[pos] != leaf_path_elem->block_id)
+		return;
+	parent->block = (struct bps_inner *)
+		bps_tree_touch_block(tree, parent->block_id);
+	parent->block->child_cards[pos] = leaf_path_elem->block->header.size;
+}
+
+/**
+ * @brief Set the card of an inner block in its parent to the sum of
+ *  the block's child cards. See bps_tree_update_card_leaf.
+ */
+static inline void
+bps_tree_update_card_inner(struct bps_tree *tree,
+			   struct bps_inner_path_elem *inner_path_elem)
+{
+	struct bps_inner_path_elem *parent = inner_path_elem->parent;
+	if (tree->root_id == (bps_tree_block_id_t)(-1) || !parent)
+		return;
+	bps_tree_pos_t pos = inner_path_elem->pos_in_parent;
+	if (pos >= parent->block->header.size ||
+	    parent->block->child_ids[pos] != inner_path_elem->block_id)
+		return;
+	struct bps_inner *inner = inner_path_elem->block;
+	bps_tree_block_card_t card = 0;
+	for (bps_tree_pos_t i = 0; i < inner->header.size; i++)
+		card += inner->child_cards[i];
+	parent->block = (struct bps_inner *)
+		bps_tree_touch_block(tree, parent->block_id);
+	parent->block->child_cards[pos] = card;
+}
+
+/**
+ * @brief Add delta to the cards of the given inner block and all
+ *  its ancestors, i.e. account elements inserted to (or deleted from)
+ *  the subtree of the block.
+ */
+static inline void
+bps_tree_add_card_path(struct bps_tree *tree,
+		       struct bps_inner_path_elem *inner_path_elem,
+		       int64_t delta)
+{
+	if (tree->root_id == (bps_tree_block_id_t)(-1))
+		return;
+	for (struct bps_inner_path_elem *path = inner_path_elem;
+	     path && path->parent; path = path->parent) {
+		struct bps_inner_path_elem *parent = path->parent;
+		parent->block = (struct bps_inner *)
+			bps_tree_touch_block(tree, parent->block_id);
+		parent->block->child_cards[path->pos_in_parent] += delta;
+	}
+}
+
+/**
+ * @brief Recalculate all child cards of an inner block from scratch
+ *  and update the card of the block in its parent. Used after
+ *  insert-and-move of children, that happens only on split and thus
+ *  rarely enough to not bother with tracking each moved child.
+ */
+static inline void
+bps_tree_refresh_cards_inner(struct bps_tree *tree,
+			     struct bps_inner_path_elem *inner_path_elem)
+{
+	if (tree->root_id == (bps_tree_block_id_t)(-1))
+		return;
+	struct bps_inner *inner = inner_path_elem->block;
+	for (bps_tree_pos_t i = 0; i < inner->header.size; i++)
+		inner->child_cards[i] =
+			bps_tree_block_card(tree, inner->child_ids[i]);
+	bps_tree_update_card_inner(tree, inner_path_elem);
+}
+
+#endif /* BPS_INNER_CARD */
+
 /**
  * @brief Replace element by it's path and fill the *replaced argument
  */
@@ -2419,6 +3118,16 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 				assert(src < ((char *)src_inner->elems) +
 				       (BPS_TREE_MAX_COUNT_IN_INNER - 1) *
 				       sizeof(bps_tree_elem_t));
+#ifdef BPS_INNER_CARD
+			} else if (dst >= ((char *)dst_inner->child_cards)) {
+				assert(dst < ((char *)dst_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_block_card_t));
+				assert(src >= (char *)src_inner->child_cards);
+				assert(src < ((char *)src_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_block_card_t));
+#endif
 			} else {
 				assert(dst >= ((char *)dst_inner->child_ids));
 				assert(dst < ((char *)dst_inner->child_ids) +
@@ -2439,6 +3148,17 @@ bps_tree_debug_memmove(void *dst_arg, void *src_arg, size_t num,
 					(BPS_TREE_MAX_COUNT_IN_INNER - 1) *
 					sizeof(bps_tree_elem_t)) {
 				/* nothing to do due to if condition */
+#ifdef BPS_INNER_CARD
+			} else if (dst >= ((char *)dst_inner->child_cards) &&
+				   src >= ((char *)src_inner->child_cards)) {
+				assert(dst <= ((char *)dst_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_block_card_t));
+				assert(src >= (char *)src_inner->child_cards);
+				assert(src <= ((char *)src_inner->child_cards) +
+				       BPS_TREE_MAX_COUNT_IN_INNER *
+				       sizeof(bps_tree_block_card_t));
+#endif
 			} else {
 				assert(dst >= ((char *)dst_inner->child_ids));
 				assert(dst <= ((char *)dst_inner->child_ids) +
@@ -2485,6 +3205,10 @@ bps_tree_insert_into_leaf(struct bps_tree *tree,
 	}
 	leaf->header.size++;
 	tree->size++;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_card_leaf(tree, leaf_path_elem);
+	bps_tree_add_card_path(tree, leaf_path_elem->parent, 1);
+#endif
 }
 
 /**
@@ -2513,12 +3237,22 @@ bps_tree_insert_into_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(inner->child_ids + pos + 1,
 				  inner->child_ids + pos,
 				  inner->header.size - pos, inner, inner);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(inner->child_cards + pos + 1,
+				  inner->child_cards + pos,
+				  inner->header.size - pos, inner, inner);
+#endif
 	} else {
 		if (pos > 0)
 			inner->elems[pos - 1] = *inner_path_elem->max_elem_copy;
 		*inner_path_elem->max_elem_copy = max_elem;
 	}
 	inner->child_ids[pos] = block_id;
+#ifdef BPS_INNER_CARD
+	inner->child_cards[pos] = 0;
+	if (tree->root_id != (bps_tree_block_id_t) -1)
+		inner->child_cards[pos] = bps_tree_block_card(tree, block_id);
+#endif
 
 	inner->header.size++;
 }
@@ -2552,6 +3286,10 @@ bps_tree_delete_from_leaf(struct bps_tree *tree,
 	}
 
 	tree->size--;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_card_leaf(tree, leaf_path_elem);
+	bps_tree_add_card_path(tree, leaf_path_elem->parent, -1);
+#endif
 }
 
 /**
@@ -2570,6 +3308,11 @@ bps_tree_delete_from_inner(struct bps_tree *tree,
 
 	assert(pos >= 0);
 	assert(pos < inner->header.size);
+#ifdef BPS_INNER_CARD
+	/* Only an emptied child can be deleted */
+	assert(tree->root_id == (bps_tree_block_id_t) -1 ||
+	       inner->child_cards[pos] == 0);
+#endif
 
 	if (pos < inner->header.size - 1) {
 		BPS_TREE_DATAMOVE(inner->elems + pos, inner->elems + pos + 1,
@@ -2577,6 +3320,11 @@ bps_tree_delete_from_inner(struct bps_tree *tree,
 		BPS_TREE_DATAMOVE(inner->child_ids + pos,
 				  inner->child_ids + pos + 1,
 				  inner->header.size - 1 - pos, inner, inner);
+#ifdef BPS_INNER_CARD
+		BPS_TREE_DATAMOVE(inner->child_cards + pos,
+				  inner->child_cards + pos + 1,
+				  inner->header.size - 1 - pos, inner, inner);
+#endif
 	} else if (pos > 0) {
 		*inner_path_elem->max_elem_copy = inner->elems[pos - 1];
 	}
@@ -2619,6 +3367,10 @@ bps_tree_move_elems_to_right_leaf(struct bps_tree *tree,
 		*a_leaf_path_elem->max_elem_copy =
 			a->elems[a->header.size - 1];
 	*b_leaf_path_elem->max_elem_copy = b->elems[b->header.size - 1];
+#ifdef BPS_INNER_CARD
+	bps_tree_update_card_leaf(tree, a_leaf_path_elem);
+	bps_tree_update_card_leaf(tree, b_leaf_path_elem);
+#endif
 }
 
 /**
@@ -2650,6 +3402,12 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 			  b->header.size, b, b);
 	BPS_TREE_DATAMOVE(b->child_ids, a->child_ids + a->header.size - num,
 			  num, b, a);
+#ifdef BPS_INNER_CARD
+	BPS_TREE_DATAMOVE(b->child_cards + num, b->child_cards,
+			  b->header.size, b, b);
+	BPS_TREE_DATAMOVE(b->child_cards,
+			  a->child_cards + a->header.size - num, num, b, a);
+#endif
 
 	if (!move_to_empty)
 		BPS_TREE_DATAMOVE(b->elems + num, b->elems,
@@ -2667,6 +3425,10 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= num;
 	b->header.size += num;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_card_inner(tree, a_inner_path_elem);
+	bps_tree_update_card_inner(tree, b_inner_path_elem);
+#endif
 }
 
 /**
@@ -2699,6 +3461,10 @@ bps_tree_move_elems_to_left_leaf(struct bps_tree *tree,
 	a->header.size += num;
 	b->header.size -= num;
 	*a_leaf_path_elem->max_elem_copy = a->elems[a->header.size - 1];
+#ifdef BPS_INNER_CARD
+	bps_tree_update_card_leaf(tree, a_leaf_path_elem);
+	bps_tree_update_card_leaf(tree, b_leaf_path_elem);
+#endif
 }
 
 /**
@@ -2730,6 +3496,12 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 			  num, a, b);
 	BPS_TREE_DATAMOVE(b->child_ids, b->child_ids + num,
 			  b->header.size - num, b, b);
+#ifdef BPS_INNER_CARD
+	BPS_TREE_DATAMOVE(a->child_cards + a->header.size, b->child_cards,
+			  num, a, b);
+	BPS_TREE_DATAMOVE(b->child_cards, b->child_cards + num,
+			  b->header.size - num, b, b);
+#endif
 
 	if (!move_to_empty)
 		a->elems[a->header.size - 1] =
@@ -2746,6 +3518,10 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= num;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_card_inner(tree, a_inner_path_elem);
+	bps_tree_update_card_inner(tree, b_inner_path_elem);
+#endif
 }
 
 /**
@@ -2814,6 +3590,11 @@ bps_tree_insert_and_move_elems_to_right_leaf(struct bps_tree *tree,
 		*b_leaf_path_elem->max_elem_copy =
 			b->elems[b->header.size - 1];
 	tree->size++;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_card_leaf(tree, a_leaf_path_elem);
+	bps_tree_update_card_leaf(tree, b_leaf_path_elem);
+	bps_tree_add_card_path(tree, a_leaf_path_elem->parent, 1);
+#endif
 	return ret;
 }
 
@@ -2950,6 +3731,10 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= (num - 1);
 	b->header.size += num;
+#ifdef BPS_INNER_CARD
+	bps_tree_refresh_cards_inner(tree, a_inner_path_elem);
+	bps_tree_refresh_cards_inner(tree, b_inner_path_elem);
+#endif
 }
 
 /**
@@ -3017,6 +3802,11 @@ bps_tree_insert_and_move_elems_to_left_leaf(struct bps_tree *tree,
 		*b_leaf_path_elem->max_elem_copy =
 			b->elems[b->header.size - 1];
 	tree->size++;
+#ifdef BPS_INNER_CARD
+	bps_tree_update_card_leaf(tree, a_leaf_path_elem);
+	bps_tree_update_card_leaf(tree, b_leaf_path_elem);
+	bps_tree_add_card_path(tree, a_leaf_path_elem->parent, 1);
+#endif
 	return ret;
 }
 
@@ -3148,6 +3938,10 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= (num - 1);
+#ifdef BPS_INNER_CARD
+	bps_tree_refresh_cards_inner(tree, a_inner_path_elem);
+	bps_tree_refresh_cards_inner(tree, b_inner_path_elem);
+#endif
 }
 
 /**
@@ -3713,6 +4507,12 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 		new_root->header.size = 2;
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
+#ifdef BPS_INNER_CARD
+		new_root->child_cards[0] =
+			bps_tree_block_card(tree, tree->root_id);
+		new_root->child_cards[1] =
+			bps_tree_block_card(tree, new_block_id);
+#endif
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -4033,6 +4833,12 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 		new_root->header.size = 2;
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
+#ifdef BPS_INNER_CARD
+		new_root->child_cards[0] =
+			bps_tree_block_card(tree, tree->root_id);
+		new_root->child_cards[1] =
+			bps_tree_block_card(tree, new_block_id);
+#endif
 		new_root->elems[0] = tree->max_elem;
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
@@ -4658,13 +5464,21 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 				result |= 0x4000000;
 		}
 
-		for (bps_tree_pos_t i = 0; i < block->size; i++)
+		for (bps_tree_pos_t i = 0; i < block->size; i++) {
+#ifdef BPS_INNER_CARD
+			size_t count_before = *calc_count;
+#endif
 			result |= bps_tree_debug_check_block(tree,
 				bps_tree_restore_block(tree,
 						       inner->child_ids[i]),
 				inner->child_ids[i], level - 1, calc_count,
 				expected_prev_id, expected_this_id,
 				check_fullness_next);
+#ifdef BPS_INNER_CARD
+			if (inner->child_cards[i] != *calc_count - count_before)
+				result |= 0x8000000;
+#endif
+		}
 		return result;
 	}
 }
@@ -6076,6 +6890,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_inner
 #undef bps_garbage
 #undef bps_tree_iterator
+#undef bps_tree_view
 #undef bps_inner_path_elem
 #undef bps_leaf_path_elem
 
@@ -6083,6 +6898,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_build
 #undef bps_tree_destroy
 #undef bps_tree_find
+#undef bps_tree_find_batch
 #undef bps_tree_insert
 #undef bps_tree_delete
 #undef bps_tree_delete_identical
@@ -6099,11 +6915,20 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_lower_bound_elem
 #undef bps_tree_upper_bound_elem
 #undef bps_tree_approximate_count
+#undef bps_tree_iterator_at
+#undef bps_tree_lower_bound_get_offset
+#undef bps_tree_upper_bound_get_offset
 #undef bps_tree_iterator_get_elem
 #undef bps_tree_iterator_next
 #undef bps_tree_iterator_prev
 #undef bps_tree_iterator_freeze
 #undef bps_tree_iterator_destroy
+#undef bps_tree_view_create
+#undef bps_tree_view_destroy
+#undef bps_tree_view_first
+#undef bps_tree_view_last
+#undef bps_tree_view_lower_bound
+#undef bps_tree_view_upper_bound
 #undef bps_tree_debug_check
 #undef bps_tree_print
 #undef bps_tree_debug_check_internal_functions
@@ -6121,9 +6946,18 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_restore_block_ver
 #undef bps_tree_root
 #undef bps_tree_touch_block
+#undef bps_tree_block_card
+#undef bps_tree_build_cards
+#undef bps_tree_update_card_leaf
+#undef bps_tree_update_card_inner
+#undef bps_tree_add_card_path
+#undef bps_tree_refresh_cards_inner
 #undef bps_tree_find_ins_point_key
 #undef bps_tree_find_ins_point_elem
 #undef bps_tree_find_after_ins_point_key
+#undef bps_tree_view_find_ins_point_key
+#undef bps_tree_view_bound
+#undef bps_tree_view_compare_key
 #undef bps_tree_find_after_ins_point_elem
 #undef bps_tree_get_leaf_safe
 #undef bps_tree_garbage_push
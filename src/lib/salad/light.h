@@ -226,6 +226,15 @@ LIGHT(find)(const struct LIGHT(core) *ht, uint32_t hash, LIGHT_DATA_TYPE data);
 static inline uint32_t
 LIGHT(find_key)(const struct LIGHT(core) *ht, uint32_t hash, LIGHT_KEY_TYPE data);
 
+/**
+ * @brief Prefetch the record a lookup of the given hash starts with.
+ * Used to overlap cache misses of a batch of lookups.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ */
+static inline void
+LIGHT(prefetch)(const struct LIGHT(core) *ht, uint32_t hash);
+
 /**
  * @brief Insert a record with given hash and value
  * @param ht - pointer to a hash table struct
@@ -450,6 +459,20 @@ LIGHT(find_key)(const struct LIGHT(core) *ht, uint32_t hash, LIGHT_KEY_TYPE key)
 	return LIGHT(end);
 }
 
+/**
+ * @brief Prefetch the record a lookup of the given hash starts with.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ */
+static inline void
+LIGHT(prefetch)(const struct LIGHT(core) *ht, uint32_t hash)
+{
+	if (ht->count == 0)
+		return;
+	uint32_t slot = LIGHT(slot)(ht, hash);
+	__builtin_prefetch(matras_get(&ht->mtable, slot));
+}
+
 /**
  * @brief Replace a record with given hash and value
  * @param ht - pointer to a hash table struct
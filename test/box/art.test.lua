@@ -0,0 +1,88 @@
+test_run = require('test_run').new()
+
+--
+-- ART index: an adaptive radix tree over memcomparable
+-- encoded keys. It supports the same iterators and partial
+-- key lookups as TREE and never dereferences tuples on lookup.
+--
+ids = function(r) local t = {} for _, v in ipairs(r) do table.insert(t, v[1]) end return table.concat(t, ' ') end
+s = box.schema.space.create('test')
+pk = s:create_index('pk', {type = 'art', parts = {2, 'string'}})
+pk.type
+pk.unique
+bsize = pk:bsize()
+urls = {'http://a.org/', 'http://a.org/x', 'http://a.org/x/y', 'http://b.org/', 'https://a.org/', 'http', ''}
+for i, u in ipairs(urls) do s:insert{i, u} end
+s:count()
+pk:len()
+pk:bsize() > bsize
+s:get{'http://a.org/x'}
+s:get{'http://a.org/z'}
+s:get{1}
+s:insert{8, 'http'}
+ids(s:select())
+ids(pk:select('http://a.org/', {iterator = 'GT'}))
+ids(pk:select('http://a.org/x', {iterator = 'LE'}))
+ids(pk:select('http://a.org/x', {iterator = 'LT'}))
+ids(pk:select('http://b', {iterator = 'GE'}))
+ids(pk:select('http', {iterator = 'REQ'}))
+ids(pk:select('', {iterator = 'LT'}))
+pk:min()
+pk:max()
+pk:get_many({'http', 'none', ''})
+pk:random(1) ~= nil
+s:replace{8, 'http'}
+s:delete{'http'}
+s:count()
+-- Zero bytes are escaped, a string sorts before its extensions.
+s:insert{9, 'a\0b'} s:insert{10, 'a'} s:insert{11, 'a\0'}
+ids(pk:select('a', {iterator = 'GE', limit = 3}))
+
+-- Non-unique multipart index, partial keys are prefix scans.
+s2 = box.schema.space.create('test2')
+_ = s2:create_index('pk')
+for i = 1, 12 do s2:insert{i, 'k' .. i % 3, i % 4 - 2} end
+sk = s2:create_index('sk', {type = 'art', parts = {{2, 'string'}, {3, 'integer'}}, unique = false})
+sk:len()
+ids(sk:select('k1'))
+ids(sk:select('k1', {iterator = 'REQ'}))
+ids(sk:select({'k1', -1}, {iterator = 'GE', limit = 3}))
+ids(sk:select({'k1', -1}, {iterator = 'GT'}))
+ids(sk:select('k1', {iterator = 'LT'}))
+ids(sk:select({'k1', 0}, {iterator = 'LE'}))
+ids(sk:select({}, {iterator = 'REQ', limit = 2}))
+sk:count('k2')
+sk:min()
+sk:max()
+sk:min('k1')
+sk:max('k1')
+sk:select({}, {iterator = 'BITS_ALL_SET'})
+
+-- Restrictions.
+s2:create_index('x', {type = 'art', parts = {{2, 'string', collation = 'unicode_ci'}}})
+s2:create_index('x', {type = 'art', parts = {5, 'number'}})
+s2:create_index('x', {type = 'art', parts = {{5, 'unsigned', path = '[*]'}}})
+s2:create_index('x', {type = 'art', parts = {{5, 'string', is_nullable = true}}})
+
+-- Iterators survive modifications of the index.
+for _, t in sk:pairs('k0') do s2:delete{t[1]} end
+sk:count('k0')
+s2:count()
+s2:update({1}, {{'=', 2, 'k0'}})
+sk:select('k0')
+s2.index.pk:alter({type = 'art'})
+s2.index.pk.type
+
+-- Indexes survive a checkpoint and a restart.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+s2 = box.space.test2
+ids = function(r) local t = {} for _, v in ipairs(r) do table.insert(t, v[1]) end return table.concat(t, ' ') end
+ids(s:select())
+s2:count()
+ids(s2.index.sk:select('k1'))
+ids(s2:select(5, {iterator = 'GE'}))
+ids(s2:select(5, {iterator = 'LT'}))
+s:drop()
+s2:drop()
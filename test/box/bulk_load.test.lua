@@ -0,0 +1,82 @@
+test_run = require('test_run').new()
+fio = require('fio')
+msgpack = require('msgpack')
+fun = require('fun')
+
+--
+-- space:bulk_load() fills an empty memtx space bypassing
+-- transactions and WAL, the data is made durable by a
+-- checkpoint.
+--
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'string'}, unique = false})
+t = {}
+for i = 1, 1000 do t[i] = {1001 - i, 'k' .. i % 10} end
+lsn = box.info.lsn
+s:bulk_load(t)
+box.info.lsn == lsn
+s:count()
+pk:min()
+pk:max()
+sk:count{'k3'}
+s:bsize() > 0
+-- The space accepts writes after the load.
+s:insert{1001, 'k1'}
+s:bulk_load({{2000, 'x'}})
+s:truncate()
+
+-- Errors leave the space empty.
+s:bulk_load({{1, 'a'}, {2, 'b'}, {1, 'c'}})
+s:count()
+s:bulk_load({{1, 'a'}, {2, 'b'}, {'x'}})
+s:count()
+s:bsize()
+
+-- Iterators.
+s:bulk_load(function(param, state) if state < 3 then return state + 1, {state + 1, 'i'} end end, nil, 0)
+s:select()
+s:truncate()
+s:bulk_load(fun.range(5):map(function(i) return {i, 'f'} end))
+s:count()
+s:truncate()
+
+-- A file of MsgPack arrays.
+path = fio.pathjoin(fio.tempdir(), 'bulk_load.mp')
+f = fio.open(path, {'O_CREAT', 'O_WRONLY'}, tonumber('644', 8))
+for i = 1, 100 do f:write(msgpack.encode({i, 'file'})) end
+f:close()
+s:bulk_load(path)
+s:count()
+s:bulk_load('/no/such/file')
+
+-- The loaded data survives a restart.
+test_run:cmd('restart server default')
+s = box.space.test
+s:count()
+s.index.sk:count{'file'}
+s:drop()
+
+-- Restrictions.
+s = box.schema.space.create('test')
+s:bulk_load({})
+_ = s:create_index('pk', {type = 'hash'})
+s:bulk_load({})
+s:drop()
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+s:bulk_load({})
+s:drop()
+
+-- Loaded data is not replicated.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = box.space._cluster:insert{2, require('uuid').str()}
+s:bulk_load({{1}})
+s:drop()
+s = box.schema.space.create('test', {is_local = true})
+_ = s:create_index('pk')
+s:bulk_load({{1}})
+s:count()
+s:drop()
+_ = box.space._cluster:delete{2}
@@ -0,0 +1,58 @@
+test_run = require('test_run').new()
+
+--
+-- box.commit({wait = 'none'}) returns without waiting for
+-- the transaction to be written to WAL.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+lsn = box.info.lsn
+box.begin() s:insert{1} s:insert{2} box.commit({wait = 'none'}) lsn_on_return = box.info.lsn
+lsn_on_return == lsn
+-- The changes are visible right away.
+s:select()
+test_run:wait_cond(function() return box.info.lsn == lsn + 2 end)
+
+-- Commit triggers are run once the transaction is written.
+committed = nil
+box.begin() s:replace{3} box.on_commit(function(iter) committed = {} for _, _, new in iter() do table.insert(committed, new) end end) box.commit({wait = 'none'}) committed_on_return = committed
+committed_on_return
+test_run:wait_cond(function() return committed ~= nil end)
+committed
+
+-- Transactions are written in the commit order.
+box.begin() s:replace{4, 'async'} box.commit({wait = 'none'}) s:replace{4, 'sync'}
+s:get{4}
+test_run:cmd('restart server default')
+s = box.space.test
+s:select()
+
+-- Synchronous commit.
+box.begin() s:replace{5} box.commit({wait = 'complete'})
+s:get{5}
+
+-- Commit triggers may yield.
+fiber = require('fiber')
+done = false
+box.begin() s:replace{6} box.on_commit(function() fiber.sleep(0.01) done = true end) box.commit({wait = 'none'})
+test_run:wait_cond(function() return done end)
+s:get{6}
+
+-- Too many transactions in flight make commit wait.
+for i = 1, 2000 do box.begin() s:replace{i + 10} box.commit({wait = 'none'}) end
+s:count()
+
+-- Vinyl transactions are committed synchronously.
+v = box.schema.space.create('test_vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk')
+lsn = box.info.lsn
+box.begin() v:insert{1} box.commit({wait = 'none'}) lsn_on_return = box.info.lsn
+lsn_on_return == lsn + 1
+v:drop()
+
+-- Invalid arguments.
+box.commit({wait = 'all'})
+box.commit({wait = 1})
+box.commit('none')
+box.commit({wait = 'none'})
+s:drop()
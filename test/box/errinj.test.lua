@@ -587,3 +587,58 @@ fio = require('fio')
 #fio.glob(fio.pathjoin(box.cfg.vinyl_dir, box.space.test.id, 0, '*.index.inprogress')) == 0
 
 box.space.test:drop()
+
+--
+-- A failure to write an asynchronously committed transaction
+-- is reported to its rollback triggers.
+--
+test_run = require('test_run').new()
+errinj = box.error.injection
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+rolled_back = nil
+errinj.set('ERRINJ_WAL_WRITE', true)
+box.begin() s:insert{1} box.on_rollback(function() rolled_back = true end) box.commit({wait = 'none'})
+test_run:wait_cond(function() return rolled_back end)
+s:get{1}
+errinj.set('ERRINJ_WAL_WRITE', false)
+s:drop()
+
+--
+-- A failed batch mixing synchronous and asynchronously
+-- committed transactions is rolled back in reverse order.
+--
+fiber = require('fiber')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:replace{1, 0}
+done = nil
+rolled_back = nil
+errinj.set('ERRINJ_WAL_DELAY', true)
+_ = fiber.create(function() done = pcall(s.replace, s, {1, 1}) end)
+box.begin() s:replace{1, 2} box.on_rollback(function() rolled_back = true end) box.commit({wait = 'none'})
+s:get{1}
+errinj.set('ERRINJ_WAL_WRITE', true)
+errinj.set('ERRINJ_WAL_DELAY', false)
+test_run:wait_cond(function() return done ~= nil and rolled_back end)
+done
+s:get{1}
+errinj.set('ERRINJ_WAL_WRITE', false)
+s:drop()
+
+--
+-- Bulk loaded data is deleted if it can't be checkpointed.
+--
+v = box.schema.space.create('test_vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk')
+v:insert{1}
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+errinj.set('ERRINJ_VY_RUN_WRITE', true)
+s:bulk_load({{1}, {2}})
+errinj.set('ERRINJ_VY_RUN_WRITE', false)
+s:count()
+s:bsize()
+s:insert{3}
+s:drop()
+v:drop()
@@ -0,0 +1,62 @@
+test_run = require('test_run').new()
+net_box = require('net.box')
+fiber = require('fiber')
+
+--
+-- Requests parsed from one input buffer are delivered to tx
+-- in one message when iproto_batch is set.
+--
+box.cfg{iproto_batch = 1}
+box.cfg{iproto_batch = true}
+box.schema.user.grant('guest', 'read,write', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+c = net_box.connect(box.cfg.listen)
+errors = {}
+done = 0
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 10 do
+    fiber.create(function()
+        for j = 1, 100 do
+            local ok, err = pcall(c.space.test.insert, c.space.test,
+                                  {j, i})
+            if not ok then
+                table.insert(errors, err.code)
+            end
+            c.space.test:select{j}
+        end
+        done = done + 1
+    end)
+end;
+test_run:cmd("setopt delimiter ''");
+test_run:wait_cond(function() return done == 10 end)
+s:count()
+#errors
+errors[1] == box.error.TUPLE_FOUND
+
+--
+-- Reads sent at once make a batch. Writes are never batched,
+-- so that they share a WAL write.
+--
+test_run:cmd("setopt delimiter ';'")
+function send_all(f)
+    local futures = {}
+    for i = 1, 100 do
+        table.insert(futures, f(i))
+    end
+    for _, future in ipairs(futures) do
+        future:wait_result()
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+batches = box.stat.net.BATCHES.total
+send_all(function(i) return c.space.test:replace({i, 0}, {is_async = true}) end)
+box.stat.net.BATCHES.total == batches
+send_all(function(i) return c.space.test:select({i}, {is_async = true}) end)
+box.stat.net.BATCHES.total > batches
+box.stat.net.BATCHES.total - batches < 100
+
+c:close()
+s:drop()
+box.schema.user.revoke('guest', 'read,write', 'universe')
+box.cfg{iproto_batch = false}
@@ -0,0 +1,62 @@
+test_run = require('test_run').new()
+net_box = require('net.box')
+
+--
+-- A big result set may be read with a server-side cursor,
+-- page by page.
+--
+box.schema.user.grant('guest', 'read', 'universe')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 1000 do s:replace{i} end
+c = net_box.connect(box.cfg.listen)
+cur = c.space.test:cursor(nil, {batch_size = 300})
+cur.id
+#cur:fetch()
+cur:fetch(2)
+#cur:fetch()
+#cur:fetch()
+#cur:fetch()
+#cur:fetch()
+cur.is_closed
+cur:fetch()
+
+-- Iterator type and key are the same as for select.
+cur = c.space.test.index.pk:cursor({10}, {iterator = 'LE', batch_size = 3})
+t = {}
+for _, tuple in cur:pairs() do table.insert(t, tuple[1]) end
+t
+cur.is_closed
+c.space.test:cursor({'a'})
+
+-- A cursor may be closed before it is exhausted.
+cur = c.space.test:cursor()
+#cur:fetch(10)
+cur:close()
+cur.is_closed
+c:_request('cursor_fetch', nil, cur.id, 1)
+
+-- A page is cut short when the output buffer is big enough.
+s:truncate()
+for i = 1, 4 do s:replace{i, string.rep('x', 512 * 1024)} end
+cur = c.space.test:cursor()
+page = cur:fetch(4)
+#page > 0 and #page < 4
+cur:close()
+
+-- Cursors are closed with the session.
+cur = c.space.test:cursor()
+c:close()
+c = net_box.connect(box.cfg.listen)
+c:_request('cursor_fetch', nil, cur.id, 1)
+
+-- A session may have a limited number of cursors open.
+t = {}
+for i = 1, 1024 do table.insert(t, c.space.test:cursor()) end
+c.space.test:cursor()
+t[1]:close()
+cur = c.space.test:cursor()
+cur.is_closed
+c:close()
+s:drop()
+box.schema.user.revoke('guest', 'read', 'universe')
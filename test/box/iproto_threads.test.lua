@@ -0,0 +1,36 @@
+test_run = require('test_run').new()
+
+--
+-- Connections are spread over several network threads.
+--
+test_run:cmd("create server test with script='box/iproto_threads.lua'")
+test_run:cmd("start server test")
+test_run:cmd("switch test")
+box.cfg.iproto_threads
+net_box = require('net.box')
+fiber = require('fiber')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+conns = {}
+for i = 1, 16 do conns[i] = net_box.connect(box.cfg.listen) end
+done = 0
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 16 do
+    fiber.create(function()
+        for j = 1, 100 do
+            conns[i].space.test:replace{i * 1000 + j}
+        end
+        done = done + 1
+    end)
+end;
+test_run:cmd("setopt delimiter ''");
+test_run:wait_cond(function() return done == 16 end)
+s:count()
+box.stat.net().CONNECTIONS.total >= 16
+box.stat.net.REQUESTS.total >= 1600
+for i = 1, 16 do conns[i]:close() end
+s:drop()
+test_run:cmd("switch default")
+test_run:cmd("stop server test")
+test_run:cmd("cleanup server test")
+test_run:cmd("delete server test")
@@ -195,6 +195,39 @@ function check_space(space, N)
     return errors
 end
 
+-- Check that all indexes of a space hold the same tuples and
+-- tree indexes are ordered. Return true or the name of the first
+-- broken index.
+function check_indexes(space)
+    local key_def = require('key_def')
+    local msgpack = require('msgpack')
+    local pk = space.index[0]
+    local pk_def = key_def.new(pk.parts)
+    for i = 0, #space.index do
+        local index = space.index[i]
+        local def = key_def.new(index.parts)
+        local prev = nil
+        local count = 0
+        for _, t in index:pairs() do
+            if index.type == 'TREE' and prev ~= nil and
+               def:compare(prev, t) > 0 then
+                return index.name
+            end
+            local pk_tuple = pk:get(pk_def:extract_key(t))
+            if pk_tuple == nil or
+               msgpack.encode(pk_tuple) ~= msgpack.encode(t) then
+                return index.name
+            end
+            prev = t
+            count = count + 1
+        end
+        if count ~= space:len() then
+            return index.name
+        end
+    end
+    return true
+end
+
 function space_bsize(s)
     local bsize = 0
     for _, t in s:pairs() do
@@ -239,6 +272,7 @@ return {
     sort = sort;
     tuple_to_string = tuple_to_string;
     check_space = check_space;
+    check_indexes = check_indexes;
     space_bsize = space_bsize;
     create_iterator = create_iterator;
     setmap = setmap;
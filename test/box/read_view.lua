@@ -0,0 +1,12 @@
+#!/usr/bin/env tarantool
+os = require('os')
+
+box.cfg{
+    listen              = os.getenv("LISTEN"),
+    read_view_threads   = 2,
+}
+
+require('console').listen(os.getenv('ADMIN'))
+box.once('init', function()
+    box.schema.user.grant('guest', 'read,write,execute', 'universe')
+end)
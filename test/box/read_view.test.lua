@@ -0,0 +1,46 @@
+test_run = require('test_run').new()
+
+--
+-- Primary key SELECTs over iproto are served by reader threads
+-- from a read view of spaces created with read_view option.
+--
+test_run:cmd("create server test with script='box/read_view.lua'")
+test_run:cmd("start server test")
+test_run:cmd("switch test")
+box.cfg.read_view_threads
+box.cfg{read_view_staleness = 0}
+box.cfg{read_view_staleness = 0.1}
+box.schema.space.create('test_vinyl', {engine = 'vinyl', read_view = true})
+net_box = require('net.box')
+s = box.schema.space.create('test', {read_view = true})
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, i * 10} end
+c = net_box.connect(box.cfg.listen)
+c.space.test:select({}, {limit = 3})
+c.space.test:select({50}, {iterator = 'LT', limit = 2})
+c.space.test:select({98}, {iterator = 'GE'})
+c.space.test:select({}, {iterator = 'REQ', limit = 2})
+c.space.test:select({5}, {offset = 1})
+c.space.test:get(7)
+-- ALL with a key is GE for a TREE.
+c.space.test:select({98}, {iterator = 'ALL'})
+-- Changes become visible as soon as the view is refreshed.
+s:replace{1, 0}
+test_run:wait_cond(function() return c.space.test:get(1)[2] == 0 end)
+-- Requests the view can't serve are executed by tx.
+c.space.test:select({'a'})
+-- A HASH primary key is not frozen, requests are served by tx.
+h = box.schema.space.create('test_hash', {read_view = true})
+_ = h:create_index('pk', {type = 'hash'})
+h:replace{1}
+c:reload_schema()
+test_run:wait_cond(function() return #c.space.test_hash:select() == 1 end)
+c.space.test_hash:get(1)
+c.space.test_hash:select({1}, {iterator = 'GE'})
+c:close()
+s:drop()
+h:drop()
+test_run:cmd("switch default")
+test_run:cmd("stop server test")
+test_run:cmd("cleanup server test")
+test_run:cmd("delete server test")
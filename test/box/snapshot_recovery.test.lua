@@ -0,0 +1,59 @@
+test_run = require('test_run').new()
+test_run:cmd('restart server default with cleanup=1')
+utils = require('utils')
+
+--
+-- On recovery, snapshot files are read by reader threads and
+-- secondary keys are built in batches sorted in parallel.
+--
+s1 = box.schema.space.create('test1')
+_ = s1:create_index('pk')
+_ = s1:create_index('sk', {parts = {2, 'unsigned'}})
+_ = s1:create_index('sk2', {parts = {{3, 'unsigned'}, {4, 'string'}}, unique = false})
+_ = s1:create_index('hash', {type = 'hash', parts = {4, 'string'}})
+s2 = box.schema.space.create('test2')
+_ = s2:create_index('pk', {type = 'hash'})
+_ = s2:create_index('sk', {parts = {4, 'string'}, unique = false})
+test_run:cmd("setopt delimiter ';'")
+function fill(s, n)
+    box.begin()
+    for i = 1, n do
+        s:insert{i, n - i, i % 7, tostring(i)}
+    end
+    box.commit()
+end;
+test_run:cmd("setopt delimiter ''");
+fill(s1, 10000)
+fill(s2, 5000)
+s2:update(1, {{'=', 4, '2'}})
+box.snapshot()
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+utils = require('utils')
+s1 = box.space.test1
+s2 = box.space.test2
+s1:len()
+s2:len()
+s1.index.sk:get(0)
+s1.index.hash:get('5000')
+s1.index.sk2:count(3)
+s2.index.sk:count('2')
+utils.check_indexes(s1)
+utils.check_indexes(s2)
+
+-- Shards of a sharded snapshot are recovered concurrently.
+box.cfg{memtx_checkpoint_threads = 4}
+s1:delete(1)
+box.snapshot()
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+utils = require('utils')
+s1 = box.space.test1
+s2 = box.space.test2
+s1:len()
+s2:len()
+utils.check_indexes(s1)
+utils.check_indexes(s2)
+
+s1:drop()
+s2:drop()
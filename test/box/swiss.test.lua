@@ -0,0 +1,100 @@
+test_run = require('test_run').new()
+
+--
+-- SWISS index: a unique hash index probing control bytes
+-- of 16 slots at once.
+--
+s = box.schema.space.create('test')
+i = s:create_index('pk', {type = 'swiss'})
+i.type
+bsize = i:bsize()
+for k = 1, 1000 do s:insert{k, tostring(k)} end
+s:count()
+i:len()
+i:bsize() > bsize
+s:get{1}
+s:get{1000}
+s:get{1001}
+s:get{'x'}
+s:get{1, 2}
+s:insert{1, 'x'}
+s:replace{1, 'one'}
+s:update({2}, {{'=', 2, 'two'}})
+s:delete{3}
+s:get{3}
+s:count()
+
+-- Deleted slots are reused.
+for k = 1, 1000 do s:delete{k} end
+s:count()
+for k = 1, 1000 do s:insert{k} end
+s:count()
+#s:select()
+i:random(42) ~= nil
+
+-- Legacy GT iteration can be used to scan the whole index.
+keys = {}
+last = nil
+test_run:cmd("setopt delimiter ';'")
+repeat
+    local batch = i:select(last, {iterator = 'GT', limit = 100})
+    for _, t in ipairs(batch) do keys[t[1]] = true end
+    last = #batch > 0 and batch[#batch][1] or nil
+until last == nil;
+test_run:cmd("setopt delimiter ''");
+#keys
+i:select({1}, {iterator = 'LE'})
+
+-- Restrictions.
+s:create_index('sk', {type = 'swiss', unique = false})
+s:create_index('sk', {type = 'swiss', parts = {{2, 'unsigned', path = '[*]'}}})
+s:create_index('sk', {type = 'swiss', parts = {2, 'any'}})
+s:drop()
+
+-- Multipart keys, secondary index, alter.
+s = box.schema.space.create('test')
+_ = s:create_index('pk', {type = 'hash'})
+for k = 1, 100 do s:insert{k, 'key' .. k % 10, k} end
+sk = s:create_index('sk', {type = 'swiss', parts = {{2, 'string'}, {3, 'unsigned'}}})
+sk:len()
+sk:get{'key1', 1}
+sk:get{'key1', 2}
+sk:get{'key1'}
+sk:get_many({{'key1', 1}, {'key2', 2}, {'key1', 2}})
+s.index.pk:get_many({3, 200, 1})
+batch = {}
+for k = 1, 150 do batch[k] = k end
+#s.index.pk:get_many(batch)
+s:insert{101, 'key1', 1}
+s.index.pk:alter({type = 'swiss'})
+s.index.pk.type
+s.index.pk:get{50}
+#s.index.pk:get_many(batch)
+s:count()
+
+-- Tables survive a checkpoint and a restart.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.pk.type
+s.index.sk.type
+s:count()
+s.index.sk:len()
+s.index.sk:get{'key3', 3}
+s:drop()
+
+-- The table grows incrementally: tuples stay reachable while
+-- they are moved to a bigger table.
+s = box.schema.space.create('test')
+i = s:create_index('pk', {type = 'swiss'})
+missing = 0
+for k = 1, 10000 do s:insert{k} if s:get{k} == nil or s:get{math.ceil(k / 2)} == nil then missing = missing + 1 end end
+missing
+s:count()
+i:len()
+#s:select()
+for k = 1, 10000, 2 do s:delete{k} end
+s:count()
+s:get{2}
+s:get{3}
+s:drop()
@@ -0,0 +1,80 @@
+env = require('test_run')
+test_run = env.new()
+
+--
+-- Range counts, ranks and offsets in memtx tree index are
+-- calculated using subtree cardinalities.
+--
+s = box.schema.space.create('tree_count')
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+for i = 1, 1000 do s:insert{i, i % 10} end
+
+pk:count(500)
+pk:count(1001)
+pk:count(500, {iterator = 'LT'})
+pk:count(500, {iterator = 'LE'})
+pk:count(500, {iterator = 'GT'})
+pk:count(500, {iterator = 'GE'})
+pk:count(500, {iterator = 'REQ'})
+pk:count(500, {iterator = 'ALL'})
+pk:count()
+sk:count(3)
+sk:count(3, {iterator = 'REQ'})
+sk:count(3, {iterator = 'LT'})
+sk:count(3, {iterator = 'GE'})
+sk:count(10)
+pk:count(1, {iterator = 'BITS_ALL_SET'})
+
+pk:rank(1)
+pk:rank(500)
+pk:rank(2000)
+sk:rank(5)
+pk:rank()
+
+-- Offset result must match the one of a plain scan.
+test_run:cmd("setopt delimiter ';'")
+function check_offset(index, key, iterator)
+    local all = index:select(key, {iterator = iterator})
+    for offset = 0, #all + 1, 7 do
+        local part = index:select(key, {iterator = iterator,
+                                        offset = offset, limit = 3})
+        for j = 1, 3 do
+            local a = all[offset + j]
+            local b = part[j]
+            if (a and a[1]) ~= (b and b[1]) then
+                return false, iterator, key, offset
+            end
+        end
+    end
+    return true
+end;
+function check_all_offsets(index, keys)
+    for _, iterator in ipairs({'EQ', 'REQ', 'GE', 'GT', 'LE', 'LT', 'ALL'}) do
+        for _, key in ipairs(keys) do
+            local ok, it, k, offset = check_offset(index, key, iterator)
+            if not ok then
+                return ok, it, k, offset
+            end
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+check_all_offsets(pk, {{}, 1, 500, 1000, 1001})
+check_all_offsets(sk, {{}, 0, 3, 9, 10})
+pk:select({}, {offset = 998})
+sk:select(3, {offset = 98})
+sk:select(3, {iterator = 'REQ', offset = 98})
+sk:select(3, {offset = 100})
+
+-- Cardinalities are kept up to date on delete.
+for i = 1, 1000, 2 do s:delete{i} end
+pk:count(500, {iterator = 'LT'})
+sk:count(3)
+sk:rank(5)
+check_all_offsets(pk, {{}, 1, 500, 1000, 1001})
+check_all_offsets(sk, {{}, 0, 3, 9, 10})
+
+s:drop()
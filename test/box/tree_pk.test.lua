@@ -301,3 +301,53 @@ s:drop()
 
 box.internal.collation.drop('test')
 box.internal.collation.drop('test-ci')
+
+--
+-- TREE index entries store shrunk comparison hints. Check that
+-- keys which differ only in the dropped hint bits are ordered
+-- correctly.
+--
+s = box.schema.space.create('test')
+pk = s:create_index('pk', {parts = {1, 'scalar'}})
+for i = 0, 62 do local x = bit.lshift(1LL, i) for d = -1, 1 do s:replace{x + d} s:replace{-x - d} end end
+for i = -100, 100 do s:replace{i + 0.5} end
+for i = 0, 255 do s:replace{string.format('prefix%03d', i)} end
+s:count()
+test_run:cmd("setopt delimiter ';'")
+function check_order()
+    local t = pk:select()
+    for i = 2, #t do
+        local a, b = t[i - 1][1], t[i][1]
+        local ok
+        if type(a) == 'string' then
+            ok = type(b) == 'string' and a < b
+        else
+            ok = type(b) == 'string' or a < b
+        end
+        if not ok then
+            return false, a, b
+        end
+        if pk:count(b, {iterator = 'LT'}) ~= i - 1 or
+           pk:get(b) == nil then
+            return false, b
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+check_order()
+pk:select(1LL, {iterator = 'GT', limit = 3})
+pk:select('prefix', {iterator = 'GT', limit = 2})
+s:drop()
+
+-- A tuple may have a limited number of multikey index entries.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+sk = s:create_index('sk', {parts = {{2, 'unsigned', path = '[*]'}}, unique = false})
+t = {}
+for i = 1, 131073 do t[i] = i end
+s:insert{1, t}
+t[#t] = nil
+_ = s:insert{1, t}
+sk:count()
+s:drop()
@@ -194,3 +194,25 @@ test_run:cmd("setopt delimiter ''");
 space:drop()
 
 space = nil
+
+-- Keys mixing integer, number and collated string parts.
+space = box.schema.space.create('test')
+pk = space:create_index('primary', {parts = {{1, 'integer'}, {2, 'number'}, {3, 'string', collation = 'unicode_ci'}}})
+sk = space:create_index('second', {parts = {{4, 'string'}, {5, 'unsigned'}, {1, 'integer'}, {3, 'string'}}})
+space:insert{-1, 1.5, 'b', 'k', 2}
+space:insert{-1, 1, 'A', 'k', 1}
+space:insert{-1, 1, 'c', 'j', 2}
+space:insert{2, -0.5, 'x', 'k', 1}
+space:insert{0, 3, 'B', 'k', 1}
+space:insert{-1, 1, 'a', 'l', 1}
+pk:select()
+pk:select{-1, 1}
+pk:select{-1, 1, 'C'}
+pk:select({-1, 1.2}, {iterator = 'LT'})
+pk:select({0}, {iterator = 'GE'})
+sk:select()
+sk:select{'k', 1}
+sk:select({'k', 1, 0}, {iterator = 'GT'})
+sk:select{'k', 1, -1, 'A'}
+sk:select{'k', 1, -1, 'a'}
+space:drop()
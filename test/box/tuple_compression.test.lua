@@ -0,0 +1,61 @@
+test_run = require('test_run').new()
+--
+-- Memtx spaces can compress big tuples: fields following the
+-- indexed ones are stored compressed with zstd.
+--
+s = box.schema.space.create('test', {compression = 'zstd', compression_threshold = 100})
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'string'}})
+big = string.rep('abcd', 500)
+used = box.slab.info().items_used
+for i = 1, 100 do s:insert{i, 'k' .. i, big, i} end
+delta = box.slab.info().items_used - used
+plain = box.schema.space.create('plain')
+_ = plain:create_index('pk')
+used = box.slab.info().items_used
+for i = 1, 100 do plain:insert{i, 'k' .. i, big, i} end
+delta < (box.slab.info().items_used - used) / 10
+s:bsize() == plain:bsize()
+s:get{1}[4]
+s:get{1}[3] == big
+sk:get{'k5'}[1]
+s:update({2}, {{'=', 4, 20}})[4]
+s:get{2}[3] == big
+
+-- Reading tuples doesn't make them take more memory.
+used = box.slab.info().items_used
+s:get{3}[3] == big
+n = 0
+for _, t in s:pairs() do if t[3] == big then n = n + 1 end end
+n
+box.slab.info().items_used == used
+
+-- Small tuples are stored as is.
+s:insert{101, 'k101', 'small', 101}
+
+-- An index over a compressed field.
+tk = s:create_index('tk', {parts = {4, 'unsigned'}, unique = false})
+#tk:select{20}
+tk:select{101}
+s:count()
+
+-- Tuples are written to a snapshot uncompressed.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+s:count()
+s:get{100}[3] == string.rep('abcd', 500)
+s.index.tk:select{20}[2][1]
+s:drop()
+box.space.plain:drop()
+
+-- Errors.
+box.schema.space.create('test', {compression = 'lz4'})
+box.schema.space.create('test', {engine = 'vinyl', compression = 'zstd'})
+box.schema.space.create('test', {compression = 'zstd', compression_level = 0})
+
+-- Compression level.
+s = box.schema.space.create('test', {compression = 'zstd', compression_threshold = 100, compression_level = 19})
+_ = s:create_index('pk')
+s:insert{1, string.rep('abcd', 500)}[2] == string.rep('abcd', 500)
+s:drop()
@@ -0,0 +1,42 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- WAL group commit and box.stat.wal().
+--
+box.cfg{wal_group_commit_delay = -1}
+box.cfg{wal_group_commit_size = 0}
+box.cfg.wal_group_commit_delay
+box.cfg.wal_group_commit_size
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.stat.reset()
+box.stat.wal().batch_count
+
+box.cfg{wal_group_commit_delay = 0.01}
+-- The target is adjusted after the first write.
+box.stat.wal().group_target
+
+-- Transactions committed while a batch is written are
+-- grouped into the next batch.
+ch = fiber.channel(100)
+for i = 1, 100 do fiber.create(function() s:insert{i} ch:put(true) end) end
+for i = 1, 100 do ch:get() end
+s:count()
+stat = box.stat.wal()
+stat.batch_count > 0 and stat.batch_count < 100
+stat.batch_size.p99 > 0
+stat.write_latency.p99 > 0
+stat.group_target <= box.cfg.wal_group_commit_size
+
+-- A transaction doesn't wait when the WAL is idle.
+t = fiber.clock()
+for i = 101, 110 do s:insert{i} end
+fiber.clock() - t < 0.1
+
+box.cfg{wal_group_commit_delay = 0}
+s:insert{111}
+box.stat.reset()
+box.stat.wal().batch_count
+s:drop()
@@ -0,0 +1,70 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+net = require('net.box')
+
+--
+-- index:get_many() looks up a batch of full keys of a unique
+-- index and returns the found tuples in the order of keys.
+--
+s = box.schema.space.create('test', {engine = engine})
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {{2, 'string'}, {3, 'unsigned'}}})
+for i = 1, 100 do s:insert{i, 'k' .. i % 10, i} end
+pk:get_many({})
+pk:get_many({5, 1, 3})
+
+-- Missing keys are skipped, repeated keys are returned repeatedly.
+pk:get_many({{7}, 1000, {7}, 0})
+s:get_many({100, 99})
+sk:get_many({{'k1', 1}, {'k1', 2}, {'k2', 2}})
+
+-- A batch larger than the number of lookups done together.
+keys = {}
+for i = 1, 200 do keys[i] = (i * 37) % 211 end
+res = pk:get_many(keys)
+#res
+j = 1
+ok = true
+test_run:cmd("setopt delimiter ';'")
+for _, k in ipairs(keys) do
+    if k >= 1 and k <= 100 then
+        if res[j][1] ~= k then ok = false end
+        j = j + 1
+    end
+end;
+test_run:cmd("setopt delimiter ''");
+ok
+
+-- Errors.
+pk:get_many(1)
+pk:get_many({{'x'}})
+pk:get_many({{1, 2}})
+sk:get_many({{'k1'}})
+nu = s:create_index('nu', {parts = {2, 'string'}, unique = false})
+nu:get_many({'k1'})
+nu:drop()
+
+-- A transaction sees its own changes.
+test_run:cmd("setopt delimiter ';'")
+function tx_get_many()
+    box.begin()
+    s:replace{1, 'one', 1}
+    s:delete{2}
+    local res = pk:get_many({1, 2, 3})
+    box.rollback()
+    return res
+end;
+test_run:cmd("setopt delimiter ''");
+tx_get_many()
+pk:get_many({1, 2})
+
+-- IPROTO_GET_MANY.
+box.schema.user.grant('guest', 'read', 'space', 'test')
+c = net.connect(box.cfg.listen)
+c.space.test.index.pk:get_many({3, 1000, 1})
+c.space.test:get_many({{2}})
+c.space.test.index.sk:get_many({{'k5', 5}})
+c.space.test.index.pk:get_many({{'x'}})
+c:close()
+box.schema.user.revoke('guest', 'read', 'space', 'test')
+s:drop()
@@ -0,0 +1,50 @@
+test_run = require('test_run').new()
+
+--
+-- A replica may ask the master to send rows compressed
+-- in zstd frames of the configured size and age.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.cfg{replication_compression_level = 100}
+box.cfg{replication_compression_frame_size = 0}
+box.cfg{replication_compression_frame_delay = -1}
+box.cfg{replication_compression_frame_size = 4096}
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+box.cfg.replication_compression
+box.cfg{replication_compression = true}
+replication = box.cfg.replication
+box.cfg{replication = {}}
+box.cfg{replication = replication}
+test_run:wait_cond(function() return box.info.replication[1].upstream.status == 'follow' end)
+test_run:cmd("switch default")
+
+for i = 1, 1000 do s:replace{i, string.rep('x', 100)} end
+test_run:wait_lsn('replica', 'default')
+c = box.info.replication[2].downstream.compression
+c.ratio > 1, c.saved > 0
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get(1000)[2] == string.rep('x', 100)
+c = box.info.replication[1].upstream.compression
+c.ratio > 1, c.saved > 0
+test_run:cmd("switch default")
+
+-- A frame which is not full is sent after the delay.
+s:replace{1001}
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:get(1001)
+box.info.replication[1].upstream.status
+test_run:cmd("switch default")
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.schema.user.revoke('guest', 'replication')
+box.cfg{replication_compression_frame_size = 65536}
+s:drop()
@@ -0,0 +1,32 @@
+test_run = require('test_run').new()
+
+--
+-- A replica may fetch the memtx snapshot of the master over
+-- several connections, a snapshot shard per connection.
+--
+box.cfg{replication_join_connections = -1}
+box.schema.user.grant('guest', 'replication')
+checkpoint_threads = box.cfg.memtx_checkpoint_threads
+box.cfg{memtx_checkpoint_threads = 4}
+for i = 1, 3 do box.schema.space.create('test' .. i):create_index('pk') end
+for i = 1, 3 do for j = 1, 1000 do box.space['test' .. i]:replace{j, i} end end
+box.snapshot()
+-- Sent on final join.
+box.space.test1:replace{1001, 1}
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica_join_fetch.lua'")
+test_run:cmd("start server replica with args='3'")
+test_run:grep_log('replica', 'fetching 4 snapshot shards')
+test_run:cmd("switch replica")
+box.space.test1:count(), box.space.test2:count(), box.space.test3:count()
+box.space.test3:get(1000)
+box.space.test1:get(1001)
+test_run:wait_cond(function() return box.info.replication[1].upstream.status == 'follow' end)
+test_run:cmd("switch default")
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.schema.user.revoke('guest', 'replication')
+box.cfg{memtx_checkpoint_threads = checkpoint_threads}
+for i = 1, 3 do box.space['test' .. i]:drop() end
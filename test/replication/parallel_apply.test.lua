@@ -0,0 +1,92 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+--
+-- Transactions received by an applier are applied by
+-- concurrent fibers unless they touch the same primary keys,
+-- and are written to WAL in the order they were received.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+box.cfg.replication_apply_concurrency
+box.cfg{replication_apply_concurrency = 0}
+box.cfg{replication_apply_concurrency = 64}
+function apply_stat() local u = box.info.replication[1].upstream return u.apply_queue, u.apply_parallelism end
+apply_stat()
+test_run:cmd("switch default")
+
+-- Conflicting transactions and DDL in the middle of the stream.
+for i = 1, 500 do s:replace{i % 100, i} end
+s2 = box.schema.space.create('test2', {engine = engine})
+_ = s2:create_index('pk')
+for i = 1, 500 do box.begin() s2:insert{i, i} s:replace{i % 50, i} box.commit() end
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get(0)
+box.space.test:get(49)
+box.space.test:get(99)
+box.space.test.index.sk:count()
+box.space.test2:count()
+box.info.replication[1].upstream.status
+apply_stat()
+
+-- A failed transaction stops the applier, transactions
+-- received after it are not applied.
+box.space.test2:insert{1001, 0}
+test_run:cmd("switch default")
+for i = 1001, 1010 do s2:insert{i, i} end
+test_run:cmd("switch replica")
+test_run:wait_cond(function() return box.info.replication[1].upstream.status == 'stopped' end)
+box.info.replication[1].upstream.message
+box.space.test2:count()
+apply_stat()
+box.space.test2:delete{1001}
+replication = box.cfg.replication
+box.cfg{replication = {}}
+box.cfg{replication = replication}
+test_run:wait_cond(function() return box.info.replication[1].upstream.status == 'follow' end)
+test_run:cmd("switch default")
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test2:count()
+box.space.test2:get(1001)
+
+-- The applier stops as soon as a transaction fails to apply,
+-- without waiting for the next one to be received.
+box.space.test2:insert{2001, 0}
+test_run:cmd("switch default")
+_ = s2:insert{2001, 2001}
+test_run:cmd("switch replica")
+test_run:wait_cond(function() return box.info.replication[1].upstream.status == 'stopped' end)
+box.info.replication[1].upstream.message
+box.space.test2:delete{2001}
+box.cfg{replication = {}}
+box.cfg{replication = replication}
+test_run:wait_cond(function() return box.space.test2:get(2001) ~= nil end)
+box.space.test2:get(2001)
+
+-- Without concurrency, transactions are applied by the applier
+-- fiber itself.
+box.cfg{replication_apply_concurrency = 1}
+test_run:cmd("switch default")
+for i = 1, 100 do s:replace{i, i} end
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:get(100)
+box.info.replication[1].upstream.status
+apply_stat()
+test_run:cmd("switch default")
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.schema.user.revoke('guest', 'replication')
+s:drop()
+s2:drop()
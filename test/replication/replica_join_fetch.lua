@@ -0,0 +1,13 @@
+#!/usr/bin/env tarantool
+
+local CONNECTIONS = tonumber(arg[1])
+
+box.cfg({
+    listen              = os.getenv("LISTEN"),
+    replication         = os.getenv("MASTER"),
+    memtx_memory        = 107374182,
+    replication_timeout = 0.1,
+    replication_join_connections = CONNECTIONS,
+})
+
+require('console').listen(os.getenv('ADMIN'))
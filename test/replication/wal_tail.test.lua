@@ -0,0 +1,74 @@
+test_run = require('test_run').new()
+
+--
+-- Relays that are caught up are fed from the WAL tail, an
+-- in-memory ring of rows recently written to the WAL. Relays
+-- that are behind the tail read WAL files.
+--
+box.cfg.wal_tail_size
+box.cfg{wal_tail_size = -1}
+
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+
+-- Rows and WAL rotations go through the tail.
+for i = 1, 100 do s:insert{i} end
+box.snapshot()
+for i = 101, 200 do s:insert{i} end
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get(200)
+test_run:cmd("switch default")
+
+-- Rows that don't fit in the tail are read from WAL files.
+box.cfg{wal_tail_size = 64}
+for i = 201, 300 do s:insert{i, string.rep('x', 100)} end
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:get(300)[2] == string.rep('x', 100)
+test_run:cmd("switch default")
+
+-- A relay that falls behind a small tail switches to files
+-- and back.
+box.cfg{wal_tail_size = 1024}
+for i = 301, 1000 do s:insert{i} end
+box.snapshot()
+for i = 1001, 2000 do box.begin() s:insert{i} s:delete{i - 1000} box.commit() end
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:count()
+box.space.test:min()
+box.space.test:max()
+test_run:cmd("switch default")
+
+-- A replica that has been down catches up from files.
+test_run:cmd("stop server replica")
+box.cfg{wal_tail_size = 16 * 1024 * 1024}
+for i = 2001, 3000 do s:insert{i} end
+test_run:cmd("start server replica")
+for i = 3001, 3100 do s:insert{i} end
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:count()
+test_run:cmd("switch default")
+
+-- The tail can be disabled.
+box.cfg{wal_tail_size = 0}
+for i = 3101, 3200 do s:insert{i} end
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:count()
+test_run:cmd("switch default")
+
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
+test_run:cmd("delete server replica")
+test_run:cleanup_cluster()
+box.schema.user.revoke('guest', 'replication')
+box.cfg{wal_tail_size = 16 * 1024 * 1024}
+s:drop()
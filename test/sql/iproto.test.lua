@@ -37,7 +37,7 @@ cn:execute('insert qwerty gjsdjq  q  qwd qmq;; q;qwd;')
 cn:execute('select id as identifier from test where a = 5;')
 
 -- netbox API errors.
-cn:execute(100)
+cn:execute(4294967295)
 cn:execute('select 1', nil, {dry_run = true})
 
 -- Empty request.
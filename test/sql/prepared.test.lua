@@ -0,0 +1,60 @@
+remote = require('net.box')
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+box.execute('pragma sql_default_engine=\''..engine..'\'')
+
+--
+-- Compiled SQL statements are cached. A statement may be
+-- prepared over iproto and then executed by id.
+--
+box.execute('create table test (id int primary key, a int)')
+box.execute('insert into test values (1, 10), (2, 20), (3, 30)')
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+cn = remote.connect(box.cfg.listen)
+
+stat = box.stat.sql()
+id = cn:prepare('select * from test where id = ?')
+type(id)
+id == cn:prepare('select * from test where id = ?')
+cn:execute(id, {2})
+-- The same text gets the same statement.
+cn:execute('select * from test where id = ?', {3})
+box.stat.sql().sql_cache_hits - stat.sql_cache_hits
+box.stat.sql().sql_cache_misses - stat.sql_cache_misses
+
+--
+-- A statement is recompiled after a schema change.
+--
+box.execute('drop table test')
+box.execute('create table test (id int primary key, a int, b text)')
+box.execute("insert into test values (1, 10, 'x')")
+stat = box.stat.sql()
+cn:execute(id, {1})
+box.stat.sql().sql_cache_misses - stat.sql_cache_misses
+
+--
+-- An evicted statement has to be prepared again.
+--
+box.cfg{sql_cache_size = -1}
+box.cfg{sql_cache_size = 0}
+box.stat.sql().sql_cache_size
+ok, err = pcall(cn.execute, cn, id, {1})
+ok, err.code == box.error.NO_SUCH_STATEMENT
+box.cfg{sql_cache_size = 64}
+new_id = cn:prepare('select * from test where id = ?')
+new_id ~= id
+cn:execute(new_id, {1})
+
+--
+-- Statements executed by text don't evict prepared ones.
+--
+box.cfg{sql_cache_size = 1}
+cn:execute('select a from test')
+cn:execute('select b from test')
+box.stat.sql().sql_cache_size
+cn:execute(new_id, {1})
+box.cfg{sql_cache_size = 64}
+
+cn:close()
+box.execute('drop table test')
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
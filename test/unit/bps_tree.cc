@@ -116,6 +116,29 @@ static int compare_key(const elem_t &a, long b)
 #define bps_tree_key_t uint32_t
 #define bps_tree_arg_t int
 #include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_IDENTICAL
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+
+/* tree with subtree cardinalities for rank/offset test */
+#define BPS_TREE_NAME rank
+#define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
+#define BPS_TREE_EXTENT_SIZE 2048 /* value is to low specially for tests */
+#define BPS_TREE_IDENTICAL(a, b) (a == b)
+#define BPS_TREE_COMPARE(a, b, arg) compare(a, b)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) compare(a, b)
+#define bps_tree_elem_t type_t
+#define bps_tree_key_t type_t
+#define bps_tree_arg_t int
+#define BPS_INNER_CARD
+#include "salad/bps_tree.h"
+#undef BPS_INNER_CARD
 
 #define bps_insert_and_check(tree_name, tree, elem, replaced) \
 {\
@@ -586,6 +609,10 @@ bps_tree_debug_self_check()
 
 	test_debug_check_internal_functions(true);
 
+	res = rank_debug_check_internal_functions(false);
+	if (res)
+		printf("self test with cards returned error %d\n", res);
+
 	footer();
 }
 
@@ -817,6 +844,99 @@ approximate_count()
 	footer();
 }
 
+static void
+rank_check_all(rank *tree, const bool *present, type_t range)
+{
+	if (rank_debug_check(tree))
+		fail("debug check nonzero", "true");
+	size_t less = 0;
+	for (type_t key = 0; key < range; key++) {
+		size_t offset;
+		struct rank_iterator itr =
+			rank_lower_bound_get_offset(tree, key, NULL, &offset);
+		if (offset != less)
+			fail("wrong lower bound offset", "true");
+		struct rank_iterator at = rank_iterator_at(tree, offset);
+		if (!rank_iterator_are_equal(tree, &itr, &at))
+			fail("lower bound and offset iterators differ", "true");
+		if (present[key])
+			less++;
+		bool exact;
+		rank_upper_bound_get_offset(tree, key, &exact, &offset);
+		if (offset != less || exact != present[key])
+			fail("wrong upper bound offset", "true");
+	}
+	if (less != rank_size(tree))
+		fail("wrong tree size", "true");
+	struct rank_iterator itr = rank_iterator_first(tree);
+	for (size_t i = 0; i < less; i++) {
+		struct rank_iterator at = rank_iterator_at(tree, i);
+		if (!rank_iterator_are_equal(tree, &itr, &at))
+			fail("wrong iterator at offset", "true");
+		rank_iterator_next(tree, &itr);
+	}
+	struct rank_iterator at = rank_iterator_at(tree, less);
+	if (!rank_iterator_is_invalid(&at))
+		fail("iterator beyond the end must be invalid", "true");
+}
+
+static void
+rank_test()
+{
+	header();
+	srand(0);
+
+	const type_t range = 1000;
+	bool present[range];
+	type_t arr[range];
+	for (type_t i = 0; i < range; i++) {
+		present[i] = (i % 3) != 0;
+		arr[i] = i;
+	}
+
+	rank tree;
+	rank_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	size_t count = 0;
+	for (type_t i = 0; i < range; i++)
+		if (present[i])
+			arr[count++] = i;
+	if (rank_build(&tree, arr, count))
+		fail("building failed", "true");
+	rank_check_all(&tree, present, range);
+
+	/* Frozen iterator makes the tree copy blocks on write */
+	struct rank_iterator frozen = rank_iterator_first(&tree);
+	rank_iterator_freeze(&tree, &frozen);
+
+	for (int round = 0; round < 20; round++) {
+		for (int i = 0; i < 500; i++) {
+			type_t v = rand() % range;
+			if (rand() % 2) {
+				rank_insert(&tree, v, NULL);
+				present[v] = true;
+			} else {
+				rank_delete(&tree, v);
+				present[v] = false;
+			}
+		}
+		rank_check_all(&tree, present, range);
+	}
+
+	rank_iterator_destroy(&tree, &frozen);
+
+	for (type_t i = 0; i < range; i++) {
+		rank_delete(&tree, i);
+		present[i] = false;
+		if (i % 100 == 0)
+			rank_check_all(&tree, present, range);
+	}
+	rank_check_all(&tree, present, range);
+
+	rank_destroy(&tree);
+
+	footer();
+}
+
 static void
 insert_get_iterator()
 {
@@ -859,6 +979,42 @@ delete_identical_check()
 	footer();
 }
 
+static void
+find_batch_test()
+{
+	header();
+	srand(0);
+
+	const size_t count = 1000;
+	type_t keys[count];
+	type_t *results[count];
+	for (size_t i = 0; i < count; i++)
+		keys[i] = rand() % (2 * count);
+
+	test tree;
+	test_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+	test_find_batch(&tree, keys, count, results);
+	for (size_t i = 0; i < count; i++) {
+		if (results[i] != NULL)
+			fail("found a key in an empty tree", "true");
+	}
+	for (size_t i = 0; i < count; i += 2)
+		test_insert(&tree, keys[i], NULL);
+	/* Check batches of different sizes, not aligned to 16. */
+	for (size_t n = 1; n <= count; n = n * 3 + 1) {
+		test_find_batch(&tree, keys, n, results);
+		for (size_t i = 0; i < n; i++) {
+			if (results[i] != test_find(&tree, keys[i]))
+				fail("batch lookup mismatch", "true");
+			if (results[i] != NULL && *results[i] != keys[i])
+				fail("batch lookup found a wrong key", "true");
+		}
+	}
+	test_destroy(&tree);
+
+	footer();
+}
+
 int
 main(void)
 {
@@ -870,6 +1026,8 @@ main(void)
 	printing_test();
 	white_box_test();
 	approximate_count();
+	rank_test();
+	find_batch_test();
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 	insert_get_iterator();
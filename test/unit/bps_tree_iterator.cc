@@ -544,6 +544,94 @@ iterator_freeze_check()
 }
 
 
+static void
+view_check()
+{
+	header();
+
+	const int test_data_size = 1000;
+	const int test_data_mod = 2000;
+	elem_t comp_buf[test_data_size];
+	int comp_buf_size = 0;
+	srand(0);
+	struct test tree;
+	test_create(&tree, 0, extent_alloc, extent_free,
+		    &total_extents_allocated);
+	for (int j = 0; j < test_data_size; j++) {
+		elem_t e;
+		e.first = rand() % test_data_mod;
+		e.second = 0;
+		test_insert(&tree, e, 0);
+	}
+	struct test_iterator iterator = test_iterator_first(&tree);
+	elem_t *e;
+	while ((e = test_iterator_get_elem(&tree, &iterator))) {
+		comp_buf[comp_buf_size++] = *e;
+		test_iterator_next(&tree, &iterator);
+	}
+	struct test_view view;
+	test_view_create(&tree, &view);
+	for (int j = 0; j < test_data_size; j++) {
+		elem_t e;
+		e.first = rand() % test_data_mod;
+		e.second = 0;
+		if (j % 2 == 0)
+			test_insert(&tree, e, 0);
+		else
+			test_delete(&tree, e);
+		int check = test_debug_check(&tree);
+		fail_if(check);
+		assert(check == 0);
+	}
+
+	/* The view shows the tree as it was when it was created. */
+	int tested_count = 0;
+	iterator = test_view_first(&tree, &view);
+	while ((e = test_iterator_get_elem(&tree, &iterator))) {
+		if (tested_count >= comp_buf_size ||
+		    !equal(*e, comp_buf[tested_count]))
+			fail("view forward iteration failed", "true");
+		tested_count++;
+		test_iterator_next(&tree, &iterator);
+	}
+	if (tested_count != comp_buf_size)
+		fail("view forward iteration failed", "true");
+	iterator = test_view_last(&tree, &view);
+	while ((e = test_iterator_get_elem(&tree, &iterator))) {
+		if (tested_count <= 0 ||
+		    !equal(*e, comp_buf[tested_count - 1]))
+			fail("view backward iteration failed", "true");
+		tested_count--;
+		test_iterator_prev(&tree, &iterator);
+	}
+	if (tested_count != 0)
+		fail("view backward iteration failed", "true");
+
+	for (long key = -1; key <= test_data_mod; key++) {
+		int lower = 0;
+		while (lower < comp_buf_size && comp_buf[lower].first < key)
+			lower++;
+		int upper = lower;
+		while (upper < comp_buf_size && comp_buf[upper].first <= key)
+			upper++;
+		iterator = test_view_lower_bound(&tree, &view, key);
+		e = test_iterator_get_elem(&tree, &iterator);
+		if (lower == comp_buf_size ? e != NULL :
+		    e == NULL || !equal(*e, comp_buf[lower]))
+			fail("view lower bound failed", "true");
+		iterator = test_view_upper_bound(&tree, &view, key);
+		e = test_iterator_get_elem(&tree, &iterator);
+		if (upper == comp_buf_size ? e != NULL :
+		    e == NULL || !equal(*e, comp_buf[upper]))
+			fail("view upper bound failed", "true");
+	}
+	test_view_destroy(&tree, &view);
+	test_destroy(&tree);
+
+	footer();
+}
+
+
 int
 main(void)
 {
@@ -551,6 +639,7 @@ main(void)
 	iterator_check();
 	iterator_invalidate_check();
 	iterator_freeze_check();
+	view_check();
 	if (total_extents_allocated) {
 		fail("memory leak", "true");
 	}
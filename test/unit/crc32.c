@@ -0,0 +1,41 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "crc32.h"
+#include "unit.h"
+#include "trivia/util.h"
+
+static void
+test_combine(void)
+{
+	header();
+	plan(4);
+
+	enum { BUF_SIZE = 4096 };
+	char *buf = malloc(BUF_SIZE);
+	fail_if(buf == NULL);
+	for (int i = 0; i < BUF_SIZE; i++)
+		buf[i] = rand();
+
+	uint32_t crc = crc32_calc(0, buf, BUF_SIZE);
+	size_t splits[] = {0, 1, 1000, BUF_SIZE};
+	for (size_t i = 0; i < lengthof(splits); i++) {
+		size_t len1 = splits[i];
+		size_t len2 = BUF_SIZE - len1;
+		uint32_t crc1 = crc32_calc(0, buf, len1);
+		uint32_t crc2 = crc32_calc(0, buf + len1, len2);
+		is(crc32_combine(crc1, crc2, len2), crc,
+		   "combine at %zu", len1);
+	}
+	free(buf);
+
+	check_plan();
+	footer();
+}
+
+int
+main()
+{
+	crc32_init();
+	test_combine();
+}
@@ -462,3 +462,26 @@ test_run:cmd("cleanup server replica")
 test_run:cmd("delete server replica")
 box.schema.user.revoke('guest', 'replication')
 s:drop()
+
+--
+-- A cursor can't be fetched or closed while a page is being
+-- read from disk.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+s:replace{1}
+box.snapshot()
+box.schema.user.grant('guest', 'read', 'space', 'test')
+c = require('net.box').connect(box.cfg.listen)
+cur = c.space.test:cursor()
+errinj.set('ERRINJ_VY_READ_PAGE_DELAY', true)
+ch = fiber.channel(1)
+_ = fiber.create(function() ch:put(cur:fetch()) end)
+c:_request('cursor_fetch', nil, cur.id, 1)
+c:_request('cursor_close', nil, cur.id)
+errinj.set('ERRINJ_VY_READ_PAGE_DELAY', false)
+#ch:get()
+cur:close()
+c:close()
+box.schema.user.revoke('guest', 'read', 'space', 'test')
+s:drop()
@@ -0,0 +1,77 @@
+test_run = require('test_run').new()
+test_run:cmd('restart server default with cleanup=1')
+
+fio = require('fio')
+
+--
+-- Parallel checkpoint: spaces are spread among up to
+-- box.cfg.memtx_checkpoint_threads snapshot shards.
+--
+box.cfg{memtx_checkpoint_threads = 0}
+box.cfg.memtx_checkpoint_threads
+
+box.cfg{memtx_checkpoint_threads = 4}
+
+test_run:cmd("setopt delimiter ';'")
+function snap_files(signature)
+    local prefix = string.format('%020d', signature)
+    local pattern = fio.pathjoin(box.cfg.memtx_dir, prefix .. '.*snap')
+    return #fio.glob(pattern)
+end;
+for i = 1, 6 do
+    local s = box.schema.space.create('test' .. i)
+    s:create_index('pk')
+    for j = 1, 100 * i do s:insert{j, i} end
+end;
+test_run:cmd("setopt delimiter ''");
+
+box.snapshot()
+signature = box.info.signature
+-- The main file and three shards.
+snap_files(signature)
+-- Sharded snapshots have a newer format version so that
+-- older versions refuse to load them.
+f = fio.open(fio.pathjoin(box.cfg.memtx_dir, string.format('%020d.snap', signature)))
+f:read(10):split('\n')[2]
+f:close()
+
+-- Recovery reads all shards regardless of the current setting.
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+fio = require('fio')
+box.cfg.memtx_checkpoint_threads
+test_run:cmd("setopt delimiter ';'")
+function snap_files(signature)
+    local prefix = string.format('%020d', signature)
+    local pattern = fio.pathjoin(box.cfg.memtx_dir, prefix .. '.*snap')
+    return #fio.glob(pattern)
+end;
+test_run:cmd("setopt delimiter ''");
+signature = box.info.signature
+for i = 1, 6 do assert(box.space['test' .. i]:count() == 100 * i) end
+box.space.test6:get{600}
+
+-- Backup lists every shard and fails if one is missing.
+files = box.backup.start()
+n = 0
+for _, f in ipairs(files) do if f:endswith('.snap') then n = n + 1 end end
+n
+box.backup.stop()
+shard = fio.pathjoin(box.cfg.memtx_dir, string.format('%020d.2.snap', signature))
+fio.rename(shard, shard .. '.bak')
+ok, err = pcall(box.backup.start)
+ok
+tostring(err):match('is missing') ~= nil
+fio.rename(shard .. '.bak', shard)
+
+-- A single thread writes a plain snapshot.
+box.space.test1:replace{1, 0}
+box.snapshot()
+snap_files(box.info.signature)
+
+-- Shards are removed along with the snapshot they belong to.
+box.space.test1:replace{1, 1}
+box.snapshot()
+test_run:wait_cond(function() return snap_files(signature) == 0 end, 10)
+
+for i = 1, 6 do box.space['test' .. i]:drop() end
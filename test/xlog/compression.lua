@@ -0,0 +1,8 @@
+#!/usr/bin/env tarantool
+
+box.cfg {
+    listen = os.getenv("LISTEN"),
+    wal_compression_threads = 2,
+}
+
+require('console').listen(os.getenv('ADMIN'))
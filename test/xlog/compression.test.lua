@@ -0,0 +1,66 @@
+test_run = require('test_run').new()
+fio = require('fio')
+
+--
+-- box.cfg.wal_compression_level, box.cfg.memtx_compression_level:
+-- zstd compression level of WAL and snapshot files.
+--
+box.cfg{wal_compression_level = -1}
+box.cfg{memtx_compression_level = 23}
+box.cfg{wal_compression_threads = 1}
+box.cfg.wal_compression_level
+box.cfg.memtx_compression_level
+
+test_run:cmd("setopt delimiter ';'")
+function files_size(pattern)
+    local size = 0
+    for _, f in ipairs(fio.glob(fio.pathjoin(box.cfg.wal_dir, pattern))) do
+        size = size + fio.stat(f).size
+    end
+    return size
+end;
+function last_snap_size()
+    local snaps = fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snap'))
+    table.sort(snaps)
+    return fio.stat(snaps[#snaps]).size
+end;
+test_run:cmd("setopt delimiter ''");
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.cfg{wal_compression_level = 0}
+size = files_size('*.xlog')
+_ = s:insert{1, string.rep('x', 100000)}
+files_size('*.xlog') - size > 100000
+box.cfg{wal_compression_level = 3}
+size = files_size('*.xlog')
+_ = s:insert{2, string.rep('x', 100000)}
+files_size('*.xlog') - size < 10000
+
+box.cfg{memtx_compression_level = 0}
+box.snapshot()
+last_snap_size() > 200000
+box.cfg{memtx_compression_level = 3}
+box.snapshot()
+last_snap_size() < 20000
+s:drop()
+
+--
+-- box.cfg.wal_compression_threads: big WAL writes are split in
+-- chunks compressed in parallel by helper threads.
+--
+test_run:cmd('create server compression with script = "xlog/compression.lua"')
+test_run:cmd('start server compression')
+test_run:cmd('switch compression')
+box.cfg.wal_compression_threads
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.begin() for i = 1, 100 do s:insert{i, string.rep(tostring(i), 5000)} end box.commit()
+test_run:cmd('restart server compression')
+s = box.space.test
+s:count()
+s:get{100}[2] == string.rep('100', 5000)
+test_run:cmd('switch default')
+test_run:cmd('stop server compression')
+test_run:cmd('cleanup server compression')
+test_run:cmd('delete server compression')
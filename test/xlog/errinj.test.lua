@@ -70,3 +70,55 @@ test_run:wait_cond(function()
     return fio.path.exists(fio.pathjoin(box.cfg.memtx_dir, filename))
 end, 10);
 test_run:cmd("setopt delimiter ''");
+
+--
+-- A finished xlog file is read with pread() if it fails
+-- to be mapped into memory.
+--
+xlog = require('xlog').pairs
+s = box.schema.space.create('test_mmap')
+_ = s:create_index('pk')
+box.snapshot()
+signature = box.info.signature
+for i = 1, 5 do s:insert{i} end
+box.snapshot()
+path = fio.pathjoin(box.cfg.wal_dir, string.format('%020d.xlog', signature))
+box.error.injection.set('ERRINJ_XLOG_MMAP', true)
+count = 0
+for _, row in xlog(path) do count = count + 1 end
+count
+box.error.injection.set('ERRINJ_XLOG_MMAP', false)
+test_run:grep_log('default', 'failed to map') ~= nil
+s:drop()
+
+--
+-- A snapshot of an ART index isn't affected by modifications
+-- made while it's being written.
+--
+fiber = require('fiber')
+s = box.schema.space.create('test_art')
+_ = s:create_index('pk', {type = 'art'})
+for i = 1, 100 do s:insert{i} end
+signature = box.info.signature
+box.error.injection.set('ERRINJ_SNAP_WRITE_ROW_TIMEOUT', 0.001)
+f = fiber.new(box.snapshot)
+f:set_joinable(true)
+test_run:cmd("setopt delimiter ';'")
+test_run:wait_cond(function()
+    local filename = string.format('%020d.snap.inprogress', signature)
+    return fio.path.exists(fio.pathjoin(box.cfg.memtx_dir, filename))
+end, 10);
+test_run:cmd("setopt delimiter ''");
+for i = 1, 100, 2 do s:delete{i} end
+for i = 2, 100, 4 do s:replace{i, 'new'} end
+for i = 101, 200 do s:insert{i} end
+box.error.injection.set('ERRINJ_SNAP_WRITE_ROW_TIMEOUT', 0)
+f:join()
+path = fio.pathjoin(box.cfg.memtx_dir, string.format('%020d.snap', signature))
+n, new = 0, 0
+for _, row in xlog(path) do if row.BODY.space_id == s.id then n = n + 1 if #row.BODY.tuple > 1 then new = new + 1 end end end
+n
+new
+s:count()
+s:select(4)
+s:drop()
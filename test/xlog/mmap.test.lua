@@ -0,0 +1,55 @@
+test_run = require('test_run').new()
+fio = require('fio')
+xlog = require('xlog').pairs
+
+--
+-- Finished xlog files, i.e. ending with the eof marker, are
+-- read through a memory mapping, other files with pread().
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+box.snapshot()
+signature = box.info.signature
+for i = 1, 5 do s:insert{i, string.rep('x', 100)} end
+box.snapshot()
+path = fio.pathjoin(box.cfg.wal_dir, string.format('%020d.xlog', signature))
+size = fio.stat(path).size
+test_run:cmd("setopt delimiter ';'")
+function read_keys(path)
+    local keys = {}
+    for _, row in xlog(path) do
+        if row.BODY ~= nil and row.BODY.space_id == s.id then
+            table.insert(keys, row.BODY.tuple[1])
+        end
+    end
+    return keys
+end;
+function copy(size)
+    local tmp = fio.pathjoin(fio.tempdir(), 'test.xlog')
+    fio.copyfile(path, tmp)
+    local f = fio.open(tmp, {'O_RDWR'})
+    f:truncate(size)
+    f:close()
+    return tmp
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- A finished file is mapped.
+read_keys(path)
+
+-- A file truncated in the middle of the last transaction
+-- has no eof marker, so it is read with pread() up to the
+-- last complete transaction.
+read_keys(copy(size - 10))
+
+-- A file that only lacks the eof marker is read in full.
+read_keys(copy(size - 4))
+
+-- A corrupted last transaction of a mapped file is skipped.
+tmp = copy(size)
+f = fio.open(tmp, {'O_RDWR'})
+f:pwrite('y', size - 5)
+f:close()
+read_keys(tmp)
+
+s:drop()
@@ -0,0 +1,47 @@
+test_run = require('test_run').new()
+test_run:cmd('restart server default with cleanup=1')
+fio = require('fio')
+
+--
+-- box.cfg.wal_spare_files: WAL rotation takes a preallocated
+-- spare file instead of creating a new one.
+--
+box.cfg{wal_spare_files = -1}
+box.cfg.wal_spare_files
+
+test_run:cmd("setopt delimiter ';'")
+function spare_files()
+    local pattern = fio.pathjoin(box.cfg.wal_dir, '*.xlog.spare')
+    return #fio.glob(pattern)
+end;
+function xlog_files()
+    return #fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+end;
+test_run:cmd("setopt delimiter ''");
+
+box.cfg{wal_spare_files = 2}
+test_run:wait_cond(function() return spare_files() == 2 end, 10)
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+xlogs = xlog_files()
+-- rows_per_wal is 10, so the WAL is rotated a few times.
+for i = 1, 30 do s:insert{i} end
+xlog_files() > xlogs
+-- The pool is refilled in background.
+test_run:wait_cond(function() return spare_files() == 2 end, 10)
+
+-- Excess spare files are removed.
+box.cfg{wal_spare_files = 1}
+test_run:wait_cond(function() return spare_files() == 1 end, 10)
+
+-- WAL files made of spare files are recovered, spare files
+-- left from the previous run are removed.
+test_run:cmd('restart server default')
+fio = require('fio')
+box.cfg.wal_spare_files
+#fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.spare'))
+s = box.space.test
+s:count()
+s:get{30}
+s:drop()